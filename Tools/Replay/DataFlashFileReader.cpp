@@ -6,10 +6,15 @@
 #include <sys/types.h>
 #include <sys/stat.h>
 #include <stdio.h>
+#include <stdlib.h>
 #include <unistd.h>
 #include <time.h>
 #include <cinttypes>
 
+#if AP_REPLAY_MMAP_ENABLED
+#include <sys/mman.h>
+#endif
+
 #ifndef PRIu64
 #define PRIu64 "llu"
 #endif
@@ -20,6 +25,16 @@ AP_LoggerFileReader::AP_LoggerFileReader()
 AP_LoggerFileReader::~AP_LoggerFileReader()
 {
     ::printf("Replay counts: %" PRIu64 " bytes  %u entries\n", bytes_read, message_count);
+#if HAL_LOGGER_FILE_COMPRESSION_ENABLED
+    delete[] encoded_block;
+    delete[] block;
+#endif
+#if AP_REPLAY_MMAP_ENABLED
+    if (map != nullptr) {
+        munmap(map, map_len);
+    }
+#endif
+    free(time_index);
 }
 
 bool AP_LoggerFileReader::open_log(const char *logfile)
@@ -33,16 +48,236 @@ bool AP_LoggerFileReader::open_log(const char *logfile)
     if (AP::FS().stat(logfile, &st) == 0) {
         file_size = st.st_size;
     }
+
+#if HAL_LOGGER_FILE_COMPRESSION_ENABLED
+    // compressed logs start with a marker rather than a message
+    uint8_t magic[sizeof(LogCompressor::FILE_MAGIC)];
+    if (read_file(magic, sizeof(magic)) == sizeof(magic) &&
+        memcmp(magic, LogCompressor::FILE_MAGIC, sizeof(magic)) == 0) {
+        encoded_block = NEW_NOTHROW uint8_t[LogCompressor::MAX_BLOCK];
+        block = NEW_NOTHROW uint8_t[LogCompressor::MAX_BLOCK];
+        if (encoded_block == nullptr || block == nullptr) {
+            return false;
+        }
+        compressed = true;
+        ::printf("Reading compressed log\n");
+        return true;
+    }
+    AP::FS().lseek(fd, 0, SEEK_SET);
+    bytes_read = 0;
+#endif
+#if AP_REPLAY_MMAP_ENABLED
+    // fall back to reading the file if it can't be mapped
+    if (map_log(logfile)) {
+        AP::FS().close(fd);
+        fd = -1;
+    }
+#endif
     return true;
 }
 
-ssize_t AP_LoggerFileReader::read_input(void *buffer, const size_t count)
+#if AP_REPLAY_MMAP_ENABLED
+/*
+  map the log into memory so messages can be handled in place rather
+  than copied out of the file a few bytes at a time
+ */
+bool AP_LoggerFileReader::map_log(const char *logfile)
+{
+    const int map_fd = ::open(logfile, O_RDONLY|O_CLOEXEC);
+    if (map_fd == -1) {
+        return false;
+    }
+    struct stat st;
+    if (fstat(map_fd, &st) != 0 || st.st_size == 0) {
+        ::close(map_fd);
+        return false;
+    }
+    // private writable pages, as message handlers are given
+    // non-const pointers into the log
+    void *p = mmap(nullptr, st.st_size, PROT_READ|PROT_WRITE, MAP_PRIVATE, map_fd, 0);
+    ::close(map_fd);
+    if (p == MAP_FAILED) {
+        return false;
+    }
+    madvise(p, st.st_size, MADV_SEQUENTIAL);
+    map = (uint8_t *)p;
+    map_len = st.st_size;
+    file_size = st.st_size;
+    build_index();
+    return true;
+}
+
+/*
+  walk the headers of every message in the log, noting the length of
+  each type and where each second of frames starts
+ */
+void AP_LoggerFileReader::build_index()
+{
+    int16_t frame_type = -1;
+    uint64_t ofs = 0;
+    while (ofs + 3 <= map_len) {
+        const uint8_t *hdr = &map[ofs];
+        if (hdr[0] != HEAD_BYTE1 || hdr[1] != HEAD_BYTE2) {
+            break;
+        }
+        uint8_t length;
+        if (hdr[2] == LOG_FORMAT_MSG) {
+            length = sizeof(struct log_Format);
+            if (ofs + length <= map_len) {
+                const struct log_Format *f = (const struct log_Format *)hdr;
+                type_index[f->type].length = f->length;
+                if (strncmp(f->name, "RFRH", 4) == 0) {
+                    frame_type = f->type;
+                }
+            }
+        } else {
+            length = type_index[hdr[2]].length;
+        }
+        if (length < 3 || ofs + length > map_len) {
+            break;
+        }
+        if (hdr[2] == frame_type && length >= 3 + sizeof(uint64_t)) {
+            uint64_t time_us;
+            memcpy(&time_us, &hdr[3], sizeof(time_us));
+            if ((num_time_buckets == 0 ||
+                 time_us >= time_index[num_time_buckets-1].time_us + LOGREADER_TIME_BUCKET_US) &&
+                !add_time_bucket(time_us, ofs)) {
+                // leave the log unindexed by time
+                num_time_buckets = 0;
+                frame_type = -1;
+            }
+            last_frame_us = time_us;
+        }
+        ofs += length;
+    }
+}
+
+bool AP_LoggerFileReader::add_time_bucket(uint64_t time_us, uint64_t ofs)
+{
+    if (num_time_buckets == max_time_buckets) {
+        const uint32_t new_max = MAX(max_time_buckets * 2, 256U);
+        TimeBucket *new_index = (TimeBucket *)realloc(time_index, new_max * sizeof(time_index[0]));
+        if (new_index == nullptr) {
+            return false;
+        }
+        time_index = new_index;
+        max_time_buckets = new_max;
+    }
+    time_index[num_time_buckets++] = { time_us, ofs };
+    return true;
+}
+
+/*
+  handle the next message of a mapped log
+ */
+bool AP_LoggerFileReader::update_mapped()
+{
+    if (bytes_read + 3 > map_len) {
+        return false;
+    }
+    uint8_t *msg = &map[bytes_read];
+    if (msg[0] != HEAD_BYTE1 || msg[1] != HEAD_BYTE2) {
+        printf("bad log header\n");
+        return false;
+    }
+    packet_counts[msg[2]]++;
+
+    if (type_index[msg[2]].skip && type_index[msg[2]].length != 0) {
+        if (bytes_read + type_index[msg[2]].length > map_len) {
+            return false;
+        }
+        bytes_read += type_index[msg[2]].length;
+        message_count++;
+        return true;
+    }
+
+    if (msg[2] == LOG_FORMAT_MSG) {
+        struct log_Format f;
+        if (bytes_read + sizeof(f) > map_len) {
+            return false;
+        }
+        memcpy(&f, msg, sizeof(f));
+        memcpy(&formats[f.type], &f, sizeof(formats[f.type]));
+        bytes_read += sizeof(f);
+        message_count++;
+        return handle_log_format_msg(f);
+    }
+
+    const struct log_Format &f = formats[msg[2]];
+    if (f.length == 0) {
+        // can't just throw these away as the format specifies the
+        // number of bytes in the message
+        ::printf("No format defined for type (%d)\n", msg[2]);
+        exit(1);
+    }
+    if (bytes_read + f.length > map_len) {
+        return false;
+    }
+    bytes_read += f.length;
+    message_count++;
+    return handle_msg(f, msg);
+}
+#endif  // AP_REPLAY_MMAP_ENABLED
+
+ssize_t AP_LoggerFileReader::read_file(void *buffer, const size_t count)
 {
     uint64_t ret = AP::FS().read(fd, buffer, count);
     bytes_read += ret;
     return ret;
 }
 
+#if HAL_LOGGER_FILE_COMPRESSION_ENABLED
+/*
+  read and decode the next block of a compressed log
+ */
+bool AP_LoggerFileReader::read_block()
+{
+    uint8_t hdr[LogCompressor::BLOCK_HEADER_LEN];
+    if (read_file(hdr, sizeof(hdr)) != sizeof(hdr)) {
+        return false;
+    }
+    uint16_t stored_len, raw_len;
+    bool is_stored;
+    if (!LogCompressor::decode_header(hdr, stored_len, raw_len, is_stored)) {
+        printf("bad compressed block header\n");
+        return false;
+    }
+    uint8_t *dest = is_stored ? block : encoded_block;
+    if (read_file(dest, stored_len) != stored_len) {
+        return false;
+    }
+    if (!is_stored &&
+        LogCompressor::decompress(encoded_block, stored_len, block, raw_len) != raw_len) {
+        printf("corrupt compressed block\n");
+        return false;
+    }
+    block_len = raw_len;
+    block_ofs = 0;
+    return true;
+}
+#endif
+
+ssize_t AP_LoggerFileReader::read_input(void *buffer, const size_t count)
+{
+#if HAL_LOGGER_FILE_COMPRESSION_ENABLED
+    if (compressed) {
+        uint8_t *out = (uint8_t *)buffer;
+        size_t copied = 0;
+        while (copied < count) {
+            if (block_ofs == block_len && !read_block()) {
+                break;
+            }
+            const size_t n = MIN(count - copied, size_t(block_len - block_ofs));
+            memcpy(&out[copied], &block[block_ofs], n);
+            block_ofs += n;
+            copied += n;
+        }
+        return copied;
+    }
+#endif
+    return read_file(buffer, count);
+}
+
 void AP_LoggerFileReader::format_type(uint16_t type, char dest[5])
 {
     const struct log_Format &f = formats[type];
@@ -57,8 +292,48 @@ void AP_LoggerFileReader::get_packet_counts(uint64_t dest[])
     memcpy(dest, packet_counts, sizeof(packet_counts));
 }
 
+bool AP_LoggerFileReader::indexed_time_range(uint64_t &start_us, uint64_t &end_us) const
+{
+    if (num_time_buckets == 0) {
+        return false;
+    }
+    start_us = time_index[0].time_us;
+    end_us = last_frame_us;
+    return true;
+}
+
+bool AP_LoggerFileReader::indexed_offset(uint64_t time_us, uint64_t &ofs) const
+{
+    if (num_time_buckets == 0 || time_us > last_frame_us) {
+        return false;
+    }
+    // last bucket starting at or before time_us
+    uint32_t lo = 0;
+    uint32_t hi = num_time_buckets;
+    while (hi - lo > 1) {
+        const uint32_t mid = (lo + hi) / 2;
+        if (time_index[mid].time_us <= time_us) {
+            lo = mid;
+        } else {
+            hi = mid;
+        }
+    }
+    ofs = time_index[lo].ofs;
+    return true;
+}
+
 bool AP_LoggerFileReader::update()
 {
+    if (end_ofs != 0 && bytes_read >= end_ofs) {
+        return false;
+    }
+
+#if AP_REPLAY_MMAP_ENABLED
+    if (map != nullptr) {
+        return update_mapped();
+    }
+#endif
+
     uint8_t hdr[3];
     if (read_input(hdr, 3) != 3) {
         return false;
@@ -1,9 +1,18 @@
 #pragma once
 
 #include <AP_Logger/AP_Logger.h>
+#include <AP_Logger/LogCompress.h>
 
 #define LOGREADER_MAX_FORMATS 255 // must be >= highest MESSAGE
 
+// read uncompressed logs by mapping them into memory
+#ifndef AP_REPLAY_MMAP_ENABLED
+#define AP_REPLAY_MMAP_ENABLED (CONFIG_HAL_BOARD == HAL_BOARD_SITL || CONFIG_HAL_BOARD == HAL_BOARD_LINUX)
+#endif
+
+// spacing of the time index of a mapped log
+#define LOGREADER_TIME_BUCKET_US 1000000ULL
+
 class AP_LoggerFileReader
 {
 public:
@@ -21,6 +30,26 @@ public:
     void get_packet_counts(uint64_t dest[]);
     float get_percent_read(); // Get percentage of log file read
 
+    // times of the first and last frames of the log, if it has been
+    // indexed
+    bool indexed_time_range(uint64_t &start_us, uint64_t &end_us) const;
+
+    // offset of the first frame of the time bucket holding time_us,
+    // if the log has been indexed and runs that long
+    bool indexed_offset(uint64_t time_us, uint64_t &ofs) const;
+
+    // stop reading an indexed log at an offset
+    void set_end_offset(uint64_t ofs) { end_ofs = ofs; }
+
+    // step over messages of a type in a mapped log without handling
+    // them, until cleared. Format messages are always handled
+    void set_skip_type(uint8_t type, bool skip) { type_index[type].skip = skip && type != LOG_FORMAT_MSG; }
+
+    // number of messages handled so far
+    uint32_t get_message_count() const { return message_count; }
+
+    uint64_t get_file_size() const { return file_size; }
+
 protected:
     int fd = -1;
 
@@ -28,8 +57,47 @@ protected:
 
 private:
     ssize_t read_input(void *buf, size_t count);
+    ssize_t read_file(void *buf, size_t count);
+
+#if AP_REPLAY_MMAP_ENABLED
+    // map an uncompressed log into memory and index it
+    bool map_log(const char *logfile);
+    void build_index();
+    bool update_mapped();
+    uint8_t *map = nullptr;
+    uint64_t map_len = 0;
+#endif
+
+    // length of each message type, from its FMT, so skipped messages
+    // can be stepped over
+    struct {
+        uint8_t length;
+        bool skip;
+    } type_index[LOGREADER_MAX_FORMATS] {};
+
+    // offset of the first frame header (RFRH) in each bucket of
+    // LOGREADER_TIME_BUCKET_US, starting from the first frame
+    struct TimeBucket {
+        uint64_t time_us;
+        uint64_t ofs;
+    } *time_index = nullptr;
+    uint32_t num_time_buckets = 0;
+    uint32_t max_time_buckets = 0;
+    uint64_t last_frame_us = 0;
+    bool add_time_bucket(uint64_t time_us, uint64_t ofs);
+
+#if HAL_LOGGER_FILE_COMPRESSION_ENABLED
+    // decoding of compressed logs, see AP_Logger/LogCompress.h
+    bool read_block();
+    bool compressed = false;
+    uint8_t *encoded_block = nullptr;
+    uint8_t *block = nullptr;
+    uint16_t block_len = 0;
+    uint16_t block_ofs = 0;
+#endif
 
     uint64_t bytes_read = 0;
+    uint64_t end_ofs = 0;
     uint64_t file_size = 0; // Total size of the log file
     uint32_t message_count = 0;
     uint64_t start_micros;
@@ -0,0 +1,213 @@
+#include "EKFCheckpoints.h"
+
+#if AP_NAVEKF_CHECKPOINT_ENABLED
+
+#include "DataFlashFileReader.h"
+#include "Replay.h"
+
+#include <AP_DAL/AP_DAL.h>
+#include <AP_Filesystem/AP_Filesystem.h>
+#include <AP_Math/crc.h>
+
+#include <fcntl.h>
+#include <stdio.h>
+
+EKFCheckpoints ekf_checkpoints;
+
+static const char checkpoint_magic[4] { 'R', 'E', 'K', 'C' };
+
+/*
+  checkpoints are only valid for the parameters they were written
+  with, so the --parm and --param-file settings are part of the file
+ */
+uint32_t EKFCheckpoints::user_params_crc()
+{
+    uint32_t crc = 0;
+    for (const struct user_parameter *u=user_parameters; u; u=u->next) {
+        crc = crc_crc32(crc, (const uint8_t *)u->name, strnlen(u->name, sizeof(u->name)));
+        crc = crc_crc32(crc, (const uint8_t *)&u->value, sizeof(u->value));
+    }
+    return crc;
+}
+
+bool EKFCheckpoints::start_writing(const char *_filename, float interval_s, const AP_LoggerFileReader &_reader)
+{
+    fd = AP::FS().open(_filename, O_WRONLY|O_CREAT|O_TRUNC, true);
+    if (fd == -1) {
+        ::printf("Failed to create checkpoint file: %s\n", _filename);
+        return false;
+    }
+    filename = _filename;
+    interval_us = interval_s * 1.0e6f;
+    reader = &_reader;
+    return true;
+}
+
+bool EKFCheckpoints::start_seek(const char *_filename, float seek_s, const AP_LoggerFileReader &_reader)
+{
+    auto &fs = AP::FS();
+    const int in_fd = fs.open(_filename, O_RDONLY, true);
+    if (in_fd == -1) {
+        ::printf("Failed to open checkpoint file: %s\n", _filename);
+        return false;
+    }
+    reader = &_reader;
+
+    FileHeader hdr;
+    if (fs.read(in_fd, &hdr, sizeof(hdr)) != sizeof(hdr) ||
+        memcmp(hdr.magic, checkpoint_magic, sizeof(hdr.magic)) != 0 ||
+        hdr.version != VERSION) {
+        ::printf("%s is not a checkpoint file\n", _filename);
+        fs.close(in_fd);
+        return false;
+    }
+    if (hdr.log_size != reader->get_file_size()) {
+        ::printf("%s was written for a different log\n", _filename);
+        fs.close(in_fd);
+        return false;
+    }
+    if (hdr.params_crc != user_params_crc()) {
+        ::printf("%s was written with different parameters\n", _filename);
+        fs.close(in_fd);
+        return false;
+    }
+
+    const uint64_t target_us = hdr.start_time_us + uint64_t(seek_s * 1.0e6f);
+    uint64_t log_start_us, log_end_us;
+    if (reader->indexed_time_range(log_start_us, log_end_us) && target_us > log_end_us) {
+        ::printf("Log ends at %.1fs\n", (log_end_us - hdr.start_time_us) * 1.0e-6);
+        fs.close(in_fd);
+        return false;
+    }
+
+    // find the last checkpoint at or before the target
+    CheckpointHeader best {};
+    int32_t best_pos = -1;
+    int32_t pos = sizeof(hdr);
+    CheckpointHeader ch;
+    while (fs.read(in_fd, &ch, sizeof(ch)) == sizeof(ch)) {
+        pos += sizeof(ch);
+        if (ch.time_us > target_us) {
+            break;
+        }
+        best = ch;
+        best_pos = pos;
+        pos = fs.lseek(in_fd, ch.length, SEEK_CUR);
+        if (pos == -1) {
+            break;
+        }
+    }
+    if (best_pos == -1) {
+        ::printf("No checkpoint before %.1fs, replaying from the start\n", seek_s);
+        fs.close(in_fd);
+        return true;
+    }
+
+    seek_data = NEW_NOTHROW uint8_t[best.length];
+    if (seek_data == nullptr ||
+        fs.lseek(in_fd, best_pos, SEEK_SET) != best_pos ||
+        fs.read(in_fd, seek_data, best.length) != int32_t(best.length)) {
+        ::printf("Failed to read checkpoint from %s\n", _filename);
+        delete[] seek_data;
+        seek_data = nullptr;
+        fs.close(in_fd);
+        return false;
+    }
+    fs.close(in_fd);
+
+    seek_len = best.length;
+    seek_msg = best.msg_num;
+    seek_time_us = best.time_us;
+    start_time_us = hdr.start_time_us;
+    ::printf("Seeking to checkpoint at %.1fs\n", (seek_time_us - start_time_us) * 1.0e-6);
+    return true;
+}
+
+void EKFCheckpoints::frame_done(bool ekf3_updated, NavEKF3 &ekf3)
+{
+    if (seeking()) {
+        if (reader->get_message_count() == seek_msg) {
+            resume(ekf3);
+        }
+        return;
+    }
+    if (fd == -1) {
+        return;
+    }
+
+    const uint64_t now_us = AP::dal().micros64();
+    if (start_time_us == 0) {
+        start_time_us = now_us;
+    }
+    if (!ekf3_updated || !AP::dal().ekf3_initialised() || now_us < next_save_us) {
+        return;
+    }
+    next_save_us = now_us + interval_us;
+    save(ekf3, now_us);
+}
+
+/*
+  append a checkpoint of the state after the current message
+ */
+void EKFCheckpoints::save(NavEKF3 &ekf3, uint64_t time_us)
+{
+    EKF_Checkpoint measure;
+    ekf3.checkpoint_save(measure);
+    const uint32_t len = measure.length();
+    uint8_t *buf = NEW_NOTHROW uint8_t[len];
+    if (buf == nullptr) {
+        return;
+    }
+    EKF_Checkpoint cp(buf, len);
+    ekf3.checkpoint_save(cp);
+
+    auto &fs = AP::FS();
+    bool ok = cp.ok();
+    if (num_saved == 0) {
+        FileHeader hdr {};
+        memcpy(hdr.magic, checkpoint_magic, sizeof(hdr.magic));
+        hdr.version = VERSION;
+        hdr.log_size = reader->get_file_size();
+        hdr.start_time_us = start_time_us;
+        hdr.params_crc = user_params_crc();
+        ok = ok && fs.write(fd, &hdr, sizeof(hdr)) == sizeof(hdr);
+    }
+    const CheckpointHeader ch {
+        time_us,
+        reader->get_message_count(),
+        len,
+    };
+    ok = ok &&
+        fs.write(fd, &ch, sizeof(ch)) == sizeof(ch) &&
+        fs.write(fd, buf, len) == int32_t(len);
+    delete[] buf;
+
+    if (!ok) {
+        ::printf("Failed to write checkpoint to %s\n", filename);
+        fs.close(fd);
+        fd = -1;
+        return;
+    }
+    num_saved++;
+}
+
+/*
+  restore EKF3 after the message the checkpoint was written after
+ */
+void EKFCheckpoints::resume(NavEKF3 &ekf3)
+{
+    // create and set up the cores, then overwrite their state
+    ekf3.InitialiseFilter();
+    EKF_Checkpoint cp((const uint8_t *)seek_data, seek_len);
+    if (!ekf3.checkpoint_load(cp) || cp.length() != seek_len) {
+        ::printf("Checkpoint doesn't match this build of Replay\n");
+        exit(1);
+    }
+    AP::dal().set_ekf3_initialised(true);
+
+    delete[] seek_data;
+    seek_data = nullptr;
+    ::printf("Resumed EKF3 at %.1fs\n", (seek_time_us - start_time_us) * 1.0e-6);
+}
+
+#endif  // AP_NAVEKF_CHECKPOINT_ENABLED
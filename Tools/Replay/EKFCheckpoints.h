@@ -0,0 +1,76 @@
+#pragma once
+
+#include <AP_NavEKF3/AP_NavEKF3.h>
+
+#if AP_NAVEKF_CHECKPOINT_ENABLED
+
+class AP_LoggerFileReader;
+
+/*
+  checkpoints of the EKF3 state, written every few seconds of log
+  time so a later replay of the same log, by the same build and with
+  the same parameters, can start near a time of interest.
+
+  When seeking, the messages before the checkpoint are handled with
+  EKF3 frames removed, leaving the DAL and parameters as they were
+  when the checkpoint was written, then the EKF3 state is restored
+  and the replay carries on from there. EKF2 isn't checkpointed, so
+  it runs through the whole log as usual
+ */
+class EKFCheckpoints
+{
+public:
+    // write a checkpoint every interval_s seconds of log time
+    bool start_writing(const char *filename, float interval_s, const AP_LoggerFileReader &reader);
+
+    // resume EKF3 from the last checkpoint at or before seek_s
+    // seconds into the log
+    bool start_seek(const char *filename, float seek_s, const AP_LoggerFileReader &reader);
+
+    // true while handling the messages before the checkpoint being
+    // resumed from
+    bool seeking() const { return seek_data != nullptr; }
+
+    // called after each EKF frame message
+    void frame_done(bool ekf3_updated, NavEKF3 &ekf3);
+
+private:
+    struct PACKED FileHeader {
+        char magic[4];
+        uint16_t version;
+        uint64_t log_size;
+        uint64_t start_time_us;     // time of the first frame of the log
+        uint32_t params_crc;        // of the parameters given to Replay
+    };
+    struct PACKED CheckpointHeader {
+        uint64_t time_us;
+        uint32_t msg_num;           // message the checkpoint follows
+        uint32_t length;
+    };
+    static constexpr uint16_t VERSION = 1;
+
+    static uint32_t user_params_crc();
+
+    void save(NavEKF3 &ekf3, uint64_t time_us);
+    void resume(NavEKF3 &ekf3);
+
+    const AP_LoggerFileReader *reader;
+
+    // writing
+    int fd = -1;
+    const char *filename;
+    uint64_t interval_us;
+    uint64_t start_time_us;
+    uint64_t next_save_us;
+    uint32_t num_saved;
+
+    // seeking
+    uint8_t *seek_data;
+    uint32_t seek_len;
+    uint32_t seek_msg;
+    uint64_t seek_time_us;
+};
+
+extern EKFCheckpoints ekf_checkpoints;
+
+#endif  // AP_NAVEKF_CHECKPOINT_ENABLED
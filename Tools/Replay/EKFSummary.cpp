@@ -0,0 +1,86 @@
+#include "EKFSummary.h"
+
+#include <stdio.h>
+
+EKFSummary ekf_summary;
+
+template <class EKF>
+void EKFSummary::update(Stats &stats, const EKF &ekf)
+{
+    if (ekf.activeCores() == 0) {
+        return;
+    }
+    stats.frames++;
+    if (!ekf.healthy()) {
+        stats.unhealthy++;
+    }
+
+    const int8_t primary = ekf.getPrimaryCoreIndex();
+    if (stats.primary != -1 && primary != stats.primary) {
+        stats.lane_switches++;
+    }
+    stats.primary = primary;
+
+    uint16_t faults;
+    ekf.getFilterFaults(faults);
+    stats.faults |= faults;
+
+    float ratio[NUM_RATIOS];
+    Vector3f mag_ratio;
+    Vector2f offset;
+    if (!ekf.getVariances(ratio[RATIO_VEL], ratio[RATIO_POS], ratio[RATIO_HGT], mag_ratio, ratio[RATIO_TAS], offset)) {
+        return;
+    }
+    ratio[RATIO_MAG] = MAX(MAX(mag_ratio.x, mag_ratio.y), mag_ratio.z);
+    stats.ratio_frames++;
+
+    bool failed = false;
+    for (uint8_t i=0; i<NUM_RATIOS; i++) {
+        stats.max_ratio[i] = MAX(stats.max_ratio[i], ratio[i]);
+        stats.sum_ratio[i] += ratio[i];
+        failed |= ratio[i] > 1;
+    }
+    if (failed) {
+        stats.innovation_failures++;
+    }
+}
+
+void EKFSummary::update(const NavEKF2 &ekf2)
+{
+    update(ekf2_stats, ekf2);
+}
+
+void EKFSummary::update(const NavEKF3 &ekf3)
+{
+    update(ekf3_stats, ekf3);
+}
+
+void EKFSummary::print(int fd) const
+{
+    print(fd, "EKF2", ekf2_stats);
+    print(fd, "EKF3", ekf3_stats);
+}
+
+void EKFSummary::print(int fd, const char *name, const Stats &stats) const
+{
+    if (stats.frames == 0) {
+        return;
+    }
+    static const char *ratio_names[NUM_RATIOS] { "vel", "pos", "hgt", "mag", "tas" };
+    ::dprintf(fd, "%s frames=%u unhealthy=%u innov_fail=%u lane_switch=%u faults=0x%04x",
+              name,
+              unsigned(stats.frames),
+              unsigned(stats.unhealthy),
+              unsigned(stats.innovation_failures),
+              unsigned(stats.lane_switches),
+              unsigned(stats.faults));
+    // maximum and mean of each test ratio, over the frames where the
+    // EKF had test ratios to give
+    for (uint8_t i=0; i<NUM_RATIOS && stats.ratio_frames > 0; i++) {
+        ::dprintf(fd, " %s=%.3f/%.3f",
+                  ratio_names[i],
+                  stats.max_ratio[i],
+                  stats.sum_ratio[i] / stats.ratio_frames);
+    }
+    ::dprintf(fd, "\n");
+}
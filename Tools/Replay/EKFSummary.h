@@ -0,0 +1,48 @@
+#pragma once
+
+#include <AP_NavEKF2/AP_NavEKF2.h>
+#include <AP_NavEKF3/AP_NavEKF3.h>
+
+/*
+  summary of how the EKFs behaved over a replay, for comparing many
+  logs replayed with different parameters
+ */
+class EKFSummary
+{
+public:
+    // called after each EKF update frame
+    void update(const NavEKF2 &ekf2);
+    void update(const NavEKF3 &ekf3);
+
+    // write a line for each EKF which ran to a file descriptor
+    void print(int fd) const;
+
+private:
+    // innovation test ratios returned by getVariances()
+    enum {
+        RATIO_VEL,
+        RATIO_POS,
+        RATIO_HGT,
+        RATIO_MAG,
+        RATIO_TAS,
+        NUM_RATIOS
+    };
+
+    struct Stats {
+        uint32_t frames;
+        uint32_t unhealthy;             // frames the EKF was unhealthy
+        uint32_t innovation_failures;   // frames with a test ratio over 1
+        uint32_t lane_switches;
+        int8_t primary = -1;
+        uint16_t faults;                // all faults seen
+        uint32_t ratio_frames;          // frames with test ratios
+        float max_ratio[NUM_RATIOS];
+        double sum_ratio[NUM_RATIOS];
+    } ekf2_stats, ekf3_stats;
+
+    template <class EKF>
+    void update(Stats &stats, const EKF &ekf);
+    void print(int fd, const char *name, const Stats &stats) const;
+};
+
+extern EKFSummary ekf_summary;
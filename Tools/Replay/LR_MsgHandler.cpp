@@ -1,6 +1,8 @@
 #include "LR_MsgHandler.h"
 #include "LogReader.h"
 #include "Replay.h"
+#include "EKFSummary.h"
+#include "EKFCheckpoints.h"
 
 #include <AP_DAL/AP_DAL.h>
 
@@ -38,7 +40,28 @@ void LR_MsgHandler_RFRF::process_message(uint8_t *msgbytes)
         MAP_FLAG(AP_DAL::FrameType::LogWriteEKF2, AP_DAL::FrameType::LogWriteEKF3);
     }
 #undef MAP_FLAG
+#if AP_NAVEKF_CHECKPOINT_ENABLED
+    /*
+      before the checkpoint being resumed from EKF3 doesn't run, the
+      rest of the frame still updates the DAL
+     */
+    if (ekf_checkpoints.seeking()) {
+        msg.frame_types &= ~uint8_t(uint8_t(AP_DAL::FrameType::InitialiseFilterEKF3) |
+                                    uint8_t(AP_DAL::FrameType::UpdateFilterEKF3) |
+                                    uint8_t(AP_DAL::FrameType::LogWriteEKF3));
+    }
+#endif
     AP::dal().handle_message(msg, ekf2, ekf3);
+
+    if (msg.frame_types & uint8_t(AP_DAL::FrameType::UpdateFilterEKF2)) {
+        ekf_summary.update(ekf2);
+    }
+    if (msg.frame_types & uint8_t(AP_DAL::FrameType::UpdateFilterEKF3)) {
+        ekf_summary.update(ekf3);
+    }
+#if AP_NAVEKF_CHECKPOINT_ENABLED
+    ekf_checkpoints.frame_done(msg.frame_types & uint8_t(AP_DAL::FrameType::UpdateFilterEKF3), ekf3);
+#endif
 }
 
 void LR_MsgHandler_RFRN::process_message(uint8_t *msgbytes)
@@ -2,6 +2,7 @@
 
 #include "MsgHandler.h"
 #include "Replay.h"
+#include "EKFCheckpoints.h"
 
 #include <stdio.h>
 #include <unistd.h>
@@ -59,6 +60,11 @@ bool LogReader::handle_log_format_msg(const struct log_Format &f)
         return true;
     }
 
+    // the output of a replay resumed from a checkpoint still needs
+    // the parameters and metadata
+    static const char *seek_copy_types[] = { "PARM", "FMTU", "UNIT", "MULT", NULL };
+    copy_while_seeking[f.type] = in_list(name, seek_copy_types);
+
     // map from format name to a parser subclass:
 	if (streq(name, "PARM")) {
         msgparser[f.type] = NEW_NOTHROW LR_MsgHandler_PARM(formats[f.type]);
@@ -130,12 +136,25 @@ bool LogReader::handle_log_format_msg(const struct log_Format &f)
         // debug("  No parser for (%s)\n", name);
     }
 
+#if AP_NAVEKF_CHECKPOINT_ENABLED
+    // before the checkpoint nothing is done with these
+    if (ekf_checkpoints.seeking() && msgparser[f.type] == NULL && !copy_while_seeking[f.type]) {
+        set_skip_type(f.type, true);
+        skipping_types = true;
+    }
+#endif
+
     return true;
 }
 
 bool LogReader::handle_msg(const struct log_Format &f, uint8_t *msg) {
     // emit the output as we receive it:
-    AP::logger().WriteBlock(msg, f.length);
+#if AP_NAVEKF_CHECKPOINT_ENABLED
+    if (!ekf_checkpoints.seeking() || copy_while_seeking[f.type])
+#endif
+    {
+        AP::logger().WriteBlock(msg, f.length);
+    }
 
     LR_MsgHandler *p = msgparser[f.type];
     if (p == NULL) {
@@ -144,6 +163,16 @@ bool LogReader::handle_msg(const struct log_Format &f, uint8_t *msg) {
 
     p->process_message(msg);
 
+#if AP_NAVEKF_CHECKPOINT_ENABLED
+    if (skipping_types && !ekf_checkpoints.seeking()) {
+        // resumed from the checkpoint
+        for (uint16_t i=0; i<LOGREADER_MAX_FORMATS; i++) {
+            set_skip_type(i, false);
+        }
+        skipping_types = false;
+    }
+#endif
+
     return true;
 }
 
@@ -31,6 +31,12 @@ private:
     uint8_t _log_structure_count;
 
     class LR_MsgHandler *msgparser[LOGREADER_MAX_FORMATS] {};
+
+    // types copied to the output while seeking to a checkpoint
+    bool copy_while_seeking[LOGREADER_MAX_FORMATS] {};
+
+    // types with no handler are stepped over while seeking
+    bool skipping_types = false;
 };
 
 // some vars are difficult to get through the layers
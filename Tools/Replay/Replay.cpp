@@ -16,11 +16,14 @@
 #include "Replay.h"
 
 #include "LogReader.h"
+#include "EKFSummary.h"
+#include "EKFCheckpoints.h"
 
 #include <stdio.h>
 #include <AP_HAL/utility/getopt_cpp.h>
 
 #include <AP_Vehicle/AP_Vehicle.h>
+#include <AP_DAL/AP_DAL.h>
 
 #include <GCS_MAVLink/GCS_Dummy.h>
 #include <AP_Filesystem/AP_Filesystem.h>
@@ -31,6 +34,16 @@
 #include <AP_HAL_Linux/Scheduler.h>
 #endif
 
+#if AP_REPLAY_BATCH_ENABLED
+#include <errno.h>
+#include <fcntl.h>
+#include <limits.h>
+#include <stdlib.h>
+#include <sys/stat.h>
+#include <sys/wait.h>
+#include <unistd.h>
+#endif
+
 #define streq(x, y) (!strcmp(x, y))
 
 static ReplayVehicle replayvehicle;
@@ -126,11 +139,28 @@ void Replay::usage(void)
     ::printf("\t--force-ekf2 force enable EKF2\n");
     ::printf("\t--force-ekf3 force enable EKF3\n");
     ::printf("\t--progress  show a progress bar during replay\n");
+#if AP_REPLAY_BATCH_ENABLED
+    ::printf("\t--jobs N  replay N logs at a time when given several logs (default one per CPU)\n");
+    ::printf("\t--batch FILENAME  replay the logs listed in a file, one per line\n");
+    ::printf("\t--batch-dir DIR  directory for the output of each log (default replay_batch)\n");
+#endif
+#if AP_NAVEKF_CHECKPOINT_ENABLED
+    ::printf("\t--checkpoint-file FILENAME  EKF3 checkpoint file to write, or to read with --seek\n");
+    ::printf("\t--checkpoint-interval SECONDS  log time between checkpoints (default 10)\n");
+    ::printf("\t--seek SECONDS  resume EKF3 from the last checkpoint before SECONDS into the log\n");
+#endif
+    ::printf("\t--stop SECONDS  stop SECONDS into the log\n");
 }
 
 enum param_key : uint8_t {
     FORCE_EKF2 = 1,
     FORCE_EKF3,
+    BATCH_LIST,
+    BATCH_DIR,
+    CHECKPOINT_FILE,
+    CHECKPOINT_INTERVAL,
+    SEEK,
+    STOP,
 };
 
 void Replay::_parse_command_line(uint8_t argc, char * const argv[])
@@ -143,11 +173,22 @@ void Replay::_parse_command_line(uint8_t argc, char * const argv[])
         {"force-ekf2",      false,  0, param_key::FORCE_EKF2},
         {"force-ekf3",      false,  0, param_key::FORCE_EKF3},
         {"progress",        false,  0, 'P'},
+#if AP_REPLAY_BATCH_ENABLED
+        {"jobs",            true,   0, 'j'},
+        {"batch",           true,   0, param_key::BATCH_LIST},
+        {"batch-dir",       true,   0, param_key::BATCH_DIR},
+#endif
+#if AP_NAVEKF_CHECKPOINT_ENABLED
+        {"checkpoint-file",     true,   0, param_key::CHECKPOINT_FILE},
+        {"checkpoint-interval", true,   0, param_key::CHECKPOINT_INTERVAL},
+        {"seek",                true,   0, param_key::SEEK},
+#endif
+        {"stop",            true,   0, param_key::STOP},
         {"help",            false,  0, 'h'},
         {0, false, 0, 0}
     };
 
-    GetOptLong gopt(argc, argv, "p:F:Ph", options);
+    GetOptLong gopt(argc, argv, "p:F:Pj:h", options);
 
     int opt;
     while ((opt = gopt.getoption()) != -1) {
@@ -182,6 +223,54 @@ void Replay::_parse_command_line(uint8_t argc, char * const argv[])
             show_progress = true;
             break;
 
+#if AP_REPLAY_BATCH_ENABLED
+        case 'j':
+            batch_jobs = atoi(gopt.optarg);
+            if (batch_jobs == 0) {
+                ::printf("Usage: --jobs N\n");
+                exit(1);
+            }
+            break;
+
+        case param_key::BATCH_LIST:
+            load_batch_list(gopt.optarg);
+            break;
+
+        case param_key::BATCH_DIR:
+            batch_dir = gopt.optarg;
+            break;
+#endif
+
+#if AP_NAVEKF_CHECKPOINT_ENABLED
+        case param_key::CHECKPOINT_FILE:
+            checkpoint_file = gopt.optarg;
+            break;
+
+        case param_key::CHECKPOINT_INTERVAL:
+            checkpoint_interval_s = atof(gopt.optarg);
+            if (checkpoint_interval_s <= 0) {
+                ::printf("Usage: --checkpoint-interval SECONDS\n");
+                exit(1);
+            }
+            break;
+
+        case param_key::SEEK:
+            seek_s = atof(gopt.optarg);
+            if (seek_s <= 0) {
+                ::printf("Usage: --seek SECONDS\n");
+                exit(1);
+            }
+            break;
+#endif
+
+        case param_key::STOP:
+            stop_s = atof(gopt.optarg);
+            if (stop_s <= 0) {
+                ::printf("Usage: --stop SECONDS\n");
+                exit(1);
+            }
+            break;
+
         case 'h':
         default:
             usage();
@@ -192,11 +281,219 @@ void Replay::_parse_command_line(uint8_t argc, char * const argv[])
     argv += gopt.optind;
     argc -= gopt.optind;
 
+#if AP_REPLAY_BATCH_ENABLED
+    if (num_batch_logs > 0 || argc > 1 || batch_jobs > 0) {
+#if AP_NAVEKF_CHECKPOINT_ENABLED
+        if (checkpoint_file != nullptr) {
+            ::printf("Checkpoints can't be used with several logs\n");
+            exit(1);
+        }
+#endif
+        for (uint8_t i=0; i<argc; i++) {
+            if (!add_batch_log(argv[i])) {
+                exit(1);
+            }
+        }
+        return;
+    }
+#endif
+
     if (argc > 0) {
         filename = argv[0];
     }
 }
 
+#if AP_REPLAY_BATCH_ENABLED
+/*
+  add a log to the batch.  Children change directory before opening
+  their log, so the absolute path is kept
+ */
+bool Replay::add_batch_log(const char *path)
+{
+    char *abs_path = realpath(path, nullptr);
+    if (abs_path == nullptr) {
+        ::printf("%s: %m\n", path);
+        return false;
+    }
+    if (num_batch_logs == max_batch_logs) {
+        const uint32_t new_max = MAX(max_batch_logs * 2, 16U);
+        char **new_logs = (char **)realloc(batch_logs, new_max * sizeof(batch_logs[0]));
+        if (new_logs == nullptr) {
+            free(abs_path);
+            return false;
+        }
+        batch_logs = new_logs;
+        max_batch_logs = new_max;
+    }
+    batch_logs[num_batch_logs++] = abs_path;
+    return true;
+}
+
+/*
+  add the logs listed in a file to the batch, ignoring blank lines
+  and comments
+ */
+void Replay::load_batch_list(const char *list_filename)
+{
+    auto &fs = AP::FS();
+    int fd = fs.open(list_filename, O_RDONLY, true);
+    if (fd == -1) {
+        ::printf("Failed to open batch list: %s\n", list_filename);
+        exit(1);
+    }
+    char line[256];
+    while (fs.fgets(line, sizeof(line)-1, fd)) {
+        if (line[0] == 0 || line[0] == '#') {
+            continue;
+        }
+        if (!add_batch_log(line)) {
+            exit(1);
+        }
+    }
+    fs.close(fd);
+}
+
+/*
+  replay each log of the batch in a child process, running up to
+  batch_jobs at a time.  The EKF libraries, parameters and logger are
+  all process-wide, so a process per log keeps each replay the same as
+  if it had been run on its own.  Each child works in a directory of
+  its own under batch_dir, so the logs and parameter storage of
+  different logs don't collide, and writes its EKF summary there to
+  be printed when it finishes.
+
+  This only returns in a child, which goes on to replay its log
+ */
+void Replay::run_batch()
+{
+    if (batch_jobs == 0) {
+        batch_jobs = constrain_int32(sysconf(_SC_NPROCESSORS_ONLN), 1, UINT16_MAX);
+    }
+    if (mkdir(batch_dir, 0755) != 0 && errno != EEXIST) {
+        ::printf("mkdir(%s): %m\n", batch_dir);
+        exit(1);
+    }
+
+    // process and log index of each running child
+    pid_t *pids = NEW_NOTHROW pid_t[batch_jobs];
+    uint32_t *job_logs = NEW_NOTHROW uint32_t[batch_jobs];
+    if (pids == nullptr || job_logs == nullptr) {
+        ::printf("Out of memory\n");
+        exit(1);
+    }
+
+    // make sure output written so far isn't repeated by the children
+    ::fflush(nullptr);
+
+    uint32_t next_log = 0;
+    uint16_t running = 0;
+    while (next_log < num_batch_logs || running > 0) {
+        if (next_log < num_batch_logs && running < batch_jobs) {
+            const pid_t pid = fork();
+            if (pid == -1) {
+                ::printf("fork: %m\n");
+                exit(1);
+            }
+            if (pid == 0) {
+                delete[] pids;
+                delete[] job_logs;
+                start_batch_log(next_log);
+                return;
+            }
+            pids[running] = pid;
+            job_logs[running] = next_log;
+            running++;
+            next_log++;
+            continue;
+        }
+
+        int status;
+        const pid_t pid = wait(&status);
+        if (pid == -1) {
+            ::printf("wait: %m\n");
+            exit(1);
+        }
+        for (uint16_t j=0; j<running; j++) {
+            if (pids[j] != pid) {
+                continue;
+            }
+            report_batch_log(job_logs[j], status);
+            running--;
+            pids[j] = pids[running];
+            job_logs[j] = job_logs[running];
+            break;
+        }
+    }
+
+    ::printf("Replayed %u logs, %u failed\n", unsigned(num_batch_logs), unsigned(batch_failures));
+    exit(batch_failures == 0 ? 0 : 1);
+}
+
+/*
+  set up a child to replay log i of the batch
+ */
+void Replay::start_batch_log(uint32_t i)
+{
+    char dir[PATH_MAX];
+    snprintf(dir, sizeof(dir), "%s/%05u", batch_dir, unsigned(i));
+    if ((mkdir(dir, 0755) != 0 && errno != EEXIST) || chdir(dir) != 0) {
+        ::printf("%s: %m\n", dir);
+        exit(1);
+    }
+    unlink("summary.txt");
+
+    // keep the output of each log apart
+    const int out_fd = ::open("replay.txt", O_WRONLY|O_CREAT|O_TRUNC, 0644);
+    if (out_fd == -1) {
+        exit(1);
+    }
+    dup2(out_fd, STDOUT_FILENO);
+    dup2(out_fd, STDERR_FILENO);
+    ::close(out_fd);
+
+    filename = batch_logs[i];
+    in_batch = true;
+}
+
+/*
+  print the summary a child left for log i of the batch
+ */
+void Replay::report_batch_log(uint32_t i, int status)
+{
+    const char *log = batch_logs[i];
+    if (WIFSIGNALED(status)) {
+        ::printf("%s: killed by signal %d\n", log, WTERMSIG(status));
+        batch_failures++;
+        return;
+    }
+    if (!WIFEXITED(status) || WEXITSTATUS(status) != 0) {
+        ::printf("%s: failed with status %d\n", log, WEXITSTATUS(status));
+        batch_failures++;
+        return;
+    }
+
+    char path[PATH_MAX];
+    snprintf(path, sizeof(path), "%s/%05u/summary.txt", batch_dir, unsigned(i));
+    auto &fs = AP::FS();
+    int fd = fs.open(path, O_RDONLY, true);
+    if (fd == -1) {
+        ::printf("%s: no summary\n", log);
+        return;
+    }
+    char line[256];
+    bool have_summary = false;
+    while (fs.fgets(line, sizeof(line)-1, fd)) {
+        ::printf("%s: %s\n", log, line);
+        have_summary = true;
+    }
+    fs.close(fd);
+    if (!have_summary) {
+        // the EKFs never ran
+        ::printf("%s: no EKF updates\n", log);
+    }
+}
+#endif  // AP_REPLAY_BATCH_ENABLED
+
 static const LogStructure EKF2_log_structures[] = {
     { LOG_FORMAT_UNITS_MSG, sizeof(log_Format_Units), \
       "FMTU", "QBNN",      "TimeUS,FmtType,UnitIds,MultIds","s---", "F---" },   \
@@ -258,6 +555,14 @@ void Replay::setup()
         _parse_command_line(argc, argv);
     }
 
+#if AP_REPLAY_BATCH_ENABLED
+    if (num_batch_logs > 0) {
+        // the rest of setup happens in the children, each of which
+        // replays one log
+        run_batch();
+    }
+#endif
+
     _vehicle.setup();
 
     set_user_parameters();
@@ -292,11 +597,64 @@ void Replay::setup()
     if (replay_force_ekf2) {
         write_EKF_formats();
     }
+
+#if AP_NAVEKF_CHECKPOINT_ENABLED
+    if (seek_s > 0 && checkpoint_file == nullptr) {
+        ::printf("--seek needs a --checkpoint-file\n");
+        exit(1);
+    }
+    if (checkpoint_file != nullptr) {
+        const bool ok = seek_s > 0 ?
+            ekf_checkpoints.start_seek(checkpoint_file, seek_s, reader) :
+            ekf_checkpoints.start_writing(checkpoint_file, checkpoint_interval_s, reader);
+        if (!ok) {
+            exit(1);
+        }
+    }
+#endif
+
+    if (stop_s > 0) {
+        // stop reading within a bucket of the stop time, the last
+        // frames before it are found from the DAL time
+        uint64_t start_us, end_us, end_ofs;
+        if (reader.indexed_time_range(start_us, end_us) &&
+            reader.indexed_offset(start_us + uint64_t(stop_s * 1.0e6f) + LOGREADER_TIME_BUCKET_US, end_ofs)) {
+            reader.set_end_offset(end_ofs);
+        }
+    }
+}
+
+/*
+  true once the DAL has passed the --stop time
+ */
+bool Replay::past_stop()
+{
+    if (stop_s <= 0) {
+        return false;
+    }
+    const uint64_t now_us = AP::dal().micros64();
+    if (now_us == 0) {
+        return false;
+    }
+    if (stop_start_us == 0) {
+        stop_start_us = now_us;
+    }
+    return now_us - stop_start_us > uint64_t(stop_s * 1.0e6f);
 }
 
 void Replay::loop()
 {
-    if (!reader.update()) {
+    if (!reader.update() || past_stop()) {
+        ::fflush(nullptr);
+        int summary_fd = STDOUT_FILENO;
+#if AP_REPLAY_BATCH_ENABLED
+        if (in_batch) {
+            summary_fd = ::open("summary.txt", O_WRONLY|O_CREAT|O_TRUNC, 0644);
+        }
+#endif
+        if (summary_fd != -1) {
+            ekf_summary.print(summary_fd);
+        }
 #if CONFIG_HAL_BOARD == HAL_BOARD_LINUX
     // If we don't tear down the threads then they continue to access
     // global state during object destruction.
@@ -21,6 +21,11 @@
 
 #define AP_PARAM_VEHICLE_NAME replayvehicle
 
+// replay many logs at once, each in its own process
+#ifndef AP_REPLAY_BATCH_ENABLED
+#define AP_REPLAY_BATCH_ENABLED (CONFIG_HAL_BOARD == HAL_BOARD_SITL)
+#endif
+
 struct user_parameter {
     struct user_parameter *next;
     char name[17];
@@ -112,4 +117,32 @@ private:
 
     void Write_Format(const struct LogStructure &s);
     void write_EKF_formats(void);
+
+    // --stop time in seconds from the first frame of the log
+    float stop_s;
+    uint64_t stop_start_us;
+    bool past_stop();
+
+#if AP_NAVEKF_CHECKPOINT_ENABLED
+    const char *checkpoint_file;
+    float checkpoint_interval_s = 10;
+    float seek_s;
+#endif
+
+#if AP_REPLAY_BATCH_ENABLED
+    // logs to replay in batch mode
+    char **batch_logs;
+    uint32_t num_batch_logs;
+    uint32_t max_batch_logs;
+    uint16_t batch_jobs;
+    const char *batch_dir = "replay_batch";
+    uint32_t batch_failures;
+    bool in_batch;  // true in the process replaying one of a batch
+
+    bool add_batch_log(const char *path);
+    void load_batch_list(const char *filename);
+    void run_batch();
+    void start_batch_log(uint32_t i);
+    void report_batch_log(uint32_t i, int status);
+#endif
 };
@@ -85,6 +85,74 @@ def check_log(logfile, progress=print, ekf2_only=False, ekf3_only=False, verbose
         return False
     return True
 
+def replayed_ekf3_messages(logfile):
+    '''return the EKF3 messages written by replay, keyed by type, core and time'''
+    from pymavlink import mavutil
+    mlog = mavutil.mavlink_connection(logfile)
+    ek3_list = ['XKF1','XKF2','XKF3','XKF4','XKF0','XKFS','XKQ','XKFD','XKV1','XKV2','XKY0','XKY1']
+    ret = {}
+    while True:
+        m = mlog.recv_match(type=ek3_list)
+        if m is None:
+            break
+        if not hasattr(m,'C') or m.C < 100:
+            continue
+        key = (m.get_type(), m.C, m.TimeUS)
+        if key not in ret:
+            ret[key] = []
+        ret[key].append(m)
+    return ret
+
+def compare_ekf3_messages(expected, actual, progress):
+    '''return the number of EKF3 messages in actual which are not
+    exactly the same as in expected'''
+    errors = 0
+    for key in sorted(actual.keys(), key=lambda k: k[2]):
+        if key not in expected or len(expected[key]) != len(actual[key]):
+            progress("Unmatched %s C=%u TimeUS=%u" % key)
+            errors += 1
+            continue
+        for (m, mb) in zip(actual[key], expected[key]):
+            for f in m._fieldnames:
+                v1 = getattr(m,f)
+                v2 = getattr(mb,f)
+                # NaN fields match each other
+                if v1 != v2 and not (v1 != v1 and v2 != v2):
+                    errors += 1
+                    progress("Mismatch in field %s.%s at %u: %s %s" % (key[0], f, key[2], str(v1), str(v2)))
+    return errors
+
+def check_seek(straight_logfile, seek_logfile, progress=print):
+    '''check a replay resumed from an EKF3 checkpoint gives exactly the
+    same EKF3 output as a replay of the whole log'''
+    progress("Comparing %s with %s" % (seek_logfile, straight_logfile))
+    straight = replayed_ekf3_messages(straight_logfile)
+    seek = replayed_ekf3_messages(seek_logfile)
+    if len(seek) == 0:
+        progress("No EKF3 output after seeking")
+        return False
+    errors = compare_ekf3_messages(straight, seek, progress)
+    progress("Compared %u times after seeking, %u errors" % (len(seek), errors))
+    return errors == 0
+
+def check_same(reference_logfile, logfile, progress=print):
+    '''check two replays of the same log, for example with and without
+    an EKF3 option that must not change the results, give exactly the
+    same EKF3 output'''
+    progress("Comparing %s with %s" % (logfile, reference_logfile))
+    reference = replayed_ekf3_messages(reference_logfile)
+    other = replayed_ekf3_messages(logfile)
+    if len(other) == 0:
+        progress("No EKF3 output")
+        return False
+    errors = compare_ekf3_messages(reference, other, progress)
+    for key in reference.keys():
+        if key not in other:
+            progress("Missing %s C=%u TimeUS=%u" % key)
+            errors += 1
+    progress("Compared %u times, %u errors" % (len(other), errors))
+    return errors == 0
+
 if __name__ == '__main__':
     import sys
     from argparse import ArgumentParser
@@ -94,13 +162,21 @@ if __name__ == '__main__':
     parser.add_argument("--verbose", action='store_true', help="verbose output")
     parser.add_argument("--accuracy", type=float, default=0.0, help="accuracy percentage for match")
     parser.add_argument("--ignore-field", action='append', default=[], help="ignore message field when comparing")
+    parser.add_argument("--seek-of", metavar="LOG", default=None, help="check the logs are seeks within this replay log")
+    parser.add_argument("--same-as", metavar="LOG", default=None, help="check the logs have the same EKF3 output as this replay log")
     parser.add_argument("logs", metavar="LOG", nargs="+")
 
     args = parser.parse_args()
 
     failed = False
     for filename in args.logs:
-        if not check_log(filename, print, args.ekf2_only, args.ekf3_only, args.verbose, accuracy=args.accuracy, ignores=args.ignore_field):
+        if args.seek_of is not None:
+            if not check_seek(args.seek_of, filename, print):
+                failed = True
+        elif args.same_as is not None:
+            if not check_same(args.same_as, filename, print):
+                failed = True
+        elif not check_log(filename, print, args.ekf2_only, args.ekf3_only, args.verbose, accuracy=args.accuracy, ignores=args.ignore_field):
             failed = True
 
     if failed:
@@ -10952,7 +10952,46 @@ class AutoTestCopter(vehicle_test_suite.TestSuite):
         ]
         for (name, func) in bits:
             self.start_subtest("%s" % name)
-            self.test_replay_bit(func)
+            log_filepath = self.test_replay_bit(func)
+            if name == 'GPS':
+                self.start_subtest("Seek")
+                self.test_replay_seek(log_filepath)
+                self.start_subtest("ThreadedLanes")
+                self.test_replay_threaded_lanes(log_filepath)
+
+    def test_replay_seek(self, log_filepath):
+        '''check EKF3 resumed from a checkpoint matches a replay of the whole log'''
+        checkpoint_filepath = "replay-checkpoints.bin"
+        self.progress("Writing EKF3 checkpoints")
+        straight_log_filepath = self.run_replay(log_filepath, [
+            "--checkpoint-file", checkpoint_filepath,
+            "--checkpoint-interval", "5",
+        ])
+        self.progress("Seeking")
+        seek_log_filepath = self.run_replay(log_filepath, [
+            "--checkpoint-file", checkpoint_filepath,
+            "--seek", "30",
+        ])
+        os.unlink(util.reltopdir(checkpoint_filepath))
+
+        check_replay = util.load_local_module("Tools/Replay/check_replay.py")
+        if not check_replay.check_seek(straight_log_filepath, seek_log_filepath, self.progress):
+            raise NotAchievedException("check_replay seek (%s) failed" % log_filepath)
+
+    def test_replay_threaded_lanes(self, log_filepath):
+        '''check EKF3 lanes run on their own threads give exactly the same results as lanes run one after another'''
+        self.progress("Replaying with lanes run one after another")
+        sequential_log_filepath = self.run_replay(log_filepath, [
+            "--parm", "EK3_OPTIONS=0",
+        ])
+        self.progress("Replaying with threaded lanes")
+        threaded_log_filepath = self.run_replay(log_filepath, [
+            "--parm", "EK3_OPTIONS=8",
+        ])
+
+        check_replay = util.load_local_module("Tools/Replay/check_replay.py")
+        if not check_replay.check_same(sequential_log_filepath, threaded_log_filepath, self.progress):
+            raise NotAchievedException("check_replay threaded lanes (%s) failed" % log_filepath)
 
     def test_replay_bit(self, bit):
 
@@ -10977,6 +11016,8 @@ class AutoTestCopter(vehicle_test_suite.TestSuite):
         if not ok:
             raise NotAchievedException("check_replay (%s) failed" % current_log_filepath)
 
+        return current_log_filepath
+
     def DefaultIntervalsFromFiles(self):
         '''Test setting default mavlink message intervals from files'''
         ex = None
@@ -12002,7 +12043,7 @@ class AutoTestCopter(vehicle_test_suite.TestSuite):
 
     def PerfInfo(self):
         '''Test Scheduler PerfInfo output'''
-        self.set_parameter('SCHED_OPTIONS', 1)  # enable gathering
+        self.set_parameter('SCHED_OPTIONS', 3)  # enable gathering and latency histograms
         # sometimes we need to trigger collection....
         content = self.fetch_file_via_ftp("@SYS/tasks.txt")
         self.delay_sim_time(5)
@@ -12011,8 +12052,8 @@ class AutoTestCopter(vehicle_test_suite.TestSuite):
 
         lines = content.split("\n")
 
-        if not lines[0].startswith("TasksV2"):
-            raise NotAchievedException("Expected TasksV2 as first line first not (%s)" % lines[0])
+        if not lines[0].startswith("TasksV3"):
+            raise NotAchievedException("Expected TasksV3 as first line first not (%s)" % lines[0])
         # last line is empty, so -2 here
         if not lines[-2].startswith("AP_Vehicle::update_arming"):
             raise NotAchievedException("Expected EFI last not (%s)" % lines[-2])
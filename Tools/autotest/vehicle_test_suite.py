@@ -14222,10 +14222,12 @@ switch value'''
         # heading seemingly indefinitely.
         self.reboot_sitl()
 
-    def run_replay(self, filepath):
+    def run_replay(self, filepath, args=None):
         '''runs replay in filepath, returns filepath to Replay logfile'''
+        if args is None:
+            args = []
         util.run_cmd(
-            ['build/sitl/tool/Replay', filepath],
+            ['build/sitl/tool/Replay'] + args + [filepath],
             directory=util.topdir(),
             checkfail=True,
             show=True,
@@ -0,0 +1,93 @@
+#!/usr/bin/env python3
+
+'''
+decompress a DataFlash log written with LOG_FILE_COMPR=1 into a plain
+.BIN log readable by the usual log tools
+
+AP_FLAKE8_CLEAN
+'''
+
+import argparse
+import struct
+import sys
+
+FILE_MAGIC = b'APLZ'
+BLOCK_STORED = 0x8000
+MIN_MATCH = 4
+
+
+def lz4_block_decompress(src, raw_len):
+    '''decode one LZ4 format block'''
+    out = bytearray()
+    i = 0
+    while i < len(src):
+        token = src[i]
+        i += 1
+        lit = token >> 4
+        if lit == 15:
+            while True:
+                b = src[i]
+                i += 1
+                lit += b
+                if b != 255:
+                    break
+        out += src[i:i+lit]
+        i += lit
+        if i >= len(src):
+            break
+        offset = src[i] | (src[i+1] << 8)
+        i += 2
+        if offset == 0 or offset > len(out):
+            raise ValueError("bad match offset")
+        mlen = token & 0x0F
+        if mlen == 15:
+            while True:
+                b = src[i]
+                i += 1
+                mlen += b
+                if b != 255:
+                    break
+        mlen += MIN_MATCH
+        start = len(out) - offset
+        for j in range(mlen):
+            out.append(out[start + j])
+    if len(out) != raw_len:
+        raise ValueError("block length mismatch")
+    return bytes(out)
+
+
+def decompress(infile, outfile):
+    with open(infile, 'rb') as f:
+        data = f.read()
+    if data[:4] != FILE_MAGIC:
+        print("%s is not a compressed log" % infile)
+        return False
+    ofs = 4
+    nblocks = 0
+    with open(outfile, 'wb') as out:
+        while ofs + 4 <= len(data):
+            (stored_len, raw_len) = struct.unpack('<HH', data[ofs:ofs+4])
+            ofs += 4
+            is_stored = (stored_len & BLOCK_STORED) != 0
+            stored_len &= ~BLOCK_STORED
+            payload = data[ofs:ofs+stored_len]
+            if len(payload) != stored_len:
+                print("truncated block at end of log")
+                break
+            ofs += stored_len
+            if is_stored:
+                out.write(payload)
+            else:
+                out.write(lz4_block_decompress(payload, raw_len))
+            nblocks += 1
+    print("Decompressed %u blocks from %s into %s" % (nblocks, infile, outfile))
+    return True
+
+
+if __name__ == '__main__':
+    parser = argparse.ArgumentParser(description=__doc__)
+    parser.add_argument("infile", help="compressed log")
+    parser.add_argument("outfile", help="decompressed log to write")
+    args = parser.parse_args()
+    if not decompress(args.infile, args.outfile):
+        sys.exit(1)
@@ -45,7 +45,7 @@ void AP_OABendyRuler::Write_OABendyRuler(const uint8_t type, const bool active,
 #endif  // AP_OAPATHPLANNER_BENDYRULER_ENABLED
 
 #if AP_OAPATHPLANNER_DIJKSTRA_ENABLED
-void AP_OADijkstra::Write_OADijkstra(const uint8_t state, const uint8_t error_id, const uint8_t curr_point, const uint8_t tot_points, const Location &final_dest, const Location &oa_dest) const
+void AP_OADijkstra::Write_OADijkstra(const uint8_t state, const uint8_t error_id, const uint16_t curr_point, const uint16_t tot_points, const Location &final_dest, const Location &oa_dest) const
 {
     const struct log_OADijkstra pkt{
         LOG_PACKET_HEADER_INIT(LOG_OA_DIJKSTRA_MSG),
@@ -64,7 +64,7 @@ void AP_OADijkstra::Write_OADijkstra(const uint8_t state, const uint8_t error_id
 #endif
 
 #if AP_OAPATHPLANNER_ENABLED
-void AP_OADijkstra::Write_Visgraph_point(const uint8_t version, const uint8_t point_num, const int32_t Lat, const int32_t Lon) const
+void AP_OADijkstra::Write_Visgraph_point(const uint8_t version, const uint16_t point_num, const int32_t Lat, const int32_t Lon) const
 {
     const struct log_OD_Visgraph pkt{
         LOG_PACKET_HEADER_INIT(LOG_OD_VISGRAPH_MSG),
@@ -145,8 +145,16 @@ void AP_OADatabase::update()
         return;
     }
 
+    WITH_SEMAPHORE(_database.sem);
     process_queue();
     database_items_remove_all_expired();
+    _index.update(_database.count);
+}
+
+bool AP_OADatabase::closest_to_segment(const Vector3f &start, const Vector3f &end, float &margin)
+{
+    WITH_SEMAPHORE(_database.sem);
+    return _index.closest_to_segment(start, end, _database.count, margin);
 }
 
 // Push an object into the database. Pos is the offset in meters from the EKF origin, measurement timestamp in ms, distance in meters
@@ -222,6 +230,10 @@ void AP_OADatabase::init_database()
     }
 
     _database.items = NEW_NOTHROW OA_DbItem[_database.size];
+    if (_database.items != nullptr) {
+        // the database still works without the index, just slower
+        _index.init(_database.items, _database.size);
+    }
 }
 
 // get bitmask of gcs channels item should be sent to based on its importance
@@ -289,6 +301,8 @@ bool AP_OADatabase::process_queue()
         return false;
     }
 
+    WITH_SEMAPHORE(_database.sem);
+
     for (uint16_t queue_index=0; queue_index<queue_available; queue_index++) {
         OA_DbItem item;
 
@@ -304,16 +318,26 @@ bool AP_OADatabase::process_queue()
         item.send_to_gcs = get_send_to_gcs_flags(item.importance);
 
         // compare item to all items in database. If found a similar item, update the existing, else add it as a new one
-        bool found = false;
-        for (uint16_t i=0; i<_database.count; i++) {
-            if (item_match(_database.items[i], item)) {
-                database_item_refresh(_database.items[i], item);
-                found = true;
-                break;
+        int32_t found = -1;
+        if (item.source == OA_DbItem::Source::proximity) {
+            // only nearby items can match
+            found = _index.find_first(item.pos, MAX(item.radius, _index.max_radius()), _database.count,
+                                      [&](const OA_DbItem &other) { return item_match(other, item); });
+        } else {
+            for (uint16_t i=0; i<_database.count; i++) {
+                if (item_match(_database.items[i], item)) {
+                    found = i;
+                    break;
+                }
             }
         }
 
-        if (!found) {
+        if (found != -1) {
+            _index.remove(found);
+            database_item_refresh(_database.items[found], item);
+            _index.insert(found);
+            database_note_timestamp(_database.items[found].timestamp_ms);
+        } else {
             database_item_add(item);
         }
     }
@@ -327,6 +351,8 @@ void AP_OADatabase::database_item_add(const OA_DbItem &item)
     }
     _database.items[_database.count] = item;
     _database.items[_database.count].send_to_gcs = get_send_to_gcs_flags(_database.items[_database.count].importance);
+    _index.insert(_database.count);
+    database_note_timestamp(item.timestamp_ms);
     _database.count++;
 }
 
@@ -337,6 +363,8 @@ void AP_OADatabase::database_item_remove(const uint16_t index)
         return;
     }
 
+    _index.remove(index);
+
     // radius of 0 tells the GCS we don't care about it any more (aka it expired)
     _database.items[index].radius = 0;
     _database.items[index].send_to_gcs = get_send_to_gcs_flags(_database.items[index].importance);
@@ -348,8 +376,10 @@ void AP_OADatabase::database_item_remove(const uint16_t index)
 
     if (index != _database.count) {
         // copy last object in array over expired object
+        _index.remove(_database.count);
         _database.items[index] = _database.items[_database.count];
         _database.items[index].send_to_gcs = get_send_to_gcs_flags(_database.items[index].importance);
+        _index.insert(index);
     }
 }
 
@@ -385,16 +415,31 @@ void AP_OADatabase::database_items_remove_all_expired()
 
     const uint32_t now_ms = AP_HAL::millis();
     const uint32_t expiry_ms = (uint32_t)_database_expiry_seconds * 1000;
+    if (_database.count == 0 || now_ms - _database.oldest_timestamp_ms <= expiry_ms) {
+        // nothing can have expired yet
+        return;
+    }
     uint16_t index = 0;
+    _database.oldest_timestamp_ms = now_ms;
     while (index < _database.count) {
         if (now_ms - _database.items[index].timestamp_ms > expiry_ms) {
             database_item_remove(index);
         } else {
+            database_note_timestamp(_database.items[index].timestamp_ms);
             index++;
         }
     }
 }
 
+// keep track of the oldest timestamp so the expiry check can be
+// skipped until an item is due to expire
+void AP_OADatabase::database_note_timestamp(uint32_t timestamp_ms)
+{
+    if (_database.count == 0 || int32_t(timestamp_ms - _database.oldest_timestamp_ms) < 0) {
+        _database.oldest_timestamp_ms = timestamp_ms;
+    }
+}
+
 #if HAL_GCS_ENABLED
 // send ADSB_VEHICLE mavlink messages
 void AP_OADatabase::send_adsb_vehicle(mavlink_channel_t chan, uint16_t interval_ms)
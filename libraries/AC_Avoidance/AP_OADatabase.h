@@ -8,6 +8,7 @@
 #include <AP_Math/AP_Math.h>
 #include <GCS_MAVLink/GCS_MAVLink.h>
 #include <AP_Param/AP_Param.h>
+#include "AP_OADatabaseIndex.h"
 
 class AP_OADatabase {
 public:
@@ -61,6 +62,11 @@ public:
     // get number of items in the database
     uint16_t database_count() const { return _database.count; }
 
+    // find the smallest distance between a line segment and the edge
+    // of any object. Start and end are offsets in meters from the EKF
+    // origin. Returns false if the database is empty
+    bool closest_to_segment(const Vector3f &start, const Vector3f &end, float &margin);
+
     // empty queue and try and put into database. Return true if there's more work to do
     bool process_queue();
 
@@ -80,6 +86,7 @@ private:
     void database_item_refresh(OA_DbItem &current_item, const OA_DbItem &new_item) const;
     void database_item_remove(const uint16_t index);
     void database_items_remove_all_expired();
+    void database_note_timestamp(uint32_t timestamp_ms);
 
     // get bitmask of gcs channels item should be sent to based on its importance
     // returns 0xFF (send to all channels) if should be sent or 0 if it should not be sent
@@ -117,8 +124,12 @@ private:
         OA_DbItem       *items;                             // array of objects in the database
         uint16_t        count;                              // number of objects in the items array
         uint16_t        size;                               // cached value of _database_size_param that sticks after initialized
+        uint32_t        oldest_timestamp_ms;                // no item has an older timestamp than this
+        HAL_Semaphore   sem;                                // held while the items or index are changed or searched
     } _database;
 
+    AP_OADatabaseIndex<OA_DbItem> _index;                   // spatial index of _database.items
+
     uint16_t _next_index_to_send[MAVLINK_COMM_NUM_BUFFERS]; // index of next object in _database to send to GCS
     uint16_t _highest_index_sent[MAVLINK_COMM_NUM_BUFFERS]; // highest index in _database sent to GCS
     uint32_t _last_send_to_gcs_ms[MAVLINK_COMM_NUM_BUFFERS];// system time that send_adsb_vehicle was last called
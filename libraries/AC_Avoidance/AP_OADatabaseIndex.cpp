@@ -0,0 +1,214 @@
+/*
+   This program is free software: you can redistribute it and/or modify
+   it under the terms of the GNU General Public License as published by
+   the Free Software Foundation, either version 3 of the License, or
+   (at your option) any later version.
+   This program is distributed in the hope that it will be useful,
+   but WITHOUT ANY WARRANTY; without even the implied warranty of
+   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+   GNU General Public License for more details.
+   You should have received a copy of the GNU General Public License
+   along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#include "AC_Avoidance_config.h"
+
+#if AP_OADATABASE_ENABLED
+
+#include "AP_OADatabaseIndex.h"
+#include "AP_OADatabase.h"
+
+#include <string.h>
+
+template <class T>
+AP_OADatabaseIndex<T>::~AP_OADatabaseIndex()
+{
+    delete[] _head;
+    delete[] _next;
+}
+
+template <class T>
+bool AP_OADatabaseIndex<T>::init(const T *items, uint16_t max_items)
+{
+    _items = items;
+    if (max_items == 0 || max_items == INDEX_NONE) {
+        return false;
+    }
+
+    // around one item per bucket when full
+    uint16_t num_buckets = 16;
+    while (num_buckets < max_items && num_buckets < 0x8000) {
+        num_buckets <<= 1;
+    }
+    _head = NEW_NOTHROW uint16_t[num_buckets];
+    _next = NEW_NOTHROW uint16_t[max_items];
+    if (_head == nullptr || _next == nullptr) {
+        delete[] _head;
+        delete[] _next;
+        _head = nullptr;
+        _next = nullptr;
+        return false;
+    }
+    memset(_head, 0xFF, sizeof(_head[0]) * num_buckets);
+    _num_buckets = num_buckets;
+    return true;
+}
+
+template <class T>
+void AP_OADatabaseIndex<T>::insert(uint16_t idx)
+{
+    const T &item = _items[idx];
+    _max_radius = MAX(_max_radius, item.radius);
+    if (_head == nullptr) {
+        return;
+    }
+    const int32_t cx = cell(item.pos.x);
+    const int32_t cy = cell(item.pos.y);
+    extend_bounds(cx, cy);
+    uint16_t &head = _head[bucket(cx, cy)];
+    _next[idx] = head;
+    head = idx;
+}
+
+template <class T>
+void AP_OADatabaseIndex<T>::remove(uint16_t idx)
+{
+    const T &item = _items[idx];
+    // the bounds may now be larger than needed, which only costs
+    // queries some time until update() is called
+    _bounds_stale = true;
+    if (_head == nullptr) {
+        return;
+    }
+    uint16_t *link = &_head[bucket(cell(item.pos.x), cell(item.pos.y))];
+    while (*link != INDEX_NONE) {
+        if (*link == idx) {
+            *link = _next[idx];
+            return;
+        }
+        link = &_next[*link];
+    }
+}
+
+template <class T>
+void AP_OADatabaseIndex<T>::update(uint16_t count)
+{
+    if (!_bounds_stale) {
+        return;
+    }
+    _max_radius = 0;
+    _have_bounds = false;
+    for (uint16_t i=0; i<count; i++) {
+        _max_radius = MAX(_max_radius, _items[i].radius);
+        extend_bounds(cell(_items[i].pos.x), cell(_items[i].pos.y));
+    }
+    _bounds_stale = false;
+}
+
+template <class T>
+void AP_OADatabaseIndex<T>::extend_bounds(int32_t cx, int32_t cy)
+{
+    if (!_have_bounds) {
+        _cell_min_x = _cell_max_x = cx;
+        _cell_min_y = _cell_max_y = cy;
+        _have_bounds = true;
+        return;
+    }
+    _cell_min_x = MIN(_cell_min_x, cx);
+    _cell_max_x = MAX(_cell_max_x, cx);
+    _cell_min_y = MIN(_cell_min_y, cy);
+    _cell_max_y = MAX(_cell_max_y, cy);
+}
+
+/*
+  search the cells around the segment's bounding box, one ring of
+  cells at a time. Items outside the rings searched so far are at
+  least (ring - 1) * AP_OADATABASE_INDEX_CELL_SIZE from the segment,
+  so the search stops once that, less the largest radius, can't beat
+  the closest item found. Within a ring, cells too far from the
+  segment to hold a closer item are skipped, and the first ring
+  starts with the cells the segment passes through. The search ends
+  once the rings cover every occupied cell
+ */
+template <class T>
+bool AP_OADatabaseIndex<T>::closest_to_segment(const Vector3f &start, const Vector3f &end, uint16_t count, float &margin) const
+{
+    if (count == 0) {
+        return false;
+    }
+
+    float smallest_margin = FLT_MAX;
+
+    const int32_t x0 = cell(MIN(start.x, end.x));
+    const int32_t x1 = cell(MAX(start.x, end.x));
+    const int32_t y0 = cell(MIN(start.y, end.y));
+    const int32_t y1 = cell(MAX(start.y, end.y));
+    const Vector2f start_xy{start.x, start.y};
+    const Vector2f end_xy{end.x, end.y};
+
+    // visiting a cell is much cheaper than checking an item
+    const uint32_t max_cells = 4U * count + 16U;
+    uint32_t cells_visited = 0;
+
+    for (int32_t ring=0; _head != nullptr; ring++) {
+        if (ring > 0 && smallest_margin <= (ring - 1) * AP_OADATABASE_INDEX_CELL_SIZE - _max_radius) {
+            margin = smallest_margin;
+            return true;
+        }
+        const int32_t rx0 = x0 - ring;
+        const int32_t rx1 = x1 + ring;
+        const int32_t ry0 = y0 - ring;
+        const int32_t ry1 = y1 + ring;
+        const uint32_t ring_cells = ring == 0 ? uint32_t(rx1 - rx0 + 1) * (ry1 - ry0 + 1)
+                                              : 2U * ((rx1 - rx0 + 1) + (ry1 - ry0 - 1));
+        cells_visited += ring_cells;
+        if (cells_visited > max_cells) {
+            // too far to search cell by cell
+            smallest_margin = FLT_MAX;
+            for (uint16_t i=0; i<count; i++) {
+                smallest_margin = MIN(smallest_margin, margin_to(start, end, i));
+            }
+            break;
+        }
+        // the first ring is searched twice, first for the cells on the
+        // segment and then for the rest
+        for (uint8_t pass=(ring == 0 ? 0 : 1); pass<2; pass++) {
+            for (int32_t cx=rx0; cx<=rx1; cx++) {
+                // only the edges of the ring are new
+                const bool edge_x = (ring == 0) || cx == rx0 || cx == rx1;
+                for (int32_t cy=ry0; cy<=ry1; cy += (edge_x ? 1 : ry1 - ry0)) {
+                    const Vector2f center{(cx + 0.5f) * AP_OADATABASE_INDEX_CELL_SIZE, (cy + 0.5f) * AP_OADATABASE_INDEX_CELL_SIZE};
+                    const float closest = Vector2f::closest_distance_between_line_and_point(start_xy, end_xy, center) - CELL_HALF_DIAGONAL;
+                    if ((ring == 0 && (pass == 0) != (closest <= 0)) ||
+                        closest - _max_radius >= smallest_margin) {
+                        continue;
+                    }
+                    for (uint16_t i=_head[bucket(cx, cy)]; i!=INDEX_NONE; i=_next[i]) {
+                        smallest_margin = MIN(smallest_margin, margin_to(start, end, i));
+                    }
+                }
+            }
+        }
+        if (!_have_bounds ||
+            (rx0 <= _cell_min_x && rx1 >= _cell_max_x && ry0 <= _cell_min_y && ry1 >= _cell_max_y)) {
+            // every item has been considered
+            break;
+        }
+    }
+
+    if (_head == nullptr) {
+        for (uint16_t i=0; i<count; i++) {
+            smallest_margin = MIN(smallest_margin, margin_to(start, end, i));
+        }
+    }
+
+    margin = smallest_margin;
+    return true;
+}
+
+/*
+  instantiate template classes
+ */
+template class AP_OADatabaseIndex<AP_OADatabase::OA_DbItem>;
+
+#endif  // AP_OADATABASE_ENABLED
@@ -0,0 +1,123 @@
+#pragma once
+
+#include "AC_Avoidance_config.h"
+
+#if AP_OADATABASE_ENABLED
+
+#include <AP_Common/AP_Common.h>
+#include <AP_Math/AP_Math.h>
+
+#ifndef AP_OADATABASE_INDEX_CELL_SIZE
+#define AP_OADATABASE_INDEX_CELL_SIZE 2.0f  // meters
+#endif
+
+/*
+ * Spatial index over the object database's item array.
+ *
+ * Items are hashed into buckets by the horizontal grid cell holding
+ * their position, with the items in each bucket linked through a
+ * per-item next index. The index is kept in step with the array by
+ * the database, which removes an item before moving or changing it
+ * and inserts it again afterwards.
+ *
+ * Queries visit the cells around the query point or segment, growing
+ * outwards until no unvisited item can be closer. When that would
+ * visit more cells than there are items, or the index could not be
+ * allocated, they fall back to a scan of every item.
+ */
+template <class T>
+class AP_OADatabaseIndex {
+public:
+    ~AP_OADatabaseIndex();
+
+    // allocate an index for an array of up to max_items items.
+    // Returns false if the buckets couldn't be allocated, in which
+    // case queries scan the whole array
+    bool init(const T *items, uint16_t max_items);
+
+    // add or remove the item at idx
+    void insert(uint16_t idx);
+    void remove(uint16_t idx);
+
+    // recalculate the largest item radius and the occupied cells if
+    // items have been removed
+    void update(uint16_t count);
+
+    // largest radius of any item
+    float max_radius() const { return _max_radius; }
+
+    // lowest index of the first count items within radius of pos
+    // horizontally and for which match(item) is true, or -1 if none
+    template <typename F>
+    int32_t find_first(const Vector3f &pos, float radius, uint16_t count, F match) const;
+
+    // smallest distance between a line segment and the edge of any of
+    // the first count items. Returns false if there are no items
+    bool closest_to_segment(const Vector3f &start, const Vector3f &end, uint16_t count, float &margin) const;
+
+private:
+    static constexpr uint16_t INDEX_NONE = 0xFFFF;
+    static constexpr float CELL_HALF_DIAGONAL = 0.7072f * AP_OADATABASE_INDEX_CELL_SIZE;
+
+    // grid cell holding a position
+    static int32_t cell(float v) {
+        return (int32_t)floorf(v * (1.0f / AP_OADATABASE_INDEX_CELL_SIZE));
+    }
+    uint16_t bucket(int32_t cx, int32_t cy) const {
+        return (uint32_t(cx) * 73856093U ^ uint32_t(cy) * 19349663U) & (_num_buckets - 1);
+    }
+
+    // grow the bounds of the occupied cells to include a cell
+    void extend_bounds(int32_t cx, int32_t cy);
+
+    // distance from a segment to the edge of an item
+    float margin_to(const Vector3f &start, const Vector3f &end, uint16_t idx) const {
+        return Vector3f::closest_distance_between_line_and_point(start, end, _items[idx].pos) - _items[idx].radius;
+    }
+
+    const T *_items;
+    uint16_t *_head = nullptr;  // first item in each bucket
+    uint16_t *_next = nullptr;  // next item in the same bucket
+    uint16_t _num_buckets;      // always a power of two
+    float _max_radius;          // largest radius of any indexed item
+    int32_t _cell_min_x;        // bounds of the cells holding items
+    int32_t _cell_max_x;
+    int32_t _cell_min_y;
+    int32_t _cell_max_y;
+    bool _have_bounds;          // false until an item has been inserted
+    bool _bounds_stale;         // true if items have been removed since update()
+};
+
+template <class T>
+template <typename F>
+int32_t AP_OADatabaseIndex<T>::find_first(const Vector3f &pos, float radius, uint16_t count, F match) const
+{
+    int32_t found = -1;
+
+    const int32_t x0 = cell(pos.x - radius);
+    const int32_t x1 = cell(pos.x + radius);
+    const int32_t y0 = cell(pos.y - radius);
+    const int32_t y1 = cell(pos.y + radius);
+    if (_head == nullptr || int64_t(x1 - x0 + 1) * (y1 - y0 + 1) > count) {
+        // cheaper to check every item
+        for (uint16_t i=0; i<count; i++) {
+            if (match(_items[i])) {
+                return i;
+            }
+        }
+        return -1;
+    }
+
+    for (int32_t cx=x0; cx<=x1; cx++) {
+        for (int32_t cy=y0; cy<=y1; cy++) {
+            for (uint16_t i=_head[bucket(cx, cy)]; i!=INDEX_NONE; i=_next[i]) {
+                if ((found == -1 || i < found) && match(_items[i])) {
+                    found = i;
+                }
+            }
+        }
+    }
+    return found;
+}
+
+#endif  // AP_OADATABASE_ENABLED
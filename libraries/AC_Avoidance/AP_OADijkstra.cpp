@@ -27,22 +27,36 @@
 #include <AP_AHRS/AP_AHRS.h>
 #include <AP_Logger/AP_Logger.h>
 #include <GCS_MAVLink/GCS.h>
+#include <AP_Math/crc.h>
+#include <string.h>
 
 #define OA_DIJKSTRA_EXPANDING_ARRAY_ELEMENTS_PER_CHUNK  32      // expanding arrays for fence points and paths to destination will grow in increments of 20 elements
-#define OA_DIJKSTRA_POLYGON_SHORTPATH_NOTSET_IDX        255     // index use to indicate we do not have a tentative short path for a node
+#define OA_DIJKSTRA_POLYGON_SHORTPATH_NOTSET_IDX        0xFFFF  // index use to indicate we do not have a tentative short path for a node
+#define OA_DIJKSTRA_FENCE_VISIBLE                       0xFFFF  // _fence_blocker value for fence points that are visible to each other
+#define OA_DIJKSTRA_EXCLUSION_CIRCLE_NUMPOINTS          6       // number of points created around each exclusion circle
 #define OA_DIJKSTRA_ERROR_REPORTING_INTERVAL_MS         5000    // failure messages sent to GCS every 5 seconds
 
 /// Constructor
 AP_OADijkstra::AP_OADijkstra(AP_Int16 &options) :
         _inclusion_polygon_pts(OA_DIJKSTRA_EXPANDING_ARRAY_ELEMENTS_PER_CHUNK),
+        _inclusion_polygon_numpoints_each(OA_DIJKSTRA_EXPANDING_ARRAY_ELEMENTS_PER_CHUNK),
         _exclusion_polygon_pts(OA_DIJKSTRA_EXPANDING_ARRAY_ELEMENTS_PER_CHUNK),
+        _exclusion_polygon_numpoints_each(OA_DIJKSTRA_EXPANDING_ARRAY_ELEMENTS_PER_CHUNK),
         _exclusion_circle_pts(OA_DIJKSTRA_EXPANDING_ARRAY_ELEMENTS_PER_CHUNK),
         _short_path_data(OA_DIJKSTRA_EXPANDING_ARRAY_ELEMENTS_PER_CHUNK),
+        _heap(OA_DIJKSTRA_EXPANDING_ARRAY_ELEMENTS_PER_CHUNK),
         _path(OA_DIJKSTRA_EXPANDING_ARRAY_ELEMENTS_PER_CHUNK),
         _options(options)
 {
 }
 
+AP_OADijkstra::~AP_OADijkstra()
+{
+    delete[] _fence_blocker;
+    delete[] _fence_visgraph_pts;
+    delete[] _fence_groups;
+}
+
 // calculate a destination to avoid fences
 // returns DIJKSTRA_STATE_SUCCESS and populates origin_new, destination_new and next_destination_new if avoidance is required
 // next_destination_new will be non-zero if there is a next destination
@@ -183,7 +197,7 @@ AP_OADijkstra::AP_OADijkstra_State AP_OADijkstra::update(const Location &current
 
     // path has been created, return latest point
     Vector2f dest_pos;
-    const uint8_t path_length = get_shortest_path_numpoints() > 0 ? (get_shortest_path_numpoints() - 1) : 0;
+    const uint16_t path_length = get_shortest_path_numpoints() > 0 ? (get_shortest_path_numpoints() - 1) : 0;
     if ((_path_idx_returned < path_length) && get_shortest_path_point(_path_idx_returned, dest_pos)) {
 
         // for the first point return origin as current_loc
@@ -335,6 +349,7 @@ bool AP_OADijkstra::create_inclusion_polygon_with_margin(float margin_cm, AP_OAD
 
     // clear all points
     _inclusion_polygon_numpoints = 0;
+    _inclusion_polygon_num = 0;
 
     // return immediately if no polygons
     const uint8_t num_inclusion_polygons = fence->polyfence().get_inclusion_polygon_count();
@@ -398,8 +413,16 @@ bool AP_OADijkstra::create_inclusion_polygon_with_margin(float margin_cm, AP_OAD
             new_points++;
         }
 
+        // record number of points created for this polygon
+        if (!_inclusion_polygon_numpoints_each.expand_to_hold(i + 1)) {
+            err_id = AP_OADijkstra_Error::DIJKSTRA_ERROR_OUT_OF_MEMORY;
+            return false;
+        }
+        _inclusion_polygon_numpoints_each[i] = new_points;
+
         // update total number of points
         _inclusion_polygon_numpoints += new_points;
+        _inclusion_polygon_num++;
     }
     return true;
 }
@@ -436,6 +459,7 @@ bool AP_OADijkstra::create_exclusion_polygon_with_margin(float margin_cm, AP_OAD
 
     // clear all points
     _exclusion_polygon_numpoints = 0;
+    _exclusion_polygon_num = 0;
 
     // return immediately if no exclusion polygons
     const uint8_t num_exclusion_polygons = fence->polyfence().get_exclusion_polygon_count();
@@ -499,8 +523,16 @@ bool AP_OADijkstra::create_exclusion_polygon_with_margin(float margin_cm, AP_OAD
             new_points++;
         }
 
+        // record number of points created for this polygon
+        if (!_exclusion_polygon_numpoints_each.expand_to_hold(i + 1)) {
+            err_id = AP_OADijkstra_Error::DIJKSTRA_ERROR_OUT_OF_MEMORY;
+            return false;
+        }
+        _exclusion_polygon_numpoints_each[i] = new_points;
+
         // update total number of points
         _exclusion_polygon_numpoints += new_points;
+        _exclusion_polygon_num++;
     }
     return true;
 }
@@ -530,6 +562,7 @@ bool AP_OADijkstra::create_exclusion_circle_with_margin(float margin_cm, AP_OADi
 
     // clear all points
     _exclusion_circle_numpoints = 0;
+    _exclusion_circle_num = 0;
 
     // unit length offsets for polygon points around circles
     const Vector2f unit_offsets[] = {
@@ -541,6 +574,7 @@ bool AP_OADijkstra::create_exclusion_circle_with_margin(float margin_cm, AP_OADi
             {cosf(radians(330)), cosf(radians(330-90))},// north-west
     };
     const uint8_t num_points_per_circle = ARRAY_SIZE(unit_offsets);
+    static_assert(ARRAY_SIZE(unit_offsets) == OA_DIJKSTRA_EXCLUSION_CIRCLE_NUMPOINTS, "exclusion circle points must match fence groups");
 
     // expand polygon point array if required
     const uint8_t num_exclusion_circles = fence->polyfence().get_exclusion_circle_count();
@@ -562,6 +596,7 @@ bool AP_OADijkstra::create_exclusion_circle_with_margin(float margin_cm, AP_OADi
                 _exclusion_circle_pts[_exclusion_circle_numpoints] = circle_pos_cm + (unit_offsets[j] * scaler);
                 _exclusion_circle_numpoints++;
             }
+            _exclusion_circle_num++;
         }
     }
 
@@ -676,7 +711,209 @@ bool AP_OADijkstra::intersects_fence(const Vector2f &seg_start, const Vector2f &
     return false;
 }
 
+// create list of fence items and the points around them, returns nullptr if out of memory
+// consistent is set false if the fence items no longer match the points (with margin) they were created from
+// requires these functions to have been run create_inclusion_polygon_with_margin, create_exclusion_polygon_with_margin, create_exclusion_circle_with_margin
+AP_OADijkstra::FenceGroup *AP_OADijkstra::create_fence_groups(uint16_t &num_groups, bool &consistent) const
+{
+    const AC_PolyFence_loader &polyfence = AC_Fence::get_singleton()->polyfence();
+
+    const uint8_t num_inclusion_polygons = polyfence.get_inclusion_polygon_count();
+    const uint8_t num_exclusion_polygons = polyfence.get_exclusion_polygon_count();
+    const uint8_t num_exclusion_circles = polyfence.get_exclusion_circle_count();
+    const uint8_t num_inclusion_circles = polyfence.get_inclusion_circle_count();
+    num_groups = num_inclusion_polygons + num_exclusion_polygons + num_exclusion_circles + num_inclusion_circles;
+
+    // the fence may have been updated since the points (with margin) were created
+    const uint16_t num_points = total_numpoints();
+    consistent = (num_inclusion_polygons == _inclusion_polygon_num) &&
+                 (num_exclusion_polygons == _exclusion_polygon_num) &&
+                 (num_exclusion_circles == _exclusion_circle_num);
+
+    FenceGroup *groups = NEW_NOTHROW FenceGroup[MAX(num_groups, 1U)];
+    if (groups == nullptr) {
+        return nullptr;
+    }
+
+    // groups are in the same order as the points returned by get_point
+    uint16_t group_idx = 0;
+    uint16_t first_point = 0;
+    for (uint8_t t = 0; t < 4; t++) {
+        const FenceGroup::Type type = (FenceGroup::Type)t;
+        uint8_t num_items = 0;
+        switch (type) {
+        case FenceGroup::Type::INCLUSION_POLYGON:
+            num_items = num_inclusion_polygons;
+            break;
+        case FenceGroup::Type::EXCLUSION_POLYGON:
+            num_items = num_exclusion_polygons;
+            break;
+        case FenceGroup::Type::EXCLUSION_CIRCLE:
+            num_items = num_exclusion_circles;
+            break;
+        case FenceGroup::Type::INCLUSION_CIRCLE:
+            num_items = num_inclusion_circles;
+            break;
+        }
+        for (uint8_t i = 0; i < num_items; i++) {
+            FenceGroup &group = groups[group_idx++];
+            group.type = type;
+            group.fence_idx = i;
+            group.first_point = first_point;
+            group.num_points = 0;
+            group.crc = 0;
+            group.bbox_min.zero();
+            group.bbox_max.zero();
+
+            switch (type) {
+            case FenceGroup::Type::INCLUSION_POLYGON:
+            case FenceGroup::Type::EXCLUSION_POLYGON: {
+                uint16_t num_boundary_points = 0;
+                const Vector2f* boundary;
+                if (type == FenceGroup::Type::INCLUSION_POLYGON) {
+                    boundary = polyfence.get_inclusion_polygon(i, num_boundary_points);
+                    if (i < _inclusion_polygon_num) {
+                        group.num_points = _inclusion_polygon_numpoints_each[i];
+                    }
+                } else {
+                    boundary = polyfence.get_exclusion_polygon(i, num_boundary_points);
+                    if (i < _exclusion_polygon_num) {
+                        group.num_points = _exclusion_polygon_numpoints_each[i];
+                    }
+                }
+                if (boundary == nullptr || num_boundary_points == 0) {
+                    break;
+                }
+                group.bbox_min = group.bbox_max = boundary[0];
+                for (uint16_t j = 1; j < num_boundary_points; j++) {
+                    group.bbox_min.x = MIN(group.bbox_min.x, boundary[j].x);
+                    group.bbox_min.y = MIN(group.bbox_min.y, boundary[j].y);
+                    group.bbox_max.x = MAX(group.bbox_max.x, boundary[j].x);
+                    group.bbox_max.y = MAX(group.bbox_max.y, boundary[j].y);
+                }
+                group.crc = crc32_small(0, (const uint8_t *)boundary, num_boundary_points * sizeof(Vector2f));
+                break;
+            }
+            case FenceGroup::Type::EXCLUSION_CIRCLE:
+            case FenceGroup::Type::INCLUSION_CIRCLE: {
+                Vector2f center_pos_cm;
+                float radius;
+                const bool ok = (type == FenceGroup::Type::EXCLUSION_CIRCLE) ?
+                    polyfence.get_exclusion_circle(i, center_pos_cm, radius) :
+                    polyfence.get_inclusion_circle(i, center_pos_cm, radius);
+                if (!ok) {
+                    break;
+                }
+                if ((type == FenceGroup::Type::EXCLUSION_CIRCLE) && (i < _exclusion_circle_num)) {
+                    group.num_points = OA_DIJKSTRA_EXCLUSION_CIRCLE_NUMPOINTS;
+                }
+                const Vector2f radius_cm {radius * 100.0f, radius * 100.0f};
+                group.bbox_min = center_pos_cm - radius_cm;
+                group.bbox_max = center_pos_cm + radius_cm;
+                group.crc = crc32_small(0, (const uint8_t *)&center_pos_cm, sizeof(center_pos_cm));
+                group.crc = crc32_small(group.crc, (const uint8_t *)&radius, sizeof(radius));
+                break;
+            }
+            }
+
+            // never refer to points beyond those created
+            if (uint32_t(first_point) + group.num_points > num_points) {
+                group.num_points = 0;
+                consistent = false;
+            }
+
+            // include the points around the item
+            for (uint16_t j = 0; j < group.num_points; j++) {
+                Vector2f point;
+                if (get_point(first_point + j, point)) {
+                    group.crc = crc32_small(group.crc, (const uint8_t *)&point, sizeof(point));
+                }
+            }
+            first_point += group.num_points;
+        }
+    }
+
+    // every point must belong to exactly one item
+    if (first_point != num_points) {
+        consistent = false;
+    }
+
+    return groups;
+}
+
+// returns true if line segment intersects a fence item
+bool AP_OADijkstra::intersects_fence_group(const FenceGroup &group, const Vector2f &seg_start, const Vector2f &seg_end) const
+{
+    const AC_PolyFence_loader &polyfence = AC_Fence::get_singleton()->polyfence();
+
+    // segments entirely to one side of the item cannot cross its boundary
+    if ((group.type != FenceGroup::Type::INCLUSION_CIRCLE) &&
+        ((MAX(seg_start.x, seg_end.x) < group.bbox_min.x) ||
+         (MIN(seg_start.x, seg_end.x) > group.bbox_max.x) ||
+         (MAX(seg_start.y, seg_end.y) < group.bbox_min.y) ||
+         (MIN(seg_start.y, seg_end.y) > group.bbox_max.y))) {
+        return false;
+    }
+
+    switch (group.type) {
+    case FenceGroup::Type::INCLUSION_POLYGON:
+    case FenceGroup::Type::EXCLUSION_POLYGON: {
+        uint16_t num_points = 0;
+        const Vector2f* boundary = (group.type == FenceGroup::Type::INCLUSION_POLYGON) ?
+            polyfence.get_inclusion_polygon(group.fence_idx, num_points) :
+            polyfence.get_exclusion_polygon(group.fence_idx, num_points);
+        Vector2f intersection;
+        return (boundary != nullptr) && Polygon_intersects(boundary, num_points, seg_start, seg_end, intersection);
+    }
+    case FenceGroup::Type::EXCLUSION_CIRCLE: {
+        Vector2f center_pos_cm;
+        float radius;
+        if (polyfence.get_exclusion_circle(group.fence_idx, center_pos_cm, radius)) {
+            // intersects if distance is less than radius
+            return Vector2f::closest_distance_between_line_and_point(seg_start, seg_end, center_pos_cm) <= (radius * 100.0f);
+        }
+        return false;
+    }
+    case FenceGroup::Type::INCLUSION_CIRCLE: {
+        Vector2f center_pos_cm;
+        float radius;
+        if (polyfence.get_inclusion_circle(group.fence_idx, center_pos_cm, radius)) {
+            // intersects circle if either start or end is further from the center than the radius
+            const float radius_cm_sq = sq(radius * 100.0f);
+            return ((seg_start - center_pos_cm).length_squared() > radius_cm_sq) ||
+                   ((seg_end - center_pos_cm).length_squared() > radius_cm_sq);
+        }
+        return false;
+    }
+    }
+
+    // we should never reach here but just in case
+    return false;
+}
+
+// returns the index of the first fence item in groups that the segment intersects, or OA_DIJKSTRA_FENCE_VISIBLE
+// if changed_only is true only the items marked in changed are checked
+uint16_t AP_OADijkstra::find_blocking_group(const FenceGroup *groups, uint16_t num_groups, const bool *changed, bool changed_only, const Vector2f &seg_start, const Vector2f &seg_end) const
+{
+    for (uint16_t i = 0; i < num_groups; i++) {
+        if (changed_only && !changed[i]) {
+            continue;
+        }
+        if (intersects_fence_group(groups[i], seg_start, seg_end)) {
+            return i;
+        }
+    }
+    return OA_DIJKSTRA_FENCE_VISIBLE;
+}
+
+// returns true if the line between two fence points does not intersect any fence
+bool AP_OADijkstra::fence_points_visible(uint16_t i, uint16_t j) const
+{
+    return _fence_blocker[fence_pair_index(i, j)] == OA_DIJKSTRA_FENCE_VISIBLE;
+}
+
 // create visibility graph for all fence (with margin) points
+// only the pairs of points affected by fence items that have changed since the last call are checked
 // returns true on success.  returns false on failure and err_id is updated
 // requires these functions to have been run create_inclusion_polygon_with_margin, create_exclusion_polygon_with_margin, create_exclusion_circle_with_margin
 bool AP_OADijkstra::create_fence_visgraph(AP_OADijkstra_Error &err_id)
@@ -688,37 +925,104 @@ bool AP_OADijkstra::create_fence_visgraph(AP_OADijkstra_Error &err_id)
         return false;
     }
 
-    // fail if more fence points than algorithm can handle
-    if (total_numpoints() >= OA_DIJKSTRA_POLYGON_SHORTPATH_NOTSET_IDX) {
+    // fail if more fence points than algorithm can handle (the source and destination are also nodes)
+    const uint16_t num_points = total_numpoints();
+    if (num_points + 2U >= OA_DIJKSTRA_POLYGON_SHORTPATH_NOTSET_IDX) {
         err_id = AP_OADijkstra_Error::DIJKSTRA_ERROR_TOO_MANY_FENCE_POINTS;
         return false;
     }
 
-    // clear fence points visibility graph
-    _fence_visgraph.clear();
-
-    // calculate distance from each point to all other points
-    for (uint8_t i = 0; i < total_numpoints() - 1; i++) {
-        Vector2f start_seg;
-        if (get_point(i, start_seg)) {
-            for (uint8_t j = i + 1; j < total_numpoints(); j++) {
-                Vector2f end_seg;
-                if (get_point(j, end_seg)) {
-                    // if line segment does not intersect with any inclusion or exclusion zones add to visgraph
-                    if (!intersects_fence(start_seg, end_seg)) {
-                        if (!_fence_visgraph.add_item({AP_OAVisGraph::OATYPE_INTERMEDIATE_POINT, i},
-                                                      {AP_OAVisGraph::OATYPE_INTERMEDIATE_POINT, j},
-                                                      (start_seg - end_seg).length())) {
-                            // failure to add a point can only be caused by out-of-memory
-                            err_id = AP_OADijkstra_Error::DIJKSTRA_ERROR_OUT_OF_MEMORY;
-                            return false;
-                        }
-                    }
+    // allocate new visgraph and working space
+    uint16_t num_groups = 0;
+    bool groups_consistent = false;
+    FenceGroup *groups = create_fence_groups(num_groups, groups_consistent);
+    Vector2f *points = NEW_NOTHROW Vector2f[MAX(num_points, 1U)];
+    uint16_t *blocker = NEW_NOTHROW uint16_t[MAX(fence_pair_index(0, num_points), 1U)];
+    bool *changed = NEW_NOTHROW bool[MAX(num_groups, 1U)];
+    uint16_t *prev_point = NEW_NOTHROW uint16_t[MAX(num_points, 1U)];
+    uint16_t *prev_group_to_group = NEW_NOTHROW uint16_t[MAX(_fence_groups_num, 1U)];
+    if (groups == nullptr || points == nullptr || blocker == nullptr || changed == nullptr ||
+        prev_point == nullptr || prev_group_to_group == nullptr) {
+        delete[] groups;
+        delete[] points;
+        delete[] blocker;
+        delete[] changed;
+        delete[] prev_point;
+        delete[] prev_group_to_group;
+        err_id = AP_OADijkstra_Error::DIJKSTRA_ERROR_OUT_OF_MEMORY;
+        return false;
+    }
+
+    for (uint16_t i = 0; i < num_points; i++) {
+        get_point(i, points[i]);
+    }
+
+    // match fence items with those used to create the previous visgraph
+    for (uint16_t i = 0; i < _fence_groups_num; i++) {
+        prev_group_to_group[i] = OA_DIJKSTRA_FENCE_VISIBLE;
+    }
+    for (uint16_t i = 0; i < num_points; i++) {
+        prev_point[i] = OA_DIJKSTRA_POLYGON_SHORTPATH_NOTSET_IDX;
+    }
+    for (uint16_t i = 0; i < num_groups; i++) {
+        const FenceGroup &group = groups[i];
+        changed[i] = true;
+        // if the fence items do not match the points fall back to checking every pair of points
+        for (uint16_t j = 0; groups_consistent && (j < _fence_groups_num) && changed[i]; j++) {
+            const FenceGroup &prev_group = _fence_groups[j];
+            if ((prev_group_to_group[j] != OA_DIJKSTRA_FENCE_VISIBLE) ||
+                (prev_group.type != group.type) ||
+                (prev_group.crc != group.crc) ||
+                (prev_group.num_points != group.num_points) ||
+                (uint32_t(prev_group.first_point) + prev_group.num_points > _fence_visgraph_numpoints) ||
+                (memcmp(&_fence_visgraph_pts[prev_group.first_point], &points[group.first_point], group.num_points * sizeof(Vector2f)) != 0)) {
+                continue;
+            }
+            prev_group_to_group[j] = i;
+            changed[i] = false;
+            for (uint16_t k = 0; k < group.num_points; k++) {
+                prev_point[group.first_point + k] = prev_group.first_point + k;
+            }
+        }
+    }
+
+    // calculate visibility between each pair of points
+    for (uint16_t j = 1; j < num_points; j++) {
+        for (uint16_t i = 0; i < j; i++) {
+            uint16_t &pair_blocker = blocker[fence_pair_index(i, j)];
+            if ((prev_point[i] != OA_DIJKSTRA_POLYGON_SHORTPATH_NOTSET_IDX) &&
+                (prev_point[j] != OA_DIJKSTRA_POLYGON_SHORTPATH_NOTSET_IDX)) {
+                // both points are unchanged
+                const uint16_t prev_blocker = _fence_blocker[fence_pair_index(prev_point[i], prev_point[j])];
+                if (prev_blocker == OA_DIJKSTRA_FENCE_VISIBLE) {
+                    // still visible unless a changed item is now in the way
+                    pair_blocker = find_blocking_group(groups, num_groups, changed, true, points[i], points[j]);
+                    continue;
+                }
+                if (prev_group_to_group[prev_blocker] != OA_DIJKSTRA_FENCE_VISIBLE) {
+                    // still blocked by the same unchanged item
+                    pair_blocker = prev_group_to_group[prev_blocker];
+                    continue;
                 }
             }
+            pair_blocker = find_blocking_group(groups, num_groups, changed, false, points[i], points[j]);
         }
     }
 
+    // replace previous visgraph
+    delete[] _fence_blocker;
+    delete[] _fence_visgraph_pts;
+    delete[] _fence_groups;
+    _fence_blocker = blocker;
+    _fence_visgraph_pts = points;
+    _fence_visgraph_numpoints = num_points;
+    _fence_groups = groups;
+    _fence_groups_num = num_groups;
+
+    delete[] changed;
+    delete[] prev_point;
+    delete[] prev_group_to_group;
+
     return true;
 }
 
@@ -732,7 +1036,7 @@ bool AP_OADijkstra::update_visgraph(AP_OAVisGraph& visgraph, const AP_OAVisGraph
     visgraph.clear();
 
     // calculate distance from position to all inclusion/exclusion fence points
-    for (uint8_t i = 0; i < total_numpoints(); i++) {
+    for (uint16_t i = 0; i < total_numpoints(); i++) {
         Vector2f seg_end;
         if (get_point(i, seg_end)) {
             if (!intersects_fence(position, seg_end)) {
@@ -756,6 +1060,23 @@ bool AP_OADijkstra::update_visgraph(AP_OAVisGraph& visgraph, const AP_OAVisGraph
     return true;
 }
 
+// update a node's distance if it is shorter to reach it from the current node
+void AP_OADijkstra::update_node_distance(node_index curr_node_idx, node_index node_idx, float dist_cm)
+{
+    ShortPathNode &node = _short_path_data[node_idx];
+    if (node.visited) {
+        return;
+    }
+    // if current node's distance + distance to item is less than item's current distance, update item's distance
+    const float dist_to_item_via_current_node = _short_path_data[curr_node_idx].distance_cm + dist_cm;
+    if (dist_to_item_via_current_node < node.distance_cm) {
+        // update item's distance and set "distance_from_idx" to current node's index
+        node.distance_cm = dist_to_item_via_current_node;
+        node.distance_from_idx = curr_node_idx;
+        heap_update(node_idx);
+    }
+}
+
 // update total distance for all nodes visible from current node
 // curr_node_idx is an index into the _short_path_data array
 void AP_OADijkstra::update_visible_node_distances(node_index curr_node_idx)
@@ -766,38 +1087,93 @@ void AP_OADijkstra::update_visible_node_distances(node_index curr_node_idx)
     }
 
     // get current node for convenience
+    // nodes visible from the source are updated from the source visgraph
     const ShortPathNode &curr_node = _short_path_data[curr_node_idx];
+    if (curr_node.id.id_type != AP_OAVisGraph::OATYPE_INTERMEDIATE_POINT) {
+        return;
+    }
+    const uint16_t curr_point = curr_node.id.id_num;
+    const Vector2f &curr_pos = _fence_visgraph_pts[curr_point];
 
-    // for each visibility graph
-    const AP_OAVisGraph* visgraphs[] = {&_fence_visgraph, &_destination_visgraph};
-    for (uint8_t v=0; v<ARRAY_SIZE(visgraphs); v++) {
-
-        // skip if empty
-        const AP_OAVisGraph &curr_visgraph = *visgraphs[v];
-        if (curr_visgraph.num_items() == 0) {
+    // update fence points visible from current node
+    for (uint16_t i = 0; i < _fence_visgraph_numpoints; i++) {
+        if ((i == curr_point) || !fence_points_visible(curr_point, i)) {
             continue;
         }
+        node_index item_node_idx;
+        if (find_node_from_id({AP_OAVisGraph::OATYPE_INTERMEDIATE_POINT, i}, item_node_idx)) {
+            update_node_distance(curr_node_idx, item_node_idx, (curr_pos - _fence_visgraph_pts[i]).length());
+        }
+    }
 
-        // search visibility graph for items visible from current_node
-        for (uint16_t i = 0; i < curr_visgraph.num_items(); i++) {
-            const AP_OAVisGraph::VisGraphItem &item = curr_visgraph[i];
-            // match if current node's id matches either of the id's in the graph (i.e. either end of the vector)
-            if ((curr_node.id == item.id1) || (curr_node.id == item.id2)) {
-                AP_OAVisGraph::OAItemID matching_id = (curr_node.id == item.id1) ? item.id2 : item.id1;
-                // find item's id in node array
-                node_index item_node_idx;
-                if (find_node_from_id(matching_id, item_node_idx)) {
-                    // if current node's distance + distance to item is less than item's current distance, update item's distance
-                    const float dist_to_item_via_current_node = _short_path_data[curr_node_idx].distance_cm + item.distance_cm;
-                    if (dist_to_item_via_current_node < _short_path_data[item_node_idx].distance_cm) {
-                        // update item's distance and set "distance_from_idx" to current node's index
-                        _short_path_data[item_node_idx].distance_cm = dist_to_item_via_current_node;
-                        _short_path_data[item_node_idx].distance_from_idx = curr_node_idx;
-                    }
-                }
-            }
+    // update destination if visible from current node
+    node_index dest_node_idx;
+    if ((curr_node.dest_distance_cm < FLT_MAX) && find_node_from_id({AP_OAVisGraph::OATYPE_DESTINATION, 0}, dest_node_idx)) {
+        update_node_distance(curr_node_idx, dest_node_idx, curr_node.dest_distance_cm);
+    }
+}
+
+// move heap element to new position, keeping node's heap index up to date
+void AP_OADijkstra::heap_set(node_index heap_idx, node_index node_idx)
+{
+    _heap[heap_idx] = node_idx;
+    _short_path_data[node_idx].heap_idx = heap_idx;
+}
+
+// add node to heap or move it up the heap after its distance has been reduced
+void AP_OADijkstra::heap_update(node_index node_idx)
+{
+    node_index heap_idx = _short_path_data[node_idx].heap_idx;
+    if (heap_idx == OA_DIJKSTRA_POLYGON_SHORTPATH_NOTSET_IDX) {
+        heap_idx = _heap_numpoints++;
+    }
+
+    // move parents down until the node's place is found
+    while (heap_idx > 0) {
+        const node_index parent_heap_idx = (heap_idx - 1) / 2;
+        const node_index parent_node_idx = _heap[parent_heap_idx];
+        if (!heap_less(node_idx, parent_node_idx)) {
+            break;
+        }
+        heap_set(heap_idx, parent_node_idx);
+        heap_idx = parent_heap_idx;
+    }
+    heap_set(heap_idx, node_idx);
+}
+
+// remove node with lowest distance plus heuristic from heap
+// returns true if successful and node_idx argument is updated
+bool AP_OADijkstra::heap_pop(node_index &node_idx)
+{
+    if (_heap_numpoints == 0) {
+        return false;
+    }
+    node_idx = _heap[0];
+    _short_path_data[node_idx].heap_idx = OA_DIJKSTRA_POLYGON_SHORTPATH_NOTSET_IDX;
+    _heap_numpoints--;
+    if (_heap_numpoints == 0) {
+        return true;
+    }
+
+    // move last node down from the top until its place is found
+    const node_index last_node_idx = _heap[_heap_numpoints];
+    uint32_t heap_idx = 0;
+    while (true) {
+        uint32_t child_heap_idx = 2 * heap_idx + 1;
+        if (child_heap_idx >= _heap_numpoints) {
+            break;
+        }
+        if ((child_heap_idx + 1 < _heap_numpoints) && heap_less(_heap[child_heap_idx + 1], _heap[child_heap_idx])) {
+            child_heap_idx++;
+        }
+        if (!heap_less(_heap[child_heap_idx], last_node_idx)) {
+            break;
         }
+        heap_set(heap_idx, _heap[child_heap_idx]);
+        heap_idx = child_heap_idx;
     }
+    heap_set(heap_idx, last_node_idx);
+    return true;
 }
 
 // find a node's index into _short_path_data array from it's id (i.e. id type and id number)
@@ -832,47 +1208,6 @@ bool AP_OADijkstra::find_node_from_id(const AP_OAVisGraph::OAItemID &id, node_in
     return false;
 }
 
-// find index of node with lowest tentative distance (ignore visited nodes)
-// returns true if successful and node_idx argument is updated
-bool AP_OADijkstra::find_closest_node_idx(node_index &node_idx) const
-{
-    node_index lowest_idx = 0;
-    float lowest_dist = FLT_MAX;
-
-    // scan through all nodes looking for closest
-    for (node_index i=0; i<_short_path_data_numpoints; i++) {
-        const ShortPathNode &node = _short_path_data[i];
-        if (node.visited || is_equal(_short_path_data[i].distance_cm, FLT_MAX)) {
-            // if node is already visited OR cannot be reached yet, we can't use it
-            continue;
-        }
-        // figure out the pos of this node
-        Vector2f node_pos;
-        float dist_with_heuristics = FLT_MAX;
-        if (convert_node_to_point(node.id, node_pos)) {
-            // heuristics is is simple Euclidean distance from the node to the destination
-            // This should be admissible, therefore optimal path is guaranteed
-            const float heuristics = (node_pos-_path_destination).length();
-            dist_with_heuristics = node.distance_cm + heuristics;
-        } else {
-            // shouldn't happen
-            return false;
-        }
-        if (dist_with_heuristics < lowest_dist) {
-            // for NOW, this is the closest node
-            lowest_idx = i;
-            lowest_dist = dist_with_heuristics;
-        }
-    }
-
-    if (lowest_dist < FLT_MAX) {
-        // found the closest node
-        node_idx = lowest_idx;
-        return true;
-    }
-    return false;
-}
-
 // calculate shortest path from origin to destination
 // returns true on success.  returns false on failure and err_id is updated
 // requires these functions to have been run: create_inclusion_polygon_with_margin, create_exclusion_polygon_with_margin, create_exclusion_circle_with_margin, create_polygon_fence_visgraph
@@ -880,12 +1215,23 @@ bool AP_OADijkstra::find_closest_node_idx(node_index &node_idx) const
 bool AP_OADijkstra::calc_shortest_path(const Location &origin, const Location &destination, AP_OADijkstra_Error &err_id)
 {
     // convert origin and destination to offsets from EKF origin
-    if (!origin.get_vector_xy_from_origin_NE_cm(_path_source) ||
-        !destination.get_vector_xy_from_origin_NE_cm(_path_destination)) {
+    Vector2f origin_cm, destination_cm;
+    if (!origin.get_vector_xy_from_origin_NE_cm(origin_cm) ||
+        !destination.get_vector_xy_from_origin_NE_cm(destination_cm)) {
         err_id = AP_OADijkstra_Error::DIJKSTRA_ERROR_NO_POSITION_ESTIMATE;
         return false;
     }
 
+    return calc_shortest_path(origin_cm, destination_cm, err_id);
+}
+
+// calculate shortest path between offsets (in cm) from the EKF origin
+// returns true on success.  returns false on failure and err_id is updated
+bool AP_OADijkstra::calc_shortest_path(const Vector2f &origin_cm, const Vector2f &destination_cm, AP_OADijkstra_Error &err_id)
+{
+    _path_source = origin_cm;
+    _path_destination = destination_cm;
+
     // create visgraphs of origin and destination to fence points
     if (!update_visgraph(_source_visgraph, {AP_OAVisGraph::OATYPE_SOURCE, 0}, _path_source, true, _path_destination)) {
         err_id = AP_OADijkstra_Error::DIJKSTRA_ERROR_OUT_OF_MEMORY;
@@ -896,20 +1242,32 @@ bool AP_OADijkstra::calc_shortest_path(const Location &origin, const Location &d
         return false;
     }
 
-    // expand _short_path_data if necessary
-    if (!_short_path_data.expand_to_hold(2 + total_numpoints())) {
+    // expand _short_path_data and heap if necessary
+    const uint16_t num_nodes = 2 + _fence_visgraph_numpoints;
+    if (!_short_path_data.expand_to_hold(num_nodes) || !_heap.expand_to_hold(num_nodes)) {
         err_id = AP_OADijkstra_Error::DIJKSTRA_ERROR_OUT_OF_MEMORY;
         return false;
     }
 
-    // add origin and destination (node_type, id, visited, distance_from_idx, distance_cm) to short_path_data array
-    _short_path_data[0] = {{AP_OAVisGraph::OATYPE_SOURCE, 0}, false, 0, 0};
-    _short_path_data[1] = {{AP_OAVisGraph::OATYPE_DESTINATION, 0}, false, OA_DIJKSTRA_POLYGON_SHORTPATH_NOTSET_IDX, FLT_MAX};
+    // add origin and destination (node_type, id, visited, distance_from_idx, heap_idx, distance_cm, heuristic_cm, dest_distance_cm) to short_path_data array
+    // heuristics is simple Euclidean distance from the node to the destination
+    // This should be admissible, therefore optimal path is guaranteed
+    _short_path_data[0] = {{AP_OAVisGraph::OATYPE_SOURCE, 0}, false, 0, OA_DIJKSTRA_POLYGON_SHORTPATH_NOTSET_IDX, 0, (_path_source - _path_destination).length(), FLT_MAX};
+    _short_path_data[1] = {{AP_OAVisGraph::OATYPE_DESTINATION, 0}, false, OA_DIJKSTRA_POLYGON_SHORTPATH_NOTSET_IDX, OA_DIJKSTRA_POLYGON_SHORTPATH_NOTSET_IDX, FLT_MAX, 0, 0};
     _short_path_data_numpoints = 2;
 
-    // add all inclusion and exclusion fence points to short_path_data array (node_type, id, visited, distance_from_idx, distance_cm)
-    for (uint8_t i=0; i<total_numpoints(); i++) {
-        _short_path_data[_short_path_data_numpoints++] = {{AP_OAVisGraph::OATYPE_INTERMEDIATE_POINT, i}, false, OA_DIJKSTRA_POLYGON_SHORTPATH_NOTSET_IDX, FLT_MAX};
+    // add all inclusion and exclusion fence points to short_path_data array
+    for (uint16_t i=0; i<_fence_visgraph_numpoints; i++) {
+        _short_path_data[_short_path_data_numpoints++] = {{AP_OAVisGraph::OATYPE_INTERMEDIATE_POINT, i}, false, OA_DIJKSTRA_POLYGON_SHORTPATH_NOTSET_IDX, OA_DIJKSTRA_POLYGON_SHORTPATH_NOTSET_IDX, FLT_MAX, (_fence_visgraph_pts[i] - _path_destination).length(), FLT_MAX};
+    }
+    _heap_numpoints = 0;
+
+    // record distance to destination from nodes that can see it
+    for (uint16_t i = 0; i < _destination_visgraph.num_items(); i++) {
+        node_index node_idx;
+        if (find_node_from_id(_destination_visgraph[i].id2, node_idx)) {
+            _short_path_data[node_idx].dest_distance_cm = _destination_visgraph[i].distance_cm;
+        }
     }
 
     // start algorithm from source point
@@ -919,8 +1277,7 @@ bool AP_OADijkstra::calc_shortest_path(const Location &origin, const Location &d
     for (uint16_t i = 0; i < _source_visgraph.num_items(); i++) {
         node_index node_idx;
         if (find_node_from_id(_source_visgraph[i].id2, node_idx)) {
-            _short_path_data[node_idx].distance_cm = _source_visgraph[i].distance_cm;
-            _short_path_data[node_idx].distance_from_idx = current_node_idx;
+            update_node_distance(current_node_idx, node_idx, _source_visgraph[i].distance_cm);
         } else {
             err_id = AP_OADijkstra_Error::DIJKSTRA_ERROR_COULD_NOT_FIND_PATH;
             return false;
@@ -929,8 +1286,8 @@ bool AP_OADijkstra::calc_shortest_path(const Location &origin, const Location &d
     // mark source node as visited
     _short_path_data[current_node_idx].visited = true;
 
-    // move current_node_idx to node with lowest distance
-    while (find_closest_node_idx(current_node_idx)) {
+    // move current_node_idx to node with lowest distance plus heuristic
+    while (heap_pop(current_node_idx)) {
         node_index dest_node;
         // See if this next "closest" node is actually the destination
         if (find_node_from_id({AP_OAVisGraph::OATYPE_DESTINATION,0}, dest_node) && current_node_idx == dest_node) {
@@ -985,7 +1342,7 @@ bool AP_OADijkstra::calc_shortest_path(const Location &origin, const Location &d
 }
 
 // return point from final path as an offset (in cm) from the ekf origin
-bool AP_OADijkstra::get_shortest_path_point(uint8_t point_num, Vector2f& pos) const
+bool AP_OADijkstra::get_shortest_path_point(uint16_t point_num, Vector2f& pos) const
 {
     if ((_path_numpoints == 0) || (point_num >= _path_numpoints)) {
         return false;
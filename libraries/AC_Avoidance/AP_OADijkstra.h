@@ -12,12 +12,19 @@
 
 /*
  * Dijkstra's algorithm for path planning around polygon fence
+ *
+ * The search is A* with a straight line heuristic, taking nodes from a
+ * binary heap. The visibility graph between fence points records which
+ * fence item blocks each pair of points, so that when fences change
+ * only the pairs affected by the changed items are checked again
  */
 
 class AP_OADijkstra {
+    friend class AP_OADijkstra_test;
 public:
 
     AP_OADijkstra(AP_Int16 &options);
+    ~AP_OADijkstra();
 
     CLASS_NO_COPY(AP_OADijkstra);  /* Do not allow copies */
 
@@ -120,15 +127,59 @@ private:
     bool intersects_fence(const Vector2f &seg_start, const Vector2f &seg_end) const;
 
     // create visibility graph for all fence (with margin) points
+    // only the pairs of points affected by fence items that have changed since the last call are checked
     // returns true on success.  returns false on failure and err_id is updated
     bool create_fence_visgraph(AP_OADijkstra_Error &err_id);
 
+    // fence items that may block a path, with the range of points (with margin) created around them
+    struct FenceGroup {
+        enum class Type : uint8_t {
+            INCLUSION_POLYGON,
+            EXCLUSION_POLYGON,
+            EXCLUSION_CIRCLE,
+            INCLUSION_CIRCLE,
+        } type;
+        uint8_t fence_idx;      // index of the item amongst AC_PolyFence_loader's items of the same type
+        uint16_t first_point;   // index of the first point (with margin) around the item
+        uint16_t num_points;    // number of points (with margin) around the item
+        uint32_t crc;           // crc of the item's boundary and points, used to detect changes
+        Vector2f bbox_min;      // bounding box of the item as offsets (in cm) from the ekf origin
+        Vector2f bbox_max;
+    };
+
+    // create list of fence items and the points around them, returns nullptr if out of memory
+    // consistent is set false if the fence items no longer match the points (with margin) they were created from
+    FenceGroup *create_fence_groups(uint16_t &num_groups, bool &consistent) const;
+
+    // returns true if line segment intersects a fence item
+    bool intersects_fence_group(const FenceGroup &group, const Vector2f &seg_start, const Vector2f &seg_end) const;
+
+    // returns the index of the first fence item in groups that the segment intersects, or OA_DIJKSTRA_FENCE_VISIBLE
+    // if changed_only is true only the items marked in changed are checked
+    uint16_t find_blocking_group(const FenceGroup *groups, uint16_t num_groups, const bool *changed, bool changed_only, const Vector2f &seg_start, const Vector2f &seg_end) const;
+
+    // index into _fence_blocker of a pair of fence points
+    static uint32_t fence_pair_index(uint16_t i, uint16_t j) {
+        if (i > j) {
+            const uint16_t tmp = i;
+            i = j;
+            j = tmp;
+        }
+        return (uint32_t(j) * (j - 1)) / 2 + i;
+    }
+
+    // returns true if the line between two fence points does not intersect any fence
+    bool fence_points_visible(uint16_t i, uint16_t j) const;
+
     // calculate shortest path from origin to destination
     // returns true on success.  returns false on failure and err_id is updated
     // requires create_polygon_fence_with_margin and create_polygon_fence_visgraph to have been run
     // resulting path is stored in _shortest_path array as vector offsets from EKF origin
     bool calc_shortest_path(const Location &origin, const Location &destination, AP_OADijkstra_Error &err_id);
 
+    // calculate shortest path between offsets (in cm) from the EKF origin
+    bool calc_shortest_path(const Vector2f &origin_cm, const Vector2f &destination_cm, AP_OADijkstra_Error &err_id);
+
     // shortest path state variables
     bool _inclusion_polygon_with_margin_ok;
     bool _exclusion_polygon_with_margin_ok;
@@ -138,27 +189,39 @@ private:
 
     Location _destination_prev;     // destination of previous iterations (used to determine if path should be re-calculated)
     Location _next_destination_prev;// next_destination of previous iterations (used to determine if path should be re-calculated)
-    uint8_t _path_idx_returned;     // index into _path array which gives location vehicle should be currently moving towards
+    uint16_t _path_idx_returned;    // index into _path array which gives location vehicle should be currently moving towards
     bool _dest_to_next_dest_clear;  // true if path from dest to next_dest is clear (i.e. does not intersects a fence)
 
     // inclusion polygon (with margin) related variables
     float _polyfence_margin = 10;           // margin around polygon defaults to 10m but is overriden with set_fence_margin
     AP_ExpandingArray<Vector2f> _inclusion_polygon_pts; // array of nodes corresponding to inclusion polygon points plus a margin
-    uint8_t _inclusion_polygon_numpoints;   // number of points held in above array
+    uint16_t _inclusion_polygon_numpoints;  // number of points held in above array
+    AP_ExpandingArray<uint16_t> _inclusion_polygon_numpoints_each;  // number of points created for each inclusion polygon
+    uint8_t _inclusion_polygon_num;         // number of inclusion polygons held in above array
     uint32_t _inclusion_polygon_update_ms;  // system time of boundary update from AC_Fence (used to detect changes to polygon fence)
 
     // exclusion polygon related variables
     AP_ExpandingArray<Vector2f> _exclusion_polygon_pts; // array of nodes corresponding to exclusion polygon points plus a margin
-    uint8_t _exclusion_polygon_numpoints;   // number of points held in above array
+    uint16_t _exclusion_polygon_numpoints;  // number of points held in above array
+    AP_ExpandingArray<uint16_t> _exclusion_polygon_numpoints_each;  // number of points created for each exclusion polygon
+    uint8_t _exclusion_polygon_num;         // number of exclusion polygons held in above array
     uint32_t _exclusion_polygon_update_ms;  // system time exclusion polygon was updated (used to detect changes)
 
     // exclusion circle related variables
     AP_ExpandingArray<Vector2f> _exclusion_circle_pts; // array of nodes surrounding exclusion circles plus a margin
-    uint8_t _exclusion_circle_numpoints;    // number of points held in above array
+    uint16_t _exclusion_circle_numpoints;   // number of points held in above array
+    uint8_t _exclusion_circle_num;          // number of exclusion circles with points in above array
     uint32_t _exclusion_circle_update_ms;   // system time exclusion circles were updated (used to detect changes)
 
+    // fence visibility graph.  For each pair of fence points (with margin) holds the index into _fence_groups
+    // of the first fence item found to block the line between them, or OA_DIJKSTRA_FENCE_VISIBLE
+    uint16_t *_fence_blocker;
+    Vector2f *_fence_visgraph_pts;          // copy of the fence points (with margin) used to create the fence visgraph
+    uint16_t _fence_visgraph_numpoints;     // number of points in above array
+    FenceGroup *_fence_groups;              // fence items used to create the fence visgraph
+    uint16_t _fence_groups_num;             // number of items in above array
+
     // visibility graphs
-    AP_OAVisGraph _fence_visgraph;          // holds distances between all inclusion/exclusion fence points (with margin)
     AP_OAVisGraph _source_visgraph;         // holds distances from source point to all other nodes
     AP_OAVisGraph _destination_visgraph;    // holds distances from the destination to all other nodes
 
@@ -168,16 +231,42 @@ private:
     // returns true on success
     bool update_visgraph(AP_OAVisGraph& visgraph, const AP_OAVisGraph::OAItemID& oaid, const Vector2f &position, bool add_extra_position = false, Vector2f extra_position = Vector2f(0,0));
 
-    typedef uint8_t node_index;         // indices into short path data
+    typedef uint16_t node_index;        // indices into short path data
     struct ShortPathNode {
         AP_OAVisGraph::OAItemID id;     // unique id for node (combination of type and id number)
         bool visited;                   // true if all this node's neighbour's distances have been updated
-        node_index distance_from_idx;   // index into _short_path_data from where distance was updated (or 255 if not set)
+        node_index distance_from_idx;   // index into _short_path_data from where distance was updated (or OA_DIJKSTRA_POLYGON_SHORTPATH_NOTSET_IDX if not set)
+        node_index heap_idx;            // index into _heap while the node is held there (or OA_DIJKSTRA_POLYGON_SHORTPATH_NOTSET_IDX if not)
         float distance_cm;              // distance from source (number is tentative until this node is the current node and/or visited = true)
+        float heuristic_cm;             // straight line distance to destination
+        float dest_distance_cm;         // distance to destination if visible from this node, FLT_MAX if not
     };
     AP_ExpandingArray<ShortPathNode> _short_path_data;
     node_index _short_path_data_numpoints;  // number of elements in _short_path_data array
 
+    // binary heap of nodes reached but not yet visited, ordered by distance from source plus heuristic
+    AP_ExpandingArray<node_index> _heap;
+    node_index _heap_numpoints;             // number of elements in _heap array
+
+    // add node to heap or move it up the heap after its distance has been reduced
+    void heap_update(node_index node_idx);
+
+    // remove node with lowest distance plus heuristic from heap
+    // returns true if successful and node_idx argument is updated
+    bool heap_pop(node_index &node_idx);
+
+    // returns true if node a should be taken from the heap before node b
+    bool heap_less(node_index a, node_index b) const {
+        return (_short_path_data[a].distance_cm + _short_path_data[a].heuristic_cm) <
+               (_short_path_data[b].distance_cm + _short_path_data[b].heuristic_cm);
+    }
+
+    // move heap element to new position, keeping node's heap index up to date
+    void heap_set(node_index heap_idx, node_index node_idx);
+
+    // update a node's distance if it is shorter to reach it from the current node
+    void update_node_distance(node_index curr_node_idx, node_index node_idx, float dist_cm);
+
     // update total distance for all nodes visible from current node
     // curr_node_idx is an index into the _short_path_data array
     void update_visible_node_distances(node_index curr_node_idx);
@@ -186,21 +275,17 @@ private:
     // returns true if successful and node_idx is updated
     bool find_node_from_id(const AP_OAVisGraph::OAItemID &id, node_index &node_idx) const;
 
-    // find index of node with lowest tentative distance (ignore visited nodes)
-    // returns true if successful and node_idx argument is updated
-    bool find_closest_node_idx(node_index &node_idx) const;
-
     // final path variables and functions
     AP_ExpandingArray<AP_OAVisGraph::OAItemID> _path;   // ids of points on return path in reverse order (i.e. destination is first element)
-    uint8_t _path_numpoints;                            // number of points on return path
+    uint16_t _path_numpoints;                           // number of points on return path
     Vector2f _path_source;                              // source point used in shortest path calculations (offset in cm from EKF origin)
     Vector2f _path_destination;                         // destination position used in shortest path calculations (offset in cm from EKF origin)
 
     // return number of points on path
-    uint8_t get_shortest_path_numpoints() const { return _path_numpoints; }
+    uint16_t get_shortest_path_numpoints() const { return _path_numpoints; }
 
     // return point from final path as an offset (in cm) from the ekf origin
-    bool get_shortest_path_point(uint8_t point_num, Vector2f& pos) const;
+    bool get_shortest_path_point(uint16_t point_num, Vector2f& pos) const;
 
     // find the position of a node as an offset (in cm) from the ekf origin
     // returns true if successful and pos is updated
@@ -211,13 +296,13 @@ private:
 
 #if HAL_LOGGING_ENABLED
     // Logging functions
-    void Write_OADijkstra(const uint8_t state, const uint8_t error_id, const uint8_t curr_point, const uint8_t tot_points, const Location &final_dest, const Location &oa_dest) const;
-    void Write_Visgraph_point(const uint8_t version, const uint8_t point_num, const int32_t Lat, const int32_t Lon) const;
+    void Write_OADijkstra(const uint8_t state, const uint8_t error_id, const uint16_t curr_point, const uint16_t tot_points, const Location &final_dest, const Location &oa_dest) const;
+    void Write_Visgraph_point(const uint8_t version, const uint16_t point_num, const int32_t Lat, const int32_t Lon) const;
 #else
-    void Write_OADijkstra(const uint8_t state, const uint8_t error_id, const uint8_t curr_point, const uint8_t tot_points, const Location &final_dest, const Location &oa_dest) const {}
-    void Write_Visgraph_point(const uint8_t version, const uint8_t point_num, const int32_t Lat, const int32_t Lon) const {}
+    void Write_OADijkstra(const uint8_t state, const uint8_t error_id, const uint16_t curr_point, const uint16_t tot_points, const Location &final_dest, const Location &oa_dest) const {}
+    void Write_Visgraph_point(const uint8_t version, const uint16_t point_num, const int32_t Lat, const int32_t Lon) const {}
 #endif
-    uint8_t _log_num_points;
+    uint16_t _log_num_points;
     uint8_t _log_visgraph_version;
 
     // reference to AP_OAPathPlanner options param
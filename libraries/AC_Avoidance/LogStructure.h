@@ -59,8 +59,8 @@ struct PACKED log_OADijkstra {
     uint64_t time_us;
     uint8_t state;
     uint8_t error_id;
-    uint8_t curr_point;
-    uint8_t tot_points;
+    uint16_t curr_point;
+    uint16_t tot_points;
     int32_t final_lat;
     int32_t final_lng;
     int32_t oa_lat;
@@ -102,7 +102,7 @@ struct PACKED log_OD_Visgraph {
   LOG_PACKET_HEADER;
   uint64_t time_us;
   uint8_t version;
-  uint8_t point_num;
+  uint16_t point_num;
   int32_t Lat;
   int32_t Lon;
 };
@@ -112,11 +112,11 @@ struct PACKED log_OD_Visgraph {
     { LOG_OA_BENDYRULER_MSG, sizeof(log_OABendyRuler), \
       "OABR","QBBHHHBfLLfLLf","TimeUS,Type,Act,DYaw,Yaw,DP,RChg,Mar,DLt,DLg,DAlt,OLt,OLg,OAlt", "s--ddd-mDUmDUm", "F-------GG0GG0" , true }, \
     { LOG_OA_DIJKSTRA_MSG, sizeof(log_OADijkstra), \
-      "OADJ","QBBBBLLLL","TimeUS,State,Err,CurrPoint,TotPoints,DLat,DLng,OALat,OALng", "s----DUDU", "F----GGGG" , true }, \
+      "OADJ","QBBHHLLLL","TimeUS,State,Err,CurrPoint,TotPoints,DLat,DLng,OALat,OALng", "s----DUDU", "F----GGGG" , true }, \
     { LOG_SIMPLE_AVOID_MSG, sizeof(log_SimpleAvoid), \
       "SA",  "QBffffffB","TimeUS,State,DVelX,DVelY,DVelZ,MVelX,MVelY,MVelZ,Back", "s-nnnnnn-", "F--------", true }, \
      { LOG_OD_VISGRAPH_MSG, sizeof(log_OD_Visgraph), \
-      "OAVG", "QBBLL", "TimeUS,version,point_num,Lat,Lon", "s--DU", "F--GG", true},
+      "OAVG", "QBHLL", "TimeUS,version,point_num,Lat,Lon", "s--DU", "F--GG", true},
 #else
 #define LOG_STRUCTURE_FROM_AVOIDANCE
 #endif // AP_AVOIDANCE_ENABLED
@@ -0,0 +1,179 @@
+/*
+   This program is free software: you can redistribute it and/or modify
+   it under the terms of the GNU General Public License as published by
+   the Free Software Foundation, either version 3 of the License, or
+   (at your option) any later version.
+
+   This program is distributed in the hope that it will be useful,
+   but WITHOUT ANY WARRANTY; without even the implied warranty of
+   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+   GNU General Public License for more details.
+
+   You should have received a copy of the GNU General Public License
+   along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+/*
+  object database queries with and without the spatial index. The
+  database is filled from synthetic 360 degree lidar scans of a room
+  with some clutter, and the argument is the number of objects held.
+  Each BendyRuler iteration checks the margin along 72 probe bearings,
+  and each scan of 360 points is matched against the database
+ */
+#include <AP_gbenchmark.h>
+
+#include <AC_Avoidance/AP_OADatabase.h>
+
+const AP_HAL::HAL& hal = AP_HAL::get_HAL();
+
+typedef AP_OADatabase::OA_DbItem OA_DbItem;
+
+static const float beam_width_scalar = 0.0875f;    // tan(5deg)
+static const uint8_t num_probes = 72;
+static const float probe_length = 15;
+
+// range to the walls of a 24m by 16m room, or closer clutter
+static float scan_range(float bearing_deg, uint32_t n)
+{
+    const float b = radians(bearing_deg);
+    const float range_x = 12 / MAX(fabsf(cosf(b)), 0.01f);
+    const float range_y = 8 / MAX(fabsf(sinf(b)), 0.01f);
+    float range = MIN(range_x, range_y);
+    if ((n % 7) == 0) {
+        range *= 0.4f + 0.05f * (n % 5);
+    }
+    return range;
+}
+
+static Vector3f scan_point(float bearing_deg, float range)
+{
+    const float b = radians(bearing_deg);
+    return Vector3f{range * cosf(b), range * sinf(b), 1};
+}
+
+static uint16_t fill_items(OA_DbItem *items, uint16_t count)
+{
+    for (uint16_t i=0; i<count; i++) {
+        const float bearing = i * 360.0f / count;
+        const float range = scan_range(bearing, i);
+        items[i] = OA_DbItem{};
+        items[i].pos = scan_point(bearing, range);
+        items[i].radius = range * beam_width_scalar;
+        items[i].source = OA_DbItem::Source::proximity;
+    }
+    return count;
+}
+
+static bool item_match(const OA_DbItem &A, const OA_DbItem &B)
+{
+    return A.source == B.source && (A.pos - B.pos).length_squared() < sq(MAX(A.radius, B.radius));
+}
+
+static void BM_OADatabaseMarginScan(benchmark::State& state)
+{
+    const uint16_t count = state.range(0);
+    OA_DbItem *items = new OA_DbItem[count];
+    fill_items(items, count);
+    const Vector3f start{0, 0, 1};
+    while (state.KeepRunning()) {
+        float best = 0;
+        for (uint8_t p=0; p<num_probes; p++) {
+            const Vector3f end = scan_point(p * 5.0f, probe_length);
+            float smallest_margin = FLT_MAX;
+            for (uint16_t i=0; i<count; i++) {
+                const float m = Vector3f::closest_distance_between_line_and_point(start, end, items[i].pos) - items[i].radius;
+                smallest_margin = MIN(smallest_margin, m);
+            }
+            best = MAX(best, smallest_margin);
+        }
+        gbenchmark_escape(&best);
+    }
+    delete[] items;
+}
+
+static void BM_OADatabaseMarginIndex(benchmark::State& state)
+{
+    const uint16_t count = state.range(0);
+    OA_DbItem *items = new OA_DbItem[count];
+    AP_OADatabaseIndex<OA_DbItem> index {};
+    index.init(items, count);
+    fill_items(items, count);
+    for (uint16_t i=0; i<count; i++) {
+        index.insert(i);
+    }
+    const Vector3f start{0, 0, 1};
+    while (state.KeepRunning()) {
+        float best = 0;
+        for (uint8_t p=0; p<num_probes; p++) {
+            const Vector3f end = scan_point(p * 5.0f, probe_length);
+            float margin;
+            index.closest_to_segment(start, end, count, margin);
+            best = MAX(best, margin);
+        }
+        gbenchmark_escape(&best);
+    }
+    delete[] items;
+}
+
+// match one 360 point scan against the database, as process_queue() does
+static void BM_OADatabaseMatchScan(benchmark::State& state)
+{
+    const uint16_t count = state.range(0);
+    OA_DbItem *items = new OA_DbItem[count];
+    fill_items(items, count);
+    uint32_t n = 0;
+    while (state.KeepRunning()) {
+        uint16_t matched = 0;
+        for (uint16_t b=0; b<360; b++, n++) {
+            const float range = scan_range(b, n);
+            OA_DbItem item {};
+            item.pos = scan_point(b, range);
+            item.radius = range * beam_width_scalar;
+            item.source = OA_DbItem::Source::proximity;
+            for (uint16_t i=0; i<count; i++) {
+                if (item_match(items[i], item)) {
+                    matched++;
+                    break;
+                }
+            }
+        }
+        gbenchmark_escape(&matched);
+    }
+    delete[] items;
+}
+
+static void BM_OADatabaseMatchIndex(benchmark::State& state)
+{
+    const uint16_t count = state.range(0);
+    OA_DbItem *items = new OA_DbItem[count];
+    AP_OADatabaseIndex<OA_DbItem> index {};
+    index.init(items, count);
+    fill_items(items, count);
+    for (uint16_t i=0; i<count; i++) {
+        index.insert(i);
+    }
+    uint32_t n = 0;
+    while (state.KeepRunning()) {
+        uint16_t matched = 0;
+        for (uint16_t b=0; b<360; b++, n++) {
+            const float range = scan_range(b, n);
+            OA_DbItem item {};
+            item.pos = scan_point(b, range);
+            item.radius = range * beam_width_scalar;
+            item.source = OA_DbItem::Source::proximity;
+            const int32_t found = index.find_first(item.pos, MAX(item.radius, index.max_radius()), count,
+                                                   [&](const OA_DbItem &other) { return item_match(other, item); });
+            if (found != -1) {
+                matched++;
+            }
+        }
+        gbenchmark_escape(&matched);
+    }
+    delete[] items;
+}
+
+BENCHMARK(BM_OADatabaseMarginScan)->Arg(100)->Arg(400)->Arg(1000);
+BENCHMARK(BM_OADatabaseMarginIndex)->Arg(100)->Arg(400)->Arg(1000);
+BENCHMARK(BM_OADatabaseMatchScan)->Arg(100)->Arg(400)->Arg(1000);
+BENCHMARK(BM_OADatabaseMatchIndex)->Arg(100)->Arg(400)->Arg(1000);
+
+BENCHMARK_MAIN();
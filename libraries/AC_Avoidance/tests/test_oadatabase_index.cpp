@@ -0,0 +1,208 @@
+/*
+  check the object database's spatial index finds the same items as a
+  scan of every item
+ */
+#include <AP_gtest.h>
+
+#include <AC_Avoidance/AP_OADatabase.h>
+
+const AP_HAL::HAL& hal = AP_HAL::get_HAL();
+
+#if AP_OADATABASE_ENABLED
+
+typedef AP_OADatabase::OA_DbItem Item;
+
+static const uint16_t MAX_ITEMS = 300;
+static Item items[MAX_ITEMS];
+static uint16_t count;
+
+static uint32_t seed = 1;
+
+static uint32_t random_int(uint32_t n)
+{
+    seed = seed * 1103515245U + 12345U;
+    return (seed >> 8) % n;
+}
+
+static float random_float(float low, float high)
+{
+    return low + (high - low) * random_int(10001) * 1.0e-4f;
+}
+
+// a coordinate which is often exactly on the edge of a cell
+static float random_coordinate(float centre, float spread)
+{
+    if (random_int(3) == 0) {
+        const int32_t cells = int32_t(spread / AP_OADATABASE_INDEX_CELL_SIZE);
+        return centre + (int32_t(random_int(2 * cells + 1)) - cells) * AP_OADATABASE_INDEX_CELL_SIZE;
+    }
+    return centre + random_float(-spread, spread);
+}
+
+// a mix of point-like, small and large items
+static float random_radius()
+{
+    switch (random_int(4)) {
+    case 0:
+        return 0;
+    case 1:
+        return random_float(5, 12);
+    default:
+        return random_float(0.05f, 2);
+    }
+}
+
+/*
+  a cloud of items in a few clusters, leaving most cells empty, kept
+  in the index the same way as the database does
+ */
+static void create_cloud(AP_OADatabaseIndex<Item> &index)
+{
+    count = 0;
+    const uint8_t num_clusters = 1 + random_int(4);
+    Vector2f centres[4];
+    for (uint8_t i=0; i<num_clusters; i++) {
+        centres[i] = Vector2f{float(int32_t(random_int(81)) - 40), float(int32_t(random_int(81)) - 40)};
+    }
+    const uint16_t n = random_int(MAX_ITEMS + 1);
+    for (uint16_t i=0; i<n; i++) {
+        const Vector2f &centre = centres[random_int(num_clusters)];
+        Item &item = items[count];
+        item.pos = Vector3f{random_coordinate(centre.x, 8), random_coordinate(centre.y, 8), random_float(-2, 2)};
+        item.radius = random_radius();
+        index.insert(count);
+        count++;
+    }
+
+    // remove some, moving the last item into the gap, and move others
+    const uint16_t changes = count / 4;
+    for (uint16_t i=0; i<changes && count > 0; i++) {
+        const uint16_t idx = random_int(count);
+        if (random_int(2) == 0) {
+            index.remove(idx);
+            count--;
+            if (idx != count) {
+                index.remove(count);
+                items[idx] = items[count];
+                index.insert(idx);
+            }
+        } else {
+            index.remove(idx);
+            items[idx].pos.x = random_coordinate(items[idx].pos.x, 4);
+            items[idx].radius = random_radius();
+            index.insert(idx);
+        }
+    }
+    if (random_int(2) == 0) {
+        index.update(count);
+    }
+}
+
+static Vector3f random_point()
+{
+    return Vector3f{random_coordinate(0, 50), random_coordinate(0, 50), random_float(-2, 2)};
+}
+
+static float margin_to(const Vector3f &start, const Vector3f &end, const Item &item)
+{
+    return Vector3f::closest_distance_between_line_and_point(start, end, item.pos) - item.radius;
+}
+
+TEST(AP_OADatabaseIndex, closest_to_segment_matches_scan)
+{
+    for (uint16_t cloud=0; cloud<200; cloud++) {
+        AP_OADatabaseIndex<Item> index {};
+        ASSERT_TRUE(index.init(items, MAX_ITEMS));
+        create_cloud(index);
+
+        for (uint16_t n=0; n<50; n++) {
+            const Vector3f start = random_point();
+            Vector3f end;
+            switch (random_int(3)) {
+            case 0:
+                end = start;
+                break;
+            case 1:
+                // a short segment, as BendyRuler probes
+                end = start + Vector3f{random_float(-5, 5), random_float(-5, 5), 0};
+                break;
+            default:
+                end = random_point();
+                break;
+            }
+
+            float margin;
+            const bool found = index.closest_to_segment(start, end, count, margin);
+            ASSERT_EQ(found, count > 0);
+            if (!found) {
+                continue;
+            }
+            float expected = FLT_MAX;
+            for (uint16_t i=0; i<count; i++) {
+                expected = MIN(expected, margin_to(start, end, items[i]));
+            }
+            EXPECT_FLOAT_EQ(margin, expected);
+        }
+    }
+}
+
+TEST(AP_OADatabaseIndex, find_first_matches_scan)
+{
+    for (uint16_t cloud=0; cloud<200; cloud++) {
+        AP_OADatabaseIndex<Item> index {};
+        ASSERT_TRUE(index.init(items, MAX_ITEMS));
+        create_cloud(index);
+
+        for (uint16_t n=0; n<50; n++) {
+            // query near the items, often on a cell edge
+            Vector3f pos = random_point();
+            if (count > 0 && random_int(2) == 0) {
+                pos = items[random_int(count)].pos;
+                pos.x = random_coordinate(pos.x, 2);
+            }
+            const float radius = random_int(4) == 0 ? 0 : random_float(0.1f, 6);
+            const float min_item_radius = random_float(0, 3);
+
+            // items within radius horizontally, and only some of those
+            auto match = [&](const Item &item) {
+                const Vector2f diff{item.pos.x - pos.x, item.pos.y - pos.y};
+                return diff.length() <= radius && item.radius >= min_item_radius;
+            };
+
+            int32_t expected = -1;
+            for (uint16_t i=0; i<count; i++) {
+                if (match(items[i])) {
+                    expected = i;
+                    break;
+                }
+            }
+            EXPECT_EQ(index.find_first(pos, radius, count, match), expected);
+        }
+    }
+}
+
+TEST(AP_OADatabaseIndex, unallocated_index_scans)
+{
+    AP_OADatabaseIndex<Item> index {};
+    EXPECT_FALSE(index.init(items, 0));
+    count = 0;
+    for (uint16_t i=0; i<20; i++) {
+        items[count].pos = random_point();
+        items[count].radius = random_radius();
+        index.insert(count);
+        count++;
+    }
+    const Vector3f start = random_point();
+    const Vector3f end = random_point();
+    float margin;
+    ASSERT_TRUE(index.closest_to_segment(start, end, count, margin));
+    float expected = FLT_MAX;
+    for (uint16_t i=0; i<count; i++) {
+        expected = MIN(expected, margin_to(start, end, items[i]));
+    }
+    EXPECT_FLOAT_EQ(margin, expected);
+}
+
+#endif  // AP_OADATABASE_ENABLED
+
+AP_GTEST_MAIN()
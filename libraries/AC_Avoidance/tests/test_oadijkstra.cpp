@@ -0,0 +1,316 @@
+/*
+  check the incrementally updated fence visibility graph matches one
+  created from scratch, and that the path search finds paths as short
+  as an exhaustive search of the visibility graph
+ */
+#include <AP_gtest.h>
+
+#include <AC_Avoidance/AP_OADijkstra.h>
+#include <AC_Fence/AC_Fence.h>
+
+const AP_HAL::HAL& hal = AP_HAL::get_HAL();
+
+#if AP_OAPATHPLANNER_DIJKSTRA_ENABLED
+
+static AC_Fence fence;
+static AP_Int16 oa_options;
+
+static uint32_t seed = 1;
+
+static int32_t random_int(int32_t low, int32_t high)
+{
+    seed = seed * 1103515245U + 12345U;
+    return low + int32_t((seed >> 8) % uint32_t(high - low + 1));
+}
+
+class AP_OADijkstra_test {
+public:
+    static const uint8_t MAX_EXCLUSION_POLYGONS = 4;
+    static const uint8_t MAX_EXCLUSION_POLYGON_POINTS = 6;
+    static const uint8_t MAX_EXCLUSION_CIRCLES = 4;
+    static const uint8_t INCLUSION_POLYGON_POINTS = 8;
+
+    // fence items loaded directly into the polygon fence loader
+    static Vector2f inclusion_points[INCLUSION_POLYGON_POINTS];
+    static Vector2f exclusion_points[MAX_EXCLUSION_POLYGONS][MAX_EXCLUSION_POLYGON_POINTS];
+    static AC_PolyFence_loader::InclusionBoundary inclusion_boundary[1];
+    static AC_PolyFence_loader::ExclusionBoundary exclusion_boundary[MAX_EXCLUSION_POLYGONS];
+    static AC_PolyFence_loader::ExclusionCircle exclusion_circle[MAX_EXCLUSION_CIRCLES];
+    static uint8_t num_exclusion_polygons;
+    static uint8_t num_exclusion_circles;
+
+    // create an octagon 200m across around the origin
+    static void create_inclusion_polygon()
+    {
+        for (uint8_t i = 0; i < INCLUSION_POLYGON_POINTS; i++) {
+            const float angle = i * M_2PI / INCLUSION_POLYGON_POINTS;
+            inclusion_points[i] = Vector2f{10000.0f * cosf(angle), 10000.0f * sinf(angle)};
+        }
+        inclusion_boundary[0].points = inclusion_points;
+        inclusion_boundary[0].count = INCLUSION_POLYGON_POINTS;
+    }
+
+    // place a star shaped exclusion polygon at random inside the inclusion polygon
+    static void randomise_exclusion_polygon(uint8_t idx)
+    {
+        const Vector2f centre {float(random_int(-6000, 6000)), float(random_int(-6000, 6000))};
+        const uint8_t n = random_int(3, MAX_EXCLUSION_POLYGON_POINTS);
+        for (uint8_t i = 0; i < n; i++) {
+            const float angle = i * M_2PI / n;
+            const float r = random_int(500, 1500);
+            exclusion_points[idx][i] = centre + Vector2f{r * cosf(angle), r * sinf(angle)};
+        }
+        exclusion_boundary[idx].points = exclusion_points[idx];
+        exclusion_boundary[idx].count = n;
+    }
+
+    // place an exclusion circle at random inside the inclusion polygon
+    static void randomise_exclusion_circle(uint8_t idx)
+    {
+        exclusion_circle[idx].pos_cm = Vector2f{float(random_int(-6000, 6000)), float(random_int(-6000, 6000))};
+        exclusion_circle[idx].radius = random_int(3, 10);
+    }
+
+    // make a random change to the fence
+    static void edit_fence()
+    {
+        switch (random_int(0, 5)) {
+        case 0:
+            if (num_exclusion_polygons < MAX_EXCLUSION_POLYGONS) {
+                randomise_exclusion_polygon(num_exclusion_polygons++);
+            }
+            break;
+        case 1:
+            if (num_exclusion_polygons > 0) {
+                // remove a polygon, moving the later ones down
+                const uint8_t idx = random_int(0, num_exclusion_polygons - 1);
+                for (uint8_t i = idx; i + 1 < num_exclusion_polygons; i++) {
+                    memcpy(exclusion_points[i], exclusion_points[i+1], sizeof(exclusion_points[i]));
+                    exclusion_boundary[i].count = exclusion_boundary[i+1].count;
+                }
+                num_exclusion_polygons--;
+            }
+            break;
+        case 2:
+            if (num_exclusion_polygons > 0) {
+                randomise_exclusion_polygon(random_int(0, num_exclusion_polygons - 1));
+            }
+            break;
+        case 3:
+            if (num_exclusion_circles < MAX_EXCLUSION_CIRCLES) {
+                randomise_exclusion_circle(num_exclusion_circles++);
+            }
+            break;
+        case 4:
+            if (num_exclusion_circles > 0) {
+                const uint8_t idx = random_int(0, num_exclusion_circles - 1);
+                exclusion_circle[idx] = exclusion_circle[--num_exclusion_circles];
+            }
+            break;
+        default:
+            // leave the fence unchanged
+            break;
+        }
+        load_fence();
+    }
+
+    // point the polygon fence loader at the fence items
+    static void load_fence()
+    {
+        AC_PolyFence_loader &loader = fence.polyfence();
+        loader._loaded_inclusion_boundary = inclusion_boundary;
+        loader._num_loaded_inclusion_boundaries = 1;
+        loader._loaded_exclusion_boundary = exclusion_boundary;
+        loader._num_loaded_exclusion_boundaries = num_exclusion_polygons;
+        loader._loaded_circle_exclusion_boundary = exclusion_circle;
+        loader._num_loaded_circle_exclusion_boundaries = num_exclusion_circles;
+        loader._num_loaded_circle_inclusion_boundaries = 0;
+        loader._load_time_ms++;
+    }
+
+    // create the points (with margin) around the fence items
+    static bool create_margin_points(AP_OADijkstra &oa)
+    {
+        AP_OADijkstra::AP_OADijkstra_Error err_id;
+        const float margin_cm = oa._polyfence_margin * 100.0f;
+        return oa.create_inclusion_polygon_with_margin(margin_cm, err_id) &&
+               oa.create_exclusion_polygon_with_margin(margin_cm, err_id) &&
+               oa.create_exclusion_circle_with_margin(margin_cm, err_id);
+    }
+
+    // create the fence visgraph from the points (with margin)
+    static bool create_fence_visgraph(AP_OADijkstra &oa)
+    {
+        AP_OADijkstra::AP_OADijkstra_Error err_id;
+        return oa.create_fence_visgraph(err_id);
+    }
+
+    // create the points (with margin) and fence visgraph
+    static bool create_visgraph(AP_OADijkstra &oa)
+    {
+        return create_margin_points(oa) && create_fence_visgraph(oa);
+    }
+
+    // check the visgraph agrees with a check of every pair of points against every fence item
+    static void check_visgraph(const AP_OADijkstra &incremental, const AP_OADijkstra &full)
+    {
+        ASSERT_EQ(incremental._fence_visgraph_numpoints, full._fence_visgraph_numpoints);
+        const uint16_t num_points = full._fence_visgraph_numpoints;
+        for (uint16_t i = 0; i < num_points; i++) {
+            EXPECT_EQ(incremental._fence_visgraph_pts[i], full._fence_visgraph_pts[i]);
+        }
+        for (uint16_t j = 1; j < num_points; j++) {
+            for (uint16_t i = 0; i < j; i++) {
+                const bool visible = !full.intersects_fence(full._fence_visgraph_pts[i], full._fence_visgraph_pts[j]);
+                EXPECT_EQ(visible, full.fence_points_visible(i, j));
+                EXPECT_EQ(visible, incremental.fence_points_visible(i, j));
+            }
+        }
+    }
+
+    // returns the length of the path found between two points, or -1 if there is none
+    static float path_length(AP_OADijkstra &oa, const Vector2f &source, const Vector2f &destination)
+    {
+        AP_OADijkstra::AP_OADijkstra_Error err_id;
+        if (!oa.calc_shortest_path(source, destination, err_id)) {
+            return -1;
+        }
+        float length = 0;
+        Vector2f prev;
+        EXPECT_TRUE(oa.get_shortest_path_point(0, prev));
+        EXPECT_EQ(prev, source);
+        for (uint16_t i = 1; i < oa.get_shortest_path_numpoints(); i++) {
+            Vector2f point;
+            EXPECT_TRUE(oa.get_shortest_path_point(i, point));
+            length += (point - prev).length();
+            prev = point;
+        }
+        EXPECT_EQ(prev, destination);
+        return length;
+    }
+
+    // returns the length of the shortest path found by visiting every reachable node, or -1 if there is none
+    static float exhaustive_path_length(const AP_OADijkstra &oa, const Vector2f &source, const Vector2f &destination)
+    {
+        // nodes are the source, the fence points and then the destination
+        const uint16_t num_nodes = oa._fence_visgraph_numpoints + 2;
+        Vector2f *nodes = NEW_NOTHROW Vector2f[num_nodes];
+        float *distance = NEW_NOTHROW float[num_nodes];
+        bool *visited = NEW_NOTHROW bool[num_nodes];
+        nodes[0] = source;
+        for (uint16_t i = 0; i < oa._fence_visgraph_numpoints; i++) {
+            nodes[i+1] = oa._fence_visgraph_pts[i];
+        }
+        nodes[num_nodes-1] = destination;
+        for (uint16_t i = 0; i < num_nodes; i++) {
+            distance[i] = FLT_MAX;
+            visited[i] = false;
+        }
+        distance[0] = 0;
+
+        while (true) {
+            // visit the closest node not yet visited
+            uint16_t curr = num_nodes;
+            for (uint16_t i = 0; i < num_nodes; i++) {
+                if (!visited[i] && (distance[i] < FLT_MAX) && ((curr == num_nodes) || (distance[i] < distance[curr]))) {
+                    curr = i;
+                }
+            }
+            if (curr == num_nodes) {
+                break;
+            }
+            visited[curr] = true;
+            for (uint16_t i = 0; i < num_nodes; i++) {
+                if (!visited[i] && !oa.intersects_fence(nodes[curr], nodes[i])) {
+                    distance[i] = MIN(distance[i], distance[curr] + (nodes[i] - nodes[curr]).length());
+                }
+            }
+        }
+
+        const float length = (distance[num_nodes-1] < FLT_MAX) ? distance[num_nodes-1] : -1;
+        delete[] nodes;
+        delete[] distance;
+        delete[] visited;
+        return length;
+    }
+};
+
+Vector2f AP_OADijkstra_test::inclusion_points[INCLUSION_POLYGON_POINTS];
+Vector2f AP_OADijkstra_test::exclusion_points[MAX_EXCLUSION_POLYGONS][MAX_EXCLUSION_POLYGON_POINTS];
+AC_PolyFence_loader::InclusionBoundary AP_OADijkstra_test::inclusion_boundary[1];
+AC_PolyFence_loader::ExclusionBoundary AP_OADijkstra_test::exclusion_boundary[MAX_EXCLUSION_POLYGONS];
+AC_PolyFence_loader::ExclusionCircle AP_OADijkstra_test::exclusion_circle[MAX_EXCLUSION_CIRCLES];
+uint8_t AP_OADijkstra_test::num_exclusion_polygons;
+uint8_t AP_OADijkstra_test::num_exclusion_circles;
+
+TEST(AP_OADijkstra, incremental_visgraph_matches_full)
+{
+    AP_OADijkstra_test::create_inclusion_polygon();
+    AP_OADijkstra_test::load_fence();
+
+    AP_OADijkstra *incremental = NEW_NOTHROW AP_OADijkstra(oa_options);
+    ASSERT_NE(incremental, nullptr);
+    for (uint16_t iter = 0; iter < 200; iter++) {
+        AP_OADijkstra_test::edit_fence();
+        AP_OADijkstra *full = NEW_NOTHROW AP_OADijkstra(oa_options);
+        ASSERT_NE(full, nullptr);
+        ASSERT_TRUE(AP_OADijkstra_test::create_visgraph(*incremental));
+        ASSERT_TRUE(AP_OADijkstra_test::create_visgraph(*full));
+        AP_OADijkstra_test::check_visgraph(*incremental, *full);
+        delete full;
+    }
+    delete incremental;
+}
+
+TEST(AP_OADijkstra, fence_changed_after_margin_created)
+{
+    AP_OADijkstra_test::create_inclusion_polygon();
+    AP_OADijkstra_test::load_fence();
+
+    AP_OADijkstra *incremental = NEW_NOTHROW AP_OADijkstra(oa_options);
+    ASSERT_NE(incremental, nullptr);
+    for (uint16_t iter = 0; iter < 200; iter++) {
+        // the fence may change between creating the points (with margin) and the visgraph
+        AP_OADijkstra_test::edit_fence();
+        ASSERT_TRUE(AP_OADijkstra_test::create_margin_points(*incremental));
+        AP_OADijkstra_test::edit_fence();
+        EXPECT_TRUE(AP_OADijkstra_test::create_fence_visgraph(*incremental));
+
+        AP_OADijkstra *full = NEW_NOTHROW AP_OADijkstra(oa_options);
+        ASSERT_NE(full, nullptr);
+        ASSERT_TRUE(AP_OADijkstra_test::create_visgraph(*incremental));
+        ASSERT_TRUE(AP_OADijkstra_test::create_visgraph(*full));
+        AP_OADijkstra_test::check_visgraph(*incremental, *full);
+        delete full;
+    }
+    delete incremental;
+}
+
+TEST(AP_OADijkstra, path_length_matches_exhaustive_search)
+{
+    AP_OADijkstra_test::create_inclusion_polygon();
+    AP_OADijkstra_test::load_fence();
+
+    AP_OADijkstra *oa = NEW_NOTHROW AP_OADijkstra(oa_options);
+    ASSERT_NE(oa, nullptr);
+    for (uint16_t iter = 0; iter < 100; iter++) {
+        AP_OADijkstra_test::edit_fence();
+        ASSERT_TRUE(AP_OADijkstra_test::create_visgraph(*oa));
+        for (uint8_t q = 0; q < 10; q++) {
+            const Vector2f source {float(random_int(-7000, 7000)), float(random_int(-7000, 7000))};
+            const Vector2f destination {float(random_int(-7000, 7000)), float(random_int(-7000, 7000))};
+            const float length = AP_OADijkstra_test::path_length(*oa, source, destination);
+            const float expected = AP_OADijkstra_test::exhaustive_path_length(*oa, source, destination);
+            if (expected < 0) {
+                EXPECT_LT(length, 0);
+            } else {
+                EXPECT_NEAR(length, expected, expected * 1.0e-5f + 0.01f);
+            }
+        }
+    }
+    delete oa;
+}
+
+#endif  // AP_OAPATHPLANNER_DIJKSTRA_ENABLED
+
+AP_GTEST_MAIN()
@@ -0,0 +1,296 @@
+/*
+   This program is free software: you can redistribute it and/or modify
+   it under the terms of the GNU General Public License as published by
+   the Free Software Foundation, either version 3 of the License, or
+   (at your option) any later version.
+
+   This program is distributed in the hope that it will be useful,
+   but WITHOUT ANY WARRANTY; without even the implied warranty of
+   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+   GNU General Public License for more details.
+
+   You should have received a copy of the GNU General Public License
+   along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "AC_PolyFence_grid.h"
+
+#if AP_FENCE_ENABLED
+
+#include <string.h>
+
+// most list entries we'll allocate per edge before making the bands
+// or cells coarser
+#define AC_POLYFENCE_GRID_ENTRIES_PER_EDGE 8U
+
+// most grid cells along each side
+#define AC_POLYFENCE_GRID_MAX_CELLS 32U
+
+bool AC_PolyFenceGrid::init(const Vector2l *points_lla, const Vector2f *points, uint8_t count)
+{
+    clear();
+
+    _points_lla = points_lla;
+    _points = points;
+    _count = count;
+    // as the Polygon_ functions, ignore a closing point
+    _lla_edges = Polygon_complete(points_lla, count) ? count - 1 : count;
+    _edges = Polygon_complete(points, count) ? count - 1 : count;
+    if (_lla_edges < 3 || _edges < 3) {
+        return false;
+    }
+
+    _lla_min = _lla_max = points_lla[0];
+    _min = points[0];
+    _max = points[0];
+    for (uint8_t i=1; i<count; i++) {
+        _lla_min.x = MIN(_lla_min.x, points_lla[i].x);
+        _lla_min.y = MIN(_lla_min.y, points_lla[i].y);
+        _lla_max.x = MAX(_lla_max.x, points_lla[i].x);
+        _lla_max.y = MAX(_lla_max.y, points_lla[i].y);
+        _min.x = MIN(_min.x, points[i].x);
+        _min.y = MIN(_min.y, points[i].y);
+        _max.x = MAX(_max.x, points[i].x);
+        _max.y = MAX(_max.y, points[i].y);
+    }
+    _lla_span_y = int64_t(_lla_max.y) - _lla_min.y + 1;
+    _max_abs = MAX(MAX(fabsf(_min.x), fabsf(_min.y)), MAX(fabsf(_max.x), fabsf(_max.y)));
+
+    // bands: around one per edge, fewer if long edges span many bands
+    const uint32_t max_band_entries = AC_POLYFENCE_GRID_ENTRIES_PER_EDGE * _lla_edges;
+    uint32_t band_entries;
+    for (_num_bands=_lla_edges; ; _num_bands /= 2) {
+        band_entries = 0;
+        for (uint8_t e=0; e<_lla_edges; e++) {
+            const ListRange r = band_range(e);
+            band_entries += r.y1 - r.y0 + 1U;
+        }
+        if (band_entries <= max_band_entries || _num_bands == 1) {
+            break;
+        }
+    }
+
+    // cells: square, and around one per edge
+    const float width = _max.x - _min.x;
+    const float height = _max.y - _min.y;
+    _cell_size = sqrtf(width * height / constrain_int16(_edges, 4, 256));
+    _cell_size = MAX(_cell_size, MAX(width, height) / AC_POLYFENCE_GRID_MAX_CELLS);
+    _cell_size = MAX(_cell_size, 1.0f);
+    uint32_t cell_entries;
+    for (;;) {
+        _cells_x = MIN(uint32_t(ceilf(width / _cell_size)), AC_POLYFENCE_GRID_MAX_CELLS);
+        _cells_y = MIN(uint32_t(ceilf(height / _cell_size)), AC_POLYFENCE_GRID_MAX_CELLS);
+        _cells_x = MAX(_cells_x, 1);
+        _cells_y = MAX(_cells_y, 1);
+        cell_entries = 0;
+        for (uint8_t e=0; e<_edges; e++) {
+            const ListRange r = cell_range(e);
+            cell_entries += (r.x1 - r.x0 + 1U) * (r.y1 - r.y0 + 1U);
+        }
+        if (cell_entries <= AC_POLYFENCE_GRID_ENTRIES_PER_EDGE * _edges + _cells_x * _cells_y ||
+            (_cells_x == 1 && _cells_y == 1)) {
+            break;
+        }
+        _cell_size *= 2;
+    }
+
+    if (!build_lists(_lla_edges, 1, _num_bands, band_entries,
+                     [this](uint8_t e) { return band_range(e); },
+                     _band_start, _band_edges) ||
+        !build_lists(_edges, _cells_x, _cells_y, cell_entries,
+                     [this](uint8_t e) { return cell_range(e); },
+                     _cell_start, _cell_edges)) {
+        clear();
+        return false;
+    }
+    return true;
+}
+
+void AC_PolyFenceGrid::clear()
+{
+    delete[] _band_start;
+    _band_start = nullptr;
+    delete[] _band_edges;
+    _band_edges = nullptr;
+    delete[] _cell_start;
+    _cell_start = nullptr;
+    delete[] _cell_edges;
+    _cell_edges = nullptr;
+}
+
+// bands an edge spans part of
+AC_PolyFenceGrid::ListRange AC_PolyFenceGrid::band_range(uint8_t edge) const
+{
+    const Vector2l &v1 = _points_lla[edge];
+    const Vector2l &v2 = _points_lla[(edge + 1) % _lla_edges];
+    return ListRange {0, 0, band(MIN(v1.y, v2.y)), band(MAX(v1.y, v2.y))};
+}
+
+// cells overlapped by an edge's bounding box
+AC_PolyFenceGrid::ListRange AC_PolyFenceGrid::cell_range(uint8_t edge) const
+{
+    const Vector2f &v1 = _points[edge];
+    const Vector2f &v2 = _points[(edge + 1) % _edges];
+    return ListRange {
+        cell(MIN(v1.x, v2.x), _min.x, _cells_x),
+        cell(MAX(v1.x, v2.x), _min.x, _cells_x),
+        cell(MIN(v1.y, v2.y), _min.y, _cells_y),
+        cell(MAX(v1.y, v2.y), _min.y, _cells_y),
+    };
+}
+
+/*
+  allocate and fill the lists of edges for a grid of lists, with the
+  edges of list (x, y) at entries list_start[n] to list_start[n+1]-1
+  of list_edges, where n = y * num_x + x
+ */
+template <typename F>
+bool AC_PolyFenceGrid::build_lists(uint8_t num_edges, uint8_t num_x, uint8_t num_y, uint32_t total, F range_of,
+                                   uint16_t *&list_start, uint8_t *&list_edges)
+{
+    const uint16_t num_lists = num_x * num_y;
+    if (total > UINT16_MAX) {
+        return false;
+    }
+    list_start = NEW_NOTHROW uint16_t[num_lists + 1];
+    list_edges = NEW_NOTHROW uint8_t[MAX(total, 1U)];
+    if (list_start == nullptr || list_edges == nullptr) {
+        return false;
+    }
+    memset(list_start, 0, sizeof(list_start[0]) * (num_lists + 1));
+
+    // count the entries in each list, then make the counts into
+    // offsets of the start of each list
+    for (uint8_t e=0; e<num_edges; e++) {
+        const ListRange r = range_of(e);
+        for (uint16_t y=r.y0; y<=r.y1; y++) {
+            for (uint16_t x=r.x0; x<=r.x1; x++) {
+                list_start[y * num_x + x + 1]++;
+            }
+        }
+    }
+    for (uint16_t i=0; i<num_lists; i++) {
+        list_start[i+1] += list_start[i];
+    }
+
+    // fill the lists, which leaves each start at the start of the
+    // next list, then move them back
+    for (uint8_t e=0; e<num_edges; e++) {
+        const ListRange r = range_of(e);
+        for (uint16_t y=r.y0; y<=r.y1; y++) {
+            for (uint16_t x=r.x0; x<=r.x1; x++) {
+                list_edges[list_start[y * num_x + x]++] = e;
+            }
+        }
+    }
+    memmove(&list_start[1], &list_start[0], sizeof(list_start[0]) * (num_lists - 1));
+    list_start[0] = 0;
+    return true;
+}
+
+bool AC_PolyFenceGrid::outside(const Vector2l &pos) const
+{
+    if (_band_start == nullptr) {
+        return Polygon_outside(pos, _points_lla, _count);
+    }
+    // outside the bounding box every edge either crosses or doesn't
+    // cross the ray, so there are an even number of crossings
+    if (pos.x < _lla_min.x || pos.x > _lla_max.x ||
+        pos.y < _lla_min.y || pos.y > _lla_max.y) {
+        return true;
+    }
+    // an edge only crosses the ray if pos.y is within its y range,
+    // which puts it in the same band as pos
+    const uint8_t b = band(pos.y);
+    bool outside = true;
+    for (uint16_t i=_band_start[b]; i<_band_start[b+1]; i++) {
+        const uint8_t e = _band_edges[i];
+        if (Polygon_edge_crosses(pos, _points_lla[e], _points_lla[(e + 1) % _lla_edges])) {
+            outside = !outside;
+        }
+    }
+    return outside;
+}
+
+/*
+  search rings of cells around the cell holding pos, or the closest
+  cell if pos is outside the grid. A cell ring cells away is at least
+  (ring - 1) cells further from pos than the grid's bounding box is,
+  along one axis, so the search can stop once that is further than
+  the closest edge found or the limit. Cells further than the closest
+  edge found are skipped. A little is taken off each bound to allow
+  for rounding
+ */
+bool AC_PolyFenceGrid::closest_distance(const Vector2f &pos, float limit, float &distance) const
+{
+    if (_cell_start == nullptr) {
+        return Polygon_closest_distance_point(_points, _count, pos, distance);
+    }
+    if (!is_positive(limit)) {
+        distance = limit;
+        return true;
+    }
+
+    const int16_t cx = cell(pos.x, _min.x, _cells_x);
+    const int16_t cy = cell(pos.y, _min.y, _cells_y);
+    const int16_t max_ring = MAX(MAX(cx, _cells_x - 1 - cx), MAX(cy, _cells_y - 1 - cy));
+    const float slack = 0.1f * _cell_size + 16 * FLT_EPSILON * (_max_abs + fabsf(pos.x) + fabsf(pos.y));
+    // distance from pos to the grid along each axis
+    const float out_x = MAX(MAX(_min.x - pos.x, pos.x - _max.x), 0.0f);
+    const float out_y = MAX(MAX(_min.y - pos.y, pos.y - _max.y), 0.0f);
+
+    // edges can be in more than one cell, so remember which have
+    // been checked
+    uint32_t checked[(UINT8_MAX + 1) / 32] {};
+    float closest_sq = FLT_MAX;
+
+    for (int16_t ring=0; ring<=max_ring; ring++) {
+        const float ring_gap = MAX((ring - 1) * _cell_size - slack, 0.0f);
+        const float bound_sq = MIN(sq(out_x + ring_gap) + sq(out_y), sq(out_x) + sq(out_y + ring_gap));
+        if (bound_sq >= closest_sq) {
+            break;
+        }
+        if (bound_sq >= sq(limit)) {
+            distance = limit;
+            return true;
+        }
+        for (int16_t x=cx-ring; x<=cx+ring; x++) {
+            if (x < 0 || x >= _cells_x) {
+                continue;
+            }
+            const float cell_min_x = _min.x + x * _cell_size;
+            const float cell_max_x = (x == _cells_x - 1) ? _max.x : cell_min_x + _cell_size;
+            const float gap_x = MAX(MAX(cell_min_x - pos.x, pos.x - cell_max_x) - slack, 0.0f);
+            // only the edges of the ring are new
+            const bool edge_x = (x == cx - ring || x == cx + ring);
+            for (int16_t y=cy-ring; y<=cy+ring; y += (edge_x ? 1 : 2 * ring)) {
+                if (y < 0 || y >= _cells_y) {
+                    continue;
+                }
+                const float cell_min_y = _min.y + y * _cell_size;
+                const float cell_max_y = (y == _cells_y - 1) ? _max.y : cell_min_y + _cell_size;
+                const float gap_y = MAX(MAX(cell_min_y - pos.y, pos.y - cell_max_y) - slack, 0.0f);
+                if (sq(gap_x) + sq(gap_y) >= closest_sq) {
+                    continue;
+                }
+                const uint16_t c = y * _cells_x + x;
+                for (uint16_t i=_cell_start[c]; i<_cell_start[c+1]; i++) {
+                    const uint8_t e = _cell_edges[i];
+                    if (checked[e / 32] & (1U << (e % 32))) {
+                        continue;
+                    }
+                    checked[e / 32] |= 1U << (e % 32);
+                    const float dist_sq = Vector2f::closest_distance_between_line_and_point_squared(_points[e], _points[(e + 1) % _edges], pos);
+                    if (dist_sq < closest_sq) {
+                        closest_sq = dist_sq;
+                    }
+                }
+            }
+        }
+    }
+
+    distance = sqrtf(closest_sq);
+    return true;
+}
+
+#endif  // AP_FENCE_ENABLED
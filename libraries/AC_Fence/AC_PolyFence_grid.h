@@ -0,0 +1,101 @@
+#pragma once
+
+#include "AC_Fence_config.h"
+
+#if AP_FENCE_ENABLED
+
+#include <AP_Common/AP_Common.h>
+#include <AP_Math/AP_Math.h>
+
+/*
+ * Lookup structure for one loaded polygon fence, built when the fence
+ * is loaded so breach checks don't have to look at every edge.
+ *
+ * Point in polygon tests use the latitude/longitude points. The
+ * polygon's y range is split into equal bands, each listing the edges
+ * spanning part of it, so only the edges in the band holding the
+ * point can cross the ray Polygon_outside counts crossings of.
+ *
+ * Distance queries use the offsets from origin. Their bounding box is
+ * split into a grid of square cells, each listing the edges whose
+ * bounding box overlaps it, and rings of cells around the point are
+ * searched until no unvisited edge can be closer.
+ *
+ * Results are the same as Polygon_outside and
+ * Polygon_closest_distance_point, which are used instead if the lists
+ * couldn't be allocated.
+ */
+class AC_PolyFenceGrid {
+public:
+    AC_PolyFenceGrid() {}
+    ~AC_PolyFenceGrid() { clear(); }
+
+    /* Do not allow copies */
+    CLASS_NO_COPY(AC_PolyFenceGrid);
+
+    // build the lists for a polygon. The points must stay valid until
+    // clear() is called. Returns false if the lists couldn't be
+    // allocated
+    bool init(const Vector2l *points_lla, const Vector2f *points, uint8_t count);
+
+    // free the lists
+    void clear();
+
+    // returns true if pos is outside the polygon, as Polygon_outside
+    bool outside(const Vector2l &pos) const WARN_IF_UNUSED;
+
+    // closest distance in cm from pos to an edge of the polygon, as
+    // Polygon_closest_distance_point. The search stops early once no
+    // edge can be closer than limit, in which case distance is set to
+    // limit
+    bool closest_distance(const Vector2f &pos, float limit, float &distance) const WARN_IF_UNUSED;
+
+private:
+    // a range of lists an edge is in
+    struct ListRange {
+        uint8_t x0, x1;
+        uint8_t y0, y1;
+    };
+
+    ListRange band_range(uint8_t edge) const;
+    ListRange cell_range(uint8_t edge) const;
+
+    // build lists for a grid of num_x by num_y lists holding total entries
+    template <typename F>
+    static bool build_lists(uint8_t num_edges, uint8_t num_x, uint8_t num_y, uint32_t total, F range_of,
+                            uint16_t *&list_start, uint8_t *&list_edges);
+
+    // band holding a y coordinate, which must be within the polygon's range
+    uint8_t band(int32_t y) const {
+        return (uint8_t)((int64_t(y) - _lla_min.y) * _num_bands / _lla_span_y);
+    }
+    uint8_t cell(float v, float min_v, uint8_t num_cells) const {
+        return (uint8_t)constrain_float((v - min_v) / _cell_size, 0, num_cells - 1);
+    }
+
+    const Vector2l *_points_lla;
+    const Vector2f *_points;
+    uint8_t _count;
+
+    // bands for point in polygon tests
+    uint8_t _lla_edges;             // edges, excluding a closing point
+    Vector2l _lla_min;              // bounding box of the points
+    Vector2l _lla_max;
+    int64_t _lla_span_y;            // _lla_max.y - _lla_min.y + 1
+    uint8_t _num_bands;
+    uint16_t *_band_start = nullptr;    // first entry of each band, plus the total
+    uint8_t *_band_edges = nullptr;     // edges of each band
+
+    // grid for distance queries
+    uint8_t _edges;                 // edges, excluding a closing point
+    Vector2f _min;                  // bounding box of the points
+    Vector2f _max;
+    float _max_abs;                 // largest coordinate magnitude
+    float _cell_size;
+    uint8_t _cells_x;
+    uint8_t _cells_y;
+    uint16_t *_cell_start = nullptr;    // first entry of each cell, plus the total
+    uint8_t *_cell_edges = nullptr;     // edges of each cell
+};
+
+#endif  // AP_FENCE_ENABLED
@@ -229,7 +229,32 @@ bool AC_PolyFence_loader::breached() const
 
 // check if a position (expressed as lat/lng) is within the boundary
 //   returns true if location is outside the boundary
+bool AC_PolyFence_loader::breached(const Location& loc) const
+{
+    float distance_outside_fence;
+    return breached(loc, false, distance_outside_fence);
+}
+
 bool AC_PolyFence_loader::breached(const Location& loc, float& distance_outside_fence) const
+{
+    return breached(loc, true, distance_outside_fence);
+}
+
+/*
+  distance in cm beyond which a polygon edge can't change
+  distance_outside_fence when it is updated to MAX(distance_outside_fence,
+  -distance). The limit is a little further than needed so rounding
+  when converting to metres can't matter
+ */
+static float polygon_distance_limit(float distance_outside_fence)
+{
+    if (distance_outside_fence <= -FLT_MAX * 0.01f) {
+        return FLT_MAX;
+    }
+    return MAX(-distance_outside_fence * 101.0f, 0.0f);
+}
+
+bool AC_PolyFence_loader::breached(const Location& loc, bool want_distance, float& distance_outside_fence) const
 {
     if (!loaded() || total_fence_count() == 0) {
         return false;
@@ -249,19 +274,18 @@ bool AC_PolyFence_loader::breached(const Location& loc, float& distance_outside_
     for (uint8_t i=0; i<_num_loaded_inclusion_boundaries; i++) {
         const InclusionBoundary &boundary = _loaded_inclusion_boundary[i];
         float distance;
-        bool valid_distance = Polygon_closest_distance_point(boundary.points, boundary.count, scaled_pos, distance);
-        distance *= 0.01f; // convert back to meters
-        if (Polygon_outside(pos, boundary.points_lla, boundary.count)) {
+        if (boundary.grid.outside(pos)) {
             num_inclusion_outside++;
-            if (valid_distance) {
+            if (want_distance && boundary.grid.closest_distance(scaled_pos, FLT_MAX, distance)) {
+                distance *= 0.01f; // convert back to meters
                 if (is_positive(distance_outside_fence)) {
                     distance_outside_fence = MIN(distance_outside_fence, distance);
                 } else {
                     distance_outside_fence = distance;
                 }
             }
-        } else if (valid_distance) {
-            distance_outside_fence = MAX(distance_outside_fence, -distance);
+        } else if (want_distance && boundary.grid.closest_distance(scaled_pos, polygon_distance_limit(distance_outside_fence), distance)) {
+            distance_outside_fence = MAX(distance_outside_fence, -distance * 0.01f);
         }
     }
 
@@ -269,17 +293,15 @@ bool AC_PolyFence_loader::breached(const Location& loc, float& distance_outside_
     for (uint8_t i=0; i<_num_loaded_exclusion_boundaries; i++) {
         const ExclusionBoundary &boundary = _loaded_exclusion_boundary[i];
         float distance;
-        bool valid_distance = Polygon_closest_distance_point(boundary.points, boundary.count, scaled_pos, distance);
-        distance *= 0.01f; // convert back to meters
-        if (!Polygon_outside(pos, boundary.points_lla, boundary.count)) {
-            if (valid_distance) {
-                distance_outside_fence = distance;
+        if (!boundary.grid.outside(pos)) {
+            if (want_distance && boundary.grid.closest_distance(scaled_pos, FLT_MAX, distance)) {
+                distance_outside_fence = distance * 0.01f;
             } else {
                 distance_outside_fence = 0.0f;
             }
             return true;
-        } else if (valid_distance) {
-            distance_outside_fence = MAX(distance_outside_fence, -distance);
+        } else if (want_distance && boundary.grid.closest_distance(scaled_pos, polygon_distance_limit(distance_outside_fence), distance)) {
+            distance_outside_fence = MAX(distance_outside_fence, -distance * 0.01f);
         }
     }
 
@@ -906,6 +928,17 @@ bool AC_PolyFence_loader::load_from_storage()
         return false;
     }
 
+    // build the lookup structures for breach checks. If one can't be
+    // allocated that polygon is checked edge by edge
+    for (uint8_t i=0; i<_num_loaded_inclusion_boundaries; i++) {
+        InclusionBoundary &boundary = _loaded_inclusion_boundary[i];
+        IGNORE_RETURN(boundary.grid.init(boundary.points_lla, boundary.points, boundary.count));
+    }
+    for (uint8_t i=0; i<_num_loaded_exclusion_boundaries; i++) {
+        ExclusionBoundary &boundary = _loaded_exclusion_boundary[i];
+        IGNORE_RETURN(boundary.grid.init(boundary.points_lla, boundary.points, boundary.count));
+    }
+
     _load_time_ms = AP_HAL::millis();
 
     get_loaded_fence_semaphore().give();
@@ -1705,6 +1738,7 @@ bool AC_PolyFence_loader::get_inclusion_circle(uint8_t index, Vector2f &center_p
 void AC_PolyFence_loader::handle_msg(GCS_MAVLINK &link, const mavlink_message_t& msg) {};
 
 bool AC_PolyFence_loader::breached() const { return false; }
+bool AC_PolyFence_loader::breached(const Location& loc) const { return false; }
 bool AC_PolyFence_loader::breached(const Location& loc, float& distance_outside_fence) const { return false; }
 
 uint16_t AC_PolyFence_loader::max_items() const { return 0; }
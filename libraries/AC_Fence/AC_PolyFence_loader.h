@@ -52,8 +52,11 @@ public:
 #include <AP_Common/Location.h>
 #include <GCS_MAVLink/GCS_MAVLink.h>
 
+#include "AC_PolyFence_grid.h"
+
 class AC_PolyFence_loader
 {
+    friend class AP_OADijkstra_test;
 
 public:
 
@@ -148,11 +151,7 @@ public:
     //  returns true if location is outside the boundary also returns the minimum distance to the fence
     bool breached(const Location& loc, float& distance_outside_fence) const WARN_IF_UNUSED;
     //  breached(Location&) - returns true if location is outside the boundary
-    bool breached(const Location& loc) const WARN_IF_UNUSED
-    {
-        float distance_outside_fence;
-        return breached(loc, distance_outside_fence);
-    }
+    bool breached(const Location& loc) const WARN_IF_UNUSED;
 
     // returns true if a polygonal include fence could be returned
     bool inclusion_boundary_available() const WARN_IF_UNUSED {
@@ -293,6 +292,11 @@ private:
     // example, in _loaded_offsets_from_origin
     void unload();
 
+    // breach check shared by the public breached() methods. The
+    // distance to polygon edges is only calculated if want_distance
+    // is true
+    bool breached(const Location& loc, bool want_distance, float& distance_outside_fence) const WARN_IF_UNUSED;
+
     // pointer into _loaded_offsets_from_origin where the return point
     // can be found:
     Vector2f *_loaded_return_point;
@@ -306,6 +310,7 @@ private:
         Vector2f *points; // pointer into the _loaded_offsets_from_origin array
         Vector2l *points_lla; // pointer into the _loaded_points_lla array
         uint8_t count; // count of points in the boundary
+        AC_PolyFenceGrid grid; // lookup structure for breach checks
     };
     InclusionBoundary *_loaded_inclusion_boundary;
 
@@ -316,6 +321,7 @@ private:
         Vector2f *points; // pointer into the _loaded_offsets_from_origin array
         Vector2l *points_lla; // pointer into the _loaded_points_lla_lla array
         uint8_t count; // count of points in the boundary
+        AC_PolyFenceGrid grid; // lookup structure for breach checks
     };
     ExclusionBoundary *_loaded_exclusion_boundary;
 
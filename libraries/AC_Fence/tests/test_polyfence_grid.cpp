@@ -0,0 +1,100 @@
+/*
+  check the polygon fence lookup structure gives the same results as
+  the Polygon_ functions it replaces
+ */
+#include <AP_gtest.h>
+
+#include <AC_Fence/AC_PolyFence_grid.h>
+
+const AP_HAL::HAL& hal = AP_HAL::get_HAL();
+
+static uint32_t seed = 1;
+
+static int32_t random_int(int32_t low, int32_t high)
+{
+    seed = seed * 1103515245U + 12345U;
+    return low + int32_t((seed >> 8) % uint32_t(high - low + 1));
+}
+
+/*
+  fill in a polygon, in latitude/longitude and as offsets in cm,
+  returning the number of points
+ */
+static uint8_t make_polygon(uint8_t shape, uint8_t n, bool close, Vector2l *points_lla, Vector2f *points)
+{
+    const Vector2l origin {-353632610, 1491652300};
+    for (uint8_t i=0; i<n; i++) {
+        const float angle = i * M_2PI / n;
+        float x, y;
+        switch (shape) {
+        case 0: {
+            // star
+            const float r = (i & 1) ? random_int(200, 2000) : random_int(1000, 5000);
+            x = r * cosf(angle);
+            y = r * sinf(angle);
+            break;
+        }
+        case 1:
+            // long thin teeth, as a survey fence might have
+            if (i < n / 2) {
+                x = (i / 2) * 40;
+                y = ((i & 1) == ((i % 4) >= 2)) ? 0 : 3000;
+            } else {
+                x = (n - 1 - i) * 20;
+                y = -200 - (i & 1) * 50;
+            }
+            break;
+        default:
+            // self-intersecting
+            x = random_int(-3000, 3000);
+            y = random_int(-3000, 3000);
+            break;
+        }
+        points_lla[i] = Vector2l{origin.x + int32_t(x), origin.y + int32_t(y)};
+        points[i] = Vector2f{x * 1.1132f, y * 0.9063f};
+    }
+    if (close) {
+        points_lla[n] = points_lla[0];
+        points[n] = points[0];
+        n++;
+    }
+    return n;
+}
+
+TEST(AC_PolyFenceGrid, matches_polygon_functions)
+{
+    Vector2l points_lla[256];
+    Vector2f points[256];
+    for (uint16_t iter=0; iter<150; iter++) {
+        const uint8_t n = make_polygon(iter % 3, random_int(3, iter < 75 ? 20 : 250), iter & 1, points_lla, points);
+        AC_PolyFenceGrid grid;
+        EXPECT_TRUE(grid.init(points_lla, points, n));
+        for (uint16_t q=0; q<500; q++) {
+            // include points level with vertices
+            Vector2l pos = points_lla[random_int(0, n - 1)];
+            pos.x += random_int(-6000, 6000);
+            if (q & 1) {
+                pos.y += random_int(-6000, 6000);
+            }
+            EXPECT_EQ(Polygon_outside(pos, points_lla, n), grid.outside(pos));
+
+            const Vector2f pos_cm {(pos.x - points_lla[0].x) * 1.1132f + points[0].x,
+                                   (pos.y - points_lla[0].y) * 0.9063f + points[0].y};
+            float expected, distance;
+            EXPECT_TRUE(Polygon_closest_distance_point(points, n, pos_cm, expected));
+            EXPECT_TRUE(grid.closest_distance(pos_cm, FLT_MAX, distance));
+            EXPECT_FLOAT_EQ(expected, distance);
+
+            // with a limit the distance is exact if closer than the limit
+            const float limit = random_int(1, 3000);
+            EXPECT_TRUE(grid.closest_distance(pos_cm, limit, distance));
+            if (expected < limit) {
+                EXPECT_FLOAT_EQ(expected, distance);
+            } else {
+                EXPECT_GE(distance, limit);
+            }
+        }
+    }
+}
+
+AP_GTEST_MAIN()
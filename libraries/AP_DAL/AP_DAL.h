@@ -247,6 +247,10 @@ public:
     }
     void handle_message(const log_RFRF &msg, NavEKF2 &ekf2, NavEKF3 &ekf3);
 
+    // EKF3 initialisation state, kept in Replay checkpoints
+    bool ekf3_initialised() const { return ekf3_init_done; }
+    void set_ekf3_initialised(bool done) { ekf3_init_done = done; }
+
     void handle_message(const log_RISH &msg) {
         _ins.handle_message(msg);
     }
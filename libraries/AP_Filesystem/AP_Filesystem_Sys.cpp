@@ -26,6 +26,8 @@
 #include <AP_CANManager/AP_CANManager.h>
 #include <AP_Scheduler/AP_Scheduler.h>
 #include <AP_Common/ExpandingString.h>
+#include <AP_HAL/utility/Trace.h>
+#include <GCS_MAVLink/GCS.h>
 
 extern const AP_HAL::HAL& hal;
 
@@ -40,6 +42,9 @@ static const SysFileList sysfs_file_list[] = {
     {"memory.txt"},
     {"uarts.txt"},
     {"timers.txt"},
+#if HAL_GCS_ENABLED
+    {"streams.txt"},
+#endif
 #if HAL_MAX_CAN_PROTOCOL_DRIVERS
     {"can_log.txt"},
 #endif
@@ -52,6 +57,9 @@ static const SysFileList sysfs_file_list[] = {
 #endif
     {"crash_dump.bin"},
     {"storage.bin"},
+#if AP_HAL_TRACE_ENABLED
+    {"trace.json"},
+#endif
 #if AP_FILESYSTEM_SYS_FLASH_ENABLED
     {"flash.bin"},
 #endif
@@ -120,6 +128,16 @@ int AP_Filesystem_Sys::open(const char *fname, int flags, bool allow_absolute_pa
     if (strcmp(fname, "timers.txt") == 0) {
         hal.util->timer_info(*r.str);
     }
+#if HAL_GCS_ENABLED
+    if (strcmp(fname, "streams.txt") == 0) {
+        gcs().stream_rate_info(*r.str);
+    }
+#endif
+#if AP_HAL_TRACE_ENABLED
+    if (strcmp(fname, "trace.json") == 0) {
+        AP_HAL::Trace::export_json(*r.str);
+    }
+#endif
 #if HAL_CANMANAGER_ENABLED
     if (strcmp(fname, "can_log.txt") == 0) {
         AP::can().log_retrieve(*r.str);
@@ -68,6 +68,28 @@ void AP_Filesystem_Backend::unload_file(FileData *fd)
     }
 }
 
+/*
+  write a list of buffers in order. Backends without a native
+  gathering write fall back to one write() per buffer, stopping at the
+  first short write. Returns the total bytes written, or -1 if nothing
+  could be written
+*/
+int32_t AP_Filesystem_Backend::writev(int fd, const ByteBuffer::IoVec *iov, uint8_t iovcnt)
+{
+    int32_t total = 0;
+    for (uint8_t i=0; i<iovcnt; i++) {
+        const int32_t ret = write(fd, iov[i].data, iov[i].len);
+        if (ret < 0) {
+            return total > 0 ? total : ret;
+        }
+        total += ret;
+        if (uint32_t(ret) != iov[i].len) {
+            break;
+        }
+    }
+    return total;
+}
+
 // return true if file operations are allowed
 bool AP_Filesystem_Backend::file_op_allowed(void) const
 {
@@ -21,6 +21,7 @@
 
 #include <GCS_MAVLink/GCS.h>
 #include <AP_Logger/AP_Logger.h>
+#include <AP_HAL/utility/Trace.h>
 #include <Filter/HarmonicNotchFilter.h>
 #include <AP_BoardConfig/AP_BoardConfig.h>
 #include <AP_Arming/AP_Arming.h>
@@ -57,6 +58,7 @@ extern const AP_HAL::HAL& hal;
 #define FFT_HARMONIC_FIT_MULT       50.0f
 #define FFT_HARMONIC_FIT_TRACK_ROLL    4
 #define FFT_HARMONIC_FIT_TRACK_PITCH   5
+#define FFT_SDFT_REFRESH_MS         1000    // how long to track peaks with the sliding DFT before revalidating with the FFT
 
 // table of user settable parameters
 const AP_Param::GroupInfo AP_GyroFFT::var_info[] = {
@@ -169,8 +171,8 @@ const AP_Param::GroupInfo AP_GyroFFT::var_info[] = {
 
     // @Param: OPTIONS
     // @DisplayName: FFT options
-    // @Description: FFT configuration options. Values: 1:Apply the FFT *after* the filter bank,2:Check noise at the motor frequencies using ESC data as a reference
-    // @Bitmask: 0:Enable post-filter FFT,1:Check motor noise
+    // @Description: FFT configuration options. Values: 1:Apply the FFT *after* the filter bank,2:Check noise at the motor frequencies using ESC data as a reference,4:Analyse all three axes together each frame rather than one axis per frame, at the cost of extra memory,8:Once peaks are found track them with a sliding DFT updated every sample, falling back to the FFT to reacquire them
+    // @Bitmask: 0:Enable post-filter FFT,1:Check motor noise,2:Batch axes,3:Sliding DFT tracking
     // @User: Advanced
     // @RebootRequired: True
     AP_GROUPINFO("OPTIONS", 15, AP_GyroFFT, _options, 0),
@@ -234,7 +236,11 @@ __INITFUNC__ void AP_GyroFFT::init(uint16_t loop_rate_hz)
 
     // check that we have enough memory for the window size requested
     // INS: XYZ_AXIS_COUNT * INS_MAX_INSTANCES * _window_size, DSP: 3 * _window_size, FFT: XYZ_AXIS_COUNT + 3 * _window_size
-    const uint32_t allocation_count = (XYZ_AXIS_COUNT * INS_MAX_INSTANCES + 3 + XYZ_AXIS_COUNT + 3 + _num_frames) * sizeof(float);
+    // batched axes need a DSP state per axis rather than one shared between them
+    const uint8_t dsp_states = batch_axes() ? XYZ_AXIS_COUNT : 1;
+    // sliding DFT: (XYZ_AXIS_COUNT + 1) * _window_size
+    const uint8_t sdft_windows = sliding_dft_tracking() ? XYZ_AXIS_COUNT + 1 : 0;
+    const uint32_t allocation_count = (XYZ_AXIS_COUNT * INS_MAX_INSTANCES + (3 + _num_frames) * dsp_states + XYZ_AXIS_COUNT + 3 + sdft_windows) * sizeof(float);
     if (allocation_count * FFT_DEFAULT_WINDOW_SIZE > hal.util->available_memory() / 2) {
         GCS_SEND_TEXT(MAV_SEVERITY_WARNING, "AP_GyroFFT: disabled, required %u bytes", (unsigned int)allocation_count * FFT_DEFAULT_WINDOW_SIZE);
         return;
@@ -317,6 +323,38 @@ __INITFUNC__ void AP_GyroFFT::init(uint16_t loop_rate_hz)
         GCS_SEND_TEXT(MAV_SEVERITY_WARNING, "Failed to initialize DSP engine");
         return;
     }
+    _axis_state[0] = _state;
+    // additional states so that all axes can be analysed in one pass
+    if (batch_axes()) {
+        for (uint8_t axis = 1; axis < XYZ_AXIS_COUNT; axis++) {
+            _axis_state[axis] = hal.dsp->fft_init(_window_size, _fft_sampling_rate_hz, _num_frames);
+            if (_axis_state[axis] == nullptr) {
+                GCS_SEND_TEXT(MAV_SEVERITY_WARNING, "FFT: unable to batch axes");
+                for (uint8_t i = 1; i < axis; i++) {
+                    delete _axis_state[i];
+                    _axis_state[i] = nullptr;
+                }
+                break;
+            }
+        }
+    }
+
+    // peak trackers for use between FFTs
+    if (sliding_dft_tracking()) {
+        _sdft = NEW_NOTHROW AP_GyroFFT_SlidingDFT[XYZ_AXIS_COUNT];
+        _sdft_samples = NEW_NOTHROW float[_window_size];
+        bool ok = _sdft != nullptr && _sdft_samples != nullptr;
+        for (uint8_t axis = 0; ok && axis < XYZ_AXIS_COUNT; axis++) {
+            ok = _sdft[axis].init(_window_size, _fft_sampling_rate_hz);
+        }
+        if (!ok) {
+            GCS_SEND_TEXT(MAV_SEVERITY_WARNING, "FFT: unable to allocate sliding DFT");
+            delete[] _sdft;
+            _sdft = nullptr;
+            delete[] _sdft_samples;
+            _sdft_samples = nullptr;
+        }
+    }
 
     // per-axis frame time
     _frame_time_ms = _samples_per_frame * 1000 / _fft_sampling_rate_hz;
@@ -440,8 +478,16 @@ uint16_t AP_GyroFFT::run_cycle()
         return 0;
     }
 
+    if (_sdft_tracking) {
+        EngineConfig config = _config;
+        _sem.give();
+        return run_sdft_cycle(config);
+    }
+
+    const bool batch = batch_cycle_enabled();
+
     // do we have enough samples for another pass?
-    if (!start_analysis()) {
+    if (!start_analysis(batch)) {
         uint16_t new_sample_count =  get_available_samples(_update_axis);
         _sem.give();
         return new_sample_count;
@@ -452,6 +498,10 @@ uint16_t AP_GyroFFT::run_cycle()
 
     _sem.give();
 
+    if (batch) {
+        return run_batch_cycle(config);
+    }
+
     uint32_t now = AP_HAL::micros();
 
     // get the appropriate gyro buffer
@@ -476,7 +526,161 @@ uint16_t AP_GyroFFT::run_cycle()
     _output_cycle_micros = _thread_state._last_output_us[_update_axis] - now;
 
 #if AP_SIM_ENABLED && HAL_LOGGING_ENABLED
-    // extra logging when running simulations
+    write_sim_peaks_log();
+#endif
+
+    _sdft_fft_axes |= 1U << _update_axis;
+
+    // move onto the next axis
+    _update_axis = (_update_axis + 1) % XYZ_AXIS_COUNT;
+
+    // ready to receive another frame, because lock contention is so expensive we don't lock
+    // around this flag but rather rely on the semaphore at the beginning of the loop to
+    // ensure eventual visibility to the main loop
+    _thread_state._analysis_started = false;
+
+    start_sdft_tracking();
+
+    // samples remaining in the next axis
+    return get_available_samples(_update_axis);
+}
+
+// analyse all axes in one pass, returns number of samples still held
+// called from FFT thread
+uint16_t AP_GyroFFT::run_batch_cycle(const EngineConfig& config)
+{
+    uint32_t now = AP_HAL::micros();
+
+    for (uint8_t axis = 0; axis < XYZ_AXIS_COUNT; axis++) {
+        FloatBuffer& gyro_buffer = (_sample_mode == 0 ?_ins->get_raw_gyro_window(axis) : _downsampled_gyro_data[axis]);
+        // drop samples if we are struggling to keep up, as for a single axis
+        if (gyro_buffer.available() > uint32_t(_state->_window_size + uint16_t(_samples_per_frame >> 1))) {
+            gyro_buffer.advance(gyro_buffer.available() - _state->_window_size);
+        }
+        hal.dsp->fft_start(_axis_state[axis], gyro_buffer, _samples_per_frame);
+    }
+
+    uint16_t bin_max[XYZ_AXIS_COUNT];
+    hal.dsp->fft_analyse_batch(_axis_state, XYZ_AXIS_COUNT, config._fft_start_bin, config._fft_end_bin, config._attenuation_cutoff, bin_max);
+
+    // peak tracking works on the current axis and state
+    for (_update_axis = 0; _update_axis < XYZ_AXIS_COUNT; _update_axis++) {
+        _state = _axis_state[_update_axis];
+        update_ref_energy(bin_max[_update_axis]);
+        calculate_noise(false, config);
+        _thread_state._last_output_us[_update_axis] = AP_HAL::micros();
+#if AP_SIM_ENABLED && HAL_LOGGING_ENABLED
+        write_sim_peaks_log();
+#endif
+    }
+    _output_cycle_micros = _thread_state._last_output_us[XYZ_AXIS_COUNT - 1] - now;
+
+    _state = _axis_state[0];
+    _update_axis = 0;
+    _sdft_fft_axes = (1U << XYZ_AXIS_COUNT) - 1;
+
+    // ready to receive another frame, see run_cycle()
+    _thread_state._analysis_started = false;
+
+    start_sdft_tracking();
+
+    uint16_t remaining_samples = get_available_samples(0);
+    for (uint8_t axis = 1; axis < XYZ_AXIS_COUNT; axis++) {
+        remaining_samples = MIN(remaining_samples, get_available_samples(axis));
+    }
+    return remaining_samples;
+}
+
+// switch to tracking with the sliding DFT once every axis has a fresh lock on its center peak
+// called from FFT thread
+void AP_GyroFFT::start_sdft_tracking()
+{
+    if (_sdft == nullptr || _sdft_fft_axes != (1U << XYZ_AXIS_COUNT) - 1
+        || _thread_state._noise_needs_calibration || !_calibrated || _axis_state[0]->_averaging) {
+        return;
+    }
+
+    for (uint8_t axis = 0; axis < XYZ_AXIS_COUNT; axis++) {
+        if (_thread_state._health[axis] == 0 || _missed_cycles[axis][FrequencyPeak::CENTER] > 0) {
+            return;
+        }
+    }
+
+    for (uint8_t axis = 0; axis < XYZ_AXIS_COUNT; axis++) {
+        // only track peaks that the FFT is currently seeing
+        float freqs[FrequencyPeak::MAX_TRACKED_PEAKS] {};
+        for (uint8_t peak = 0; peak < _tracked_peaks; peak++) {
+            if (_missed_cycles[axis][peak] == 0) {
+                freqs[peak] = get_tl_noise_center_freq_hz(FrequencyPeak(peak), axis);
+            }
+        }
+        // the newest window of samples becomes the tracker history
+        FloatBuffer& gyro_buffer = (_sample_mode == 0 ?_ins->get_raw_gyro_window(axis) : _downsampled_gyro_data[axis]);
+        if (gyro_buffer.available() > _state->_window_size) {
+            gyro_buffer.advance(gyro_buffer.available() - _state->_window_size);
+        }
+        const uint16_t n = gyro_buffer.peek(_sdft_samples, _state->_window_size);
+        gyro_buffer.advance(n);
+        _sdft[axis].lock(_sdft_samples, n, freqs, FrequencyPeak::MAX_TRACKED_PEAKS);
+    }
+
+    _sdft_tracking = true;
+    _sdft_start_ms = AP_HAL::millis();
+}
+
+// track peaks with the sliding DFT using every new sample, returns number of samples still held
+// called from FFT thread
+uint16_t AP_GyroFFT::run_sdft_cycle(const EngineConfig& config)
+{
+    bool lost = false;
+
+    for (uint8_t axis = 0; axis < XYZ_AXIS_COUNT; axis++) {
+        FloatBuffer& gyro_buffer = (_sample_mode == 0 ?_ins->get_raw_gyro_window(axis) : _downsampled_gyro_data[axis]);
+        uint16_t n;
+        while ((n = gyro_buffer.peek(_sdft_samples, _state->_window_size)) > 0) {
+            for (uint16_t i = 0; i < n; i++) {
+                _sdft[axis].update(_sdft_samples[i]);
+            }
+            gyro_buffer.advance(n);
+        }
+
+        for (uint8_t peak = 0; peak < FrequencyPeak::MAX_TRACKED_PEAKS; peak++) {
+            if (!_sdft[axis].is_tracking(peak)) {
+                continue;
+            }
+            float freq_hz;
+            if (!_sdft[axis].get_peak_frequency(peak, freq_hz)
+                || freq_hz < config._fft_min_hz || freq_hz > config._fft_max_hz) {
+                lost = true;
+                continue;
+            }
+            update_tl_noise_center_freq_hz(FrequencyPeak(peak), axis, freq_hz);
+            if (peak == FrequencyPeak::CENTER) {
+                _thread_state._center_freq_hz[axis] = freq_hz;
+                _thread_state._health_ms[axis] = AP_HAL::millis();
+            }
+        }
+        _thread_state._last_output_us[axis] = AP_HAL::micros();
+    }
+
+    // reacquire with the FFT if a peak was lost and periodically so that
+    // energies, bandwidths and peak assignments are refreshed
+    if (lost || !_calibrated || _axis_state[0]->_averaging
+        || AP_HAL::millis() - _sdft_start_ms > FFT_SDFT_REFRESH_MS) {
+        for (uint8_t axis = 0; axis < XYZ_AXIS_COUNT; axis++) {
+            _sdft[axis].unlock();
+        }
+        _sdft_tracking = false;
+        _sdft_fft_axes = 0;
+    }
+
+    return 0;
+}
+
+#if AP_SIM_ENABLED && HAL_LOGGING_ENABLED
+// extra logging when running simulations
+void AP_GyroFFT::write_sim_peaks_log()
+{
     // @LoggerMessage: FTN3
     // @Description: Additional FFT Noise Frequency Peak
     // @Field: TimeUS: microseconds since system startup
@@ -507,23 +711,12 @@ uint16_t AP_GyroFFT::run_cycle()
         _state->_freq_bins[_state->_peak_data[0]._bin],
         _state->_freq_bins[_state->_peak_data[1]._bin],
         _state->_freq_bins[_state->_peak_data[2]._bin]);
-#endif
-
-    // move onto the next axis
-    _update_axis = (_update_axis + 1) % XYZ_AXIS_COUNT;
-
-    // ready to receive another frame, because lock contention is so expensive we don't lock
-    // around this flag but rather rely on the semaphore at the beginning of the loop to
-    // ensure eventual visibility to the main loop
-    _thread_state._analysis_started = false;
-
-    // samples remaining in the next axis
-    return get_available_samples(_update_axis);
 }
+#endif
 
 // whether analysis can be run again or not
 // called from FFT thread with the semaphore held
-bool AP_GyroFFT::start_analysis() {
+bool AP_GyroFFT::start_analysis(bool all_axes) {
     if (_thread_state._analysis_started) {
         return false;
     }
@@ -532,6 +725,16 @@ bool AP_GyroFFT::start_analysis() {
         return false;
     }
 
+    if (all_axes) {
+        for (uint8_t axis = 0; axis < XYZ_AXIS_COUNT; axis++) {
+            if (get_available_samples(axis) < _state->_window_size) {
+                return false;
+            }
+        }
+        _thread_state._analysis_started = true;
+        return true;
+    }
+
     if (get_available_samples(_update_axis) >= _state->_window_size) {
         _thread_state._analysis_started = true;
         return true;
@@ -572,7 +775,9 @@ void AP_GyroFFT::update_parameters(bool force)
 void AP_GyroFFT::update_thread(void)
 {
     while (true) {
+        HAL_TRACE_BEGIN("fft");
         uint16_t remaining_samples = run_cycle();
+        HAL_TRACE_END("fft");
         // this is to stop us burning CPU while waiting for samples, the reduction by _samples_per_frame is a heuristic to prevent waiting too long
         // and missing frames (easy to see in SITL because the noise will keep calibrating)
         // we always delay by at least 1us to give logging a chance to run at the same priority
@@ -719,7 +924,7 @@ void AP_GyroFFT::start_notch_tune()
         return;
     }
 
-    if (!hal.dsp->fft_start_average(_state)) {
+    if (!hal.dsp->fft_start_average(_axis_state[0])) {
         GCS_SEND_TEXT(MAV_SEVERITY_WARNING, "FFT: Unable to start FFT averaging");
     }
     // throttle averaging for average fft calculation
@@ -766,7 +971,7 @@ void AP_GyroFFT::stop_notch_tune()
 
     float freqs[FrequencyPeak::MAX_TRACKED_PEAKS] {};
 
-    uint16_t numpeaks = hal.dsp->fft_stop_average(_state, _config._fft_start_bin, _config._fft_end_bin, freqs);
+    uint16_t numpeaks = hal.dsp->fft_stop_average(_axis_state[0], _config._fft_start_bin, _config._fft_end_bin, freqs);
 
     if (numpeaks == 0) {
         return;
@@ -25,8 +25,10 @@
 #include <AP_Param/AP_Param.h>
 #include <AP_Math/AP_Math.h>
 #include <AP_InertialSensor/AP_InertialSensor.h>
+#include <AP_Logger/AP_Logger_config.h>
 #include <Filter/LowPassFilter.h>
 #include <Filter/FilterWithBuffer.h>
+#include "AP_GyroFFT_SlidingDFT.h"
 
 #define DEBUG_FFT   0
 
@@ -40,7 +42,9 @@ public:
 
     enum class Options : uint32_t {
         FFTPostFilter = 1 << 0,
-        ESCNoiseCheck = 1 << 1
+        ESCNoiseCheck = 1 << 1,
+        BatchAxes = 1 << 2,
+        SlidingDFT = 1 << 3
     };
 
     AP_GyroFFT();
@@ -111,6 +115,10 @@ public:
     bool using_post_filter_samples() const { return (_options & uint32_t(Options::FFTPostFilter)) != 0; }
     // post filter mask of IMUs
     bool check_esc_noise() const { return (_options & uint32_t(Options::ESCNoiseCheck)) != 0; }
+    // analyse all axes together in one DSP pass
+    bool batch_axes() const { return (_options & uint32_t(Options::BatchAxes)) != 0; }
+    // track locked peaks with a sliding DFT between full FFTs
+    bool sliding_dft_tracking() const { return (_options & uint32_t(Options::SlidingDFT)) != 0; }
     // look for a frequency in the detected noise
     float has_noise_at_frequency_hz(float freq) const;
     static float calculate_notch_frequency(float* freqs, uint16_t numpeaks, float harmonic_fit, uint8_t& harmonics);
@@ -219,7 +227,21 @@ private:
     // whether to run analysis or not
     bool analysis_enabled() const { return _initialized && _analysis_enabled && _thread_created; };
     // whether analysis can be run again or not
-    bool start_analysis();
+    bool start_analysis(bool all_axes);
+    // analyse all axes together, returns number of samples still held
+    uint16_t run_batch_cycle(const EngineConfig& config);
+    // whether the current cycle should analyse all axes together
+    bool batch_cycle_enabled() const {
+        return _axis_state[XYZ_AXIS_COUNT - 1] != nullptr && !_axis_state[0]->_averaging;
+    }
+    // track peaks with the sliding DFT, returns number of samples still held
+    uint16_t run_sdft_cycle(const EngineConfig& config);
+    // switch to sliding DFT tracking if every axis has a fresh lock from the FFT
+    void start_sdft_tracking();
+#if AP_SIM_ENABLED && HAL_LOGGING_ENABLED
+    // extra logging of the current axis when running simulations
+    void write_sim_peaks_log();
+#endif
     // return samples available in the gyro window
     uint16_t get_available_samples(uint8_t axis) {
         return _sample_mode == 0 ?_ins->get_raw_gyro_window(axis).available() : _downsampled_gyro_data[axis].available();
@@ -281,8 +303,20 @@ private:
     // count of oversamples
     uint16_t _oversampled_gyro_count;
 
-    // state of the FFT engine
+    // state of the FFT engine for the axis being analysed
     AP_HAL::DSP::FFTWindowState* _state;
+    // per-axis engine state when analysing axes together, the first entry is the primary state
+    AP_HAL::DSP::FFTWindowState* _axis_state[XYZ_AXIS_COUNT];
+    // per-axis sliding DFT peak trackers
+    AP_GyroFFT_SlidingDFT* _sdft;
+    // scratch space for moving samples into the trackers
+    float* _sdft_samples;
+    // peaks are currently tracked by the sliding DFT rather than the FFT
+    bool _sdft_tracking;
+    // time at which sliding DFT tracking started
+    uint32_t _sdft_start_ms;
+    // mask of axes analysed by the FFT since sliding DFT tracking last stopped
+    uint8_t _sdft_fft_axes;
     // update state machine step information
     uint8_t _update_axis;
     // noise base of the gyros
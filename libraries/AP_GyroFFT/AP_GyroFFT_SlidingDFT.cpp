@@ -0,0 +1,193 @@
+/*
+   This program is free software: you can redistribute it and/or modify
+   it under the terms of the GNU General Public License as published by
+   the Free Software Foundation, either version 3 of the License, or
+   (at your option) any later version.
+
+   This program is distributed in the hope that it will be useful,
+   but WITHOUT ANY WARRANTY; without even the implied warranty of
+   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+   GNU General Public License for more details.
+
+   You should have received a copy of the GNU General Public License
+   along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "AP_GyroFFT_SlidingDFT.h"
+
+#if HAL_GYROFFT_ENABLED
+
+#include <string.h>
+
+// rounding errors accumulate in the recursive update, so recalculate the bins every few windows
+#define SDFT_RESYNC_WINDOWS     8
+// lock is lost when the peak power falls this far below its power at lock, -13dB
+#define SDFT_LOSS_RATIO         0.05f
+
+AP_GyroFFT_SlidingDFT::~AP_GyroFFT_SlidingDFT()
+{
+    delete[] _history;
+}
+
+bool AP_GyroFFT_SlidingDFT::init(uint16_t window_size, float sample_rate_hz)
+{
+    if (window_size < 8 || !is_positive(sample_rate_hz)) {
+        return false;
+    }
+    delete[] _history;
+    _history = NEW_NOTHROW float[window_size];
+    if (_history == nullptr) {
+        _window_size = 0;
+        return false;
+    }
+    _window_size = window_size;
+    _bin_resolution = sample_rate_hz / window_size;
+    unlock();
+    return true;
+}
+
+void AP_GyroFFT_SlidingDFT::unlock()
+{
+    for (uint8_t i = 0; i < MAX_PEAKS; i++) {
+        _peaks[i].tracking = false;
+    }
+}
+
+void AP_GyroFFT_SlidingDFT::lock(const float* samples, uint16_t num_samples, const float* freqs_hz, uint8_t num_peaks)
+{
+    unlock();
+    if (_history == nullptr) {
+        return;
+    }
+
+    // the newest samples fill the end of the window, anything missing is treated as zero
+    const uint16_t n = MIN(num_samples, _window_size);
+    memset(_history, 0, sizeof(float) * (_window_size - n));
+    memcpy(&_history[_window_size - n], &samples[num_samples - n], sizeof(float) * n);
+    _pos = 0;
+    _samples_since_sync = 0;
+
+    for (uint8_t i = 0; i < MIN(num_peaks, MAX_PEAKS); i++) {
+        if (!is_positive(freqs_hz[i])) {
+            continue;
+        }
+        // keep all three bins between DC and Nyquist
+        const uint16_t k = constrain_int32(lrintf(freqs_hz[i] / _bin_resolution), 2, _window_size / 2 - 2);
+        Peak& peak = _peaks[i];
+        for (uint8_t b = 0; b < 3; b++) {
+            set_bin(peak.bins[b], k + b - 1);
+        }
+        peak.lock_power = power(peak.bins[1]);
+        peak.tracking = is_positive(peak.lock_power);
+    }
+}
+
+/*
+  the bin for the window ending at sample n is
+    S[n] = e^(2 pi i k / N) * (S[n-1] + x[n] - x[n-N])
+  which is the same as running the recursion over the history from zero
+ */
+void AP_GyroFFT_SlidingDFT::set_bin(Bin& bin, uint16_t k) const
+{
+    bin.k = k;
+    bin.cos_k = cosf(M_2PI * k / _window_size);
+    bin.sin_k = sinf(M_2PI * k / _window_size);
+    bin.re = 0.0f;
+    bin.im = 0.0f;
+    for (uint16_t m = 0, i = _pos; m < _window_size; m++) {
+        const float re = bin.re + _history[i];
+        bin.re = bin.cos_k * re - bin.sin_k * bin.im;
+        bin.im = bin.sin_k * re + bin.cos_k * bin.im;
+        if (++i == _window_size) {
+            i = 0;
+        }
+    }
+}
+
+void AP_GyroFFT_SlidingDFT::resync()
+{
+    for (uint8_t i = 0; i < MAX_PEAKS; i++) {
+        if (!_peaks[i].tracking) {
+            continue;
+        }
+        for (uint8_t b = 0; b < 3; b++) {
+            set_bin(_peaks[i].bins[b], _peaks[i].bins[b].k);
+        }
+    }
+    _samples_since_sync = 0;
+}
+
+void AP_GyroFFT_SlidingDFT::update(float sample)
+{
+    if (_history == nullptr) {
+        return;
+    }
+    const float delta = sample - _history[_pos];
+    _history[_pos] = sample;
+    if (++_pos == _window_size) {
+        _pos = 0;
+    }
+
+    for (uint8_t i = 0; i < MAX_PEAKS; i++) {
+        if (!_peaks[i].tracking) {
+            continue;
+        }
+        for (uint8_t b = 0; b < 3; b++) {
+            Bin& bin = _peaks[i].bins[b];
+            const float re = bin.re + delta;
+            bin.re = bin.cos_k * re - bin.sin_k * bin.im;
+            bin.im = bin.sin_k * re + bin.cos_k * bin.im;
+        }
+    }
+
+    if (++_samples_since_sync >= uint32_t(_window_size) * SDFT_RESYNC_WINDOWS) {
+        resync();
+    }
+}
+
+bool AP_GyroFFT_SlidingDFT::get_peak_frequency(uint8_t peak_idx, float& freq_hz)
+{
+    if (!is_tracking(peak_idx)) {
+        return false;
+    }
+    Peak& peak = _peaks[peak_idx];
+
+    // follow the peak into a neighbouring bin, the two shared bins carry over
+    const float p0 = power(peak.bins[0]);
+    const float p1 = power(peak.bins[1]);
+    const float p2 = power(peak.bins[2]);
+    if (p0 > p1 && p0 > p2 && peak.bins[0].k > 2) {
+        peak.bins[2] = peak.bins[1];
+        peak.bins[1] = peak.bins[0];
+        set_bin(peak.bins[0], peak.bins[1].k - 1);
+    } else if (p2 > p1 && p2 > p0 && peak.bins[2].k < _window_size / 2 - 1) {
+        peak.bins[0] = peak.bins[1];
+        peak.bins[1] = peak.bins[2];
+        set_bin(peak.bins[2], peak.bins[1].k + 1);
+    }
+
+    const Bin& a = peak.bins[0];
+    const Bin& b = peak.bins[1];
+    const Bin& c = peak.bins[2];
+
+    if (power(b) < peak.lock_power * SDFT_LOSS_RATIO) {
+        peak.tracking = false;
+        return false;
+    }
+
+    // Jacobsen's estimator, delta = Re((X[k-1] - X[k+1]) / (2X[k] - X[k-1] - X[k+1]))
+    const float num_re = a.re - c.re;
+    const float num_im = a.im - c.im;
+    const float den_re = 2.0f * b.re - a.re - c.re;
+    const float den_im = 2.0f * b.im - a.im - c.im;
+    const float den = sq(den_re) + sq(den_im);
+    float delta = 0.0f;
+    if (is_positive(den)) {
+        delta = constrain_float((num_re * den_re + num_im * den_im) / den, -1.0f, 1.0f);
+    }
+
+    freq_hz = (b.k + delta) * _bin_resolution;
+    return true;
+}
+
+#endif // HAL_GYROFFT_ENABLED
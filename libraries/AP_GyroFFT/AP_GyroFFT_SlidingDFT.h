@@ -0,0 +1,95 @@
+/*
+   This program is free software: you can redistribute it and/or modify
+   it under the terms of the GNU General Public License as published by
+   the Free Software Foundation, either version 3 of the License, or
+   (at your option) any later version.
+
+   This program is distributed in the hope that it will be useful,
+   but WITHOUT ANY WARRANTY; without even the implied warranty of
+   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+   GNU General Public License for more details.
+
+   You should have received a copy of the GNU General Public License
+   along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+/*
+  streaming peak tracker using a sliding DFT. Once a peak has been
+  found by a full FFT, three DFT bins around it are updated with every
+  new sample and the peak frequency is interpolated from them with
+  Jacobsen's estimator. The bins follow the peak as it moves and lock
+  is dropped when its energy collapses so that the caller can fall
+  back to a full FFT to reacquire it
+ */
+#pragma once
+
+#include <AP_HAL/AP_HAL.h>
+
+#if HAL_GYROFFT_ENABLED
+
+#include <AP_Common/AP_Common.h>
+#include <AP_Math/AP_Math.h>
+
+class AP_GyroFFT_SlidingDFT
+{
+public:
+    // number of peaks that can be tracked at once
+    static const uint8_t MAX_PEAKS = 3;
+
+    AP_GyroFFT_SlidingDFT() :
+        _history(nullptr), _window_size(0), _pos(0), _samples_since_sync(0), _bin_resolution(0) {
+        unlock();
+    }
+    ~AP_GyroFFT_SlidingDFT();
+
+    CLASS_NO_COPY(AP_GyroFFT_SlidingDFT);
+
+    // allocate the sample history for a window of window_size samples
+    bool init(uint16_t window_size, float sample_rate_hz);
+
+    // start tracking peaks near the given frequencies, using up to a window of samples,
+    // oldest first, as the initial history. A frequency of zero leaves that peak untracked
+    void lock(const float* samples, uint16_t num_samples, const float* freqs_hz, uint8_t num_peaks);
+    // stop tracking all peaks
+    void unlock();
+    // slide the window on by one sample
+    void update(float sample);
+    // whether a peak is being tracked
+    bool is_tracking(uint8_t peak) const { return peak < MAX_PEAKS && _peaks[peak].tracking; }
+    // interpolated frequency of a tracked peak, moving the bins to follow it.
+    // Returns false if the peak is not tracked or has lost lock
+    bool get_peak_frequency(uint8_t peak, float& freq_hz);
+
+private:
+    // a single DFT bin updated with each sample
+    struct Bin {
+        float re;
+        float im;
+        // rotation by e^(2 pi i k / N) applied each sample
+        float cos_k;
+        float sin_k;
+        uint16_t k;
+    };
+
+    // three adjacent bins with the peak in the middle one
+    struct Peak {
+        Bin bins[3];
+        float lock_power;
+        bool tracking;
+    };
+
+    // recalculate a bin from the sample history
+    void set_bin(Bin& bin, uint16_t k) const;
+    void resync();
+    static float power(const Bin& bin) { return sq(bin.re) + sq(bin.im); }
+
+    Peak _peaks[MAX_PEAKS];
+    // circular sample history, _history[_pos] is the oldest sample
+    float* _history;
+    uint16_t _window_size;
+    uint16_t _pos;
+    // samples since the bins were last recalculated from the history
+    uint32_t _samples_since_sync;
+    float _bin_resolution;
+};
+
+#endif // HAL_GYROFFT_ENABLED
@@ -0,0 +1,99 @@
+#include <AP_gtest.h>
+#include <AP_HAL/HAL.h>
+#include <AP_GyroFFT/AP_GyroFFT_SlidingDFT.h>
+
+const AP_HAL::HAL& hal = AP_HAL::get_HAL();
+
+#if HAL_GYROFFT_ENABLED
+
+#define SDFT_WINDOW     64
+#define SDFT_RATE_HZ    1000.0f
+
+// feed a tone that moves linearly from f0 to f1 over num_samples
+static void feed_tone(AP_GyroFFT_SlidingDFT& sdft, float& phase, float f0, float f1, uint32_t num_samples, float amplitude)
+{
+    for (uint32_t i = 0; i < num_samples; i++) {
+        const float f = f0 + (f1 - f0) * i / num_samples;
+        phase += M_2PI * f / SDFT_RATE_HZ;
+        sdft.update(amplitude * sinf(phase));
+    }
+}
+
+TEST(SlidingDFTTest, TracksStationaryTone)
+{
+    AP_GyroFFT_SlidingDFT sdft;
+    ASSERT_TRUE(sdft.init(SDFT_WINDOW, SDFT_RATE_HZ));
+
+    float window[SDFT_WINDOW];
+    const float tone_hz = 123.4f;
+    for (uint16_t i = 0; i < SDFT_WINDOW; i++) {
+        window[i] = sinf(M_2PI * tone_hz * i / SDFT_RATE_HZ);
+    }
+    const float freqs[] { 120.0f, 0.0f, 0.0f };
+    sdft.lock(window, SDFT_WINDOW, freqs, 3);
+    EXPECT_TRUE(sdft.is_tracking(0));
+    EXPECT_FALSE(sdft.is_tracking(1));
+
+    float freq_hz;
+    ASSERT_TRUE(sdft.get_peak_frequency(0, freq_hz));
+    EXPECT_NEAR(freq_hz, tone_hz, 1.0f);
+
+    // keep sliding well past a resync of the bins
+    float phase = M_2PI * tone_hz * (SDFT_WINDOW - 1) / SDFT_RATE_HZ;
+    feed_tone(sdft, phase, tone_hz, tone_hz, SDFT_WINDOW * 20, 1.0f);
+    ASSERT_TRUE(sdft.get_peak_frequency(0, freq_hz));
+    EXPECT_NEAR(freq_hz, tone_hz, 1.0f);
+}
+
+TEST(SlidingDFTTest, FollowsMovingTone)
+{
+    AP_GyroFFT_SlidingDFT sdft;
+    ASSERT_TRUE(sdft.init(SDFT_WINDOW, SDFT_RATE_HZ));
+
+    const float freqs[] { 80.0f };
+    float window[SDFT_WINDOW];
+    float phase = 0;
+    for (uint16_t i = 0; i < SDFT_WINDOW; i++) {
+        phase += M_2PI * 80.0f / SDFT_RATE_HZ;
+        window[i] = sinf(phase);
+    }
+    sdft.lock(window, SDFT_WINDOW, freqs, 1);
+    // sweep up by several bins, querying the peak every few samples as the FFT thread would
+    float freq_hz = 0;
+    const uint16_t steps = 100;
+    for (uint16_t s = 0; s < steps; s++) {
+        const float f0 = 80.0f + 80.0f * s / steps;
+        const float f1 = 80.0f + 80.0f * (s + 1) / steps;
+        feed_tone(sdft, phase, f0, f1, 16, 1.0f);
+        ASSERT_TRUE(sdft.get_peak_frequency(0, freq_hz));
+    }
+    // once the tone settles the estimate converges on it
+    feed_tone(sdft, phase, 160.0f, 160.0f, SDFT_WINDOW, 1.0f);
+    ASSERT_TRUE(sdft.get_peak_frequency(0, freq_hz));
+    EXPECT_NEAR(freq_hz, 160.0f, 1.0f);
+}
+
+TEST(SlidingDFTTest, LosesLock)
+{
+    AP_GyroFFT_SlidingDFT sdft;
+    ASSERT_TRUE(sdft.init(SDFT_WINDOW, SDFT_RATE_HZ));
+
+    float window[SDFT_WINDOW];
+    float phase = 0;
+    for (uint16_t i = 0; i < SDFT_WINDOW; i++) {
+        phase += M_2PI * 200.0f / SDFT_RATE_HZ;
+        window[i] = sinf(phase);
+    }
+    const float freqs[] { 200.0f };
+    sdft.lock(window, SDFT_WINDOW, freqs, 1);
+
+    // the tone stops
+    feed_tone(sdft, phase, 200.0f, 200.0f, SDFT_WINDOW, 0.0f);
+    float freq_hz;
+    EXPECT_FALSE(sdft.get_peak_frequency(0, freq_hz));
+    EXPECT_FALSE(sdft.is_tracking(0));
+}
+
+#endif // HAL_GYROFFT_ENABLED
+
+AP_GTEST_MAIN()
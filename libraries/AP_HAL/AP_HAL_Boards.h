@@ -386,6 +386,16 @@
 #define HAL_ENABLE_SENDING_STATS HAL_PROGRAM_SIZE_LIMIT_KB >= 256
 #endif
 
+// per-thread timeline tracing, see AP_HAL/utility/Trace.h
+#ifndef AP_HAL_TRACE_ENABLED
+#define AP_HAL_TRACE_ENABLED (CONFIG_HAL_BOARD == HAL_BOARD_SITL || CONFIG_HAL_BOARD == HAL_BOARD_LINUX)
+#endif
+
+// batched real FFT on SIMD lanes, see AP_HAL/utility/BatchFFT.h
+#ifndef AP_HAL_BATCH_FFT_ENABLED
+#define AP_HAL_BATCH_FFT_ENABLED (CONFIG_HAL_BOARD == HAL_BOARD_SITL || CONFIG_HAL_BOARD == HAL_BOARD_LINUX)
+#endif
+
 #ifndef HAL_GPIO_LED_ON
 #define HAL_GPIO_LED_ON 0
 #elif HAL_GPIO_LED_ON == 0
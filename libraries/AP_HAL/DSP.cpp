@@ -92,6 +92,15 @@ void DSP::FFTWindowState::free_data_structures()
     _sliding_window = nullptr;
 }
 
+// perform remaining steps of the FFT analysis of several windows
+void DSP::fft_analyse_batch(FFTWindowState* const states[], uint8_t count, uint16_t start_bin, uint16_t end_bin,
+    float noise_att_cutoff, uint16_t* bin_max)
+{
+    for (uint8_t i = 0; i < count; i++) {
+        bin_max[i] = fft_analyse(states[i], start_bin, end_bin, noise_att_cutoff);
+    }
+}
+
 // step 3: find the magnitudes of the complex data
 void DSP::step_cmplx_mag(FFTWindowState* fft, uint16_t start_bin, uint16_t end_bin, float noise_att_cutoff)
 {
@@ -96,6 +96,10 @@ public:
     virtual void fft_start(FFTWindowState* state, FloatBuffer& samples, uint16_t advance) = 0;
     // perform remaining steps of an FFT analysis
     virtual uint16_t fft_analyse(FFTWindowState* state, uint16_t start_bin, uint16_t end_bin, float noise_att_cutoff) = 0;
+    // perform remaining steps of the FFT analysis of several windows in one pass, storing the bin with
+    // maximum energy for each in bin_max. The default implementation analyses each window in turn
+    virtual void fft_analyse_batch(FFTWindowState* const states[], uint8_t count, uint16_t start_bin, uint16_t end_bin,
+        float noise_att_cutoff, uint16_t* bin_max);
     // start averaging FFT data
     bool fft_start_average(FFTWindowState* fft);
     // finish the averaging process
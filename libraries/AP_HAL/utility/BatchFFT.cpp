@@ -0,0 +1,211 @@
+/*
+   This program is free software: you can redistribute it and/or modify
+   it under the terms of the GNU General Public License as published by
+   the Free Software Foundation, either version 3 of the License, or
+   (at your option) any later version.
+
+   This program is distributed in the hope that it will be useful,
+   but WITHOUT ANY WARRANTY; without even the implied warranty of
+   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+   GNU General Public License for more details.
+
+   You should have received a copy of the GNU General Public License
+   along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "BatchFFT.h"
+
+#if AP_HAL_BATCH_FFT_ENABLED
+
+#include <math.h>
+#include <string.h>
+#include <AP_HAL/AP_HAL.h>
+
+using namespace AP_HAL;
+
+// one float per window, compiled to SSE on x86 and NEON on ARM
+typedef float vec_t __attribute__((vector_size(BatchFFT::LANES * sizeof(float))));
+
+// a complex value for each window
+struct BatchFFT::cvec {
+    vec_t re;
+    vec_t im;
+
+    cvec operator+(const cvec &b) const {
+        return { re + b.re, im + b.im };
+    }
+
+    cvec operator-(const cvec &b) const {
+        return { re - b.re, im - b.im };
+    }
+
+    // multiply by the same twiddle factor in every lane
+    cvec twiddle(const float *w) const {
+        return { re * w[0] - im * w[1], re * w[1] + im * w[0] };
+    }
+};
+
+BatchFFT::~BatchFFT()
+{
+    free_buffers();
+}
+
+void BatchFFT::free_buffers(void)
+{
+    delete[] _tw;
+    _tw = nullptr;
+    delete[] _split_tw;
+    _split_tw = nullptr;
+    delete[] _buf[0];
+    _buf[0] = nullptr;
+    delete[] _buf[1];
+    _buf[1] = nullptr;
+    _n = 0;
+    _m = 0;
+}
+
+bool BatchFFT::init(uint16_t n)
+{
+    if (n < 4 || (n & (n - 1)) != 0) {
+        free_buffers();
+        return false;
+    }
+    if (n == _n) {
+        return true;
+    }
+    free_buffers();
+    const uint16_t m = n / 2;
+    _tw = NEW_NOTHROW float[2 * m];
+    _split_tw = NEW_NOTHROW float[2 * m];
+    _buf[0] = NEW_NOTHROW cvec[m];
+    _buf[1] = NEW_NOTHROW cvec[m];
+    if (_tw == nullptr || _split_tw == nullptr || _buf[0] == nullptr || _buf[1] == nullptr) {
+        free_buffers();
+        return false;
+    }
+    for (uint16_t k = 0; k < m; k++) {
+        // computed in double so the tables are accurate for large windows
+        const double a = 2 * M_PI * k / m;
+        _tw[2*k] = cos(a);
+        _tw[2*k+1] = -sin(a);
+        const double b = 2 * M_PI * k / n;
+        _split_tw[2*k] = cos(b);
+        _split_tw[2*k+1] = -sin(b);
+    }
+    _n = n;
+    _m = m;
+    return true;
+}
+
+/*
+  complex FFT of _buf[0] using radix-4 Stockham stages, with a final
+  radix-2 stage when _m is not a power of 4. Stockham ordering avoids
+  the bit reversal pass at the cost of a second buffer. Returns the
+  buffer holding the result
+ */
+BatchFFT::cvec *BatchFFT::complex_fft(void)
+{
+    cvec *x = _buf[0];
+    cvec *y = _buf[1];
+    uint16_t n = _m;    // length of the sub-transforms at this stage
+    uint16_t s = 1;     // stride between them
+
+    while (n >= 4) {
+        const uint16_t m = n / 4;
+        for (uint16_t p = 0; p < m; p++) {
+            const float *w1 = &_tw[2 * (p * s)];
+            const float *w2 = &_tw[2 * (2 * p * s)];
+            const float *w3 = &_tw[2 * (3 * p * s)];
+            for (uint16_t q = 0; q < s; q++) {
+                const cvec &a = x[q + s*p];
+                const cvec &b = x[q + s*(p + m)];
+                const cvec &c = x[q + s*(p + 2*m)];
+                const cvec &d = x[q + s*(p + 3*m)];
+                const cvec apc = a + c;
+                const cvec amc = a - c;
+                const cvec bpd = b + d;
+                // j * (b - d)
+                const cvec jbmd { d.im - b.im, b.re - d.re };
+                y[q + s*(4*p)] = apc + bpd;
+                y[q + s*(4*p + 1)] = (amc - jbmd).twiddle(w1);
+                y[q + s*(4*p + 2)] = (apc - bpd).twiddle(w2);
+                y[q + s*(4*p + 3)] = (amc + jbmd).twiddle(w3);
+            }
+        }
+        n = m;
+        s *= 4;
+        cvec *t = x;
+        x = y;
+        y = t;
+    }
+
+    if (n == 2) {
+        for (uint16_t q = 0; q < s; q++) {
+            const cvec a = x[q];
+            const cvec b = x[q + s];
+            y[q] = a + b;
+            y[q + s] = a - b;
+        }
+        x = y;
+    }
+
+    return x;
+}
+
+/*
+  transform up to LANES windows. The n real samples of each window are
+  packed as n/2 complex values, transformed, and then split into the
+  spectrum of the real window:
+    X[k] = E[k] + e^(-2 pi i k / n) O[k]
+  where E and O are the transforms of the even and odd samples,
+  recovered from Z[k] and conj(Z[m-k])
+ */
+void BatchFFT::transform_lanes(const float* const in[], float* const out[], uint8_t count)
+{
+    cvec *z = _buf[0];
+    for (uint16_t k = 0; k < _m; k++) {
+        cvec v {};
+        for (uint8_t b = 0; b < count; b++) {
+            v.re[b] = in[b][2*k];
+            v.im[b] = in[b][2*k+1];
+        }
+        z[k] = v;
+    }
+
+    z = complex_fft();
+
+    // DC and Nyquist bins are real
+    for (uint8_t b = 0; b < count; b++) {
+        out[b][0] = z[0].re[b] + z[0].im[b];
+        out[b][1] = 0;
+        out[b][2*_m] = z[0].re[b] - z[0].im[b];
+        out[b][2*_m+1] = 0;
+    }
+
+    for (uint16_t k = 1; k < _m; k++) {
+        const cvec &zk = z[k];
+        const cvec &zc = z[_m - k];
+        // E = (Z[k] + conj(Z[m-k])) / 2
+        const cvec e { (zk.re + zc.re) * 0.5f, (zk.im - zc.im) * 0.5f };
+        // O = -i (Z[k] - conj(Z[m-k])) / 2
+        const cvec o { (zk.im + zc.im) * 0.5f, (zc.re - zk.re) * 0.5f };
+        const cvec x = e + o.twiddle(&_split_tw[2*k]);
+        for (uint8_t b = 0; b < count; b++) {
+            out[b][2*k] = x.re[b];
+            out[b][2*k+1] = x.im[b];
+        }
+    }
+}
+
+void BatchFFT::transform(const float* const in[], float* const out[], uint8_t count)
+{
+    if (_n == 0) {
+        return;
+    }
+    for (uint8_t i = 0; i < count; i += LANES) {
+        const uint8_t n = count - i;
+        transform_lanes(&in[i], &out[i], n < LANES ? n : LANES);
+    }
+}
+
+#endif  // AP_HAL_BATCH_FFT_ENABLED
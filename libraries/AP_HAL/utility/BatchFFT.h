@@ -0,0 +1,77 @@
+/*
+   This program is free software: you can redistribute it and/or modify
+   it under the terms of the GNU General Public License as published by
+   the Free Software Foundation, either version 3 of the License, or
+   (at your option) any later version.
+
+   This program is distributed in the hope that it will be useful,
+   but WITHOUT ANY WARRANTY; without even the implied warranty of
+   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+   GNU General Public License for more details.
+
+   You should have received a copy of the GNU General Public License
+   along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+/*
+  real FFT of several windows of the same size in one pass. The
+  windows are interleaved across the lanes of a SIMD vector, one
+  window per lane, and transformed together with a radix-4 Stockham
+  FFT of half the window size followed by the usual split into the
+  spectrum of the real input
+ */
+#pragma once
+
+#include <AP_HAL/AP_HAL_Boards.h>
+
+#if AP_HAL_BATCH_FFT_ENABLED
+
+#include <stdint.h>
+#include <AP_Common/AP_Common.h>
+
+namespace AP_HAL {
+
+class BatchFFT {
+public:
+    // number of windows transformed together, larger batches are
+    // done in groups of this size
+    static constexpr uint8_t LANES = 4;
+
+    BatchFFT() :
+        _n(0), _m(0), _tw(nullptr), _split_tw(nullptr), _buf{nullptr, nullptr} {}
+    ~BatchFFT();
+
+    CLASS_NO_COPY(BatchFFT);
+
+    // prepare for windows of n samples, n must be a power of two of
+    // at least 4. Returns false on an invalid size or allocation failure
+    bool init(uint16_t n);
+
+    // window size set with init(), 0 if not initialised
+    uint16_t size() const { return _n; }
+
+    /*
+      transform count windows of real samples. in[i] holds the n
+      samples of window i and out[i] receives its n/2+1 bins from DC to
+      Nyquist as interleaved real and imaginary parts, so needs n+2
+      floats. Uses the forward transform sign convention, X[k] = sum
+      x[t] e^(-2 pi i k t / n)
+     */
+    void transform(const float* const in[], float* const out[], uint8_t count);
+
+private:
+    struct cvec;
+
+    void transform_lanes(const float* const in[], float* const out[], uint8_t count);
+    cvec *complex_fft(void);
+    void free_buffers(void);
+
+    uint16_t _n;            // real window size
+    uint16_t _m;            // complex FFT size, _n / 2
+    float *_tw;             // e^(-2 pi i k / _m) for k < _m, interleaved real and imaginary
+    float *_split_tw;       // e^(-2 pi i k / _n) for k < _m, interleaved real and imaginary
+    cvec *_buf[2];          // ping-pong buffers of _m vectors
+};
+
+}
+
+#endif  // AP_HAL_BATCH_FFT_ENABLED
@@ -0,0 +1,126 @@
+/*
+   This program is free software: you can redistribute it and/or modify
+   it under the terms of the GNU General Public License as published by
+   the Free Software Foundation, either version 3 of the License, or
+   (at your option) any later version.
+
+   This program is distributed in the hope that it will be useful,
+   but WITHOUT ANY WARRANTY; without even the implied warranty of
+   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+   GNU General Public License for more details.
+
+   You should have received a copy of the GNU General Public License
+   along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "Trace.h"
+
+#if AP_HAL_TRACE_ENABLED
+
+#include <pthread.h>
+#include <string.h>
+
+#include <AP_HAL/AP_HAL.h>
+#include <AP_Common/ExpandingString.h>
+
+using namespace AP_HAL;
+
+std::atomic<bool> Trace::_enabled;
+std::atomic<Trace::ThreadBuffer*> Trace::_buffers;
+std::atomic<uint32_t> Trace::_next_tid;
+
+// number of oldest events skipped when exporting a full ring, as the
+// owning thread may be overwriting them while we copy
+#define TRACE_EXPORT_MARGIN 64
+
+/*
+  return the calling thread's buffer, allocating and publishing it on
+  first use. Buffers are never freed, so readers can walk the list
+  without locking
+ */
+Trace::ThreadBuffer *Trace::thread_buffer()
+{
+    static thread_local ThreadBuffer *tbuf;
+    if (tbuf != nullptr) {
+        return tbuf;
+    }
+    ThreadBuffer *b = NEW_NOTHROW ThreadBuffer;
+    if (b == nullptr) {
+        return nullptr;
+    }
+    b->tid = _next_tid.fetch_add(1) + 1;
+    b->head.store(0);
+    b->cleared.store(0);
+    if (pthread_getname_np(pthread_self(), b->thread_name, sizeof(b->thread_name)) != 0) {
+        strncpy(b->thread_name, "unknown", sizeof(b->thread_name));
+    }
+    b->thread_name[sizeof(b->thread_name)-1] = 0;
+
+    // lock-free push onto the list of buffers
+    ThreadBuffer *old_head = _buffers.load();
+    do {
+        b->next = old_head;
+    } while (!_buffers.compare_exchange_weak(old_head, b));
+
+    tbuf = b;
+    return tbuf;
+}
+
+void Trace::record(Type type, const char *name)
+{
+    ThreadBuffer *b = thread_buffer();
+    if (b == nullptr) {
+        return;
+    }
+    const uint32_t h = b->head.load(std::memory_order_relaxed);
+    Event &e = b->events[h % EVENTS_PER_THREAD];
+    e.time_us = AP_HAL::micros64();
+    e.name = name;
+    e.type = type;
+    b->head.store(h + 1, std::memory_order_release);
+}
+
+void Trace::clear()
+{
+    for (ThreadBuffer *b = _buffers.load(); b != nullptr; b = b->next) {
+        b->cleared.store(b->head.load(std::memory_order_acquire));
+    }
+}
+
+void Trace::export_json(ExpandingString &str)
+{
+    str.printf("{\"displayTimeUnit\":\"ms\",\"traceEvents\":[\n");
+    bool first = true;
+    for (ThreadBuffer *b = _buffers.load(); b != nullptr; b = b->next) {
+        // thread name metadata so the viewer labels each row
+        str.printf("%s{\"name\":\"thread_name\",\"ph\":\"M\",\"pid\":1,\"tid\":%u,\"args\":{\"name\":\"%s\"}}",
+                   first ? "" : ",\n", unsigned(b->tid), b->thread_name);
+        first = false;
+
+        const uint32_t head = b->head.load(std::memory_order_acquire);
+        uint32_t start = b->cleared.load();
+        if (head - start > EVENTS_PER_THREAD - TRACE_EXPORT_MARGIN) {
+            start = head - EVENTS_PER_THREAD + TRACE_EXPORT_MARGIN;
+        }
+        for (uint32_t i = start; i != head; i++) {
+            const Event &e = b->events[i % EVENTS_PER_THREAD];
+            const char *name = e.name != nullptr ? e.name : "?";
+            const unsigned long long ts = e.time_us;
+            switch (e.type) {
+            case Type::BEGIN:
+            case Type::END:
+                str.printf(",\n{\"name\":\"%s\",\"ph\":\"%c\",\"ts\":%llu,\"pid\":1,\"tid\":%u}",
+                           name, e.type == Type::BEGIN ? 'B' : 'E', ts, unsigned(b->tid));
+                break;
+            case Type::INSTANT:
+                // thread-scoped instant event
+                str.printf(",\n{\"name\":\"%s\",\"ph\":\"i\",\"s\":\"t\",\"ts\":%llu,\"pid\":1,\"tid\":%u}",
+                           name, ts, unsigned(b->tid));
+                break;
+            }
+        }
+    }
+    str.printf("\n]}\n");
+}
+
+#endif  // AP_HAL_TRACE_ENABLED
@@ -0,0 +1,116 @@
+/*
+   This program is free software: you can redistribute it and/or modify
+   it under the terms of the GNU General Public License as published by
+   the Free Software Foundation, either version 3 of the License, or
+   (at your option) any later version.
+
+   This program is distributed in the hope that it will be useful,
+   but WITHOUT ANY WARRANTY; without even the implied warranty of
+   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+   GNU General Public License for more details.
+
+   You should have received a copy of the GNU General Public License
+   along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+/*
+  per-thread timeline tracing of scheduler tasks, HAL threads and
+  semaphore waits, exportable as Chrome trace JSON (chrome://tracing
+  or https://ui.perfetto.dev)
+ */
+#pragma once
+
+#include <AP_HAL/AP_HAL_Boards.h>
+
+#if AP_HAL_TRACE_ENABLED
+
+#include <atomic>
+#include <stdint.h>
+
+class ExpandingString;
+
+namespace AP_HAL {
+
+class Trace {
+public:
+    enum class Type : uint8_t {
+        BEGIN,      // start of a duration, e.g. a scheduler task
+        END,        // end of the matching BEGIN
+        INSTANT,    // a point event, e.g. a thread wakeup
+    };
+
+    // enable or disable recording. Recording is off by default so
+    // the cost when not in use is a single load and branch
+    static void set_enabled(bool enable) { _enabled.store(enable, std::memory_order_relaxed); }
+    static bool enabled() { return _enabled.load(std::memory_order_relaxed); }
+
+    // record an event in the calling thread's buffer. name must be
+    // a string with static lifetime
+    static void event(Type type, const char *name) {
+        if (enabled()) {
+            record(type, name);
+        }
+    }
+
+    // append the contents of all thread buffers as a Chrome trace
+    // JSON document
+    static void export_json(ExpandingString &str);
+
+    // discard all recorded events
+    static void clear();
+
+    // number of events held in each per-thread ring
+    static constexpr uint16_t EVENTS_PER_THREAD = 4096;
+
+    // RAII helper recording a BEGIN/END pair around a scope
+    class Scope {
+    public:
+        Scope(const char *name) : _name(name) { event(Type::BEGIN, _name); }
+        ~Scope() { event(Type::END, _name); }
+    private:
+        const char *_name;
+    };
+
+private:
+    struct Event {
+        uint64_t time_us;
+        const char *name;
+        Type type;
+    };
+
+    /*
+      single-producer ring owned by one thread. The owning thread is
+      the only writer; readers take a snapshot of head and copy out
+      the events behind it
+     */
+    struct ThreadBuffer {
+        ThreadBuffer *next;
+        uint32_t tid;
+        char thread_name[16];
+        std::atomic<uint32_t> head;
+        std::atomic<uint32_t> cleared;
+        Event events[EVENTS_PER_THREAD];
+    };
+
+    static void record(Type type, const char *name);
+    static ThreadBuffer *thread_buffer();
+
+    static std::atomic<bool> _enabled;
+    static std::atomic<ThreadBuffer*> _buffers;
+    static std::atomic<uint32_t> _next_tid;
+};
+
+}
+
+#define HAL_TRACE_BEGIN(name) AP_HAL::Trace::event(AP_HAL::Trace::Type::BEGIN, name)
+#define HAL_TRACE_END(name) AP_HAL::Trace::event(AP_HAL::Trace::Type::END, name)
+#define HAL_TRACE_INSTANT(name) AP_HAL::Trace::event(AP_HAL::Trace::Type::INSTANT, name)
+#define HAL_TRACE_SCOPE(name) AP_HAL::Trace::Scope _hal_trace_scope_(name)
+
+#else
+
+#define HAL_TRACE_BEGIN(name)
+#define HAL_TRACE_END(name)
+#define HAL_TRACE_INSTANT(name)
+#define HAL_TRACE_SCOPE(name)
+
+#endif  // AP_HAL_TRACE_ENABLED
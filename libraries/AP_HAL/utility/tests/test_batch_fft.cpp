@@ -0,0 +1,82 @@
+#include <AP_gtest.h>
+
+#include <AP_HAL/AP_HAL.h>
+#include <AP_HAL/utility/BatchFFT.h>
+#include <AP_Math/AP_Math.h>
+
+const AP_HAL::HAL& hal = AP_HAL::get_HAL();
+
+#if AP_HAL_BATCH_FFT_ENABLED
+
+#define MAX_WINDOWS 9
+
+// reference DFT of a real window, DC to Nyquist
+static void naive_dft(const float *in, uint16_t n, double *out)
+{
+    for (uint16_t k = 0; k <= n / 2; k++) {
+        double re = 0, im = 0;
+        for (uint16_t t = 0; t < n; t++) {
+            const double a = -2 * M_PI * k * t / n;
+            re += in[t] * cos(a);
+            im += in[t] * sin(a);
+        }
+        out[2*k] = re;
+        out[2*k+1] = im;
+    }
+}
+
+static void check_transform(uint16_t n, uint8_t count)
+{
+    AP_HAL::BatchFFT fft;
+    ASSERT_TRUE(fft.init(n));
+    EXPECT_EQ(fft.size(), n);
+
+    float *in[MAX_WINDOWS];
+    float *out[MAX_WINDOWS];
+    double *ref = new double[n + 2];
+    for (uint8_t b = 0; b < count; b++) {
+        in[b] = new float[n];
+        out[b] = new float[n + 2];
+        // a tone in a different bin for each window plus some noise
+        for (uint16_t t = 0; t < n; t++) {
+            in[b][t] = sinf(2 * M_PI * (b + 1) * t / n) + 0.1f * (float(rand()) / RAND_MAX - 0.5f);
+        }
+    }
+
+    fft.transform(in, out, count);
+
+    for (uint8_t b = 0; b < count; b++) {
+        naive_dft(in[b], n, ref);
+        for (uint16_t i = 0; i < n + 2; i++) {
+            EXPECT_NEAR(out[b][i], ref[i], 1e-5 * n) << "n=" << n << " window=" << unsigned(b) << " i=" << i;
+        }
+        delete[] in[b];
+        delete[] out[b];
+    }
+    delete[] ref;
+}
+
+TEST(BatchFFTTest, MatchesDFT)
+{
+    // covers both a final radix-4 and a final radix-2 stage
+    for (uint16_t n = 4; n <= 1024; n *= 2) {
+        for (uint8_t count = 1; count <= MAX_WINDOWS; count += 4) {
+            check_transform(n, count);
+        }
+    }
+}
+
+TEST(BatchFFTTest, InvalidSize)
+{
+    AP_HAL::BatchFFT fft;
+    EXPECT_FALSE(fft.init(0));
+    EXPECT_FALSE(fft.init(2));
+    EXPECT_FALSE(fft.init(48));
+    EXPECT_EQ(fft.size(), 0);
+    EXPECT_TRUE(fft.init(64));
+    EXPECT_EQ(fft.size(), 64);
+}
+
+#endif  // AP_HAL_BATCH_FFT_ENABLED
+
+AP_GTEST_MAIN()
@@ -0,0 +1,70 @@
+#include <AP_gtest.h>
+
+#include <AP_HAL/AP_HAL.h>
+#include <AP_HAL/utility/Trace.h>
+#include <AP_Common/ExpandingString.h>
+
+const AP_HAL::HAL& hal = AP_HAL::get_HAL();
+
+#if AP_HAL_TRACE_ENABLED
+
+TEST(TraceTest, DisabledRecordsNothing)
+{
+    AP_HAL::Trace::set_enabled(false);
+    AP_HAL::Trace::clear();
+    HAL_TRACE_BEGIN("disabled_task");
+    HAL_TRACE_END("disabled_task");
+
+    ExpandingString str;
+    AP_HAL::Trace::export_json(str);
+    EXPECT_FALSE(str.has_failed_allocation());
+    EXPECT_EQ(strstr(str.get_string(), "disabled_task"), nullptr);
+}
+
+TEST(TraceTest, ExportJSON)
+{
+    AP_HAL::Trace::set_enabled(true);
+    AP_HAL::Trace::clear();
+    {
+        HAL_TRACE_SCOPE("scoped_task");
+        HAL_TRACE_INSTANT("wakeup");
+    }
+    AP_HAL::Trace::set_enabled(false);
+
+    ExpandingString str;
+    AP_HAL::Trace::export_json(str);
+    const char *json = str.get_string();
+    ASSERT_NE(json, nullptr);
+    EXPECT_EQ(strncmp(json, "{\"displayTimeUnit\"", 18), 0);
+    EXPECT_NE(strstr(json, "{\"name\":\"scoped_task\",\"ph\":\"B\""), nullptr);
+    EXPECT_NE(strstr(json, "{\"name\":\"scoped_task\",\"ph\":\"E\""), nullptr);
+    EXPECT_NE(strstr(json, "{\"name\":\"wakeup\",\"ph\":\"i\""), nullptr);
+    EXPECT_NE(strstr(json, "\"thread_name\""), nullptr);
+    EXPECT_NE(strstr(json, "\n]}\n"), nullptr);
+}
+
+TEST(TraceTest, RingWraps)
+{
+    AP_HAL::Trace::set_enabled(true);
+    AP_HAL::Trace::clear();
+    for (uint32_t i = 0; i < 3 * AP_HAL::Trace::EVENTS_PER_THREAD; i++) {
+        HAL_TRACE_INSTANT("spin");
+    }
+    AP_HAL::Trace::set_enabled(false);
+
+    ExpandingString str;
+    AP_HAL::Trace::export_json(str);
+    const char *json = str.get_string();
+    ASSERT_NE(json, nullptr);
+    uint32_t count = 0;
+    for (const char *p = strstr(json, "\"spin\""); p != nullptr; p = strstr(p+1, "\"spin\"")) {
+        count++;
+    }
+    // a full ring is exported less a safety margin for the oldest events
+    EXPECT_LE(count, unsigned(AP_HAL::Trace::EVENTS_PER_THREAD));
+    EXPECT_GT(count, unsigned(AP_HAL::Trace::EVENTS_PER_THREAD / 2));
+}
+
+#endif  // AP_HAL_TRACE_ENABLED
+
+AP_GTEST_MAIN()
@@ -70,6 +70,17 @@ public:
                              uint32_t timeout_usec);
     bool adjust_timer(TimerPollable *p, uint32_t timeout_usec);
 
+    /*
+     * Handle events of @p in this thread. Unlike timers, @p is owned by the
+     * caller, which must unregister it before it's destroyed.
+     */
+    bool register_pollable(Pollable *p, uint32_t events) {
+        return _poller.register_pollable(p, events);
+    }
+    void unregister_pollable(const Pollable *p) {
+        _poller.unregister_pollable(p);
+    }
+
     void mainloop();
 
     bool stop() override;
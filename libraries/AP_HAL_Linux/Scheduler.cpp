@@ -10,6 +10,7 @@
 #include <unistd.h>
 
 #include <AP_HAL/AP_HAL.h>
+#include <AP_HAL/utility/Trace.h>
 #include <AP_Math/AP_Math.h>
 #include <AP_Vehicle/AP_Vehicle_Type.h>
 
@@ -34,6 +35,8 @@ extern const AP_HAL::HAL& hal;
 
 #define APM_LINUX_TIMER_RATE            1000
 #define APM_LINUX_UART_RATE             100
+// UARTs which wake the UART thread when ready are also run at this rate
+#define APM_LINUX_UART_IDLE_RATE        10
 #if CONFIG_HAL_BOARD_SUBTYPE == HAL_BOARD_SUBTYPE_LINUX_NAVIO ||    \
     CONFIG_HAL_BOARD_SUBTYPE == HAL_BOARD_SUBTYPE_LINUX_ERLEBRAIN2 || \
     CONFIG_HAL_BOARD_SUBTYPE == HAL_BOARD_SUBTYPE_LINUX_BH || \
@@ -111,7 +114,6 @@ void Scheduler::init()
         uint32_t rate;
     } sched_table[] = {
         SCHED_THREAD(timer, TIMER),
-        SCHED_THREAD(uart, UART),
         SCHED_THREAD(rcin, RCIN),
         SCHED_THREAD(io, IO),
     };
@@ -121,8 +123,8 @@ void Scheduler::init()
     init_realtime();
     init_cpu_affinity();
 
-    /* set barrier to N + 1 threads: worker threads + main */
-    unsigned n_threads = ARRAY_SIZE(sched_table) + 1;
+    /* set barrier to N + 2 threads: worker threads + uart + main */
+    unsigned n_threads = ARRAY_SIZE(sched_table) + 2;
     ret = pthread_barrier_init(&_initialized_barrier, nullptr, n_threads);
     if (ret) {
         AP_HAL::panic("Scheduler: Failed to initialise barrier object: %s",
@@ -137,6 +139,19 @@ void Scheduler::init()
         t->thread->start(t->name, t->policy, t->prio);
     }
 
+    /*
+      the UART thread sleeps until a UART's device is ready or there
+      are bytes to write. The timer runs UARTs which can't wake it
+     */
+    _uart_timer_usec = hz_to_usec(APM_LINUX_UART_RATE);
+    _uart_timer = _uart_thread.add_timer(FUNCTOR_BIND_MEMBER(&Scheduler::_uart_task, void),
+                                         nullptr, _uart_timer_usec);
+    if (_uart_timer == nullptr) {
+        AP_HAL::panic("Scheduler: failed to create UART timer");
+    }
+    _uart_thread.set_stack_size(1024 * 1024);
+    _uart_thread.start("ap-uart", SCHED_FIFO, APM_LINUX_UART_PRIORITY);
+
 #if defined(DEBUG_STACK) && DEBUG_STACK
     register_timer_process(FUNCTOR_BIND_MEMBER(&Scheduler::_debug_stack, void));
 #endif
@@ -244,6 +259,7 @@ void Scheduler::_timer_task()
         return;
     }
     _in_timer_proc = true;
+    HAL_TRACE_SCOPE("timer");
 
     // now call the timer based drivers
     for (i = 0; i < _num_timer_procs; i++) {
@@ -275,32 +291,50 @@ void Scheduler::_run_io(void)
 }
 
 /*
-  run timers for all UARTs
+  run timers for all UARTs. Return true if any of them can't wake the
+  UART thread when their device is ready
  */
-void Scheduler::_run_uarts()
+bool Scheduler::_run_uarts()
 {
+    bool polled = false;
+
     // process any pending serial bytes
     for (uint8_t i=0;i<hal.num_serial; i++) {
         hal.serial(i)->_timer_tick();
+        polled |= UARTDriver::from(hal.serial(i))->needs_polling();
     }
+
+    return polled;
 }
 
 void Scheduler::_rcin_task()
 {
+    HAL_TRACE_SCOPE("rcin");
     RCInput::from(hal.rcin)->_timer_tick();
 }
 
 void Scheduler::_uart_task()
 {
-    _run_uarts();
+    HAL_TRACE_SCOPE("uart");
+    const bool polled = _run_uarts();
+
+    // slow down when all UARTs wake the thread themselves
+    const uint32_t period_usec = hz_to_usec(polled ? APM_LINUX_UART_RATE : APM_LINUX_UART_IDLE_RATE);
+    if (period_usec != _uart_timer_usec &&
+        _uart_thread.adjust_timer(_uart_timer, period_usec)) {
+        _uart_timer_usec = period_usec;
+    }
 }
 
 void Scheduler::_io_task()
 {
     // process any pending storage writes
+    HAL_TRACE_BEGIN("storage");
     hal.storage->_timer_tick();
+    HAL_TRACE_END("storage");
 
     // run registered IO processes
+    HAL_TRACE_SCOPE("io");
     _run_io();
 }
 
@@ -360,6 +394,13 @@ bool Scheduler::SchedulerThread::_run()
     return PeriodicThread::_run();
 }
 
+bool Scheduler::UARTThread::_run()
+{
+    _sched._wait_all_threads();
+
+    return PollerThread::_run();
+}
+
 void Scheduler::teardown()
 {
     _timer_thread.stop();
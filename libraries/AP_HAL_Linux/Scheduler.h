@@ -4,6 +4,7 @@
 
 #include "AP_HAL_Linux.h"
 
+#include "PollerThread.h"
 #include "Semaphores.h"
 #include "Thread.h"
 
@@ -60,6 +61,17 @@ public:
      */
     void set_cpu_affinity(const cpu_set_t &cpu_affinity) { _cpu_affinity = cpu_affinity; }
 
+    /*
+      handle events of a Pollable in the UART thread, so UARTs can be
+      serviced as soon as their devices are ready
+     */
+    bool register_uart_pollable(Pollable *p, uint32_t events) {
+        return _uart_thread.register_pollable(p, events);
+    }
+    void unregister_uart_pollable(const Pollable *p) {
+        _uart_thread.unregister_pollable(p);
+    }
+
 private:
     class SchedulerThread : public PeriodicThread {
     public:
@@ -74,6 +86,18 @@ private:
         Scheduler &_sched;
     };
 
+    class UARTThread : public PollerThread {
+    public:
+        UARTThread(Scheduler &sched)
+            : _sched(sched)
+        { }
+
+    protected:
+        bool _run() override;
+
+        Scheduler &_sched;
+    };
+
     void     init_realtime();
 
     void     init_cpu_affinity();
@@ -101,7 +125,9 @@ private:
     SchedulerThread _timer_thread{FUNCTOR_BIND_MEMBER(&Scheduler::_timer_task, void), *this};
     SchedulerThread _io_thread{FUNCTOR_BIND_MEMBER(&Scheduler::_io_task, void), *this};
     SchedulerThread _rcin_thread{FUNCTOR_BIND_MEMBER(&Scheduler::_rcin_task, void), *this};
-    SchedulerThread _uart_thread{FUNCTOR_BIND_MEMBER(&Scheduler::_uart_task, void), *this};
+    UARTThread _uart_thread{*this};
+    TimerPollable *_uart_timer;
+    uint32_t _uart_timer_usec;
 
     void _timer_task();
     void _io_task();
@@ -109,7 +135,7 @@ private:
     void _uart_task();
 
     void _run_io();
-    void _run_uarts();
+    bool _run_uarts();
 
     uint64_t _stopped_clock_usec;
     uint64_t _last_stack_debug_msec;
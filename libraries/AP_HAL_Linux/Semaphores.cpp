@@ -1,4 +1,5 @@
 #include <AP_HAL/AP_HAL.h>
+#include <AP_HAL/utility/Trace.h>
 
 #include "Semaphores.h"
 
@@ -24,11 +25,22 @@ bool Semaphore::give()
 bool Semaphore::take(uint32_t timeout_ms)
 {
     if (timeout_ms == HAL_SEMAPHORE_BLOCK_FOREVER) {
+#if AP_HAL_TRACE_ENABLED
+        if (AP_HAL::Trace::enabled()) {
+            // only record contended takes
+            if (take_nonblocking()) {
+                return true;
+            }
+            HAL_TRACE_SCOPE("sem_wait");
+            return pthread_mutex_lock(&_lock) == 0;
+        }
+#endif
         return pthread_mutex_lock(&_lock) == 0;
     }
     if (take_nonblocking()) {
         return true;
     }
+    HAL_TRACE_SCOPE("sem_wait");
     uint64_t start = AP_HAL::micros64();
     do {
         hal.scheduler->delay_microseconds(200);
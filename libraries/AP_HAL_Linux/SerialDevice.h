@@ -23,4 +23,28 @@ public:
 
     /* Depends on lower level to implement, most devices are fine with defaults */
     virtual void set_parity(int v) { }
+
+    /*
+     * File descriptor which becomes readable when read() has something to
+     * return, or -1 if the device has to be polled. It may change when the
+     * device connects or disconnects.
+     */
+    virtual int get_read_fd() const { return -1; }
+
+    /*
+     * Write count packets of the given lengths, stored one after the other
+     * in buf, keeping each in its own datagram on packet based devices.
+     * Return the number of packets written.
+     */
+    virtual int write_packets(const uint8_t *buf, const uint16_t *lens, uint8_t count)
+    {
+        int i;
+        for (i = 0; i < count; i++) {
+            if (write(buf, lens[i]) != lens[i]) {
+                break;
+            }
+            buf += lens[i];
+        }
+        return i;
+    }
 };
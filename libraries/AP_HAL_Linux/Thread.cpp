@@ -24,6 +24,7 @@
 #include <utility>
 
 #include <AP_HAL/AP_HAL.h>
+#include <AP_HAL/utility/Trace.h>
 #include <AP_Math/AP_Math.h>
 #include "Scheduler.h"
 
@@ -266,6 +267,7 @@ bool PeriodicThread::_run()
         } else {
             Scheduler::from(hal.scheduler)->microsleep(dt);
         }
+        HAL_TRACE_INSTANT("wakeup");
         next_run_usec += _period_usec;
 
         _task();
@@ -10,6 +10,8 @@
 #include <stdio.h>
 #include <stdlib.h>
 #include <string.h>
+#include <sys/epoll.h>
+#include <sys/eventfd.h>
 #include <sys/ioctl.h>
 #include <sys/socket.h>
 #include <sys/stat.h>
@@ -20,6 +22,7 @@
 #include <AP_HAL/AP_HAL.h>
 
 #include "ConsoleDevice.h"
+#include "Scheduler.h"
 #include "TCPServerDevice.h"
 #include "UARTDevice.h"
 #include "UDPDevice.h"
@@ -93,6 +96,11 @@ void UARTDriver::_begin(uint32_t b, uint16_t rxS, uint16_t txS)
         _readbuf.clear();
         _writebuf.clear();
     }
+
+    if (_initialised && _kick_pollable.setup()) {
+        // have the UART thread register the device
+        _kick();
+    }
 }
 
 void UARTDriver::_allocate_buffers(uint16_t rxS, uint16_t txS)
@@ -212,6 +220,10 @@ void UARTDriver::_end()
         hal.scheduler->delay(1);
     }
 
+    Scheduler::from(hal.scheduler)->unregister_uart_pollable(&_device_pollable);
+    _device_pollable.set_fd(-1);
+    _unpollable_fd = -1;
+
     _device->close();
     _deallocate_buffers();
 }
@@ -268,7 +280,12 @@ ssize_t UARTDriver::_read(uint8_t *buffer, uint16_t count)
         return 0;
     }
 
-    return _readbuf.read(buffer, count);
+    const ssize_t ret = _readbuf.read(buffer, count);
+    if (ret > 0 && _rx_stalled.exchange(false)) {
+        // the device wasn't read to the end as the buffer was full
+        _kick();
+    }
+    return ret;
 }
 
 bool UARTDriver::_discard_input()
@@ -277,6 +294,9 @@ bool UARTDriver::_discard_input()
         return false;
     }
     _readbuf.clear();
+    if (_rx_stalled.exchange(false)) {
+        _kick();
+    }
     return true;
 }
 
@@ -294,6 +314,10 @@ size_t UARTDriver::_write(const uint8_t *buffer, size_t size)
 
     size_t ret = _writebuf.write(buffer, size);
     _write_mutex.give();
+
+    if (ret > 0) {
+        _kick();
+    }
     return ret;
 }
 
@@ -316,6 +340,21 @@ int UARTDriver::_write_fd(const uint8_t *buf, uint16_t n)
     return _device->write(buf, n);
 }
 
+/*
+  try writing count packets, handling an unresponsive port
+ */
+int UARTDriver::_write_packets_fd(const uint8_t *buf, const uint16_t *lens, uint8_t count)
+{
+    if (!_connected) {
+        _connected = _device->open();
+    }
+    if (!_connected) {
+        return 0;
+    }
+
+    return _device->write_packets(buf, lens, count);
+}
+
 /*
   try reading n bytes, handling an unresponsive port
  */
@@ -336,36 +375,46 @@ bool UARTDriver::_write_pending_bytes(void)
     uint16_t n = available_bytes;
 
 #if HAL_GCS_ENABLED
-    if (_packetise && n > 0) {
-        // send on MAVLink packet boundaries if possible
-        n = mavlink_packetise(_writebuf, n);
+    if (_packetise) {
+        // send on MAVLink packet boundaries if possible, each packet
+        // in its own UDP packet, as many as are ready at once
+        uint16_t lens[MAX_PACKETS_PER_WRITE];
+        uint8_t count = 0;
+        uint16_t len = 0;
+        while (count < ARRAY_SIZE(lens) && len < n) {
+            const uint16_t packet_len = mavlink_packetise(_writebuf, n - len, len);
+            if (packet_len == 0) {
+                break;
+            }
+            lens[count++] = packet_len;
+            len += packet_len;
+        }
+        if (count > 0) {
+            uint8_t tmpbuf[len];
+            _writebuf.peekbytes(tmpbuf, len);
+            const int sent = _write_packets_fd(tmpbuf, lens, count);
+            for (int i = 0; i < sent; i++) {
+                _writebuf.advance(lens[i]);
+            }
+        }
+        return _writebuf.available() != available_bytes;
     }
 #endif
 
     if (n > 0) {
         int ret;
+        ByteBuffer::IoVec vec[2];
+        const auto n_vec = _writebuf.peekiovec(vec, n);
+        for (int i = 0; i < n_vec; i++) {
+            ret = _write_fd(vec[i].data, (uint16_t)vec[i].len);
+            if (ret < 0) {
+                break;
+            }
+            _writebuf.advance(ret);
 
-        if (_packetise) {
-            // keep as a single UDP packet
-            uint8_t tmpbuf[n];
-            _writebuf.peekbytes(tmpbuf, n);
-            ret = _write_fd(tmpbuf, n);
-            if (ret > 0)
-                _writebuf.advance(ret);
-        } else {
-            ByteBuffer::IoVec vec[2];
-            const auto n_vec = _writebuf.peekiovec(vec, n);
-            for (int i = 0; i < n_vec; i++) {
-                ret = _write_fd(vec[i].data, (uint16_t)vec[i].len);
-                if (ret < 0) {
-                    break;
-                }
-                _writebuf.advance(ret);
-
-                /* We wrote less than we asked for, stop */
-                if ((unsigned)ret != vec[i].len) {
-                    break;
-                }
+            /* We wrote less than we asked for, stop */
+            if ((unsigned)ret != vec[i].len) {
+                break;
             }
         }
     }
@@ -374,9 +423,11 @@ bool UARTDriver::_write_pending_bytes(void)
 }
 
 /*
-  push any pending bytes to/from the serial port. This is called at
-  1kHz in the timer thread. Doing it this way reduces the system call
-  overhead in the main task enormously.
+  push any pending bytes to/from the serial port. This is called in
+  the UART thread when the device is ready or there are bytes to
+  write, and periodically for devices which can't wake it. Doing it
+  this way reduces the system call overhead in the main task
+  enormously.
  */
 void UARTDriver::_timer_tick(void)
 {
@@ -388,32 +439,146 @@ void UARTDriver::_timer_tick(void)
     while (num_send != 0 && _write_pending_bytes()) {
         num_send--;
     }
+    if (num_send == 0 && _writebuf.available() > 0) {
+        // come back for the rest after the other UARTs
+        _kick();
+    }
 
-    // try to fill the read buffer
-    int ret;
-    ByteBuffer::IoVec vec[2];
+    // try to fill the read buffer. A device registered with the UART
+    // thread only wakes it for new data, so has to be read until it
+    // has nothing more
+    const bool drain = _device_pollable.get_fd() != -1;
+    bool more;
+    do {
+        more = false;
 
-    const auto n_vec = _readbuf.reserve(vec, _readbuf.space());
-    for (int i = 0; i < n_vec; i++) {
-        ret = _read_fd(vec[i].data, vec[i].len);
-        if (ret < 0) {
-            break;
+        int ret;
+        ByteBuffer::IoVec vec[2];
+
+        const auto n_vec = _readbuf.reserve(vec, _readbuf.space());
+        for (int i = 0; i < n_vec; i++) {
+            ret = _read_fd(vec[i].data, vec[i].len);
+            if (ret < 0) {
+                break;
+            }
+            _readbuf.commit((unsigned)ret);
+
+            // update receive timestamp
+            _receive_timestamp[_receive_timestamp_idx^1] = AP_HAL::micros64();
+            _receive_timestamp_idx ^= 1;
+
+            /* stop reading as we read less than we asked for */
+            if ((unsigned)ret < vec[i].len) {
+                more = drain && ret > 0;
+                break;
+            }
         }
-        _readbuf.commit((unsigned)ret);
-
-        // update receive timestamp
-        _receive_timestamp[_receive_timestamp_idx^1] = AP_HAL::micros64();
-        _receive_timestamp_idx ^= 1;
-        
-        /* stop reading as we read less than we asked for */
-        if ((unsigned)ret < vec[i].len) {
-            break;
+    } while (more);
+
+    if (drain && _readbuf.space() == 0) {
+        // _read() kicks the thread once there is room. It may have
+        // made room before seeing the flag, so check again
+        _rx_stalled.store(true);
+        if (_readbuf.space() > 0 && _rx_stalled.exchange(false)) {
+            _kick();
         }
     }
 
+    _update_pollable();
+
     _in_timer = false;
 }
 
+/*
+  keep the device registered with the UART thread, as its fd changes
+  when it connects and disconnects
+ */
+void UARTDriver::_update_pollable()
+{
+    if (_kick_pollable.get_fd() == -1) {
+        return;
+    }
+
+    const int fd = _connected ? _device->get_read_fd() : -1;
+    if (fd == _device_pollable.get_fd() || fd == _unpollable_fd) {
+        return;
+    }
+
+    auto *sched = Scheduler::from(hal.scheduler);
+    sched->unregister_uart_pollable(&_device_pollable);
+    _device_pollable.set_fd(fd);
+    _unpollable_fd = -1;
+    if (fd == -1) {
+        return;
+    }
+
+    if (!sched->register_uart_pollable(&_device_pollable, EPOLLIN | EPOLLOUT | EPOLLET)) {
+        // e.g. a console redirected to a file, which has to be polled
+        _device_pollable.set_fd(-1);
+        _unpollable_fd = fd;
+    }
+}
+
+/*
+  wake the UART thread to run this UART, unless it's already been woken
+ */
+void UARTDriver::_kick()
+{
+    if (_kick_pending || _kick_pollable.get_fd() == -1) {
+        return;
+    }
+    _kick_pending = true;
+
+    const uint64_t val = 1;
+    if (::write(_kick_pollable.get_fd(), &val, sizeof(val)) != sizeof(val)) {
+        _kick_pending = false;
+    }
+}
+
+bool UARTDriver::KickPollable::setup()
+{
+    if (_fd != -1) {
+        return true;
+    }
+
+    _fd = eventfd(0, EFD_NONBLOCK | EFD_CLOEXEC);
+    if (_fd == -1) {
+        return false;
+    }
+
+    if (!Scheduler::from(hal.scheduler)->register_uart_pollable(this, EPOLLIN)) {
+        ::close(_fd);
+        _fd = -1;
+        return false;
+    }
+
+    return true;
+}
+
+void UARTDriver::KickPollable::on_can_read()
+{
+    uint64_t val;
+    if (::read(_fd, &val, sizeof(val)) != sizeof(val)) {
+        return;
+    }
+
+    _uart._kick_pending = false;
+    _uart._timer_tick();
+}
+
+void UARTDriver::DevicePollable::on_can_read()
+{
+    _uart._timer_tick();
+}
+
+void UARTDriver::DevicePollable::on_can_write()
+{
+    // also reported with new data, which has already been handled
+    if (_uart.tx_pending()) {
+        _uart._timer_tick();
+    }
+}
+
 void UARTDriver::configure_parity(uint8_t v) {
     UARTDriver::parity = v;
     _device->set_parity(v);
@@ -1,9 +1,12 @@
 #pragma once
 
+#include <atomic>
+
 #include <AP_HAL/utility/OwnPtr.h>
 #include <AP_HAL/utility/RingBuffer.h>
 
 #include "AP_HAL_Linux.h"
+#include "Poller.h"
 #include "SerialDevice.h"
 #include "Semaphores.h"
 
@@ -58,7 +61,59 @@ public:
 
     virtual uint32_t get_baud_rate() const override { return _baudrate; }
 
+    // true if the UART is running but can't wake the UART thread when
+    // its device is ready, so has to be run periodically
+    bool needs_polling() const { return _initialised && _device_pollable.get_fd() == -1; }
+
 private:
+    /*
+      wakes the UART thread when the device can be read or written.
+      The fd belongs to the device. It's edge-triggered, so the device
+      is read until it has nothing more each time
+     */
+    class DevicePollable : public Pollable {
+    public:
+        DevicePollable(UARTDriver &uart) : _uart(uart) { }
+        ~DevicePollable() { _fd = -1; }
+
+        void set_fd(int fd) { _fd = fd; }
+
+        void on_can_read() override;
+        void on_can_write() override;
+
+    private:
+        UARTDriver &_uart;
+    };
+
+    /*
+      wakes the UART thread when there are bytes to write, or when
+      there is room in the read buffer again
+     */
+    class KickPollable : public Pollable {
+    public:
+        KickPollable(UARTDriver &uart) : _uart(uart) { }
+
+        bool setup();
+
+        void on_can_read() override;
+
+    private:
+        UARTDriver &_uart;
+    };
+
+    DevicePollable _device_pollable{*this};
+    KickPollable _kick_pollable{*this};
+    int _unpollable_fd = -1;
+    volatile bool _kick_pending;
+    std::atomic<bool> _rx_stalled{false};
+
+    void _kick();
+    void _update_pollable();
+
+    // MAVLink packets sent in one go on packetised connections
+    static const uint8_t MAX_PACKETS_PER_WRITE = 8;
+    int _write_packets_fd(const uint8_t *buf, const uint16_t *lens, uint8_t count);
+
     AP_HAL::OwnPtr<SerialDevice> _device;
     bool _console;
     volatile bool _in_timer;
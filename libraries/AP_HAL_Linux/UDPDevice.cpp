@@ -1,10 +1,14 @@
 #include "UDPDevice.h"
 
+#include <errno.h>
 #include <fcntl.h>
 #include <stdio.h>
+#include <string.h>
 #include <sys/ioctl.h>
+#include <sys/socket.h>
 
 #include <AP_HAL/AP_HAL.h>
+#include <AP_Math/AP_Math.h>
 
 UDPDevice::UDPDevice(const char *ip, uint16_t port, bool bcast, bool input):
     _ip(ip),
@@ -33,18 +37,97 @@ ssize_t UDPDevice::write(const uint8_t *buf, uint16_t n)
     return socket.sendto(buf, n, _ip, _port);
 }
 
+/*
+  send each packet in its own datagram, all in one system call
+ */
+int UDPDevice::write_packets(const uint8_t *buf, const uint16_t *lens, uint8_t count)
+{
+    if (!_batch) {
+        return SerialDevice::write_packets(buf, lens, count);
+    }
+
+    // any packets past BATCH_MAX are left for the caller to send next time
+    count = MIN(count, BATCH_MAX);
+    struct mmsghdr msgs[BATCH_MAX];
+    struct iovec iov[BATCH_MAX];
+    memset(msgs, 0, sizeof(msgs));
+    for (uint8_t i = 0; i < count; i++) {
+        iov[i].iov_base = const_cast<uint8_t *>(buf);
+        iov[i].iov_len = lens[i];
+        msgs[i].msg_hdr.msg_iov = &iov[i];
+        msgs[i].msg_hdr.msg_iovlen = 1;
+        buf += lens[i];
+    }
+
+    int ret;
+    do {
+        ret = sendmmsg(socket.get_read_fd(), msgs, count, MSG_DONTWAIT | MSG_NOSIGNAL);
+    } while (ret < 0 && errno == EINTR);
+
+    return ret < 0 ? 0 : ret;
+}
+
 ssize_t UDPDevice::read(uint8_t *buf, uint16_t n)
 {
+    if (_batch && n >= 2 * BATCH_SLOT_SIZE) {
+        return _read_batch(buf, n);
+    }
+
     ssize_t ret = socket.recv(buf, n, 0);
     if (!_connected && ret > 0) {
         const char *ip;
         uint16_t port;
         socket.last_recv_address(ip, port);
         _connected = socket.connect(ip, port);
+        _batch = _connected;
     }
     return ret;
 }
 
+/*
+  receive as many datagrams as there are slots for in one system call,
+  then move each down to follow the one before it
+ */
+ssize_t UDPDevice::_read_batch(uint8_t *buf, uint16_t n)
+{
+    const uint8_t count = MIN(n / BATCH_SLOT_SIZE, BATCH_MAX);
+    const uint16_t slot_size = n / count;
+    struct mmsghdr msgs[BATCH_MAX];
+    struct iovec iov[BATCH_MAX];
+    memset(msgs, 0, sizeof(msgs));
+    for (uint8_t i = 0; i < count; i++) {
+        iov[i].iov_base = &buf[i * slot_size];
+        iov[i].iov_len = slot_size;
+        msgs[i].msg_hdr.msg_iov = &iov[i];
+        msgs[i].msg_hdr.msg_iovlen = 1;
+    }
+
+    int ret;
+    do {
+        ret = recvmmsg(socket.get_read_fd(), msgs, count, MSG_DONTWAIT, nullptr);
+    } while (ret < 0 && errno == EINTR);
+
+    if (ret <= 0) {
+        return -1;
+    }
+
+    uint16_t len = 0;
+    for (int i = 0; i < ret; i++) {
+        if (msgs[i].msg_hdr.msg_flags & MSG_TRUNC) {
+            // the peer sends datagrams larger than a slot, receive
+            // them one at a time into the whole buffer from now on.
+            // What arrived of this one is incomplete, so drop it
+            _batch = false;
+            continue;
+        }
+        if (len != i * slot_size) {
+            memmove(&buf[len], iov[i].iov_base, msgs[i].msg_len);
+        }
+        len += msgs[i].msg_len;
+    }
+    return len;
+}
+
 bool UDPDevice::open()
 {
     if (_input) {
@@ -57,6 +140,11 @@ bool UDPDevice::open()
         return true;
     }
     _connected = socket.connect(_ip, _port);
+
+    // multicast and broadcast addresses are received on a second socket
+    const uint32_t addr = SocketAPM_native::inet_str_to_addr(_ip);
+    _batch = _connected && (addr & 0xF0000000) != 0xE0000000 && addr != 0xFFFFFFFF;
+
     return _connected;
 }
 
@@ -14,11 +14,27 @@ public:
     virtual void set_speed(uint32_t speed) override;
     virtual ssize_t write(const uint8_t *buf, uint16_t n) override;
     virtual ssize_t read(uint8_t *buf, uint16_t n) override;
+    virtual int get_read_fd() const override { return socket.get_read_fd(); }
+    virtual int write_packets(const uint8_t *buf, const uint16_t *lens, uint8_t count) override;
 private:
+    /*
+     * Datagrams are received into slots of at least this size when
+     * receiving several in one system call
+     */
+    static const uint16_t BATCH_SLOT_SIZE = 2048;
+    static const uint8_t BATCH_MAX = 8;
+
+    ssize_t _read_batch(uint8_t *buf, uint16_t n);
+
     SocketAPM_native socket{true};
     const char *_ip;
     uint16_t _port;
     bool _bcast;
     bool _input;
     bool _connected = false;
+    /*
+     * true when connected to a unicast peer, so the socket's one fd can be
+     * used directly to send and receive batches of datagrams
+     */
+    bool _batch = false;
 };
@@ -23,7 +23,6 @@
 #include <AP_Math/AP_Math.h>
 #include <GCS_MAVLink/GCS.h>
 #include "DSP.h"
-#include <cmath>
 #include <assert.h>
 
 using namespace HALSITL;
@@ -44,6 +43,11 @@ AP_HAL::DSP::FFTWindowState* DSP::fft_init(uint16_t window_size, uint16_t sample
         delete fft;
         return nullptr;
     }
+    // allocate the transform up front so that analysis cannot fail
+    if (!_fft.init(window_size)) {
+        delete fft;
+        return nullptr;
+    }
     return fft;
 }
 
@@ -56,10 +60,20 @@ void DSP::fft_start(AP_HAL::DSP::FFTWindowState* state, FloatBuffer& samples, ui
 // perform remaining steps of an FFT analysis
 uint16_t DSP::fft_analyse(AP_HAL::DSP::FFTWindowState* state, uint16_t start_bin, uint16_t end_bin, float noise_att_cutoff)
 {
-    FFTWindowStateSITL* fft = (FFTWindowStateSITL*)state;
-    step_fft(fft);
-    step_cmplx_mag(fft, start_bin, end_bin, noise_att_cutoff);
-    return step_calc_frequencies(fft, start_bin, end_bin);
+    step_fft(&state, 1);
+    step_cmplx_mag(state, start_bin, end_bin, noise_att_cutoff);
+    return step_calc_frequencies(state, start_bin, end_bin);
+}
+
+// perform remaining steps of the FFT analysis of several windows
+void DSP::fft_analyse_batch(AP_HAL::DSP::FFTWindowState* const states[], uint8_t count, uint16_t start_bin, uint16_t end_bin,
+    float noise_att_cutoff, uint16_t* bin_max)
+{
+    step_fft(states, count);
+    for (uint8_t i = 0; i < count; i++) {
+        step_cmplx_mag(states[i], start_bin, end_bin, noise_att_cutoff);
+        bin_max[i] = step_calc_frequencies(states[i], start_bin, end_bin);
+    }
 }
 
 // create an instance of the FFT state machine
@@ -68,15 +82,7 @@ DSP::FFTWindowStateSITL::FFTWindowStateSITL(uint16_t window_size, uint16_t sampl
 {
     if (_freq_bins == nullptr || _hanning_window == nullptr || _rfft_data == nullptr || _derivative_freq_bins == nullptr) {
         GCS_SEND_TEXT(MAV_SEVERITY_WARNING, "Failed to allocate window for DSP");
-        return;
     }
-
-    buf = NEW_NOTHROW complexf[window_size];
-}
-
-DSP::FFTWindowStateSITL::~FFTWindowStateSITL()
-{
-    delete[] buf;
 }
 
 // step 1: filter the incoming samples through a Hanning window
@@ -93,23 +99,31 @@ void DSP::step_hanning(FFTWindowStateSITL* fft, FloatBuffer& samples, uint16_t a
     mult_f32(&fft->_freq_bins[0], &fft->_hanning_window[0], &fft->_freq_bins[0], fft->_window_size);
 }
 
-// step 2: perform an in-place FFT on the windowed data
-void DSP::step_fft(FFTWindowStateSITL* fft)
+// step 2: perform the real FFT of the windowed data, windows of the same size are transformed together
+void DSP::step_fft(AP_HAL::DSP::FFTWindowState* const states[], uint8_t count)
 {
-    for (uint16_t i = 0; i < fft->_window_size; i++) {
-        fft->buf[i] = complexf(fft->_freq_bins[i], 0);
-    }
-
-    calculate_fft(fft->buf, fft->_window_size);
-
-    for (uint16_t i = 0; i < fft->_bin_count; i++) {
-        fft->_freq_bins[i] = std::norm(fft->buf[i]);
-    }
-
-    // components at the nyquist frequency are real only
-    for (uint16_t i = 0, j = 0; i <= fft->_bin_count; i++, j += 2) {
-        fft->_rfft_data[j] = fft->buf[i].real();
-        fft->_rfft_data[j+1] = fft->buf[i].imag();
+    const float* in[AP_HAL::BatchFFT::LANES];
+    float* out[AP_HAL::BatchFFT::LANES];
+
+    for (uint8_t i = 0; i < count; ) {
+        const uint16_t window_size = states[i]->_window_size;
+        uint8_t n = 0;
+        for (; n < AP_HAL::BatchFFT::LANES && i + n < count && states[i + n]->_window_size == window_size; n++) {
+            in[n] = states[i + n]->_freq_bins;
+            out[n] = states[i + n]->_rfft_data;
+        }
+        // the engine was allocated in fft_init(), this only rebuilds it if window sizes are mixed
+        if (_fft.init(window_size)) {
+            // DC to Nyquist as interleaved real and imaginary parts
+            _fft.transform(in, out, n);
+        }
+        for (uint8_t j = 0; j < n; j++) {
+            FFTWindowState* fft = states[i + j];
+            for (uint16_t k = 0, r = 0; k < fft->_bin_count; k++, r += 2) {
+                fft->_freq_bins[k] = sq(fft->_rfft_data[r]) + sq(fft->_rfft_data[r+1]);
+            }
+        }
+        i += n;
     }
 }
 
@@ -156,60 +170,4 @@ float DSP::vector_mean_float(const float* vin, uint16_t len) const
     return mean_value;
 }
 
-// simple integer log2
-static uint16_t fft_log2(uint16_t n)
-{
-    uint16_t k = n, i = 0;
-    while (k) {
-        k >>= 1;
-        i++;
-    }
-    return i - 1;
-}
-
-// calculate the in-place FFT of the input using the Cooley–Tukey algorithm
-// this is a translation of Ron Nicholson's version in http://www.nicholson.com/dsp.fft1.html
-void DSP::calculate_fft(complexf *samples, uint16_t fftlen)
-{
-    uint16_t m = fft_log2(fftlen);
-    // shuffle data using bit reversed addressing ***
-    for (uint16_t k = 0; k < fftlen; k++) {
-        // generate a bit reversed address for samples[k] ***
-        uint16_t ki = k, kr = 0;
-        for (uint16_t i=1; i<=m; i++) {
-            kr <<= 1; //  left shift result kr by 1 bit
-            if (ki % 2 == 1) {
-                kr++;
-            }
-            ki >>= 1; // right shift temp ki by 1 bit
-        }
-        // swap data samples[k] to bit reversed address samples[kr]
-        if (kr > k) {
-            complexf t = samples[kr];
-            samples[kr] = samples[k];
-            samples[k] = t;
-        }
-    }
-
-    // do fft butterflys in place
-    uint16_t istep = 2;
-    while (istep <= fftlen) {// layers 2,4,8,16, ... ,n
-        uint16_t is2 = istep / 2;
-        uint16_t astep = fftlen / istep;
-        for (uint16_t km = 0; km < is2; km++) { // outer row loop
-            uint16_t a  = km * astep; // twiddle angle index
-            complexf w(sinf(2 * M_PI * (a+(fftlen/4)) / fftlen), sinf(2 * M_PI * a / fftlen));
-            for (uint16_t ki = 0; ki <= (fftlen - istep); ki += istep) { // inner column loop
-                uint16_t i = km + ki;
-                uint16_t j = is2 + i;
-                complexf t = w * samples[j];
-                complexf q = samples[i];
-                samples[j] = q - t;
-                samples[i] = q + t;
-            }
-        }
-        istep <<= 1;
-    }
-}
-
 #endif
@@ -21,10 +21,11 @@
 #if HAL_WITH_DSP
 
 #include "AP_HAL_SITL.h"
+#include <AP_HAL/utility/BatchFFT.h>
 
-#include <complex>
-
-typedef std::complex<float> complexf;
+#if !AP_HAL_BATCH_FFT_ENABLED
+#error "SITL DSP requires AP_HAL_BATCH_FFT_ENABLED"
+#endif
 
 // ChibiOS implementation of FFT analysis to run on STM32 processors
 class HALSITL::DSP : public AP_HAL::DSP {
@@ -35,6 +36,9 @@ public:
     virtual void fft_start(FFTWindowState* state, FloatBuffer& samples, uint16_t advance) override;
     // perform remaining steps of an FFT analysis
     virtual uint16_t fft_analyse(FFTWindowState* state, uint16_t start_bin, uint16_t end_bin, float noise_att_cutoff) override;
+    // perform remaining steps of the FFT analysis of several windows, transforming them together
+    virtual void fft_analyse_batch(FFTWindowState* const states[], uint8_t count, uint16_t start_bin, uint16_t end_bin,
+        float noise_att_cutoff, uint16_t* bin_max) override;
 
     // STM32-based FFT state
     class FFTWindowStateSITL : public AP_HAL::DSP::FFTWindowState {
@@ -42,21 +46,19 @@ public:
 
     public:
         FFTWindowStateSITL(uint16_t window_size, uint16_t sample_rate, uint8_t sliding_window_size);
-        virtual ~FFTWindowStateSITL();
-
-    private:
-        complexf* buf;
     };
 
 private:
     void step_hanning(FFTWindowStateSITL* fft, FloatBuffer& samples, uint16_t advance);
-    void step_fft(FFTWindowStateSITL* fft);
+    void step_fft(FFTWindowState* const states[], uint8_t count);
     void mult_f32(const float* v1, const float* v2, float* vout, uint16_t len);
     void vector_max_float(const float* vin, uint16_t len, float* maxValue, uint16_t* maxIndex) const override;
     void vector_scale_float(const float* vin, float scale, float* vout, uint16_t len) const override;
     float vector_mean_float(const float* vin, uint16_t len) const override;
     void vector_add_float(const float* vin1, const float* vin2, float* vout, uint16_t len) const override;
-    void calculate_fft(complexf* f, uint16_t length);
+
+    // real FFT engine shared by all windows, sized for the most recent window
+    AP_HAL::BatchFFT _fft;
 };
 
 #endif
@@ -147,6 +147,9 @@ void SITL_State::_fdm_input_step(void)
 
 void SITL_State::wait_clock(uint64_t wait_time_usec)
 {
+    // a speedup of zero runs the simulation in lock-step, as fast as
+    // the CPU allows
+    const bool lock_step = sitl_model->lock_step();
     float speedup = sitl_model->get_speedup();
     if (speedup < 1) {
         // for purposes of sleeps treat low speedups as 1
@@ -156,6 +159,9 @@ void SITL_State::wait_clock(uint64_t wait_time_usec)
         if (hal.scheduler->in_main_thread() ||
             Scheduler::from(hal.scheduler)->semaphore_wait_hack_required()) {
             _fdm_input_step();
+            if (lock_step) {
+                _scheduler->wait_for_woken_threads();
+            }
         } else {
 #ifdef CYGWIN_BUILD
             if (speedup > 2 && hal.util->get_soft_armed()) {
@@ -173,14 +179,16 @@ void SITL_State::wait_clock(uint64_t wait_time_usec)
                 }
             }
 #endif
-            usleep(1000);
+            if (!_scheduler->wait_for_clock(wait_time_usec)) {
+                usleep(1000);
+            }
         }
     }
     // check the outbound TCP queue size.  If it is too long then
     // MAVProxy/pymavlink take too long to process packets and it ends
     // up seeing traffic well into our past and hits time-out
     // conditions.
-    if (speedup > 1 && hal.scheduler->in_main_thread()) {
+    if ((speedup > 1 || lock_step) && hal.scheduler->in_main_thread()) {
         while (true) {
             HALSITL::UARTDriver *uart = (HALSITL::UARTDriver*)hal.serial(0);
             const int queue_length = uart->get_system_outqueue_length();
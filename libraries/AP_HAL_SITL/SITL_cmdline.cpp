@@ -82,7 +82,7 @@ void SITL_State::_usage(void)
            "\t--help|-h                display this help information\n"
            "\t--wipe|-w                wipe eeprom\n"
            "\t--unhide-groups|-u       parameter enumeration ignores AP_PARAM_FLAG_ENABLE\n"
-           "\t--speedup|-s SPEEDUP     set simulation speedup\n"
+           "\t--speedup|-s SPEEDUP     set simulation speedup, 0 for lock-step as fast as possible\n"
            "\t--rate|-r RATE           set SITL framerate\n"
            "\t--console|-C             use console instead of TCP ports\n"
            "\t--instance|-I N          set instance of SITL (adds 10*instance to all port numbers)\n"
@@ -4,7 +4,9 @@
 #include <AP_HAL_SITL/I2CDevice.h>
 #include "Scheduler.h"
 #include "UARTDriver.h"
+#include <AP_HAL/utility/Trace.h>
 #include <sys/time.h>
+#include <time.h>
 #include <fenv.h>
 #include <AP_BoardConfig/AP_BoardConfig.h>
 #if defined (__clang__) || (defined (__APPLE__) && defined (__MACH__)) || defined (__OpenBSD__)
@@ -46,6 +48,14 @@ bool Scheduler::_in_semaphore_take_wait = false;
 Scheduler::thread_attr *Scheduler::threads;
 HAL_Semaphore Scheduler::_thread_sem;
 
+Scheduler::clock_waiter Scheduler::_clock_waiters[SITL_SCHEDULER_MAX_CLOCK_WAITERS];
+pthread_mutex_t Scheduler::_clock_mutex = PTHREAD_MUTEX_INITIALIZER;
+pthread_cond_t Scheduler::_clock_advanced = PTHREAD_COND_INITIALIZER;
+pthread_cond_t Scheduler::_clock_waiter_changed = PTHREAD_COND_INITIALIZER;
+
+// index into _clock_waiters of the calling thread, or -1
+static thread_local int8_t clock_waiter_idx = -1;
+
 Scheduler::Scheduler(SITL_State *sitlState) :
     _sitlState(sitlState),
     _stopped_clock_usec(0)
@@ -246,6 +256,7 @@ void Scheduler::_run_timer_procs()
         return;
     }
     _in_timer_proc = true;
+    HAL_TRACE_SCOPE("timer");
 
     // now call the timer based drivers
     for (int i = 0; i < _num_timer_procs; i++) {
@@ -270,18 +281,24 @@ void Scheduler::_run_io_procs()
     _in_io_proc = true;
 
     // now call the IO based drivers
+    HAL_TRACE_BEGIN("io");
     for (int i = 0; i < _num_io_procs; i++) {
         if (_io_proc[i]) {
             _io_proc[i]();
         }
     }
+    HAL_TRACE_END("io");
 
     _in_io_proc = false;
 
+    HAL_TRACE_BEGIN("uart");
     for (uint8_t i=0; i<hal.num_serial; i++) {
         hal.serial(i)->_timer_tick();
     }
+    HAL_TRACE_END("uart");
+    HAL_TRACE_BEGIN("storage");
     hal.storage->_timer_tick();
+    HAL_TRACE_END("storage");
 
     // in lieu of a thread-per-bus:
     ((HALSITL::I2CDeviceManager*)(hal.i2c_mgr))->_timer_tick();
@@ -300,13 +317,97 @@ void Scheduler::_run_io_procs()
  */
 void Scheduler::stop_clock(uint64_t time_usec)
 {
+    pthread_mutex_lock(&_clock_mutex);
     _stopped_clock_usec = time_usec;
+    pthread_cond_broadcast(&_clock_advanced);
+    pthread_mutex_unlock(&_clock_mutex);
+
     if (_sitlState->_sitl != nullptr && time_usec - _last_io_run > 10000) {
         _last_io_run = time_usec;
         _run_io_procs();
     }
 }
 
+/*
+  get a wall clock time timeout_us in the future for pthread_cond_timedwait
+ */
+static void wall_deadline(struct timespec &ts, uint32_t timeout_us)
+{
+    clock_gettime(CLOCK_REALTIME, &ts);
+    ts.tv_sec += timeout_us/1000000UL;
+    ts.tv_nsec += (timeout_us % 1000000U) * 1000UL;
+    if (ts.tv_nsec >= 1000000000L) {
+        ts.tv_sec++;
+        ts.tv_nsec -= 1000000000L;
+    }
+}
+
+bool Scheduler::wait_for_clock(uint64_t wait_time_usec)
+{
+    pthread_mutex_lock(&_clock_mutex);
+    if (clock_waiter_idx == -1) {
+        for (uint8_t i=0; i<ARRAY_SIZE(_clock_waiters); i++) {
+            if (_clock_waiters[i].state == clock_waiter::State::UNUSED) {
+                _clock_waiters[i].state = clock_waiter::State::IDLE;
+                clock_waiter_idx = i;
+                break;
+            }
+        }
+        if (clock_waiter_idx == -1) {
+            pthread_mutex_unlock(&_clock_mutex);
+            return false;
+        }
+    }
+    clock_waiter &w = _clock_waiters[clock_waiter_idx];
+    w.wake_usec = wait_time_usec;
+    w.state = clock_waiter::State::WAITING;
+    pthread_cond_signal(&_clock_waiter_changed);
+
+    while (_stopped_clock_usec < wait_time_usec && !_should_exit) {
+        // the timeout only matters if the main thread stops
+        // advancing the clock
+        struct timespec ts;
+        wall_deadline(ts, 100000);
+        pthread_cond_timedwait(&_clock_advanced, &_clock_mutex, &ts);
+    }
+
+    w.state = clock_waiter::State::RUNNING;
+    pthread_mutex_unlock(&_clock_mutex);
+    return true;
+}
+
+void Scheduler::wait_for_woken_threads()
+{
+    pthread_mutex_lock(&_clock_mutex);
+    const uint64_t now_usec = _stopped_clock_usec;
+    struct timespec ts;
+    wall_deadline(ts, 20000);
+    while (true) {
+        bool busy = false;
+        for (const auto &w : _clock_waiters) {
+            if (w.state == clock_waiter::State::RUNNING ||
+                (w.state == clock_waiter::State::WAITING && w.wake_usec <= now_usec)) {
+                busy = true;
+                break;
+            }
+        }
+        if (!busy) {
+            break;
+        }
+        if (pthread_cond_timedwait(&_clock_waiter_changed, &_clock_mutex, &ts) != 0) {
+            // a woken thread is blocked on a semaphore or I/O; don't
+            // wait for it again until it next waits for the clock
+            for (auto &w : _clock_waiters) {
+                if (w.state == clock_waiter::State::RUNNING) {
+                    w.state = clock_waiter::State::IDLE;
+                }
+            }
+            break;
+        }
+    }
+    pthread_mutex_unlock(&_clock_mutex);
+}
+
 /*
   trampoline for thread create
 */
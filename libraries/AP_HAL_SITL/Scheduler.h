@@ -7,6 +7,7 @@
 #include <pthread.h>
 
 #define SITL_SCHEDULER_MAX_TIMER_PROCS 8
+#define SITL_SCHEDULER_MAX_CLOCK_WAITERS 32
 
 /* Scheduler implementation: */
 class HALSITL::Scheduler : public AP_HAL::Scheduler {
@@ -70,6 +71,21 @@ public:
     // get the name of the current thread, or nullptr if not known
     const char *get_current_thread_name(void) const;
 
+    /*
+      wait in a thread other than the main thread for the simulated
+      clock to be advanced, returning once it reaches wait_time_usec.
+      Returns false if the thread couldn't be tracked, in which case
+      the caller should poll the clock instead
+     */
+    bool wait_for_clock(uint64_t wait_time_usec);
+
+    /*
+      in lock-step, wait after advancing the clock for the threads it
+      woke to run until they next wait for the clock. A thread which
+      blocks on something else is given up on after a short time
+     */
+    void wait_for_woken_threads();
+
 private:
     SITL_State *_sitlState;
     uint8_t _nested_atomic_ctr;
@@ -92,6 +108,21 @@ private:
     void stop_clock(uint64_t time_usec) override;
 
     static void *thread_create_trampoline(void *ctx);
+
+    // threads waiting in wait_for_clock()
+    struct clock_waiter {
+        uint64_t wake_usec;
+        enum class State : uint8_t {
+            UNUSED,
+            IDLE,       // not known to be running or waiting
+            WAITING,    // waiting for wake_usec
+            RUNNING,    // woken, not yet waiting again
+        } state;
+    };
+    static clock_waiter _clock_waiters[SITL_SCHEDULER_MAX_CLOCK_WAITERS];
+    static pthread_mutex_t _clock_mutex;
+    static pthread_cond_t _clock_advanced;
+    static pthread_cond_t _clock_waiter_changed;
     static void check_thread_stacks(void);
     
     bool _initialized;
@@ -4,6 +4,7 @@
 
 #include "Semaphores.h"
 #include "Scheduler.h"
+#include <AP_HAL/utility/Trace.h>
 
 extern const AP_HAL::HAL& hal;
 
@@ -42,6 +43,13 @@ void Semaphore::check_owner() const
 bool Semaphore::take(uint32_t timeout_ms)
 {
     if (timeout_ms == HAL_SEMAPHORE_BLOCK_FOREVER) {
+#if AP_HAL_TRACE_ENABLED
+        // only record contended takes
+        if (AP_HAL::Trace::enabled() && take_nonblocking()) {
+            return true;
+        }
+        HAL_TRACE_SCOPE("sem_wait");
+#endif
         if (pthread_mutex_lock(&_lock) == 0) {
             owner = pthread_self();
             take_count++;
@@ -53,6 +61,7 @@ bool Semaphore::take(uint32_t timeout_ms)
         owner = pthread_self();
         return true;
     }
+    HAL_TRACE_SCOPE("sem_wait");
     uint64_t start = AP_HAL::micros64();
     do {
         Scheduler::from(hal.scheduler)->set_in_semaphore_take_wait(true);
@@ -127,6 +127,26 @@ bool AP_InertialSensor::BatchSampler::Write_ISBH(const float sample_rate_hz) con
 // Write a series of IMU readings to log:
 bool AP_InertialSensor::BatchSampler::Write_ISBD() const
 {
+    AP_Logger &logger = AP::logger();
+    if (logger.in_place_writes_supported()) {
+        // fill the message directly in the log buffer
+        struct log_ISBD *pkt = (struct log_ISBD *)logger.reserve_block(LOG_ISBD_MSG, sizeof(log_ISBD));
+        if (pkt == nullptr) {
+            return false;
+        }
+        pkt->head1 = HEAD_BYTE1;
+        pkt->head2 = HEAD_BYTE2;
+        pkt->msgid = LOG_ISBD_MSG;
+        pkt->time_us = AP_HAL::micros64();
+        pkt->isb_seqno = isb_seqnum;
+        pkt->seqno = (uint16_t) (data_read_offset/samples_per_msg);
+        memcpy(pkt->x, &data_x[data_read_offset], sizeof(pkt->x));
+        memcpy(pkt->y, &data_y[data_read_offset], sizeof(pkt->y));
+        memcpy(pkt->z, &data_z[data_read_offset], sizeof(pkt->z));
+        logger.commit_block((uint8_t *)pkt, sizeof(log_ISBD));
+        return true;
+    }
+
     struct log_ISBD pkt = {
         LOG_PACKET_HEADER_INIT(LOG_ISBD_MSG),
         time_us    : AP_HAL::micros64(),
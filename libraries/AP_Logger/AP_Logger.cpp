@@ -202,6 +202,15 @@ const AP_Param::GroupInfo AP_Logger::var_info[] = {
     // @RebootRequired: True
     AP_GROUPINFO("_MAX_FILES", 12, AP_Logger, _params.max_log_files, MAX_LOG_FILES),
 
+#if HAL_LOGGER_FILE_COMPRESSION_ENABLED
+    // @Param: _FILE_COMPR
+    // @DisplayName: File backend log compression
+    // @Description: When enabled, new log files written by the file backend are compressed in blocks as they are written, typically making them 2 to 4 times smaller. Compressed logs start with the marker APLZ and must be decompressed (for example by Replay or Tools/scripts/decompress_log.py) before other tools can read them. Takes effect when the next log file is opened.
+    // @Values: 0:Disabled,1:Enabled
+    // @User: Advanced
+    AP_GROUPINFO("_FILE_COMPR", 13, AP_Logger, _params.file_compress, 0),
+#endif
+
     AP_GROUPEND
 };
 
@@ -753,6 +762,26 @@ bool AP_Logger::WriteBlock_first_succeed(const void *pBuffer, uint16_t size)
     return backends[0]->WriteBlock(pBuffer, size);
 }
 
+// in-place writes are only offered with a single backend, as each
+// backend needs its own copy of the message
+bool AP_Logger::in_place_writes_supported() const
+{
+    return _next_backend == 1 && backends[0]->supports_in_place_writes();
+}
+
+uint8_t *AP_Logger::reserve_block(uint8_t msg_type, uint16_t size, bool is_critical)
+{
+    if (!in_place_writes_supported()) {
+        return nullptr;
+    }
+    return backends[0]->reserve_block(msg_type, size, is_critical);
+}
+
+void AP_Logger::commit_block(uint8_t *block, uint16_t size)
+{
+    backends[0]->commit_block(block, size);
+}
+
 // write a replay block. This differs from other as it returns false if a backend doesn't
 // have space for the msg
 bool AP_Logger::WriteReplayBlock(uint8_t msg_id, const void *pBuffer, uint16_t size) {
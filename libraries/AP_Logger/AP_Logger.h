@@ -231,6 +231,17 @@ public:
     /* Write a block of replay data at current offset */
     bool WriteReplayBlock(uint8_t msg_id, const void *pBuffer, uint16_t size);
 
+    /*
+      zero-copy writes for high-rate producers. When
+      in_place_writes_supported() is true, reserve_block() returns a
+      pointer into the log buffer (or nullptr if the message is not
+      to be logged) which the caller fills with a complete message
+      and passes to commit_block() without blocking in between
+     */
+    bool in_place_writes_supported() const;
+    uint8_t *reserve_block(uint8_t msg_type, uint16_t size, bool is_critical=false);
+    void commit_block(uint8_t *block, uint16_t size);
+
     // high level interface
     uint16_t find_last_log() const;
     void get_log_boundaries(uint16_t log_num, uint32_t & start_page, uint32_t & end_page);
@@ -349,6 +360,9 @@ public:
         AP_Float blk_ratemax;
         AP_Float disarm_ratemax;
         AP_Int16 max_log_files;
+#if HAL_LOGGER_FILE_COMPRESSION_ENABLED
+        AP_Int8 file_compress;
+#endif
     } _params;
 
     const struct LogStructure *structure(uint16_t num) const;
@@ -217,7 +217,29 @@ bool AP_Logger_Backend::Write(const uint8_t msg_type, va_list arg_list, bool is_
         return false;
     }
 
+    if (supports_in_place_writes()) {
+        // serialise straight into the backend's buffer
+        uint8_t *block = reserve_block(msg_type, msg_len, is_critical, is_streaming);
+        if (block == nullptr) {
+            return false;
+        }
+        serialise_message(block, msg_type, fmt, arg_list);
+        commit_block(block, msg_len);
+        return true;
+    }
+
     uint8_t buffer[msg_len];
+    serialise_message(buffer, msg_type, fmt, arg_list);
+
+    return WritePrioritisedBlock(buffer, msg_len, is_critical, is_streaming);
+}
+
+/*
+  pack the arguments for a WriteV() message into buffer, which must be
+  at least the message length
+ */
+void AP_Logger_Backend::serialise_message(uint8_t *buffer, uint8_t msg_type, const char *fmt, va_list arg_list) const
+{
     uint8_t offset = 0;
     buffer[offset++] = HEAD_BYTE1;
     buffer[offset++] = HEAD_BYTE2;
@@ -323,8 +345,6 @@ bool AP_Logger_Backend::Write(const uint8_t msg_type, va_list arg_list, bool is_
             offset += charlen;
         }
     }
-
-    return WritePrioritisedBlock(buffer, msg_len, is_critical, is_streaming);
 }
 
 bool AP_Logger_Backend::StartNewLogOK() const
@@ -410,18 +430,13 @@ void AP_Logger_Backend::validate_WritePrioritisedBlock(const void *pBuffer,
 }
 #endif
 
-bool AP_Logger_Backend::ensure_format_emitted(const void *pBuffer, uint16_t size)
+bool AP_Logger_Backend::ensure_format_emitted(LogMessages type)
 {
 #if APM_BUILD_TYPE(APM_BUILD_Replay)
     // we trust that Replay will correctly emit formats as required
     return true;
 #endif
 
-    // extract the ID:
-    LogMessages type;
-    if (!message_type_from_block(pBuffer, size, type)) {
-        return false;
-    }
     if (have_emitted_format_for_type(type)) {
         return true;
     }
@@ -444,6 +459,24 @@ bool AP_Logger_Backend::WritePrioritisedBlock(const void *pBuffer, uint16_t size
 #if CONFIG_HAL_BOARD == HAL_BOARD_SITL && !APM_BUILD_TYPE(APM_BUILD_Replay)
     validate_WritePrioritisedBlock(pBuffer, size);
 #endif
+    LogMessages type;
+    if (!message_type_from_block(pBuffer, size, type)) {
+        return false;
+    }
+    if (!prepare_write(type, is_critical, writev_streaming)) {
+        return false;
+    }
+
+    return _WritePrioritisedBlock(pBuffer, size, is_critical);
+}
+
+/*
+  common checks before a message of type msg_type is written,
+  starting a new log and emitting the message's format if needed.
+  Returns false if the message should not be written
+ */
+bool AP_Logger_Backend::prepare_write(uint8_t msg_type, bool is_critical, bool writev_streaming)
+{
     if (!ShouldLog(is_critical)) {
         return false;
     }
@@ -455,17 +488,32 @@ bool AP_Logger_Backend::WritePrioritisedBlock(const void *pBuffer, uint16_t size
     }
 
     if (!is_critical && rate_limiter != nullptr) {
-        const uint8_t *msgbuf = (const uint8_t *)pBuffer;
-        if (!rate_limiter->should_log(msgbuf[2], writev_streaming)) {
+        if (!rate_limiter->should_log(msg_type, writev_streaming)) {
             return false;
         }
     }
 
-    if (!ensure_format_emitted(pBuffer, size)) {
-        return false;
+    return ensure_format_emitted(LogMessages(msg_type));
+}
+
+/*
+  reserve space for an in-place write. On success the backend's
+  buffer stays locked until commit_block() is called
+ */
+uint8_t *AP_Logger_Backend::reserve_block(uint8_t msg_type, uint16_t size, bool is_critical, bool writev_streaming)
+{
+    if (!prepare_write(msg_type, is_critical, writev_streaming)) {
+        return nullptr;
     }
+    return _reserve_block(size, is_critical);
+}
 
-    return _WritePrioritisedBlock(pBuffer, size, is_critical);
+void AP_Logger_Backend::commit_block(uint8_t *block, uint16_t size)
+{
+#if CONFIG_HAL_BOARD == HAL_BOARD_SITL && !APM_BUILD_TYPE(APM_BUILD_Replay)
+    validate_WritePrioritisedBlock(block, size);
+#endif
+    _commit_block(block, size);
 }
 
 bool AP_Logger_Backend::ShouldLog(bool is_critical)
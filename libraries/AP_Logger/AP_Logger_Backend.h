@@ -71,6 +71,17 @@ public:
 
     bool WritePrioritisedBlock(const void *pBuffer, uint16_t size, bool is_critical, bool writev_streaming=false);
 
+    /*
+      in-place writes: reserve_block() returns a pointer to size bytes
+      in the backend's buffer which the caller fills with a complete
+      message of type msg_type and hands back with commit_block().
+      Returns nullptr if the message is not to be logged. Only valid
+      when supports_in_place_writes() is true
+     */
+    virtual bool supports_in_place_writes() const { return false; }
+    uint8_t *reserve_block(uint8_t msg_type, uint16_t size, bool is_critical, bool writev_streaming=false);
+    void commit_block(uint8_t *block, uint16_t size);
+
     // high level interface, indexed by the position in the list of logs
     virtual uint16_t find_last_log() = 0;
     virtual void get_log_boundaries(uint16_t list_entry, uint32_t & start_page, uint32_t & end_page) = 0;
@@ -243,6 +254,8 @@ protected:
     };
 
     virtual bool _WritePrioritisedBlock(const void *pBuffer, uint16_t size, bool is_critical) = 0;
+    virtual uint8_t *_reserve_block(uint16_t size, bool is_critical) { return nullptr; }
+    virtual void _commit_block(uint8_t *block, uint16_t size) {}
 
     bool _initialised;
 
@@ -271,7 +284,9 @@ private:
     void validate_WritePrioritisedBlock(const void *pBuffer, uint16_t size);
 
     bool message_type_from_block(const void *pBuffer, uint16_t size, LogMessages &type) const;
-    bool ensure_format_emitted(const void *pBuffer, uint16_t size);
+    bool ensure_format_emitted(LogMessages type);
+    bool prepare_write(uint8_t msg_type, bool is_critical, bool writev_streaming);
+    void serialise_message(uint8_t *buffer, uint8_t msg_type, const char *fmt, va_list arg_list) const;
     bool emit_format_for_type(LogMessages a_type);
     Bitmask<256> _formats_written;
 
@@ -452,6 +452,22 @@ bool AP_Logger_File::_WritePrioritisedBlock(const void *pBuffer, uint16_t size,
 #endif
 
 
+    if (!writebuf_has_space(size, is_critical)) {
+        return false;
+    }
+
+    _writebuf.write((uint8_t*)pBuffer, size);
+    df_stats_gather(size, _writebuf.space());
+    return true;
+}
+
+/*
+  apply the buffer space rules for a message of the given size: room
+  is kept for the startup message writer and for critical messages.
+  Must be called with semaphore held
+ */
+bool AP_Logger_File::writebuf_has_space(uint16_t size, bool is_critical)
+{
     uint32_t space = _writebuf.space();
 
     if (_writing_startup_messages &&
@@ -482,11 +498,44 @@ bool AP_Logger_File::_WritePrioritisedBlock(const void *pBuffer, uint16_t size,
         return false;
     }
 
-    _writebuf.write((uint8_t*)pBuffer, size);
-    df_stats_gather(size, _writebuf.space());
     return true;
 }
 
+/*
+  reserve size bytes in the write buffer for the caller to fill in
+  place. The semaphore is held until _commit_block(), so the caller
+  must not block between the two calls
+ */
+uint8_t *AP_Logger_File::_reserve_block(uint16_t size, bool is_critical)
+{
+    if (size > sizeof(_wrap_block)) {
+        return nullptr;
+    }
+    semaphore.take_blocking();
+    if (!writebuf_has_space(size, is_critical)) {
+        semaphore.give();
+        return nullptr;
+    }
+    ByteBuffer::IoVec vec[2];
+    if (_writebuf.reserve(vec, size) == 1) {
+        return vec[0].data;
+    }
+    // the space wraps around the end of the ring; fill a bounce
+    // buffer and copy it in on commit
+    return _wrap_block;
+}
+
+void AP_Logger_File::_commit_block(uint8_t *block, uint16_t size)
+{
+    if (block == _wrap_block) {
+        _writebuf.write(block, size);
+    } else {
+        _writebuf.commit(size);
+    }
+    df_stats_gather(size, _writebuf.space());
+    semaphore.give();
+}
+
 /*
   find the highest log number
  */
@@ -846,6 +895,9 @@ void AP_Logger_File::start_new_log(void)
     _open_error_ms = 0;
     _write_offset = 0;
     _writebuf.clear();
+#if HAL_LOGGER_FILE_COMPRESSION_ENABLED
+    start_compression();
+#endif
     write_fd_semaphore.give();
 
     // now update lastlog.txt with the new log number
@@ -855,6 +907,41 @@ void AP_Logger_File::start_new_log(void)
     }
 }
 
+#if HAL_LOGGER_FILE_COMPRESSION_ENABLED
+/*
+  set up block compression for a newly opened log file if enabled,
+  writing the file marker. Called with write_fd_semaphore held
+ */
+void AP_Logger_File::start_compression()
+{
+    _compressing = false;
+    _compress_len = 0;
+    _compress_ofs = 0;
+    if (_front._params.file_compress == 0 || APM_BUILD_TYPE(APM_BUILD_Replay)) {
+        // Replay writes straight to the file, bypassing the ring
+        return;
+    }
+    if (_compressor == nullptr) {
+        _compressor = NEW_NOTHROW LogCompressor;
+        _compress_buf = NEW_NOTHROW uint8_t[LogCompressor::MAX_ENCODED_BLOCK];
+        if (_compressor == nullptr || _compress_buf == nullptr) {
+            delete _compressor;
+            delete[] _compress_buf;
+            _compressor = nullptr;
+            _compress_buf = nullptr;
+            DEV_PRINTF("Out of memory for log compression\n");
+            return;
+        }
+    }
+    const ssize_t magic_len = sizeof(LogCompressor::FILE_MAGIC);
+    if (AP::FS().write(_write_fd, LogCompressor::FILE_MAGIC, magic_len) != magic_len) {
+        return;
+    }
+    _write_offset = magic_len;
+    _compressing = true;
+}
+#endif
+
 /*
   write LASTLOG.TXT, possibly with a discard marker
  */
@@ -883,7 +970,8 @@ void AP_Logger_File::flush(void)
 #if APM_BUILD_TYPE(APM_BUILD_Replay) || APM_BUILD_TYPE(APM_BUILD_UNKNOWN)
 {
     uint32_t tnow = AP_HAL::millis();
-    while (_write_fd != -1 && _initialised && !recent_open_error() && _writebuf.available()) {
+    while (_write_fd != -1 && _initialised && !recent_open_error() &&
+           (_writebuf.available() || compressed_block_pending())) {
         // convince the IO timer that it really is OK to write out
         // less than _writebuf_chunk bytes:
         if (tnow > 2001) { // avoid resetting _last_write_time to 0
@@ -935,10 +1023,12 @@ void AP_Logger_File::io_timer(void)
     }
 
     uint32_t nbytes = _writebuf.available();
-    if (nbytes == 0) {
+    // the rest of a partially written compressed block goes out first
+    const bool block_pending = compressed_block_pending();
+    if (nbytes == 0 && !block_pending) {
         return;
     }
-    if (nbytes < _writebuf_chunk && 
+    if (nbytes < _writebuf_chunk && !block_pending &&
         tnow - _last_write_time < 2000UL) {
         // write in _writebuf_chunk-sized chunks, but always write at
         // least once per 2 seconds if data is available
@@ -960,14 +1050,51 @@ void AP_Logger_File::io_timer(void)
     }
 #endif
     _last_write_time = tnow;
-    if (nbytes > _writebuf_chunk) {
-        // be kind to the filesystem layer
-        nbytes = _writebuf_chunk;
+
+    last_io_operation = "write";
+    if (!write_fd_semaphore.take(1)) {
+        return;
+    }
+    if (_write_fd == -1) {
+        write_fd_semaphore.give();
+        return;
     }
 
-    uint32_t size;
-    const uint8_t *head = _writebuf.readptr(size);
-    nbytes = MIN(nbytes, size);
+    // head is set when writing from a single buffer, otherwise the
+    // data is gathered from both parts of the ring with writev()
+    const uint8_t *head = nullptr;
+#if HAL_LOGGER_FILE_COMPRESSION_ENABLED
+    if (_compressing) {
+        if (!compressed_block_pending()) {
+            // encode the next contiguous part of the ring as a block
+            uint32_t size;
+            const uint8_t *src = _writebuf.readptr(size);
+            const uint16_t len = MIN(MIN(nbytes, size), uint32_t(LogCompressor::MAX_BLOCK));
+            if (len == 0) {
+                // the log was restarted while we waited
+                write_fd_semaphore.give();
+                return;
+            }
+            _compress_len = _compressor->encode_block(src, len, _compress_buf);
+            _compress_ofs = 0;
+            _writebuf.advance(len);
+        }
+        head = &_compress_buf[_compress_ofs];
+        nbytes = _compress_len - _compress_ofs;
+    } else
+#endif
+    if (HAL_LOGGER_WRITEV_MAX_CHUNKS > 1) {
+        // drain several chunks at once, including across the end of
+        // the ring, with a single writev()
+        nbytes = MIN(nbytes, uint32_t(_writebuf_chunk) * HAL_LOGGER_WRITEV_MAX_CHUNKS);
+    } else {
+        // be kind to the filesystem layer
+        nbytes = MIN(nbytes, uint32_t(_writebuf_chunk));
+
+        uint32_t size;
+        head = _writebuf.readptr(size);
+        nbytes = MIN(nbytes, size);
+    }
 
 #if !AP_FILESYSTEM_LITTLEFS_ENABLED
     // try to align writes on a 512 byte boundary to avoid filesystem reads
@@ -978,21 +1105,20 @@ void AP_Logger_File::io_timer(void)
         }
     }
 #endif
-    last_io_operation = "write";
-    if (!write_fd_semaphore.take(1)) {
-        return;
-    }
-    if (_write_fd == -1) {
-        write_fd_semaphore.give();
-        return;
-    }
 
     uint32_t bytes_until_fsync = AP::FS().bytes_until_fsync(_write_fd);
     if (bytes_until_fsync > 0 && nbytes > bytes_until_fsync) {
         nbytes = bytes_until_fsync; // write exactly enough to sync
     }
 
-    ssize_t nwritten = AP::FS().write(_write_fd, head, nbytes);
+    ssize_t nwritten;
+    if (head != nullptr) {
+        nwritten = AP::FS().write(_write_fd, head, nbytes);
+    } else {
+        ByteBuffer::IoVec iov[2];
+        const uint8_t iovcnt = _writebuf.peekiovec(iov, nbytes);
+        nwritten = AP::FS().writev(_write_fd, iov, iovcnt);
+    }
     last_io_operation = "";
     if (nwritten <= 0) {
         if (errno == ENOSPC) {
@@ -1015,7 +1141,14 @@ void AP_Logger_File::io_timer(void)
         _last_write_failed = false;
         _last_write_ms = tnow;
         _write_offset += nwritten;
-        _writebuf.advance(nwritten);
+#if HAL_LOGGER_FILE_COMPRESSION_ENABLED
+        if (_compressing) {
+            _compress_ofs += nwritten;
+        } else
+#endif
+        {
+            _writebuf.advance(nwritten);
+        }
 
         // we know nwritten > 0 so we won't sync if bytes_until_fsync == 0
         if ((uint32_t)nwritten == bytes_until_fsync) {
@@ -9,7 +9,9 @@
 #include <AP_Filesystem/AP_Filesystem.h>
 
 #include <AP_HAL/utility/RingBuffer.h>
+#include <AP_Vehicle/AP_Vehicle_Type.h>
 #include "AP_Logger_Backend.h"
+#include "LogCompress.h"
 
 #if HAL_LOGGING_FILESYSTEM_ENABLED
 
@@ -21,6 +23,16 @@
 #endif
 #endif
 
+// number of chunks io_timer() may flush in a single gathering write,
+// covering both parts of the ring when it wraps
+#ifndef HAL_LOGGER_WRITEV_MAX_CHUNKS
+#if CONFIG_HAL_BOARD == HAL_BOARD_SITL || CONFIG_HAL_BOARD == HAL_BOARD_LINUX
+#define HAL_LOGGER_WRITEV_MAX_CHUNKS 4
+#else
+#define HAL_LOGGER_WRITEV_MAX_CHUNKS 1
+#endif
+#endif
+
 class AP_Logger_File : public AP_Logger_Backend
 {
 public:
@@ -42,6 +54,9 @@ public:
 
     /* Write a block of data at current offset */
     bool _WritePrioritisedBlock(const void *pBuffer, uint16_t size, bool is_critical) override;
+#if !APM_BUILD_TYPE(APM_BUILD_Replay)
+    bool supports_in_place_writes() const override { return true; }
+#endif
     uint32_t bufferspace_available() override;
 
     // high level interface
@@ -71,6 +86,8 @@ protected:
     bool WritesOK() const override;
     bool StartNewLogOK() const override;
     void PrepForArming_start_logging() override;
+    uint8_t *_reserve_block(uint16_t size, bool is_critical) override;
+    void _commit_block(uint8_t *block, uint16_t size) override;
 
 private:
     int _write_fd = -1;
@@ -113,6 +130,24 @@ private:
     ByteBuffer _writebuf{0};
     const uint16_t _writebuf_chunk = HAL_LOGGER_WRITE_CHUNK_SIZE;
     uint32_t _last_write_time;
+    bool writebuf_has_space(uint16_t size, bool is_critical);
+
+#if HAL_LOGGER_FILE_COMPRESSION_ENABLED
+    // block compression of the current log file, see LogCompress.h
+    LogCompressor *_compressor;
+    uint8_t *_compress_buf;     // encoded block being written out
+    uint32_t _compress_len;     // bytes in _compress_buf
+    uint32_t _compress_ofs;     // bytes of _compress_buf already written
+    bool _compressing;
+    void start_compression();
+    bool compressed_block_pending() const { return _compressing && _compress_ofs < _compress_len; }
+#else
+    bool compressed_block_pending() const { return false; }
+#endif
+
+    // in-place writes that would wrap the end of _writebuf are
+    // assembled here instead. Log messages are at most 255 bytes
+    uint8_t _wrap_block[255];
 
     /* construct a file name given a log number. Caller must free. */
     char *_log_file_name(const uint16_t log_num) const;
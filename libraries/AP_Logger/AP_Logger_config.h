@@ -51,6 +51,11 @@
 #define HAL_LOGGER_FILE_CONTENTS_ENABLED HAL_LOGGING_FILESYSTEM_ENABLED && !AP_FILESYSTEM_LITTLEFS_ENABLED
 #endif
 
+// block compression of file logs, selected with LOG_FILE_COMPR
+#ifndef HAL_LOGGER_FILE_COMPRESSION_ENABLED
+#define HAL_LOGGER_FILE_COMPRESSION_ENABLED HAL_LOGGING_FILESYSTEM_ENABLED && (CONFIG_HAL_BOARD == HAL_BOARD_SITL || CONFIG_HAL_BOARD == HAL_BOARD_LINUX)
+#endif
+
 // range of IDs to allow for new messages during replay. It is very
 // useful to be able to add new messages during a replay, but we need
 // to avoid colliding with existing messages
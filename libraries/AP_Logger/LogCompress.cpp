@@ -0,0 +1,235 @@
+/*
+   This program is free software: you can redistribute it and/or modify
+   it under the terms of the GNU General Public License as published by
+   the Free Software Foundation, either version 3 of the License, or
+   (at your option) any later version.
+
+   This program is distributed in the hope that it will be useful,
+   but WITHOUT ANY WARRANTY; without even the implied warranty of
+   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+   GNU General Public License for more details.
+
+   You should have received a copy of the GNU General Public License
+   along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "LogCompress.h"
+
+#if HAL_LOGGER_FILE_COMPRESSION_ENABLED
+
+#include <string.h>
+
+// LZ4 block format constants
+#define LZ_MINMATCH     4
+#define LZ_LASTLITERALS 5   // the last 5 bytes are always literals
+#define LZ_MFLIMIT      12  // the last match must start 12 bytes before the end
+
+constexpr uint8_t LogCompressor::FILE_MAGIC[4];
+
+static inline uint32_t read32(const uint8_t *p)
+{
+    uint32_t v;
+    memcpy(&v, p, sizeof(v));
+    return v;
+}
+
+// write the extension bytes for a length that didn't fit in its nibble
+static inline uint8_t *write_length(uint8_t *op, uint32_t len)
+{
+    for (; len >= 255; len -= 255) {
+        *op++ = 255;
+    }
+    *op++ = len;
+    return op;
+}
+
+uint32_t LogCompressor::compress(const uint8_t *src, uint32_t len, uint8_t *dst, uint32_t dst_len)
+{
+    const uint8_t *ip = src;
+    const uint8_t *anchor = src;
+    const uint8_t *const iend = src + len;
+    uint8_t *op = dst;
+    uint8_t *const oend = dst + dst_len;
+
+    if (len > MAX_BLOCK) {
+        return 0;
+    }
+
+    if (len > LZ_MFLIMIT) {
+        const uint8_t *const mflimit = iend - LZ_MFLIMIT;
+        const uint8_t *const matchlimit = iend - LZ_LASTLITERALS;
+        while (ip < mflimit) {
+            const uint32_t seq = read32(ip);
+            const uint16_t h = (seq * 2654435761U) >> (32 - HASH_LOG);
+            const uint16_t pos = ip - src;
+            const uint16_t ref = hash_table[h];
+            hash_table[h] = pos;
+            if (ref >= pos || read32(&src[ref]) != seq) {
+                // skip faster through incompressible data
+                ip += 1 + ((ip - anchor) >> 6);
+                continue;
+            }
+
+            // extend the match backwards into the pending literals
+            const uint8_t *match = &src[ref];
+            while (ip > anchor && match > src && ip[-1] == match[-1]) {
+                ip--;
+                match--;
+            }
+            // and forwards
+            uint32_t mlen = LZ_MINMATCH;
+            while (ip + mlen < matchlimit && ip[mlen] == match[mlen]) {
+                mlen++;
+            }
+
+            const uint32_t lit = ip - anchor;
+            const uint32_t ml = mlen - LZ_MINMATCH;
+            if (op + 1 + lit/255 + 1 + lit + 2 + ml/255 + 1 > oend) {
+                return 0;
+            }
+            uint8_t *token = op++;
+            if (lit >= 15) {
+                *token = 15 << 4;
+                op = write_length(op, lit - 15);
+            } else {
+                *token = lit << 4;
+            }
+            memcpy(op, anchor, lit);
+            op += lit;
+
+            const uint16_t offset = ip - match;
+            *op++ = offset & 0xFF;
+            *op++ = offset >> 8;
+
+            if (ml >= 15) {
+                *token |= 15;
+                op = write_length(op, ml - 15);
+            } else {
+                *token |= ml;
+            }
+
+            ip += mlen;
+            anchor = ip;
+
+            // index a position inside the match so that repeated
+            // message headers are found again quickly
+            if (ip < mflimit) {
+                const uint8_t *p = ip - 2;
+                hash_table[(read32(p) * 2654435761U) >> (32 - HASH_LOG)] = p - src;
+            }
+        }
+    }
+
+    // remaining bytes as a literal-only sequence
+    const uint32_t lit = iend - anchor;
+    if (op + 1 + lit/255 + 1 + lit > oend) {
+        return 0;
+    }
+    if (lit >= 15) {
+        *op++ = 15 << 4;
+        op = write_length(op, lit - 15);
+    } else {
+        *op++ = lit << 4;
+    }
+    memcpy(op, anchor, lit);
+    op += lit;
+
+    return op - dst;
+}
+
+int32_t LogCompressor::decompress(const uint8_t *src, uint32_t len, uint8_t *dst, uint32_t dst_len)
+{
+    const uint8_t *ip = src;
+    const uint8_t *const iend = src + len;
+    uint8_t *op = dst;
+    uint8_t *const oend = dst + dst_len;
+
+    while (ip < iend) {
+        const uint8_t token = *ip++;
+
+        uint32_t lit = token >> 4;
+        if (lit == 15) {
+            uint8_t b;
+            do {
+                if (ip >= iend) {
+                    return -1;
+                }
+                b = *ip++;
+                lit += b;
+            } while (b == 255);
+        }
+        if (lit > uint32_t(iend - ip) || lit > uint32_t(oend - op)) {
+            return -1;
+        }
+        memcpy(op, ip, lit);
+        op += lit;
+        ip += lit;
+
+        if (ip == iend) {
+            // the last sequence has no match
+            break;
+        }
+
+        if (iend - ip < 2) {
+            return -1;
+        }
+        const uint16_t offset = ip[0] | (ip[1] << 8);
+        ip += 2;
+        if (offset == 0 || offset > op - dst) {
+            return -1;
+        }
+
+        uint32_t mlen = token & 0x0F;
+        if (mlen == 15) {
+            uint8_t b;
+            do {
+                if (ip >= iend) {
+                    return -1;
+                }
+                b = *ip++;
+                mlen += b;
+            } while (b == 255);
+        }
+        mlen += LZ_MINMATCH;
+        if (mlen > uint32_t(oend - op)) {
+            return -1;
+        }
+
+        // byte-wise copy as the match may overlap the output
+        const uint8_t *match = op - offset;
+        while (mlen--) {
+            *op++ = *match++;
+        }
+    }
+
+    return op - dst;
+}
+
+uint32_t LogCompressor::encode_block(const uint8_t *src, uint16_t len, uint8_t *dst)
+{
+    uint16_t stored_len = compress(src, len, &dst[BLOCK_HEADER_LEN], len);
+    if (stored_len == 0) {
+        // didn't compress, store it as is
+        memcpy(&dst[BLOCK_HEADER_LEN], src, len);
+        stored_len = len | BLOCK_STORED;
+    }
+    dst[0] = stored_len & 0xFF;
+    dst[1] = stored_len >> 8;
+    dst[2] = len & 0xFF;
+    dst[3] = len >> 8;
+    return BLOCK_HEADER_LEN + (stored_len & ~BLOCK_STORED);
+}
+
+bool LogCompressor::decode_header(const uint8_t hdr[BLOCK_HEADER_LEN], uint16_t &stored_len, uint16_t &raw_len, bool &is_stored)
+{
+    const uint16_t v = hdr[0] | (hdr[1] << 8);
+    is_stored = (v & BLOCK_STORED) != 0;
+    stored_len = v & ~BLOCK_STORED;
+    raw_len = hdr[2] | (hdr[3] << 8);
+    if (raw_len > MAX_BLOCK || stored_len > MAX_BLOCK) {
+        return false;
+    }
+    return !is_stored || stored_len == raw_len;
+}
+
+#endif  // HAL_LOGGER_FILE_COMPRESSION_ENABLED
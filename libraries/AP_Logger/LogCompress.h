@@ -0,0 +1,68 @@
+/*
+   This program is free software: you can redistribute it and/or modify
+   it under the terms of the GNU General Public License as published by
+   the Free Software Foundation, either version 3 of the License, or
+   (at your option) any later version.
+
+   This program is distributed in the hope that it will be useful,
+   but WITHOUT ANY WARRANTY; without even the implied warranty of
+   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+   GNU General Public License for more details.
+
+   You should have received a copy of the GNU General Public License
+   along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+/*
+  streaming block compression for log files.
+
+  A compressed log starts with the 4 byte FILE_MAGIC, followed by
+  blocks of up to MAX_BLOCK bytes of the normal log stream. Each block
+  has a 4 byte little-endian header of the stored length and raw
+  length; if BLOCK_STORED is set in the stored length the payload is
+  the raw bytes, otherwise it is an LZ4 format block. Blocks are
+  independent so a damaged block only loses its own messages
+ */
+#pragma once
+
+#include "AP_Logger_config.h"
+
+#if HAL_LOGGER_FILE_COMPRESSION_ENABLED
+
+#include <stdint.h>
+
+class LogCompressor {
+public:
+    static constexpr uint8_t FILE_MAGIC[4] { 'A', 'P', 'L', 'Z' };
+    static constexpr uint8_t BLOCK_HEADER_LEN = 4;
+    static constexpr uint16_t BLOCK_STORED = 0x8000;
+    static constexpr uint16_t MAX_BLOCK = 16384;
+
+    // largest encoded block, including its header
+    static constexpr uint32_t MAX_ENCODED_BLOCK = BLOCK_HEADER_LEN + MAX_BLOCK;
+
+    // encode len bytes (at most MAX_BLOCK) of src as a block with
+    // header into dst, which must hold MAX_ENCODED_BLOCK bytes.
+    // Returns the encoded length
+    uint32_t encode_block(const uint8_t *src, uint16_t len, uint8_t *dst);
+
+    // parse a block header, returning false if it is not valid
+    static bool decode_header(const uint8_t hdr[BLOCK_HEADER_LEN], uint16_t &stored_len, uint16_t &raw_len, bool &is_stored);
+
+    // LZ4 block compression of src into dst. Returns the compressed
+    // length, or 0 if it would not fit in dst_len bytes
+    uint32_t compress(const uint8_t *src, uint32_t len, uint8_t *dst, uint32_t dst_len);
+
+    // decompress an LZ4 block. Returns the decompressed length or
+    // -1 if the input is corrupt or does not fit in dst_len bytes
+    static int32_t decompress(const uint8_t *src, uint32_t len, uint8_t *dst, uint32_t dst_len);
+
+private:
+    static constexpr uint8_t HASH_LOG = 12;
+
+    // position within the current block of the last occurrence of
+    // each hashed 4 byte sequence. Stale entries from earlier blocks
+    // are rejected by comparing the bytes
+    uint16_t hash_table[1U<<HASH_LOG];
+};
+
+#endif  // HAL_LOGGER_FILE_COMPRESSION_ENABLED
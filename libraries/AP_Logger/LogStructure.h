@@ -547,6 +547,17 @@ struct PACKED log_Performance {
     uint64_t rtc;
 };
 
+struct PACKED log_TaskLatency {
+    LOG_PACKET_HEADER;
+    uint64_t time_us;
+    uint8_t id;
+    uint16_t p50;
+    uint16_t p99;
+    uint16_t p999;
+    uint16_t max_jitter;
+    char name[16];
+};
+
 struct PACKED log_SRTL {
     LOG_PACKET_HEADER;
     uint64_t time_us;
@@ -882,6 +893,16 @@ struct PACKED log_VER {
 // @Field: Ex: number of microseconds being added to each loop to address scheduler overruns
 // @Field: R: RTC time, time since Unix epoch
 
+// @LoggerMessage: TSKL
+// @Description: Scheduler task latency percentiles, from the per-task latency histograms
+// @Field: TimeUS: Time since system startup
+// @Field: Id: Task index in the scheduler table, 255 for the whole main loop
+// @Field: P50: median task run time (main loop time for Id 255)
+// @Field: P99: 99th percentile task run time
+// @Field: P999: 99.9th percentile task run time
+// @Field: JMax: maximum start delay relative to the start of the loop the task was due in (deviation from nominal loop period for Id 255)
+// @Field: Name: Task name
+
 // @LoggerMessage: POWR
 // @Description: System power information
 // @Field: TimeUS: Time since system startup
@@ -1194,6 +1215,8 @@ LOG_STRUCTURE_FROM_MOUNT \
     LOG_STRUCTURE_FROM_PROXIMITY                                    \
     { LOG_PERFORMANCE_MSG, sizeof(log_Performance),                     \
       "PM",  "QHHHIIHHIIIIIIQ", "TimeUS,LR,NLon,NL,MaxT,Mem,Load,ErrL,InE,ErC,SPIC,I2CC,I2CI,Ex,R", "sz---b%------ss", "F----0A------FF" }, \
+    { LOG_TASK_LATENCY_MSG, sizeof(log_TaskLatency), \
+      "TSKL", "QBHHHHN", "TimeUS,Id,P50,P99,P999,JMax,Name", "s#ssss-", "F-FFFF-" }, \
     { LOG_SRTL_MSG, sizeof(log_SRTL), \
       "SRTL", "QBHHBfff", "TimeUS,Active,NumPts,MaxPts,Action,N,E,D", "s----mmm", "F----000" }, \
 LOG_STRUCTURE_FROM_AVOIDANCE \
@@ -1348,6 +1371,7 @@ enum LogMessages : uint8_t {
     LOG_RCOUT3_MSG,
     LOG_IDS_FROM_FENCE,
     LOG_IDS_FROM_HAL,
+    LOG_TASK_LATENCY_MSG,
 
     _LOG_LAST_MSG_
 };
@@ -0,0 +1,110 @@
+#include <AP_gtest.h>
+#include <AP_HAL/HAL.h>
+#include <AP_Logger/LogCompress.h>
+#include <AP_Logger/LogStructure.h>
+#include <stdlib.h>
+#include <string.h>
+
+const AP_HAL::HAL& hal = AP_HAL::get_HAL();
+
+#if HAL_LOGGER_FILE_COMPRESSION_ENABLED
+
+static LogCompressor compressor;
+static uint8_t encoded[LogCompressor::MAX_ENCODED_BLOCK];
+static uint8_t decoded[LogCompressor::MAX_BLOCK];
+
+// encode then decode one block, returning the encoded size
+static uint32_t round_trip(const uint8_t *data, uint16_t len)
+{
+    const uint32_t enc_len = compressor.encode_block(data, len, encoded);
+    EXPECT_LE(enc_len, uint32_t(LogCompressor::BLOCK_HEADER_LEN + len));
+
+    uint16_t stored_len, raw_len;
+    bool is_stored;
+    EXPECT_TRUE(LogCompressor::decode_header(encoded, stored_len, raw_len, is_stored));
+    EXPECT_EQ(raw_len, len);
+    EXPECT_EQ(uint32_t(LogCompressor::BLOCK_HEADER_LEN + stored_len), enc_len);
+
+    const uint8_t *payload = &encoded[LogCompressor::BLOCK_HEADER_LEN];
+    if (is_stored) {
+        EXPECT_EQ(0, memcmp(payload, data, len));
+    } else {
+        EXPECT_EQ(int32_t(len), LogCompressor::decompress(payload, stored_len, decoded, sizeof(decoded)));
+        EXPECT_EQ(0, memcmp(decoded, data, len));
+    }
+    return enc_len;
+}
+
+TEST(LogCompress, EmptyAndShort)
+{
+    const uint8_t data[] { 1, 2, 3, 4, 5, 6, 7, 8, 9, 10, 11, 12, 13 };
+    for (uint8_t len = 0; len <= sizeof(data); len++) {
+        round_trip(data, len);
+    }
+}
+
+TEST(LogCompress, Incompressible)
+{
+    static uint8_t data[LogCompressor::MAX_BLOCK];
+    srandom(1);
+    for (auto &b : data) {
+        b = random();
+    }
+    // random data is stored rather than expanded
+    EXPECT_EQ(uint32_t(LogCompressor::MAX_ENCODED_BLOCK), round_trip(data, sizeof(data)));
+}
+
+TEST(LogCompress, LogMessages)
+{
+    // a stream of slowly varying IMU-like messages
+    static uint8_t data[LogCompressor::MAX_BLOCK];
+    uint16_t ofs = 0;
+    uint64_t t = 123456789;
+    while (ofs + sizeof(log_TaskLatency) <= sizeof(data)) {
+        struct log_TaskLatency pkt {
+            LOG_PACKET_HEADER_INIT(LOG_TASK_LATENCY_MSG),
+            time_us    : t,
+            id         : uint8_t(ofs % 7),
+            p50        : uint16_t(100 + (ofs % 3)),
+            p99        : 250,
+            p999       : 400,
+            max_jitter : uint16_t(900 + (ofs % 11)),
+            name       : "fast_loop",
+        };
+        memcpy(&data[ofs], &pkt, sizeof(pkt));
+        ofs += sizeof(pkt);
+        t += 2500;
+    }
+    // expect at least 2.5:1
+    const uint32_t enc_len = round_trip(data, ofs);
+    EXPECT_LT(enc_len * 5, uint32_t(ofs) * 2);
+}
+
+TEST(LogCompress, LongRuns)
+{
+    // long literal and match lengths need extension bytes
+    static uint8_t data[LogCompressor::MAX_BLOCK];
+    srandom(2);
+    for (uint16_t i=0; i<sizeof(data); i++) {
+        data[i] = (i / 1000) % 2 ? 0x55 : random();
+    }
+    round_trip(data, sizeof(data));
+}
+
+TEST(LogCompress, CorruptInput)
+{
+    // offsets before the start of the output must be rejected
+    const uint8_t bad_offset[] { 0x10, 'a', 0x05, 0x00 };
+    EXPECT_EQ(-1, LogCompressor::decompress(bad_offset, sizeof(bad_offset), decoded, sizeof(decoded)));
+    // literals past the end of the input
+    const uint8_t bad_literals[] { 0x50, 'a', 'b' };
+    EXPECT_EQ(-1, LogCompressor::decompress(bad_literals, sizeof(bad_literals), decoded, sizeof(decoded)));
+    // output too small
+    const uint8_t literals[] { 0x30, 'a', 'b', 'c' };
+    EXPECT_EQ(-1, LogCompressor::decompress(literals, sizeof(literals), decoded, 2));
+    EXPECT_EQ(3, LogCompressor::decompress(literals, sizeof(literals), decoded, 3));
+}
+
+#endif  // HAL_LOGGER_FILE_COMPRESSION_ENABLED
+
+AP_GTEST_MAIN()
@@ -55,52 +55,8 @@ bool Polygon_outside(const Vector2<T> &P, const Vector2<T> *V, unsigned n)
         if (j >= n) {
             j = 0;
         }
-        if ((V[i].y > P.y) == (V[j].y > P.y)) {
-            continue;
-        }
-        const T dx1 = P.x - V[i].x;
-        const T dx2 = V[j].x - V[i].x;
-        const T dy1 = P.y - V[i].y;
-        const T dy2 = V[j].y - V[i].y;
-        const int8_t dx1s = (dx1 < 0) ? -1 : 1;
-        const int8_t dx2s = (dx2 < 0) ? -1 : 1;
-        const int8_t dy1s = (dy1 < 0) ? -1 : 1;
-        const int8_t dy2s = (dy2 < 0) ? -1 : 1;
-        const int8_t m1 = dx1s * dy2s;
-        const int8_t m2 = dx2s * dy1s;
-        // we avoid the 64 bit multiplies if we can based on sign checks.
-        if (dy2 < 0) {
-            if (m1 > m2) {
-                outside = !outside;
-            } else if (m1 < m2) {
-                continue;
-            } else {
-                if (std::is_floating_point<T>::value) {
-                    if ( dx1 * dy2 > dx2 * dy1 ) {
-                        outside = !outside;
-                    }
-                } else {
-                    if ( dx1 * (int64_t)dy2 > dx2 * (int64_t)dy1 ) {
-                        outside = !outside;
-                    }
-                }
-            }
-        } else {
-            if (m1 < m2) {
-                outside = !outside;
-            } else if (m1 > m2) {
-                continue;
-            } else {
-                if (std::is_floating_point<T>::value) {
-                    if ( dx1 * dy2 < dx2 * dy1 ) {
-                        outside = !outside;
-                    }
-                } else {
-                    if ( dx1 * (int64_t)dy2 < dx2 * (int64_t)dy1 ) {
-                        outside = !outside;
-                    }
-                }
-            }
+        if (Polygon_edge_crosses(P, V[i], V[j])) {
+            outside = !outside;
         }
     }
     return outside;
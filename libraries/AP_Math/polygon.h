@@ -19,6 +19,51 @@
 
 #include "vector2.h"
 
+#include <type_traits>
+
+/*
+  returns true if the edge from V1 to V2 crosses the ray used by
+  Polygon_outside to count crossings from point P
+ */
+template <typename T>
+inline bool Polygon_edge_crosses(const Vector2<T> &P, const Vector2<T> &V1, const Vector2<T> &V2)
+{
+    if ((V1.y > P.y) == (V2.y > P.y)) {
+        return false;
+    }
+    const T dx1 = P.x - V1.x;
+    const T dx2 = V2.x - V1.x;
+    const T dy1 = P.y - V1.y;
+    const T dy2 = V2.y - V1.y;
+    const int8_t dx1s = (dx1 < 0) ? -1 : 1;
+    const int8_t dx2s = (dx2 < 0) ? -1 : 1;
+    const int8_t dy1s = (dy1 < 0) ? -1 : 1;
+    const int8_t dy2s = (dy2 < 0) ? -1 : 1;
+    const int8_t m1 = dx1s * dy2s;
+    const int8_t m2 = dx2s * dy1s;
+    // we avoid the 64 bit multiplies if we can based on sign checks.
+    if (dy2 < 0) {
+        if (m1 > m2) {
+            return true;
+        } else if (m1 < m2) {
+            return false;
+        }
+        if (std::is_floating_point<T>::value) {
+            return dx1 * dy2 > dx2 * dy1;
+        }
+        return dx1 * (int64_t)dy2 > dx2 * (int64_t)dy1;
+    }
+    if (m1 < m2) {
+        return true;
+    } else if (m1 > m2) {
+        return false;
+    }
+    if (std::is_floating_point<T>::value) {
+        return dx1 * dy2 < dx2 * dy1;
+    }
+    return dx1 * (int64_t)dy2 < dx2 * (int64_t)dy1;
+}
+
 template <typename T>
 bool        Polygon_outside(const Vector2<T> &P, const Vector2<T> *V, unsigned n) WARN_IF_UNUSED;
 template <typename T>
@@ -17,10 +17,26 @@
 #pragma once
 
 #include <stdint.h>
+#include <AP_HAL/AP_HAL_Boards.h>
 #include <AP_Math/AP_Math.h>
 #include <AP_Math/vectorN.h>
+#include <AP_NavEKF3/AP_NavEKF3_feature.h>
 #include "AP_Nav_Common.h"
 
+/*
+  the scratch space is per-thread when EKF3 lanes can be run on their
+  own threads
+ */
+#ifndef AP_NAVEKF_SCRATCH_PER_THREAD
+#define AP_NAVEKF_SCRATCH_PER_THREAD (EK3_FEATURE_THREADED_LANES)
+#endif
+
+#if AP_NAVEKF_SCRATCH_PER_THREAD
+#define EKF_SCRATCH_STORAGE thread_local
+#else
+#define EKF_SCRATCH_STORAGE
+#endif
+
 /*
   this declares a common parent class for AP_NavEKF2 and
   AP_NavEKF3. The purpose of this class is to hold common static
@@ -42,10 +58,10 @@ public:
 #endif
 
 protected:
-    static Matrix24 KH;                   // intermediate result used for covariance updates
-    static Matrix24 KHP;                  // intermediate result used for covariance updates
-    static Matrix24 nextP;                // Predicted covariance matrix before addition of process noise to diagonals
-    static Vector28 Kfusion;              // intermediate fusion vector
+    static EKF_SCRATCH_STORAGE Matrix24 KH;      // intermediate result used for covariance updates
+    static EKF_SCRATCH_STORAGE Matrix24 KHP;     // intermediate result used for covariance updates
+    static EKF_SCRATCH_STORAGE Matrix24 nextP;   // Predicted covariance matrix before addition of process noise to diagonals
+    static EKF_SCRATCH_STORAGE Vector28 Kfusion; // intermediate fusion vector
 
     // fill all the common scratch variables with NaN on SITL
     void fill_scratch_variables(void);
@@ -110,6 +110,38 @@ void ekf_ring_buffer::reset()
     oldest = 0;
 }
 
+#if AP_NAVEKF_CHECKPOINT_ENABLED
+void ekf_ring_buffer::checkpoint_save(EKF_Checkpoint &cp) const
+{
+    const uint8_t n = buffer != nullptr ? size : 0;
+    cp.write(&n, sizeof(n));
+    if (n == 0) {
+        return;
+    }
+    cp.write(&oldest, sizeof(oldest));
+    cp.write(&count, sizeof(count));
+    cp.write(buffer, n*uint32_t(elsize));
+}
+
+void ekf_ring_buffer::checkpoint_load(EKF_Checkpoint &cp)
+{
+    uint8_t n;
+    if (!cp.read(&n, sizeof(n))) {
+        return;
+    }
+    if (n != (buffer != nullptr ? size : 0)) {
+        cp.fail();
+        return;
+    }
+    if (n == 0) {
+        return;
+    }
+    cp.read(&oldest, sizeof(oldest));
+    cp.read(&count, sizeof(count));
+    cp.read(buffer, n*uint32_t(elsize));
+}
+#endif  // AP_NAVEKF_CHECKPOINT_ENABLED
+
 ////////////////////////////////////////////////////
 /*
   IMU buffer operations implemented separately due to different
@@ -200,3 +232,37 @@ void *ekf_imu_buffer::get(uint8_t index) const
 {
     return get_offset(index);
 }
+
+#if AP_NAVEKF_CHECKPOINT_ENABLED
+void ekf_imu_buffer::checkpoint_save(EKF_Checkpoint &cp) const
+{
+    const uint8_t n = buffer != nullptr ? _size : 0;
+    cp.write(&n, sizeof(n));
+    if (n == 0) {
+        return;
+    }
+    cp.write(&_oldest, sizeof(_oldest));
+    cp.write(&_youngest, sizeof(_youngest));
+    cp.write(&_filled, sizeof(_filled));
+    cp.write(buffer, n*uint32_t(elsize));
+}
+
+void ekf_imu_buffer::checkpoint_load(EKF_Checkpoint &cp)
+{
+    uint8_t n;
+    if (!cp.read(&n, sizeof(n))) {
+        return;
+    }
+    if (n != (buffer != nullptr ? _size : 0)) {
+        cp.fail();
+        return;
+    }
+    if (n == 0) {
+        return;
+    }
+    cp.read(&_oldest, sizeof(_oldest));
+    cp.read(&_youngest, sizeof(_youngest));
+    cp.read(&_filled, sizeof(_filled));
+    cp.read(buffer, n*uint32_t(elsize));
+}
+#endif  // AP_NAVEKF_CHECKPOINT_ENABLED
@@ -6,6 +6,8 @@
 #include <stdint.h>
 #include <type_traits>
 
+#include "EKF_Checkpoint.h"
+
 typedef struct {
     // measurement timestamp (msec)
     uint32_t    time_ms;
@@ -39,6 +41,13 @@ public:
     // zeroes all data in the ring buffer
     void reset();
 
+#if AP_NAVEKF_CHECKPOINT_ENABLED
+    // save or restore the indices and contents. A buffer can only be
+    // restored into one initialised with the same size
+    void checkpoint_save(EKF_Checkpoint &cp) const;
+    void checkpoint_load(EKF_Checkpoint &cp);
+#endif
+
 private:
     const uint8_t elsize;
     void *buffer;
@@ -86,6 +95,15 @@ public:
     void reset() {
         return ekf_ring_buffer::reset();
     }
+
+#if AP_NAVEKF_CHECKPOINT_ENABLED
+    void checkpoint_save(EKF_Checkpoint &cp) const {
+        ekf_ring_buffer::checkpoint_save(cp);
+    }
+    void checkpoint_load(EKF_Checkpoint &cp) {
+        ekf_ring_buffer::checkpoint_load(cp);
+    }
+#endif
 };
 
 
@@ -133,6 +151,13 @@ public:
         return _youngest;
     }
 
+#if AP_NAVEKF_CHECKPOINT_ENABLED
+    // save or restore the indices and contents. A buffer can only be
+    // restored into one initialised with the same size
+    void checkpoint_save(EKF_Checkpoint &cp) const;
+    void checkpoint_load(EKF_Checkpoint &cp);
+#endif
+
 protected:
     const uint8_t elsize;
     void *buffer;
@@ -202,4 +227,13 @@ public:
     inline uint8_t get_youngest_index() {
         return ekf_imu_buffer::get_youngest_index();
     }
+
+#if AP_NAVEKF_CHECKPOINT_ENABLED
+    void checkpoint_save(EKF_Checkpoint &cp) const {
+        ekf_imu_buffer::checkpoint_save(cp);
+    }
+    void checkpoint_load(EKF_Checkpoint &cp) {
+        ekf_imu_buffer::checkpoint_load(cp);
+    }
+#endif
 };
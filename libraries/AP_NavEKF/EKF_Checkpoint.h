@@ -0,0 +1,102 @@
+/*
+  serialisation of EKF state into checkpoints, allowing Replay to
+  resume a replay part way through a log
+
+  This program is free software: you can redistribute it and/or modify
+  it under the terms of the GNU General Public License as published by
+  the Free Software Foundation, either version 3 of the License, or
+  (at your option) any later version.
+
+  This program is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+  GNU General Public License for more details.
+
+  You should have received a copy of the GNU General Public License
+  along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+#pragma once
+
+#include <stdint.h>
+#include <string.h>
+#include <AP_Vehicle/AP_Vehicle_Type.h>
+
+#ifndef AP_NAVEKF_CHECKPOINT_ENABLED
+#define AP_NAVEKF_CHECKPOINT_ENABLED APM_BUILD_TYPE(APM_BUILD_Replay)
+#endif
+
+#if AP_NAVEKF_CHECKPOINT_ENABLED
+
+/*
+  a checkpoint is the raw memory of the EKF objects, so is only valid
+  for the build which wrote it. The same class measures the length of
+  a checkpoint (no buffer), writes one or reads one back
+ */
+class EKF_Checkpoint
+{
+public:
+    // measure the length of a checkpoint
+    EKF_Checkpoint() {}
+
+    // write a checkpoint into buf
+    EKF_Checkpoint(uint8_t *buf, uint32_t len) :
+        wbuf(buf),
+        buflen(len)
+        {}
+
+    // read a checkpoint from buf
+    EKF_Checkpoint(const uint8_t *buf, uint32_t len) :
+        rbuf(buf),
+        buflen(len)
+        {}
+
+    void write(const void *data, uint32_t n) {
+        if (wbuf != nullptr) {
+            if (ofs + n > buflen) {
+                failed = true;
+                return;
+            }
+            memcpy(&wbuf[ofs], data, n);
+        }
+        ofs += n;
+    }
+
+    bool read(void *data, uint32_t n) {
+        const uint8_t *p = read_ptr(n);
+        if (p == nullptr) {
+            return false;
+        }
+        memcpy(data, p, n);
+        return true;
+    }
+
+    // return the next n bytes to read and skip over them, or
+    // nullptr if there aren't that many left
+    const uint8_t *read_ptr(uint32_t n) {
+        if (rbuf == nullptr || ofs + n > buflen) {
+            failed = true;
+            return nullptr;
+        }
+        const uint8_t *ret = &rbuf[ofs];
+        ofs += n;
+        return ret;
+    }
+
+    // fail a checkpoint which doesn't match the EKF being restored
+    void fail() { failed = true; }
+
+    // bytes written, read or measured so far
+    uint32_t length() const { return ofs; }
+
+    // true if nothing has failed so far
+    bool ok() const { return !failed; }
+
+private:
+    uint8_t *wbuf = nullptr;
+    const uint8_t *rbuf = nullptr;
+    uint32_t buflen = 0;
+    uint32_t ofs = 0;
+    bool failed = false;
+};
+
+#endif  // AP_NAVEKF_CHECKPOINT_ENABLED
@@ -0,0 +1,151 @@
+/*
+  matrix kernels used by the EKF covariance update
+
+  This program is free software: you can redistribute it and/or modify
+  it under the terms of the GNU General Public License as published by
+  the Free Software Foundation, either version 3 of the License, or
+  (at your option) any later version.
+
+  This program is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+  GNU General Public License for more details.
+
+  You should have received a copy of the GNU General Public License
+  along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+#include "EKF_Kernels.h"
+
+#include <string.h>
+
+/*
+  don't let the compiler fuse multiply-adds (as it does by default on
+  targets with FMA, such as aarch64) so the scalar and vectorised
+  kernels round identically everywhere
+ */
+#ifdef __clang__
+#pragma clang fp contract(off)
+#else
+#pragma GCC optimize("fp-contract=off")
+#endif
+
+using namespace EKF_Kernels;
+
+void EKF_Kernels::sparse_product_scalar(ftype *KHP, const ftype *KH, const ftype *P, const uint8_t *cols, uint8_t ncols, uint8_t n)
+{
+    for (uint8_t i = 0; i<=n; i++) {
+        const ftype *kh = &KH[i*STRIDE];
+        for (uint8_t j = 0; j<=n; j++) {
+            ftype res = 0;
+            for (uint8_t k = 0; k<ncols; k++) {
+                res += kh[cols[k]] * P[cols[k]*STRIDE + j];
+            }
+            KHP[i*STRIDE + j] = res;
+        }
+    }
+}
+
+void EKF_Kernels::outer_product_scalar(ftype *KHP, const ftype *K, const ftype *row, uint8_t n)
+{
+    for (uint8_t i = 0; i<=n; i++) {
+        for (uint8_t j = 0; j<=n; j++) {
+            KHP[i*STRIDE + j] = K[i] * row[j];
+        }
+    }
+}
+
+void EKF_Kernels::subtract_scalar(ftype *P, const ftype *KHP, uint8_t n)
+{
+    for (uint8_t i = 0; i<=n; i++) {
+        for (uint8_t j = 0; j<=n; j++) {
+            P[i*STRIDE + j] = P[i*STRIDE + j] - KHP[i*STRIDE + j];
+        }
+    }
+}
+
+#if AP_NAVEKF_SIMD_KERNELS_ENABLED
+
+/*
+  use 256 bit vectors when AVX is available, otherwise 128 bit
+  SSE2/NEON vectors. The row stride of 24 is a multiple of the lane
+  count for both float and double, but the active block may not be,
+  so the last columns of each row are done with scalar code
+ */
+#if defined(__AVX__)
+typedef ftype vec_t __attribute__((vector_size(32)));
+#else
+typedef ftype vec_t __attribute__((vector_size(16)));
+#endif
+
+static constexpr uint8_t LANES = sizeof(vec_t) / sizeof(ftype);
+
+// matrix rows are not guaranteed to be vector aligned
+static inline vec_t load(const ftype *p)
+{
+    vec_t v;
+    memcpy(&v, p, sizeof(v));
+    return v;
+}
+
+static inline void store(ftype *p, const vec_t &v)
+{
+    memcpy(p, &v, sizeof(v));
+}
+
+void EKF_Kernels::sparse_product_simd(ftype *KHP, const ftype *KH, const ftype *P, const uint8_t *cols, uint8_t ncols, uint8_t n)
+{
+    const uint8_t len = n + 1;
+    for (uint8_t i = 0; i<len; i++) {
+        const ftype *kh = &KH[i*STRIDE];
+        ftype *out = &KHP[i*STRIDE];
+        uint8_t j = 0;
+        for (; j+LANES <= len; j += LANES) {
+            vec_t res = {};
+            for (uint8_t k = 0; k<ncols; k++) {
+                res += kh[cols[k]] * load(&P[cols[k]*STRIDE + j]);
+            }
+            store(&out[j], res);
+        }
+        for (; j<len; j++) {
+            ftype res = 0;
+            for (uint8_t k = 0; k<ncols; k++) {
+                res += kh[cols[k]] * P[cols[k]*STRIDE + j];
+            }
+            out[j] = res;
+        }
+    }
+}
+
+void EKF_Kernels::outer_product_simd(ftype *KHP, const ftype *K, const ftype *row, uint8_t n)
+{
+    const uint8_t len = n + 1;
+    for (uint8_t i = 0; i<len; i++) {
+        const ftype k = K[i];
+        ftype *out = &KHP[i*STRIDE];
+        uint8_t j = 0;
+        for (; j+LANES <= len; j += LANES) {
+            store(&out[j], k * load(&row[j]));
+        }
+        for (; j<len; j++) {
+            out[j] = k * row[j];
+        }
+    }
+}
+
+void EKF_Kernels::subtract_simd(ftype *P, const ftype *KHP, uint8_t n)
+{
+    const uint8_t len = n + 1;
+    for (uint8_t i = 0; i<len; i++) {
+        ftype *p = &P[i*STRIDE];
+        const ftype *khp = &KHP[i*STRIDE];
+        uint8_t j = 0;
+        for (; j+LANES <= len; j += LANES) {
+            store(&p[j], load(&p[j]) - load(&khp[j]));
+        }
+        for (; j<len; j++) {
+            p[j] = p[j] - khp[j];
+        }
+    }
+}
+
+#endif  // AP_NAVEKF_SIMD_KERNELS_ENABLED
@@ -0,0 +1,91 @@
+/*
+  matrix kernels used by the EKF covariance update
+
+  This program is free software: you can redistribute it and/or modify
+  it under the terms of the GNU General Public License as published by
+  the Free Software Foundation, either version 3 of the License, or
+  (at your option) any later version.
+
+  This program is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+  GNU General Public License for more details.
+
+  You should have received a copy of the GNU General Public License
+  along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+#pragma once
+
+#include <AP_HAL/AP_HAL_Boards.h>
+#include <AP_Math/AP_Math.h>
+#include <stdint.h>
+
+/*
+  vectorised kernels are only built for SITL and Linux, where the
+  compiler targets SSE2/AVX on x86 or NEON on ARM. They use the
+  compiler's generic vector types, so the same code is used for float
+  and double EKF builds
+ */
+#ifndef AP_NAVEKF_SIMD_KERNELS_ENABLED
+#if (CONFIG_HAL_BOARD == HAL_BOARD_SITL || CONFIG_HAL_BOARD == HAL_BOARD_LINUX) && (defined(__SSE2__) || defined(__ARM_NEON))
+#define AP_NAVEKF_SIMD_KERNELS_ENABLED 1
+#else
+#define AP_NAVEKF_SIMD_KERNELS_ENABLED 0
+#endif
+#endif
+
+/*
+  All kernels operate on the top left (n+1)x(n+1) block of row-major
+  24x24 matrices, matching the EKF Matrix24 layout. Each output element
+  is accumulated in the same order as the scalar code, and the kernels
+  are built without contracting multiply-adds into FMA, so the
+  vectorised versions give identical results on every target
+ */
+namespace EKF_Kernels {
+
+static constexpr uint8_t STRIDE = 24;
+
+// KHP = KH * P, where only the columns of KH listed in cols are non-zero
+void sparse_product_scalar(ftype *KHP, const ftype *KH, const ftype *P, const uint8_t *cols, uint8_t ncols, uint8_t n);
+
+// KHP[i][j] = K[i] * row[j], used when observing a single state directly
+void outer_product_scalar(ftype *KHP, const ftype *K, const ftype *row, uint8_t n);
+
+// P = P - KHP
+void subtract_scalar(ftype *P, const ftype *KHP, uint8_t n);
+
+#if AP_NAVEKF_SIMD_KERNELS_ENABLED
+void sparse_product_simd(ftype *KHP, const ftype *KH, const ftype *P, const uint8_t *cols, uint8_t ncols, uint8_t n);
+void outer_product_simd(ftype *KHP, const ftype *K, const ftype *row, uint8_t n);
+void subtract_simd(ftype *P, const ftype *KHP, uint8_t n);
+#endif
+
+// kernels selected at compile time
+inline void sparse_product(ftype *KHP, const ftype *KH, const ftype *P, const uint8_t *cols, uint8_t ncols, uint8_t n)
+{
+#if AP_NAVEKF_SIMD_KERNELS_ENABLED
+    sparse_product_simd(KHP, KH, P, cols, ncols, n);
+#else
+    sparse_product_scalar(KHP, KH, P, cols, ncols, n);
+#endif
+}
+
+inline void outer_product(ftype *KHP, const ftype *K, const ftype *row, uint8_t n)
+{
+#if AP_NAVEKF_SIMD_KERNELS_ENABLED
+    outer_product_simd(KHP, K, row, n);
+#else
+    outer_product_scalar(KHP, K, row, n);
+#endif
+}
+
+inline void subtract(ftype *P, const ftype *KHP, uint8_t n)
+{
+#if AP_NAVEKF_SIMD_KERNELS_ENABLED
+    subtract_simd(P, KHP, n);
+#else
+    subtract_scalar(P, KHP, n);
+#endif
+}
+
+}
@@ -0,0 +1,118 @@
+/*
+   This program is free software: you can redistribute it and/or modify
+   it under the terms of the GNU General Public License as published by
+   the Free Software Foundation, either version 3 of the License, or
+   (at your option) any later version.
+
+   This program is distributed in the hope that it will be useful,
+   but WITHOUT ANY WARRANTY; without even the implied warranty of
+   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+   GNU General Public License for more details.
+
+   You should have received a copy of the GNU General Public License
+   along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+/*
+  EKF covariance update kernels, scalar against vectorised. The
+  argument is the last active state index, 23 for a full EKF3 and 21
+  with the wind states inhibited
+ */
+#include <AP_gbenchmark.h>
+
+#include <AP_NavEKF/EKF_Kernels.h>
+
+const AP_HAL::HAL& hal = AP_HAL::get_HAL();
+
+using namespace EKF_Kernels;
+
+typedef void (*sparse_product_fn)(ftype *, const ftype *, const ftype *, const uint8_t *, uint8_t, uint8_t);
+typedef void (*outer_product_fn)(ftype *, const ftype *, const ftype *, uint8_t);
+typedef void (*subtract_fn)(ftype *, const ftype *, uint8_t);
+
+static ftype KH[STRIDE][STRIDE], KHP[STRIDE][STRIDE], P[STRIDE][STRIDE], K[STRIDE];
+
+static void fill_inputs()
+{
+    for (uint8_t i=0; i<STRIDE; i++) {
+        K[i] = 0.01 * i;
+        for (uint8_t j=0; j<STRIDE; j++) {
+            KH[i][j] = 0.001 * (i + j);
+            P[i][j] = i == j ? 1.0 : 0.01;
+        }
+    }
+}
+
+// magnetometer fusion, ten active columns in KH
+static void sparse_product_bench(benchmark::State& state, sparse_product_fn fn)
+{
+    fill_inputs();
+    static const uint8_t cols[] { 0, 1, 2, 3, 16, 17, 18, 19, 20, 21 };
+    const uint8_t n = state.range(0);
+    while (state.KeepRunning()) {
+        fn(&KHP[0][0], &KH[0][0], &P[0][0], cols, ARRAY_SIZE(cols), n);
+        gbenchmark_escape(KHP);
+    }
+}
+
+// direct observation of a single state, as in position and velocity fusion
+static void outer_product_bench(benchmark::State& state, outer_product_fn fn)
+{
+    fill_inputs();
+    const uint8_t n = state.range(0);
+    while (state.KeepRunning()) {
+        fn(&KHP[0][0], K, &P[4][0], n);
+        gbenchmark_escape(KHP);
+    }
+}
+
+static void subtract_bench(benchmark::State& state, subtract_fn fn)
+{
+    fill_inputs();
+    const uint8_t n = state.range(0);
+    while (state.KeepRunning()) {
+        fn(&P[0][0], &KH[0][0], n);
+        gbenchmark_escape(P);
+    }
+}
+
+static void BM_SparseProductScalar(benchmark::State& state)
+{
+    sparse_product_bench(state, sparse_product_scalar);
+}
+
+static void BM_OuterProductScalar(benchmark::State& state)
+{
+    outer_product_bench(state, outer_product_scalar);
+}
+
+static void BM_SubtractScalar(benchmark::State& state)
+{
+    subtract_bench(state, subtract_scalar);
+}
+
+BENCHMARK(BM_SparseProductScalar)->Arg(21)->Arg(23);
+BENCHMARK(BM_OuterProductScalar)->Arg(21)->Arg(23);
+BENCHMARK(BM_SubtractScalar)->Arg(21)->Arg(23);
+
+#if AP_NAVEKF_SIMD_KERNELS_ENABLED
+static void BM_SparseProductSIMD(benchmark::State& state)
+{
+    sparse_product_bench(state, sparse_product_simd);
+}
+
+static void BM_OuterProductSIMD(benchmark::State& state)
+{
+    outer_product_bench(state, outer_product_simd);
+}
+
+static void BM_SubtractSIMD(benchmark::State& state)
+{
+    subtract_bench(state, subtract_simd);
+}
+
+BENCHMARK(BM_SparseProductSIMD)->Arg(21)->Arg(23);
+BENCHMARK(BM_OuterProductSIMD)->Arg(21)->Arg(23);
+BENCHMARK(BM_SubtractSIMD)->Arg(21)->Arg(23);
+#endif
+
+BENCHMARK_MAIN();
@@ -0,0 +1,77 @@
+#include <AP_gtest.h>
+
+/*
+  tests for AP_NavEKF/EKF_Kernels.cpp
+ */
+
+#include <AP_NavEKF/EKF_Kernels.h>
+#include <string.h>
+
+#include <AP_HAL/AP_HAL.h>
+const AP_HAL::HAL& hal = AP_HAL::get_HAL();
+
+#if AP_NAVEKF_SIMD_KERNELS_ENABLED
+
+using namespace EKF_Kernels;
+
+#define MAT_SIZE (STRIDE*STRIDE)
+
+static ftype KH[MAT_SIZE], P[MAT_SIZE], K[STRIDE];
+static ftype out_scalar[MAT_SIZE], out_simd[MAT_SIZE];
+
+static void fill_inputs()
+{
+    for (uint16_t i=0; i<MAT_SIZE; i++) {
+        KH[i] = linear_interpolate(-1, 1, get_random16(), 0, UINT16_MAX);
+        P[i] = linear_interpolate(0, 10, get_random16(), 0, UINT16_MAX);
+    }
+    for (uint8_t i=0; i<STRIDE; i++) {
+        K[i] = linear_interpolate(-1, 1, get_random16(), 0, UINT16_MAX);
+    }
+}
+
+/*
+  the vectorised kernels must give the same results as the scalar
+  code for every block size, including ones that are not a multiple
+  of the vector length, and must not touch anything outside the block
+ */
+TEST(EKF_Kernels, SparseProduct)
+{
+    fill_inputs();
+    const uint8_t cols[] { 0, 1, 2, 3, 16, 17, 18, 19, 20, 21 };
+    for (uint8_t n=0; n<STRIDE; n++) {
+        memset(out_scalar, 0, sizeof(out_scalar));
+        memset(out_simd, 0, sizeof(out_simd));
+        sparse_product_scalar(out_scalar, KH, P, cols, ARRAY_SIZE(cols), n);
+        sparse_product_simd(out_simd, KH, P, cols, ARRAY_SIZE(cols), n);
+        EXPECT_EQ(memcmp(out_scalar, out_simd, sizeof(out_scalar)), 0) << "n=" << unsigned(n);
+    }
+}
+
+TEST(EKF_Kernels, OuterProduct)
+{
+    fill_inputs();
+    for (uint8_t n=0; n<STRIDE; n++) {
+        memset(out_scalar, 0, sizeof(out_scalar));
+        memset(out_simd, 0, sizeof(out_simd));
+        outer_product_scalar(out_scalar, K, &P[7*STRIDE], n);
+        outer_product_simd(out_simd, K, &P[7*STRIDE], n);
+        EXPECT_EQ(memcmp(out_scalar, out_simd, sizeof(out_scalar)), 0) << "n=" << unsigned(n);
+    }
+}
+
+TEST(EKF_Kernels, Subtract)
+{
+    fill_inputs();
+    for (uint8_t n=0; n<STRIDE; n++) {
+        memcpy(out_scalar, P, sizeof(out_scalar));
+        memcpy(out_simd, P, sizeof(out_simd));
+        subtract_scalar(out_scalar, KH, n);
+        subtract_simd(out_simd, KH, n);
+        EXPECT_EQ(memcmp(out_scalar, out_simd, sizeof(out_scalar)), 0) << "n=" << unsigned(n);
+    }
+}
+
+#endif // AP_NAVEKF_SIMD_KERNELS_ENABLED
+
+AP_GTEST_MAIN()
@@ -1,6 +1,7 @@
 #include "AP_NavEKF3_core.h"
 
 #include "AP_NavEKF3.h"
+#include "AP_NavEKF3_LaneWorker.h"
 
 #include <AP_HAL/AP_HAL.h>
 
@@ -739,8 +740,8 @@ const AP_Param::GroupInfo NavEKF3::var_info2[] = {
 
     // @Param: OPTIONS
     // @DisplayName: Optional EKF behaviour
-    // @Description: EKF optional behaviour. Bit 0 (JammingExpected): Setting JammingExpected will change the EKF behaviour such that if dead reckoning navigation is possible it will require the preflight alignment GPS quality checks controlled by EK3_GPS_CHECK and EK3_CHECK_SCALE to pass before resuming GPS use if GPS lock is lost for more than 2 seconds to prevent bad position estimate. Bit 1 (Manual lane switching): DANGEROUS – If enabled, this disables automatic lane switching. If the active lane becomes unhealthy, no automatic switching will occur. Users must manually set EK3_PRIMARY to change lanes. No health checks will be performed on the selected lane. Use with extreme caution.
-    // @Bitmask: 0:JammingExpected, 1: ManualLaneSwitching
+    // @Description: EKF optional behaviour. Bit 0 (JammingExpected): Setting JammingExpected will change the EKF behaviour such that if dead reckoning navigation is possible it will require the preflight alignment GPS quality checks controlled by EK3_GPS_CHECK and EK3_CHECK_SCALE to pass before resuming GPS use if GPS lock is lost for more than 2 seconds to prevent bad position estimate. Bit 1 (Manual lane switching): DANGEROUS – If enabled, this disables automatic lane switching. If the active lane becomes unhealthy, no automatic switching will occur. Users must manually set EK3_PRIMARY to change lanes. No health checks will be performed on the selected lane. Use with extreme caution. Bit 2 (SparseCovPrediction): skips the covariance prediction for the magnetic field and wind states while they are uncorrelated with the other states, for example when magnetic field learning has been inhibited since startup. This reduces the CPU load per IMU sample without changing the results. Bit 3 (ThreadedLanes): on Linux boards, runs each lane after the first on its own worker thread pinned to a CPU, with all lanes completing before lane selection. Results do not depend on thread timing. Requires a reboot to take effect.
+    // @Bitmask: 0:JammingExpected, 1: ManualLaneSwitching, 2:SparseCovPrediction, 3:ThreadedLanes
     // @User: Advanced
     AP_GROUPINFO("OPTIONS",  11, NavEKF3, _options, 0),
 
@@ -831,6 +832,12 @@ bool NavEKF3::InitialiseFilter(void)
         for (uint8_t i = 0; i < num_cores; i++) {
             new (&core[i]) NavEKF3_core(this, dal);
         }
+
+#if EK3_FEATURE_THREADED_LANES
+        if (option_is_enabled(Option::ThreadedLanes)) {
+            start_lane_workers();
+        }
+#endif
     }
 
     // Set up any cores that have been created
@@ -877,6 +884,30 @@ bool NavEKF3::InitialiseFilter(void)
     return ret;
 }
 
+#if EK3_FEATURE_THREADED_LANES
+/*
+  start a worker thread for each lane after the first. If a thread
+  can't be created the remaining lanes run in the main thread
+ */
+void NavEKF3::start_lane_workers(void)
+{
+    for (uint8_t i=1; i<num_cores; i++) {
+        NavEKF3_LaneWorker *worker = NEW_NOTHROW NavEKF3_LaneWorker(core[i], i);
+        if (worker == nullptr) {
+            break;
+        }
+        if (!worker->start_thread()) {
+            delete worker;
+            break;
+        }
+        lane_workers[num_lane_workers++] = worker;
+    }
+    if (num_lane_workers > 0) {
+        GCS_SEND_TEXT(MAV_SEVERITY_INFO, "EKF3 running %u lanes on worker threads", unsigned(num_lane_workers));
+    }
+}
+#endif  // EK3_FEATURE_THREADED_LANES
+
 /*
   return true if a new core index has a better score than the current
   core
@@ -917,24 +948,43 @@ void NavEKF3::UpdateFilter(void)
 
     imuSampleTime_us = dal.micros64();
 
-    for (uint8_t i=0; i<num_cores; i++) {
-        // if we have not overrun by more than 3 IMU frames, and we
-        // have already used more than 1/3 of the CPU budget for this
-        // loop then suppress the prediction step. This allows
-        // multiple EKF instances to cooperate on scheduling
-        bool allow_state_prediction = true;
-        if (core[i].getFramesSincePredict() < (_framesPerPrediction+3) &&
-            dal.ekf_low_time_remaining(AP_DAL::EKFType::EKF3, i)) {
-            allow_state_prediction = false;
+    uint8_t first_main_lane = 0;
+#if EK3_FEATURE_THREADED_LANES
+    // start the lanes that have their own thread first, then run the
+    // rest in this thread while they are running
+    if (num_lane_workers > 0) {
+        lanes_running = true;
+        for (uint8_t i=0; i<num_lane_workers; i++) {
+            lane_workers[i]->update(allow_state_prediction(i+1));
         }
-        core[i].UpdateFilter(allow_state_prediction);
+        first_main_lane = num_lane_workers + 1;
+        core[0].UpdateFilter(allow_state_prediction(0));
     }
+#endif
+    for (uint8_t i=first_main_lane; i<num_cores; i++) {
+        core[i].UpdateFilter(allow_state_prediction(i));
+    }
+#if EK3_FEATURE_THREADED_LANES
+    if (num_lane_workers > 0) {
+        // all lanes must have finished before we look at their
+        // health for lane selection
+        for (uint8_t i=0; i<num_lane_workers; i++) {
+            lane_workers[i]->wait();
+        }
+        lanes_running = false;
+        // publish any origin, messages and takeoff detection from
+        // while the lanes were running, in lane order so the result
+        // doesn't depend on thread timing
+        for (uint8_t i=0; i<num_cores; i++) {
+            core[i].publishPendingOutputs();
+        }
+    }
+#endif
 
     // If the current core selected has a bad error score or is unhealthy, switch to a healthy core with the lowest fault score
     // Don't start running the check until the primary core has started returned healthy for at least 10 seconds to avoid switching
     // due to initial alignment fluctuations and race conditions
     if (!runCoreSelection) {
-        static uint64_t lastUnhealthyTime_us = 0;
         if (!core[primary].healthy() || lastUnhealthyTime_us == 0) {
             lastUnhealthyTime_us = imuSampleTime_us;
         }
@@ -1020,6 +1070,18 @@ void NavEKF3::UpdateFilter(void)
     sources.align_inactive_sources();
 }
 
+/*
+  if we have not overrun by more than 3 IMU frames, and we have
+  already used more than 1/3 of the CPU budget for this loop then
+  suppress the prediction step. This allows multiple EKF instances to
+  cooperate on scheduling
+ */
+bool NavEKF3::allow_state_prediction(uint8_t i)
+{
+    return !(core[i].getFramesSincePredict() < (_framesPerPrediction+3) &&
+             dal.ekf_low_time_remaining(AP_DAL::EKFType::EKF3, i));
+}
+
 /*
   check if switching lanes will reduce the normalised
   innovations. This is called when the vehicle code is about to
@@ -1030,7 +1092,7 @@ void NavEKF3::checkLaneSwitch(void)
 {
     dal.log_event3(AP_DAL::Event::checkLaneSwitch);
 
-    if (option_is_enabled(Option::ManualLaneSwitch)) {
+    if (!core || option_is_enabled(Option::ManualLaneSwitch)) {
         return;
     }
 
@@ -24,12 +24,16 @@
 #include <AP_Param/AP_Param.h>
 #include <AP_NavEKF/AP_Nav_Common.h>
 #include <AP_NavEKF/AP_NavEKF_Source.h>
+#include <AP_NavEKF/EKF_Checkpoint.h>
+#include "AP_NavEKF3_feature.h"
 
 class NavEKF3_core;
+class NavEKF3_LaneWorker;
 class EKFGSF_yaw;
 
 class NavEKF3 {
     friend class NavEKF3_core;
+    friend class NavEKF3_test;
 
 public:
     NavEKF3();
@@ -368,6 +372,15 @@ public:
     // get a yaw estimator instance
     const EKFGSF_yaw *get_yawEstimator(void) const;
 
+#if AP_NAVEKF_CHECKPOINT_ENABLED
+    // save the state of the filter to a checkpoint, or restore it
+    // from one. The filter must have been initialised with the same
+    // parameters as the one which was saved before restoring, and
+    // false is returned if the checkpoint doesn't match it
+    void checkpoint_save(EKF_Checkpoint &cp) const;
+    bool checkpoint_load(EKF_Checkpoint &cp);
+#endif
+
 private:
     class AP_DAL &dal;
 
@@ -459,6 +472,8 @@ private:
     enum class Option {
         JammingExpected     = (1<<0),
         ManualLaneSwitch   = (1<<1),
+        SparseCovPrediction = (1<<2),
+        ThreadedLanes       = (1<<3),
     };
     bool option_is_enabled(Option option) const {
         return (_options & (uint32_t)option) != 0;
@@ -538,6 +553,7 @@ private:
 #define BETTER_THRESH   0.5 // a lane should have this much relative error difference to be considered for overriding a healthy primary core
     
     bool runCoreSelection;                          // true when the primary core has stabilised and the core selection logic can be started
+    uint64_t lastUnhealthyTime_us;                  // last time the primary core was unhealthy before core selection started
     bool coreSetupRequired[MAX_EKF_CORES];          // true when this core index needs to be setup
     uint8_t coreImuIndex[MAX_EKF_CORES];            // IMU index used by this core
     float coreRelativeErrors[MAX_EKF_CORES];        // relative errors of cores with respect to primary
@@ -547,6 +563,18 @@ private:
     // origin set by one of the cores
     Location common_EKF_origin;
     bool common_origin_valid;
+
+#if EK3_FEATURE_THREADED_LANES
+    // workers running the lanes after the first on their own threads
+    NavEKF3_LaneWorker *lane_workers[MAX_EKF_CORES-1];
+    uint8_t num_lane_workers;
+
+    // true while lanes are being updated concurrently
+    bool lanes_running;
+
+    // start worker threads for the lanes after the first
+    void start_lane_workers(void);
+#endif
     
     // update the yaw reset data to capture changes due to a lane switch
     // new_primary - index of the ekf instance that we are about to switch to as the primary
@@ -563,6 +591,9 @@ private:
     // old_primary - index of the ekf instance that we are currently using as the primary
     void updateLaneSwitchPosDownResetData(uint8_t new_primary, uint8_t old_primary);
 
+    // return false if the prediction step of a core should be skipped this frame
+    bool allow_state_prediction(uint8_t i);
+
     // Update instance error scores for all available cores 
     float updateCoreErrorScores(void);
 
@@ -578,4 +609,10 @@ private:
 
     // position, velocity and yaw source control
     AP_NavEKF_Source sources;
+
+#if AP_NAVEKF_CHECKPOINT_ENABLED
+    // call f(ptr, len) for each member which changes as the filter runs
+    template <typename EKF, typename F>
+    static void checkpoint_fields(EKF &ekf, F f);
+#endif
 };
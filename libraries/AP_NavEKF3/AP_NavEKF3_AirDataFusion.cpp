@@ -166,22 +166,9 @@ void NavEKF3_core::FuseAirspeed()
                     KH[i][j] = Kfusion[i] * H_TAS[j];
                 }
             }
-            for (unsigned j = 0; j<=stateIndexLim; j++) {
-                for (unsigned i = 0; i<=stateIndexLim; i++) {
-                    ftype res = 0;
-                    res += KH[i][4] * P[4][j];
-                    res += KH[i][5] * P[5][j];
-                    res += KH[i][6] * P[6][j];
-                    res += KH[i][22] * P[22][j];
-                    res += KH[i][23] * P[23][j];
-                    KHP[i][j] = res;
-                }
-            }
-            for (unsigned i = 0; i<=stateIndexLim; i++) {
-                for (unsigned j = 0; j<=stateIndexLim; j++) {
-                    P[i][j] = P[i][j] - KHP[i][j];
-                }
-            }
+            static const uint8_t KH_cols[] { 4, 5, 6, 22, 23 };
+            EKF_Kernels::sparse_product(&KHP[0][0], &KH[0][0], &P[0][0], KH_cols, ARRAY_SIZE(KH_cols), stateIndexLim);
+            EKF_Kernels::subtract(&P[0][0], &KHP[0][0], stateIndexLim);
         }
         // force the covariance matrix to be symmetrical and limit the variances to prevent ill-conditioning.
         ForceSymmetry();
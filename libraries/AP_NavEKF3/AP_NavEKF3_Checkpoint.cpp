@@ -0,0 +1,302 @@
+/*
+  This program is free software: you can redistribute it and/or modify
+  it under the terms of the GNU General Public License as published by
+  the Free Software Foundation, either version 3 of the License, or
+  (at your option) any later version.
+
+  This program is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+  GNU General Public License for more details.
+
+  You should have received a copy of the GNU General Public License
+  along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+/*
+  EKF3 checkpoints, used by Replay to resume a replay part way through
+  a log with the filter in exactly the state it had when the
+  checkpoint was saved.
+
+  The frontend saves the members which change as the filter runs. A
+  core is saved as an image of its memory, followed by the contents
+  of its data buffers and yaw estimator. When an image is restored
+  the members which point into the process (the buffers, yaw
+  estimator, DAL, frontend and public origin) keep the values they
+  were given when the core was set up
+ */
+#include "AP_NavEKF3.h"
+
+#if AP_NAVEKF_CHECKPOINT_ENABLED
+
+#include "AP_NavEKF3_core.h"
+
+namespace {
+
+// save or restore each buffer of a core
+struct BufferSaver {
+    EKF_Checkpoint &cp;
+    template <typename T>
+    void operator()(const T &buf) { buf.checkpoint_save(cp); }
+};
+
+struct BufferLoader {
+    EKF_Checkpoint &cp;
+    template <typename T>
+    void operator()(T &buf) { buf.checkpoint_load(cp); }
+};
+
+// round an offset up to a multiple of align
+constexpr size_t align_up(size_t ofs, size_t align)
+{
+    return (ofs + align - 1) / align * align;
+}
+
+// offset of the end of a reference member declared at ofs
+constexpr size_t end_of_reference(size_t ofs)
+{
+    return align_up(ofs, alignof(void *)) + sizeof(void *);
+}
+
+/*
+  byte ranges of a core which are kept when an image is restored
+ */
+class KeptRanges {
+public:
+    KeptRanges(const void *_base) :
+        base((const uint8_t *)_base)
+        {}
+
+    void add(const void *start, const void *end) {
+        if (count < ARRAY_SIZE(ranges)) {
+            ranges[count].ofs = (const uint8_t *)start - base;
+            ranges[count].len = (const uint8_t *)end - (const uint8_t *)start;
+        }
+        count++;
+    }
+    template <typename T>
+    void operator()(const T &buf) { add(&buf, &buf + 1); }
+
+    // copy the image over the object, keeping the ranges
+    bool restore(uint8_t *object, const uint8_t *image, uint32_t len) const {
+        if (count > ARRAY_SIZE(ranges)) {
+            return false;
+        }
+        uint32_t total = 0;
+        for (uint8_t i=0; i<count; i++) {
+            total += ranges[i].len;
+        }
+        uint8_t *kept = NEW_NOTHROW uint8_t[total];
+        if (kept == nullptr) {
+            return false;
+        }
+        uint32_t ofs = 0;
+        for (uint8_t i=0; i<count; i++) {
+            memcpy(&kept[ofs], &object[ranges[i].ofs], ranges[i].len);
+            ofs += ranges[i].len;
+        }
+        memcpy(object, image, len);
+        ofs = 0;
+        for (uint8_t i=0; i<count; i++) {
+            memcpy(&object[ranges[i].ofs], &kept[ofs], ranges[i].len);
+            ofs += ranges[i].len;
+        }
+        delete[] kept;
+        return true;
+    }
+
+private:
+    const uint8_t *base;
+    struct {
+        uint32_t ofs;
+        uint32_t len;
+    } ranges[24];
+    uint8_t count = 0;
+};
+
+}
+
+/*
+  call f(ptr, len) for each frontend member which changes as the
+  filter runs. The sources are left alone as Replay sets them from
+  the log
+ */
+template <typename EKF, typename F>
+void NavEKF3::checkpoint_fields(EKF &ekf, F f)
+{
+    f(&ekf.primary, sizeof(ekf.primary));
+    f(&ekf._frameTimeUsec, sizeof(ekf._frameTimeUsec));
+    f(&ekf._framesPerPrediction, sizeof(ekf._framesPerPrediction));
+    f(&ekf.imuSampleTime_us, sizeof(ekf.imuSampleTime_us));
+    f(&ekf.lastLaneSwitch_ms, sizeof(ekf.lastLaneSwitch_ms));
+    f(&ekf.lastLogWrite_us, sizeof(ekf.lastLogWrite_us));
+    f(&ekf.yaw_reset_data, sizeof(ekf.yaw_reset_data));
+    f(&ekf.pos_reset_data, sizeof(ekf.pos_reset_data));
+    f(&ekf.pos_down_reset_data, sizeof(ekf.pos_down_reset_data));
+    f(&ekf.runCoreSelection, sizeof(ekf.runCoreSelection));
+    f(&ekf.lastUnhealthyTime_us, sizeof(ekf.lastUnhealthyTime_us));
+    f(ekf.coreSetupRequired, sizeof(ekf.coreSetupRequired));
+    f(ekf.coreImuIndex, sizeof(ekf.coreImuIndex));
+    f(ekf.coreRelativeErrors, sizeof(ekf.coreRelativeErrors));
+    f(ekf.coreErrorScores, sizeof(ekf.coreErrorScores));
+    f(ekf.coreLastTimePrimary_us, sizeof(ekf.coreLastTimePrimary_us));
+    f(&ekf.common_EKF_origin, sizeof(ekf.common_EKF_origin));
+    f(&ekf.common_origin_valid, sizeof(ekf.common_origin_valid));
+}
+
+void NavEKF3::checkpoint_save(EKF_Checkpoint &cp) const
+{
+    const uint32_t core_size = sizeof(NavEKF3_core);
+    cp.write(&core_size, sizeof(core_size));
+    const uint8_t n = core != nullptr ? num_cores : 0;
+    cp.write(&n, sizeof(n));
+    checkpoint_fields(*this, [&cp](const void *p, uint32_t len) { cp.write(p, len); });
+    for (uint8_t i=0; i<n; i++) {
+        core[i].checkpoint_save(cp);
+    }
+}
+
+bool NavEKF3::checkpoint_load(EKF_Checkpoint &cp)
+{
+    uint32_t core_size;
+    uint8_t n;
+    if (!cp.read(&core_size, sizeof(core_size)) ||
+        !cp.read(&n, sizeof(n))) {
+        return false;
+    }
+    if (core_size != sizeof(NavEKF3_core) ||
+        n != (core != nullptr ? num_cores : 0)) {
+        return false;
+    }
+    checkpoint_fields(*this, [&cp](void *p, uint32_t len) { cp.read(p, len); });
+    for (uint8_t i=0; i<n && cp.ok(); i++) {
+        core[i].checkpoint_load(cp);
+    }
+    return cp.ok();
+}
+
+/*
+  call f on each data buffer of a core
+ */
+template <typename Core, typename F>
+void NavEKF3_core::checkpoint_buffers(Core &core, F &f)
+{
+    f(core.storedIMU);
+    f(core.storedGPS);
+    f(core.storedMag);
+    f(core.storedBaro);
+    f(core.storedTAS);
+#if EK3_FEATURE_RANGEFINDER_MEASUREMENTS
+    f(core.storedRange);
+#endif
+    f(core.storedOutput);
+    f(core.storedOF);
+#if EK3_FEATURE_BODY_ODOM
+    f(core.storedBodyOdm);
+    f(core.storedWheelOdm);
+#endif
+    f(core.storedYawAng);
+#if EK3_FEATURE_BEACON_FUSION
+    f(core.rngBcn.storedRange);
+#endif
+#if EK3_FEATURE_DRAG_FUSION
+    f(core.storedDrag);
+#endif
+#if EK3_FEATURE_EXTERNAL_NAV
+    f(core.storedExtNav);
+    f(core.storedExtNavVel);
+    f(core.storedExtNavYawAng);
+#endif
+}
+
+void NavEKF3_core::checkpoint_save(EKF_Checkpoint &cp) const
+{
+    cp.write(this, sizeof(*this));
+
+    BufferSaver saver{cp};
+    checkpoint_buffers(*this, saver);
+
+    const uint8_t have_yaw_estimator = yawEstimator != nullptr;
+    cp.write(&have_yaw_estimator, sizeof(have_yaw_estimator));
+    if (have_yaw_estimator) {
+        cp.write(yawEstimator, sizeof(*yawEstimator));
+    }
+
+#if EK3_FEATURE_BEACON_FUSION
+    const uint8_t num_reports = rngBcn.fusionReport != nullptr ? rngBcn.numFusionReports : 0;
+    cp.write(&num_reports, sizeof(num_reports));
+    if (num_reports > 0) {
+        cp.write(rngBcn.fusionReport, num_reports * sizeof(rngBcn.fusionReport[0]));
+    }
+#endif
+}
+
+void NavEKF3_core::checkpoint_load(EKF_Checkpoint &cp)
+{
+    const uint8_t *image = cp.read_ptr(sizeof(*this));
+    if (image == nullptr) {
+        return;
+    }
+
+    KeptRanges kept(this);
+    // the references to the DAL and public origin can't be named, so
+    // they are kept as the bytes between their neighbours. Check
+    // nothing else has been declared there
+#pragma GCC diagnostic push
+#pragma GCC diagnostic ignored "-Winvalid-offsetof"
+    static_assert(offsetof(NavEKF3_core, frontend) ==
+                  end_of_reference(offsetof(NavEKF3_core, yawEstimator) + sizeof(yawEstimator)),
+                  "only the DAL may sit between yawEstimator and frontend");
+    static_assert(offsetof(NavEKF3_core, validOrigin) ==
+                  end_of_reference(offsetof(NavEKF3_core, EKF_origin) + sizeof(EKF_origin)),
+                  "only public_origin may sit between EKF_origin and validOrigin");
+#if EK3_FEATURE_BEACON_FUSION
+    static_assert(offsetof(BeaconFusion, numFusionReports) ==
+                  offsetof(BeaconFusion, fusionReport) + sizeof(rngBcn.fusionReport),
+                  "only numFusionReports may follow fusionReport");
+    static_assert(sizeof(BeaconFusion) ==
+                  align_up(end_of_reference(offsetof(BeaconFusion, numFusionReports) + sizeof(rngBcn.numFusionReports)), alignof(BeaconFusion)),
+                  "only the DAL may follow numFusionReports");
+#endif
+#pragma GCC diagnostic pop
+    kept.add(&yawEstimator, &frontend + 1);
+    kept.add(&EKF_origin + 1, &validOrigin);
+#if EK3_FEATURE_BEACON_FUSION
+    kept.add(&rngBcn.fusionReport, &rngBcn + 1);
+#endif
+    checkpoint_buffers(*this, kept);
+    if (!kept.restore((uint8_t *)this, image, sizeof(*this))) {
+        cp.fail();
+        return;
+    }
+
+    BufferLoader loader{cp};
+    checkpoint_buffers(*this, loader);
+
+    uint8_t have_yaw_estimator;
+    if (!cp.read(&have_yaw_estimator, sizeof(have_yaw_estimator))) {
+        return;
+    }
+    if (have_yaw_estimator != (yawEstimator != nullptr)) {
+        cp.fail();
+        return;
+    }
+    if (have_yaw_estimator) {
+        cp.read(yawEstimator, sizeof(*yawEstimator));
+    }
+
+#if EK3_FEATURE_BEACON_FUSION
+    uint8_t num_reports;
+    if (!cp.read(&num_reports, sizeof(num_reports))) {
+        return;
+    }
+    if (num_reports != (rngBcn.fusionReport != nullptr ? rngBcn.numFusionReports : 0)) {
+        cp.fail();
+        return;
+    }
+    if (num_reports > 0) {
+        cp.read(rngBcn.fusionReport, num_reports * sizeof(rngBcn.fusionReport[0]));
+    }
+#endif
+}
+
+#endif  // AP_NAVEKF_CHECKPOINT_ENABLED
@@ -3,9 +3,12 @@
 #include "AP_NavEKF3.h"
 #include "AP_NavEKF3_core.h"
 #include <GCS_MAVLink/GCS.h>
+#include <AP_Logger/AP_Logger.h>
 
 #include "AP_DAL/AP_DAL.h"
 
+extern const AP_HAL::HAL& hal;
+
 // Control filter mode transitions
 void NavEKF3_core::controlFilterModes()
 {
@@ -410,7 +413,7 @@ void NavEKF3_core::setAidingMode()
         switch (PV_AidingMode) {
         case AID_NONE:
             // We have ceased aiding
-            GCS_SEND_TEXT(MAV_SEVERITY_WARNING, "EKF3 IMU%u stopped aiding",(unsigned)imu_index);
+            send_text(MAV_SEVERITY_WARNING, "EKF3 IMU%u stopped aiding",(unsigned)imu_index);
             // When not aiding, estimate orientation & height fusing synthetic constant position and zero velocity measurement to constrain tilt errors
             posTimeout = true;
             velTimeout = true;
@@ -435,7 +438,7 @@ void NavEKF3_core::setAidingMode()
 
         case AID_RELATIVE:
             // We are doing relative position navigation where velocity errors are constrained, but position drift will occur
-            GCS_SEND_TEXT(MAV_SEVERITY_INFO, "EKF3 IMU%u started relative aiding",(unsigned)imu_index);
+            send_text(MAV_SEVERITY_INFO, "EKF3 IMU%u started relative aiding",(unsigned)imu_index);
 #if EK3_FEATURE_OPTFLOW_FUSION
             if (readyToUseOptFlow()) {
                 // Reset time stamps
@@ -457,24 +460,24 @@ void NavEKF3_core::setAidingMode()
                 // We are commencing aiding using GPS - this is the preferred method
                 posResetSource = resetDataSource::GPS;
                 velResetSource = resetDataSource::GPS;
-                GCS_SEND_TEXT(MAV_SEVERITY_INFO, "EKF3 IMU%u is using GPS",(unsigned)imu_index);
+                send_text(MAV_SEVERITY_INFO, "EKF3 IMU%u is using GPS",(unsigned)imu_index);
 #if EK3_FEATURE_BEACON_FUSION
             } else if (readyToUseRangeBeacon()) {
                 // We are commencing aiding using range beacons
                 posResetSource = resetDataSource::RNGBCN;
-                GCS_SEND_TEXT(MAV_SEVERITY_INFO, "EKF3 IMU%u is using range beacons",(unsigned)imu_index);
-                GCS_SEND_TEXT(MAV_SEVERITY_INFO, "EKF3 IMU%u initial pos NE = %3.1f,%3.1f (m)",(unsigned)imu_index,(double)rngBcn.receiverPos.x,(double)rngBcn.receiverPos.y);
-                GCS_SEND_TEXT(MAV_SEVERITY_INFO, "EKF3 IMU%u initial beacon pos D offset = %3.1f (m)",(unsigned)imu_index,(double)rngBcn.posOffsetNED.z);
+                send_text(MAV_SEVERITY_INFO, "EKF3 IMU%u is using range beacons",(unsigned)imu_index);
+                send_text(MAV_SEVERITY_INFO, "EKF3 IMU%u initial pos NE = %3.1f,%3.1f (m)",(unsigned)imu_index,(double)rngBcn.receiverPos.x,(double)rngBcn.receiverPos.y);
+                send_text(MAV_SEVERITY_INFO, "EKF3 IMU%u initial beacon pos D offset = %3.1f (m)",(unsigned)imu_index,(double)rngBcn.posOffsetNED.z);
 #endif  // EK3_FEATURE_BEACON_FUSION
 #if EK3_FEATURE_EXTERNAL_NAV
             } else if (readyToUseExtNav()) {
                 // we are commencing aiding using external nav
                 posResetSource = resetDataSource::EXTNAV;
-                GCS_SEND_TEXT(MAV_SEVERITY_INFO, "EKF3 IMU%u is using external nav data",(unsigned)imu_index);
-                GCS_SEND_TEXT(MAV_SEVERITY_INFO, "EKF3 IMU%u initial pos NED = %3.1f,%3.1f,%3.1f (m)",(unsigned)imu_index,(double)extNavDataDelayed.pos.x,(double)extNavDataDelayed.pos.y,(double)extNavDataDelayed.pos.z);
+                send_text(MAV_SEVERITY_INFO, "EKF3 IMU%u is using external nav data",(unsigned)imu_index);
+                send_text(MAV_SEVERITY_INFO, "EKF3 IMU%u initial pos NED = %3.1f,%3.1f,%3.1f (m)",(unsigned)imu_index,(double)extNavDataDelayed.pos.x,(double)extNavDataDelayed.pos.y,(double)extNavDataDelayed.pos.z);
                 if (useExtNavVel) {
                     velResetSource = resetDataSource::EXTNAV;
-                    GCS_SEND_TEXT(MAV_SEVERITY_INFO, "EKF3 IMU%u initial vel NED = %3.1f,%3.1f,%3.1f (m/s)",(unsigned)imu_index,(double)extNavVelDelayed.vel.x,(double)extNavVelDelayed.vel.y,(double)extNavVelDelayed.vel.z);
+                    send_text(MAV_SEVERITY_INFO, "EKF3 IMU%u initial vel NED = %3.1f,%3.1f,%3.1f (m/s)",(unsigned)imu_index,(double)extNavVelDelayed.vel.x,(double)extNavVelDelayed.vel.y,(double)extNavVelDelayed.vel.z);
                 }
                 // handle height reset as special case
                 hgtMea = -extNavDataDelayed.pos.z;
@@ -513,7 +516,7 @@ void NavEKF3_core::checkAttitudeAlignmentStatus()
     if (!tiltAlignComplete) {
         if (tiltErrorVariance < sq(radians(5.0))) {
             tiltAlignComplete = true;
-            GCS_SEND_TEXT(MAV_SEVERITY_INFO, "EKF3 IMU%u tilt alignment complete",(unsigned)imu_index);
+            send_text(MAV_SEVERITY_INFO, "EKF3 IMU%u tilt alignment complete",(unsigned)imu_index);
         }
     }
 
@@ -712,9 +715,17 @@ bool NavEKF3_core::setOrigin(const Location &loc)
         setEarthFieldFromLocation(EKF_origin);
     }
 
-    GCS_SEND_TEXT(MAV_SEVERITY_INFO, "EKF3 IMU%u origin set",(unsigned)imu_index);
+    send_text(MAV_SEVERITY_INFO, "EKF3 IMU%u origin set",(unsigned)imu_index);
 
     if (!frontend->common_origin_valid) {
+#if EK3_FEATURE_THREADED_LANES
+        if (frontend->lanes_running) {
+            // other lanes may be setting an origin at the same time,
+            // the frontend publishes one once they have all finished
+            publicOriginPending = true;
+            return true;
+        }
+#endif
         frontend->common_origin_valid = true;
         // put origin in frontend as well to ensure it stays in sync between lanes
         public_origin = EKF_origin;
@@ -724,6 +735,90 @@ bool NavEKF3_core::setOrigin(const Location &loc)
     return true;
 }
 
+#if EK3_FEATURE_THREADED_LANES
+void NavEKF3_core::publishPendingOutputs(void)
+{
+    if (publicOriginPending && !frontend->common_origin_valid) {
+        frontend->common_origin_valid = true;
+        public_origin = EKF_origin;
+    }
+    publicOriginPending = false;
+
+    for (uint8_t i=0; i<pendingTextCount; i++) {
+        GCS_SEND_TEXT(pendingText[i].severity, "%s", pendingText[i].text);
+    }
+    pendingTextCount = 0;
+
+#if HAL_LOGGING_ENABLED
+    for (uint8_t ofs=0; ofs<pendingLogLength; ofs += 1 + pendingLog[ofs]) {
+        AP::logger().WriteBlock(&pendingLog[ofs+1], pendingLog[ofs]);
+    }
+#endif
+    pendingLogLength = 0;
+
+    if (pendingTakeoffExpected) {
+        dal.set_takeoff_expected();
+    }
+    pendingTakeoffExpected = false;
+}
+#endif
+
+/*
+  the outputs below affect the rest of the vehicle, so while lanes are
+  running concurrently they are held until all lanes have finished and
+  then published in lane order by publishPendingOutputs(). This keeps
+  them in the same order as when the lanes are run one after another
+ */
+void NavEKF3_core::send_text(MAV_SEVERITY severity, const char *fmt, ...)
+{
+#if AP_HAVE_GCS_SEND_TEXT
+    char text[MAVLINK_MSG_STATUSTEXT_FIELD_TEXT_LEN+1];
+    va_list ap;
+    va_start(ap, fmt);
+    hal.util->vsnprintf(text, sizeof(text), fmt, ap);
+    va_end(ap);
+#if EK3_FEATURE_THREADED_LANES
+    if (frontend->lanes_running) {
+        if (pendingTextCount < ARRAY_SIZE(pendingText)) {
+            pendingText[pendingTextCount].severity = severity;
+            memcpy(pendingText[pendingTextCount].text, text, sizeof(text));
+            pendingTextCount++;
+        }
+        return;
+    }
+#endif
+    GCS_SEND_TEXT(severity, "%s", text);
+#endif
+}
+
+void NavEKF3_core::write_log_block(const void *pkt, uint8_t size)
+{
+#if HAL_LOGGING_ENABLED
+#if EK3_FEATURE_THREADED_LANES
+    if (frontend->lanes_running) {
+        if (pendingLogLength + 1 + size <= sizeof(pendingLog)) {
+            pendingLog[pendingLogLength] = size;
+            memcpy(&pendingLog[pendingLogLength+1], pkt, size);
+            pendingLogLength += 1 + size;
+        }
+        return;
+    }
+#endif
+    AP::logger().WriteBlock(pkt, size);
+#endif
+}
+
+void NavEKF3_core::set_takeoff_expected(void)
+{
+#if EK3_FEATURE_THREADED_LANES
+    if (frontend->lanes_running) {
+        pendingTakeoffExpected = true;
+        return;
+    }
+#endif
+    dal.set_takeoff_expected();
+}
+
 // record all requested yaw resets completed
 void NavEKF3_core::recordYawResetsCompleted()
 {
@@ -0,0 +1,101 @@
+/*
+  This program is free software: you can redistribute it and/or modify
+  it under the terms of the GNU General Public License as published by
+  the Free Software Foundation, either version 3 of the License, or
+  (at your option) any later version.
+
+  This program is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+  GNU General Public License for more details.
+
+  You should have received a copy of the GNU General Public License
+  along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+#include "AP_NavEKF3_LaneWorker.h"
+
+#if EK3_FEATURE_THREADED_LANES
+
+#include "AP_NavEKF3_core.h"
+
+#include <pthread.h>
+#include <sched.h>
+
+extern const AP_HAL::HAL& hal;
+
+// extra stack on top of the HAL default, the EKF uses large frames
+#define LANE_WORKER_STACK_SIZE 16384
+
+NavEKF3_LaneWorker::NavEKF3_LaneWorker(NavEKF3_core &_core, uint8_t _lane) :
+    core(_core),
+    lane(_lane)
+{
+}
+
+bool NavEKF3_LaneWorker::start_thread(void)
+{
+    static const char *names[] { "EKF3-lane1", "EKF3-lane2" };
+    static_assert(ARRAY_SIZE(names) >= MAX_EKF_CORES-1, "need a name per worker lane");
+    if (lane < 1 || lane > ARRAY_SIZE(names)) {
+        return false;
+    }
+    // run at the main thread priority, as the main thread waits for us
+    return hal.scheduler->thread_create(FUNCTOR_BIND_MEMBER(&NavEKF3_LaneWorker::thread_main, void),
+                                        names[lane-1],
+                                        LANE_WORKER_STACK_SIZE, AP_HAL::Scheduler::PRIORITY_MAIN, 0);
+}
+
+void NavEKF3_LaneWorker::update(bool allow_state_prediction)
+{
+    allow_prediction = allow_state_prediction;
+    run_sem.signal();
+}
+
+void NavEKF3_LaneWorker::wait(void)
+{
+    done_sem.wait_blocking();
+}
+
+/*
+  pin to the lane'th CPU in the affinity set inherited from the main
+  thread, so each lane keeps its own CPU and caches
+ */
+void NavEKF3_LaneWorker::pin_thread(void)
+{
+    cpu_set_t allowed;
+    if (sched_getaffinity(0, sizeof(allowed), &allowed) != 0) {
+        return;
+    }
+    const int count = CPU_COUNT(&allowed);
+    if (count < 2) {
+        return;
+    }
+    int n = lane % count;
+    for (int cpu = 0; cpu < CPU_SETSIZE; cpu++) {
+        if (!CPU_ISSET(cpu, &allowed)) {
+            continue;
+        }
+        if (n-- == 0) {
+            cpu_set_t set;
+            CPU_ZERO(&set);
+            CPU_SET(cpu, &set);
+            pthread_setaffinity_np(pthread_self(), sizeof(set), &set);
+            return;
+        }
+    }
+}
+
+void NavEKF3_LaneWorker::thread_main(void)
+{
+    pin_thread();
+
+    while (true) {
+        if (!run_sem.wait_blocking()) {
+            continue;
+        }
+        core.UpdateFilter(allow_prediction);
+        done_sem.signal();
+    }
+}
+
+#endif  // EK3_FEATURE_THREADED_LANES
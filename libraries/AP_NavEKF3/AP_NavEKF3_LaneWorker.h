@@ -0,0 +1,60 @@
+/*
+  This program is free software: you can redistribute it and/or modify
+  it under the terms of the GNU General Public License as published by
+  the Free Software Foundation, either version 3 of the License, or
+  (at your option) any later version.
+
+  This program is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+  GNU General Public License for more details.
+
+  You should have received a copy of the GNU General Public License
+  along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+/*
+  run the update of one EKF3 lane on its own thread. The frontend
+  starts all worker lanes, runs the first lane itself and then waits
+  for every worker before lane selection, so lanes only run
+  concurrently with each other and never with the rest of the EKF
+ */
+#pragma once
+
+#include "AP_NavEKF3_feature.h"
+
+#if EK3_FEATURE_THREADED_LANES
+
+#include <AP_HAL/AP_HAL.h>
+
+class NavEKF3_core;
+
+class NavEKF3_LaneWorker {
+public:
+    NavEKF3_LaneWorker(NavEKF3_core &_core, uint8_t _lane);
+
+    CLASS_NO_COPY(NavEKF3_LaneWorker);
+
+    // create the thread, returning false on failure
+    bool start_thread(void);
+
+    // start an update of the lane
+    void update(bool allow_state_prediction);
+
+    // wait for the update started by update() to complete
+    void wait(void);
+
+private:
+    void thread_main(void);
+
+    // pin the calling thread to one of the CPUs the process may use
+    void pin_thread(void);
+
+    NavEKF3_core &core;
+    const uint8_t lane;
+    bool allow_prediction;
+
+    HAL_BinarySemaphore run_sem;
+    HAL_BinarySemaphore done_sem;
+};
+
+#endif  // EK3_FEATURE_THREADED_LANES
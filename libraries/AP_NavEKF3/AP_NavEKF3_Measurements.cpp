@@ -275,7 +275,7 @@ void NavEKF3_core::tryChangeCompass(uint8_t mag_index)
      // if the magnetometer is allowed to be used for yaw and has a different index, we start using it
     if (compass.healthy(mag_index) && compass.use_for_yaw(mag_index) && mag_index != magSelectIndex) {
         magSelectIndex = mag_index;
-        GCS_SEND_TEXT(MAV_SEVERITY_INFO, "EKF3 IMU%u switching to compass %u",(unsigned)imu_index,magSelectIndex);
+        send_text(MAV_SEVERITY_INFO, "EKF3 IMU%u switching to compass %u",(unsigned)imu_index,magSelectIndex);
         // reset the timeout flag and timer
         magTimeout = false;
         lastHealthyMagTime_ms = imuSampleTime_ms;
@@ -1454,7 +1454,7 @@ void NavEKF3_core::updateMovementCheck(void)
             gyro_diff_ratio    : float(gyro_diff_ratio),
             accel_diff_ratio   : float(accel_diff_ratio),
         };
-        AP::logger().WriteBlock(&pkt, sizeof(pkt));
+        write_log_block(&pkt, sizeof(pkt));
 #endif
     }
 }
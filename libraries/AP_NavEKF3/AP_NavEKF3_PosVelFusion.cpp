@@ -1108,11 +1108,7 @@ void NavEKF3_core::FuseVelPosNED()
 
                 // update the covariance - take advantage of direct observation of a single state at index = stateIndex to reduce computations
                 // this is a numerically optimised implementation of standard equation P = (I - K*H)*P;
-                for (uint8_t i= 0; i<=stateIndexLim; i++) {
-                    for (uint8_t j= 0; j<=stateIndexLim; j++) {
-                        KHP[i][j] = Kfusion[i] * P[stateIndex][j];
-                    }
-                }
+                EKF_Kernels::outer_product(&KHP[0][0], &Kfusion[0], &P[stateIndex][0], stateIndexLim);
                 // Check that we are not going to drive any variances negative and skip the update if so
                 bool healthyFusion = true;
                 for (uint8_t i= 0; i<=stateIndexLim; i++) {
@@ -1122,11 +1118,7 @@ void NavEKF3_core::FuseVelPosNED()
                 }
                 if (healthyFusion) {
                     // update the covariance matrix
-                    for (uint8_t i= 0; i<=stateIndexLim; i++) {
-                        for (uint8_t j= 0; j<=stateIndexLim; j++) {
-                            P[i][j] = P[i][j] - KHP[i][j];
-                        }
-                    }
+                    EKF_Kernels::subtract(&P[0][0], &KHP[0][0], stateIndexLim);
 
                     // force the covariance matrix to be symmetrical and limit the variances to prevent ill-conditioning.
                     ForceSymmetry();
@@ -1997,7 +1989,7 @@ void NavEKF3_core::FuseBodyVel()
             // notify first time only
             if (!bodyVelFusionActive) {
                 bodyVelFusionActive = true;
-                GCS_SEND_TEXT(MAV_SEVERITY_INFO, "EKF3 IMU%u fusing odometry",(unsigned)imu_index);
+                send_text(MAV_SEVERITY_INFO, "EKF3 IMU%u fusing odometry",(unsigned)imu_index);
             }
             // correct the covariance P = (I - K*H)*P
             // take advantage of the empty columns in KH to reduce the
@@ -31,11 +31,17 @@
 #include <AP_NavEKF/AP_NavEKF_core_common.h>
 #include <AP_NavEKF/AP_NavEKF_Source.h>
 #include <AP_NavEKF/EKF_Buffer.h>
+#include <AP_NavEKF/EKF_Kernels.h>
 #include <AP_InertialSensor/AP_InertialSensor.h>
 #include <AP_RangeFinder/AP_RangeFinder.h>
+#include <GCS_MAVLink/GCS_MAVLink.h>
 
 #include "AP_NavEKF/EKFGSF_yaw.h"
 
+#if EK3_FEATURE_THREADED_LANES && !AP_NAVEKF_SCRATCH_PER_THREAD
+#error "EK3_FEATURE_THREADED_LANES needs AP_NAVEKF_SCRATCH_PER_THREAD"
+#endif
+
 // GPS pre-flight check bit locations
 #define MASK_GPS_NSATS      (1<<0)
 #define MASK_GPS_HDOP       (1<<1)
@@ -126,6 +132,8 @@
 
 class NavEKF3_core : public NavEKF_core_common
 {
+    friend class NavEKF3_test;
+
 public:
     // Constructor
     NavEKF3_core(class NavEKF3 *_frontend, class AP_DAL &dal);
@@ -230,6 +238,14 @@ public:
     // returns false if the origin has already been set
     bool setOriginLLH(const Location &loc);
 
+#if EK3_FEATURE_THREADED_LANES
+    // publish the outputs held back while lanes were running
+    // concurrently: an origin set as the common origin if no other
+    // lane has already done so, then GCS messages, log messages and
+    // takeoff detection
+    void publishPendingOutputs(void);
+#endif
+
     // Set the EKF's NE horizontal position states and their corresponding variances from a supplied WGS-84 location and uncertainty
     // The altitude element of the location is not used.
     // Returns true if the set was successful
@@ -469,8 +485,22 @@ public:
     // failure message
     // requires_position should be true if horizontal position configuration should be checked
     bool pre_arm_check(bool requires_position, char *failure_msg, uint8_t failure_msg_len) const;
+
+#if AP_NAVEKF_CHECKPOINT_ENABLED
+    // save or restore the state of the core for a checkpoint. The
+    // core must have been set up with the same parameters as the
+    // one which was saved before restoring
+    void checkpoint_save(EKF_Checkpoint &cp) const;
+    void checkpoint_load(EKF_Checkpoint &cp);
+#endif
     
 private:
+#if AP_NAVEKF_CHECKPOINT_ENABLED
+    // call f on each data buffer of a core
+    template <typename Core, typename F>
+    static void checkpoint_buffers(Core &core, F &f);
+#endif
+
     EKFGSF_yaw *yawEstimator;
     AP_DAL &dal;
 
@@ -749,6 +779,13 @@ private:
     // fuse synthetic sideslip measurement of zero
     void FuseSideslip();
 
+    // return true if the covariances between a block of states from 16
+    // onwards and the states 0 to 15 are all zero
+    bool covBlockDecoupled(uint8_t first, uint8_t last) const;
+
+    // covariance prediction for a block of states for which covBlockDecoupled() is true
+    void predictDecoupledCovBlock(uint8_t first, uint8_t last);
+
     // zero specified range of rows in the state covariance matrix
     void zeroRows(Matrix24 &covMat, uint8_t first, uint8_t last);
 
@@ -1005,6 +1042,15 @@ private:
     void verifyTiltErrorVariance();
 #endif
 
+    // send a text message to the GCS
+    void send_text(MAV_SEVERITY severity, const char *fmt, ...) FMT_PRINTF(3, 4);
+
+    // write a message to the log
+    void write_log_block(const void *pkt, uint8_t size);
+
+    // tell the vehicle that a takeoff is expected
+    void set_takeoff_expected(void);
+
     // update timing statistics structure
     void updateTimingStatistics(void);
 
@@ -1157,6 +1203,18 @@ private:
     Location EKF_origin;     // LLH origin of the NED axis system, internal only
     Location &public_origin; // LLH origin of the NED axis system, public functions
     bool validOrigin;               // true when the EKF origin is valid
+#if EK3_FEATURE_THREADED_LANES
+    bool publicOriginPending;       // true when the origin was set while lanes were running concurrently and needs to be published
+    // outputs held back while lanes are running concurrently
+    struct {
+        MAV_SEVERITY severity;
+        char text[MAVLINK_MSG_STATUSTEXT_FIELD_TEXT_LEN+1];
+    } pendingText[4];
+    uint8_t pendingTextCount;
+    uint8_t pendingLog[64];         // length prefixed log messages, room for the XKFM and XKTV messages of one update
+    uint8_t pendingLogLength;
+    bool pendingTakeoffExpected;
+#endif
     ftype gpsSpdAccuracy;           // estimated speed accuracy in m/s returned by the GPS receiver
     ftype gpsPosAccuracy;           // estimated position accuracy in m returned by the GPS receiver
     ftype gpsHgtAccuracy;           // estimated height accuracy in m returned by the GPS receiver
@@ -46,3 +46,14 @@
 #ifndef EK3_FEATURE_OPTFLOW_FUSION
 #define EK3_FEATURE_OPTFLOW_FUSION HAL_NAVEKF3_AVAILABLE && AP_OPTICALFLOW_ENABLED
 #endif
+
+// running lanes on their own threads needs per-thread EKF scratch
+// space. Replay has it so it can check the lanes give the same results
+// as when run one after another
+#ifndef EK3_FEATURE_THREADED_LANES
+#if defined(__linux__) && (CONFIG_HAL_BOARD == HAL_BOARD_LINUX || APM_BUILD_TYPE(APM_BUILD_Replay))
+#define EK3_FEATURE_THREADED_LANES HAL_NAVEKF3_AVAILABLE
+#else
+#define EK3_FEATURE_THREADED_LANES 0
+#endif
+#endif
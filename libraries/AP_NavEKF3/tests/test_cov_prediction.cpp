@@ -0,0 +1,184 @@
+#include <AP_gtest.h>
+
+/*
+  tests for the SparseCovPrediction option of EKF3. The covariance
+  prediction must give bit-identical results with and without the
+  option, whether or not the magnetic field and wind states are
+  correlated with the other states
+ */
+
+#include <AP_NavEKF3/AP_NavEKF3.h>
+#include <AP_NavEKF3/AP_NavEKF3_core.h>
+#include <AP_DAL/AP_DAL.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include <AP_HAL/AP_HAL.h>
+const AP_HAL::HAL& hal = AP_HAL::get_HAL();
+
+#if HAL_NAVEKF3_AVAILABLE
+
+static uint32_t seed;
+
+static ftype rand_range(ftype low, ftype high)
+{
+    seed = seed * 1103515245U + 12345U;
+    return low + (high - low) * ((seed >> 8) & 0xFFFF) / ftype(0xFFFF);
+}
+
+// how the cross covariances of the states from 16 onwards are set up
+enum class CrossCov {
+    Zero,
+    NegativeZero,
+    MagCorrelated,
+    WindCorrelated,
+};
+
+class NavEKF3_test {
+public:
+    NavEKF3_test() {
+        ekf._gyrNoise.set(0.015);
+        ekf._accNoise.set(0.35);
+        ekf._gyroBiasProcessNoise.set(1.0E-03);
+        ekf._accelBiasProcessNoise.set(2.0E-03);
+        ekf._magEarthProcessNoise.set(1.0E-03);
+        ekf._magBodyProcessNoise.set(1.0E-04);
+        ekf._windVelProcessNoise.set(0.2);
+        ekf._wndVarHgtRateScale.set(1.0);
+        for (uint8_t i=0; i<ARRAY_SIZE(core); i++) {
+            // allocated the same way as the frontend allocates its cores
+            core[i] = (NavEKF3_core *)calloc(1, sizeof(NavEKF3_core));
+            new (core[i]) NavEKF3_core(&ekf, AP::dal());
+        }
+    }
+
+    ~NavEKF3_test() {
+        for (uint8_t i=0; i<ARRAY_SIZE(core); i++) {
+            core[i]->~NavEKF3_core();
+            free(core[i]);
+        }
+    }
+
+    // give both cores the same state and covariances
+    void setup(CrossCov cross) {
+        NavEKF3_core &c = *core[0];
+        c.stateIndexLim = 23;
+        c.dtEkfAvg = EKF_TARGET_DT;
+        c.windStateIsObservable = true;
+        c.tasDataDelayed.allowFusion = true;
+        c.prevTnb.identity();
+
+        QuaternionF q { rand_range(-1, 1), rand_range(-1, 1), rand_range(-1, 1), rand_range(-1, 1) };
+        q.normalize();
+        c.stateStruct.quat = q;
+        c.stateStruct.velocity = Vector3F(rand_range(-10, 10), rand_range(-10, 10), rand_range(-2, 2));
+        c.stateStruct.gyro_bias = Vector3F(rand_range(-1e-4, 1e-4), rand_range(-1e-4, 1e-4), rand_range(-1e-4, 1e-4));
+        c.stateStruct.accel_bias = Vector3F(rand_range(-1e-3, 1e-3), rand_range(-1e-3, 1e-3), rand_range(-1e-3, 1e-3));
+
+        // a symmetric covariance matrix with small cross covariances
+        for (uint8_t row=0; row<24; row++) {
+            c.P[row][row] = rand_range(1e-4, 1e-2);
+            for (uint8_t col=0; col<row; col++) {
+                c.P[row][col] = c.P[col][row] = rand_range(-1e-6, 1e-6);
+            }
+        }
+
+        for (uint8_t col=16; col<24; col++) {
+            for (uint8_t row=0; row<=15; row++) {
+                ftype v;
+                switch (cross) {
+                case CrossCov::Zero:
+                default:
+                    v = 0;
+                    break;
+                case CrossCov::NegativeZero:
+                    v = -0.0;
+                    break;
+                case CrossCov::MagCorrelated:
+                    v = col <= 21 ? c.P[row][col] : 0;
+                    break;
+                case CrossCov::WindCorrelated:
+                    v = col >= 22 ? c.P[row][col] : 0;
+                    break;
+                }
+                c.P[row][col] = c.P[col][row] = v;
+            }
+        }
+
+        memcpy(&core[1]->stateStruct, &c.stateStruct, sizeof(c.stateStruct));
+        memcpy(&core[1]->P, &c.P, sizeof(c.P));
+        core[1]->stateIndexLim = c.stateIndexLim;
+        core[1]->dtEkfAvg = c.dtEkfAvg;
+        core[1]->windStateIsObservable = c.windStateIsObservable;
+        core[1]->tasDataDelayed.allowFusion = c.tasDataDelayed.allowFusion;
+        core[1]->prevTnb = c.prevTnb;
+    }
+
+    // predict both cores over one IMU sample, core 0 using the sparse prediction
+    void predict() {
+        NavEKF3_core::imu_elements imu {};
+        imu.delAngDT = imu.delVelDT = EKF_TARGET_DT;
+        imu.delAng = Vector3F(rand_range(-0.01, 0.01), rand_range(-0.01, 0.01), rand_range(-0.01, 0.01));
+        imu.delVel = Vector3F(rand_range(-0.1, 0.1), rand_range(-0.1, 0.1), rand_range(-0.1, 0.1) - GRAVITY_MSS * EKF_TARGET_DT);
+        for (uint8_t i=0; i<ARRAY_SIZE(core); i++) {
+            ekf._options.set(i == 0 ? int32_t(NavEKF3::Option::SparseCovPrediction) : 0);
+            core[i]->imuDataDelayed = imu;
+            core[i]->CovariancePrediction(nullptr);
+        }
+        ekf._options.set(0);
+    }
+
+    bool same_covariances() const {
+        return memcmp(&core[0]->P, &core[1]->P, sizeof(core[0]->P)) == 0;
+    }
+
+    bool mag_decoupled() const {
+        return core[0]->covBlockDecoupled(16, 21);
+    }
+
+private:
+    NavEKF3 ekf;
+    NavEKF3_core *core[2];
+};
+
+static void check_prediction(CrossCov cross, bool expect_decoupled)
+{
+    NavEKF3_test test;
+    seed = 17 + uint32_t(cross);
+    for (uint8_t n=0; n<10; n++) {
+        test.setup(cross);
+        EXPECT_EQ(test.mag_decoupled(), expect_decoupled);
+        for (uint16_t step=0; step<100; step++) {
+            test.predict();
+            ASSERT_TRUE(test.same_covariances()) << "n=" << unsigned(n) << " step=" << step;
+        }
+    }
+}
+
+TEST(NavEKF3_CovPrediction, Decoupled)
+{
+    check_prediction(CrossCov::Zero, true);
+}
+
+/*
+  a negative zero cross covariance can propagate as a negative zero
+  through the full prediction, so it must not be treated as decoupled
+ */
+TEST(NavEKF3_CovPrediction, NegativeZero)
+{
+    check_prediction(CrossCov::NegativeZero, false);
+}
+
+TEST(NavEKF3_CovPrediction, MagCorrelated)
+{
+    check_prediction(CrossCov::MagCorrelated, false);
+}
+
+TEST(NavEKF3_CovPrediction, WindCorrelated)
+{
+    check_prediction(CrossCov::WindCorrelated, true);
+}
+
+#endif // HAL_NAVEKF3_AVAILABLE
+
+AP_GTEST_MAIN()
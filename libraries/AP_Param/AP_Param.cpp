@@ -25,6 +25,7 @@
 
 #include <cmath>
 #include <string.h>
+#include <ctype.h>
 
 #include <AP_Common/AP_Common.h>
 #include <AP_HAL/AP_HAL.h>
@@ -104,6 +105,19 @@ uint16_t AP_Param::_count_marker;
 uint16_t AP_Param::_count_marker_done;
 HAL_Semaphore AP_Param::_count_sem;
 
+#if AP_PARAM_INDEX_ENABLED
+// hashed name index
+AP_Param::IndexEntry *AP_Param::_index_entries;
+AP_Param::IndexSlot *AP_Param::_index_slots;
+uint16_t *AP_Param::_index_token_slots;
+uint16_t AP_Param::_index_num_entries;
+uint16_t AP_Param::_index_entries_len;
+uint16_t AP_Param::_index_slots_mask;
+uint16_t AP_Param::_index_marker;
+bool AP_Param::_index_valid;
+HAL_Semaphore AP_Param::_index_sem;
+#endif
+
 // storage and naming information about all types that can be saved
 const AP_Param::Info *AP_Param::_var_info;
 
@@ -917,6 +931,25 @@ AP_Param::find_group(const char *name, uint16_t vindex, ptrdiff_t group_offset,
 AP_Param *
 AP_Param::find(const char *name, enum ap_var_type *ptype, uint16_t *flags)
 {
+#if AP_PARAM_INDEX_ENABLED
+    ParamToken token;
+    AP_Param *found = index_find(name, true, &token, ptype);
+    // top level Vector3f elements are not visible to find()
+    if (found != nullptr &&
+        (token.idx == 0 || var_info(token.key).type == AP_PARAM_GROUP)) {
+        if (flags != nullptr && var_info(token.key).type == AP_PARAM_GROUP) {
+            uint32_t group_element = 0;
+            const struct GroupInfo *ginfo = nullptr;
+            struct GroupNesting group_nesting {};
+            uint8_t idx;
+            found->find_var_info_token(token, &group_element, ginfo, group_nesting, &idx);
+            if (ginfo != nullptr) {
+                *flags = ginfo->flags;
+            }
+        }
+        return found;
+    }
+#endif
     for (uint16_t i=0; i<_num_vars; i++) {
         const auto &info = var_info(i);
         uint8_t type = info.type;
@@ -958,12 +991,26 @@ AP_Param::find(const char *name, enum ap_var_type *ptype, uint16_t *flags)
     return nullptr;
 }
 
-// Find a variable by index. Note that this is quite slow.
+// Find a variable by index. Note that this is quite slow unless the
+// parameter index is available
 //
 AP_Param *
 AP_Param::find_by_index(uint16_t idx, enum ap_var_type *ptype, ParamToken *token)
 {
     AP_Param *ap;
+#if AP_PARAM_INDEX_ENABLED
+    if (_index_sem.take_nonblocking()) {
+        bool done = false;
+        if (index_update(!hal.util->get_soft_armed())) {
+            ap = idx < _index_num_entries ? index_entry(idx, token, ptype) : nullptr;
+            done = ap != nullptr || idx >= _index_num_entries;
+        }
+        _index_sem.give();
+        if (done) {
+            return ap;
+        }
+    }
+#endif
     uint16_t count=0;
     for (ap=AP_Param::first(token, ptype);
          ap && count < idx;
@@ -977,6 +1024,12 @@ AP_Param::find_by_index(uint16_t idx, enum ap_var_type *ptype, ParamToken *token
 AP_Param* AP_Param::find_by_name(const char* name, enum ap_var_type *ptype, ParamToken *token)
 {
     AP_Param *ap;
+#if AP_PARAM_INDEX_ENABLED
+    ap = index_find(name, false, token, ptype);
+    if (ap != nullptr) {
+        return ap;
+    }
+#endif
     for (ap = AP_Param::first(token, ptype);
          ap && *ptype != AP_PARAM_GROUP && *ptype != AP_PARAM_NONE;
          ap = AP_Param::next_scalar(token, ptype)) {
@@ -1104,6 +1157,12 @@ bool AP_Param::get_param_by_index(void *obj_ptr, uint8_t idx, ap_var_type old_pt
 AP_Param *
 AP_Param::find_object(const char *name)
 {
+#if AP_PARAM_INDEX_ENABLED
+    AP_Param *obj = index_find_object(name);
+    if (obj != nullptr) {
+        return obj;
+    }
+#endif
     for (uint16_t i=0; i<_num_vars; i++) {
         const auto &info = var_info(i);
         if (strcasecmp(name, info.name) == 0) {
@@ -1301,6 +1360,11 @@ void AP_Param::save_io_handler(void)
     if (hal.scheduler->is_system_initialized()) {
         // pay the cost of parameter counting in the IO thread
         count_parameters();
+#if AP_PARAM_INDEX_ENABLED
+        // and of rebuilding the name index
+        WITH_SEMAPHORE(_index_sem);
+        index_update(true);
+#endif
     }
 }
 
@@ -1940,6 +2004,11 @@ AP_Param *AP_Param::next(ParamToken *token, enum ap_var_type *ptype, bool skip_d
 AP_Param *AP_Param::next_scalar(ParamToken *token, enum ap_var_type *ptype, float *default_val)
 {
     AP_Param *ap;
+#if AP_PARAM_INDEX_ENABLED
+    if (default_val == nullptr && index_next_scalar(token, ptype, ap)) {
+        return ap;
+    }
+#endif
     enum ap_var_type type;
     while ((ap = next(token, &type, true, default_val)) != nullptr && type > AP_PARAM_FLOAT) ;
 
@@ -2732,6 +2801,324 @@ void AP_Param::invalidate_count(void)
     _count_marker++;
 }
 
+#if AP_PARAM_INDEX_ENABLED
+/*
+  FNV-1a hash of a parameter name, case insensitive
+ */
+uint32_t AP_Param::index_hash(const char *name)
+{
+    uint32_t h = 2166136261U;
+    for (uint8_t i=0; i<AP_MAX_NAME_SIZE && name[i] != 0; i++) {
+        h ^= (uint8_t)toupper(name[i]);
+        h *= 16777619U;
+    }
+    return h;
+}
+
+/*
+  add a reference to the hash table with linear probing. Entries with
+  the same name keep their insertion order along the probe sequence,
+  so lookups find the same parameter as the linear search
+ */
+void AP_Param::index_insert(uint32_t hash, uint16_t ref)
+{
+    uint16_t i = hash & _index_slots_mask;
+    while (_index_slots[i].ref != 0) {
+        i = (i + 1) & _index_slots_mask;
+    }
+    _index_slots[i].hash = hash >> 16;
+    _index_slots[i].ref = ref;
+}
+
+/*
+  the token as a single value for hashing and comparison
+ */
+uint32_t AP_Param::index_token_value(ParamToken token)
+{
+    static_assert(sizeof(ParamToken) == sizeof(uint32_t), "ParamToken must be 32 bits");
+    uint32_t v;
+    memcpy(&v, &token, sizeof(v));
+    return v;
+}
+
+/*
+  add entry n to the token table
+ */
+void AP_Param::index_token_insert(uint16_t n)
+{
+    uint16_t i = ((index_token_value(_index_entries[n].token) * 2654435761U) >> 16) & _index_slots_mask;
+    while (_index_token_slots[i] != 0) {
+        i = (i + 1) & _index_slots_mask;
+    }
+    _index_token_slots[i] = n + 1;
+}
+
+/*
+  find the entry for a token, or -1 if it isn't in the index
+ */
+int32_t AP_Param::index_token_find(ParamToken token)
+{
+    const uint32_t v = index_token_value(token);
+    for (uint16_t i = ((v * 2654435761U) >> 16) & _index_slots_mask;
+         _index_token_slots[i] != 0;
+         i = (i + 1) & _index_slots_mask) {
+        const uint16_t n = _index_token_slots[i] - 1;
+        if (index_token_value(_index_entries[n].token) == v) {
+            return n;
+        }
+    }
+    return -1;
+}
+
+/*
+  build the name index from a full parameter enumeration. Called with
+  _index_sem held
+ */
+bool AP_Param::index_build(void)
+{
+    _index_valid = false;
+
+    const uint16_t marker = _count_marker;
+    const uint16_t count = count_parameters();
+
+    // keep the table at most half full
+    const uint32_t nrefs = uint32_t(count) + _num_vars;
+    uint32_t nslots = 64;
+    while (nslots < 2*nrefs) {
+        nslots *= 2;
+    }
+    if (nslots > INDEX_REF_OBJECT) {
+        return false;
+    }
+
+    if (count > _index_entries_len) {
+        // leave some room for scripts adding parameters
+        const uint16_t len = count + count/8;
+        delete[] _index_entries;
+        _index_entries = NEW_NOTHROW IndexEntry[len];
+        _index_entries_len = _index_entries != nullptr ? len : 0;
+        if (_index_entries == nullptr) {
+            return false;
+        }
+    }
+    if (_index_slots == nullptr || _index_token_slots == nullptr ||
+        nslots != uint32_t(_index_slots_mask) + 1) {
+        delete[] _index_slots;
+        delete[] _index_token_slots;
+        _index_slots = NEW_NOTHROW IndexSlot[nslots];
+        _index_token_slots = NEW_NOTHROW uint16_t[nslots];
+        if (_index_slots == nullptr || _index_token_slots == nullptr) {
+            return false;
+        }
+        _index_slots_mask = nslots - 1;
+    }
+    memset(_index_slots, 0, nslots * sizeof(IndexSlot));
+    memset(_index_token_slots, 0, nslots * sizeof(uint16_t));
+
+    ParamToken token {};
+    enum ap_var_type type;
+    uint16_t n = 0;
+    char name[AP_MAX_NAME_SIZE+1];
+    for (AP_Param *ap = first(&token, &type);
+         ap != nullptr;
+         ap = next_scalar(&token, &type)) {
+        if (n >= count) {
+            // the tree changed while we were counting
+            return false;
+        }
+        _index_entries[n].token = token;
+        _index_entries[n].type = type;
+        index_token_insert(n);
+        n++;
+        if (type > AP_PARAM_FLOAT) {
+            // first() can return a non-scalar
+            continue;
+        }
+        ap->copy_name_token(token, name, AP_MAX_NAME_SIZE);
+        name[AP_MAX_NAME_SIZE] = 0;
+        index_insert(index_hash(name), n);
+    }
+    _index_num_entries = n;
+
+    // top level objects for find_object()
+    for (uint16_t i=0; i<_num_vars; i++) {
+        index_insert(index_hash(var_info(i).name), INDEX_REF_OBJECT | i);
+    }
+
+    if (marker != _count_marker) {
+        return false;
+    }
+    _index_marker = marker;
+    _index_valid = true;
+    return true;
+}
+
+/*
+  check the index matches the current parameter tree, rebuilding it
+  if allowed. Called with _index_sem held
+ */
+bool AP_Param::index_update(bool allow_build)
+{
+    if (_index_valid && _index_marker == _count_marker) {
+        return true;
+    }
+    if (!allow_build) {
+        return false;
+    }
+    return index_build();
+}
+
+/*
+  get the storage of an index entry. The pointer is resolved on each
+  lookup as pointer groups may be allocated or moved
+ */
+AP_Param *AP_Param::index_resolve(const IndexEntry &entry)
+{
+    const ParamToken token = entry.token;
+    const auto &info = var_info(token.key);
+    ptrdiff_t base;
+    if (info.type == AP_PARAM_GROUP) {
+        const struct GroupInfo *group_info = get_group_info(info);
+        if (group_info == nullptr) {
+            return nullptr;
+        }
+        struct Param_header phdr {};
+        phdr.type = token.idx != 0 ? uint8_t(AP_PARAM_VECTOR3F) : entry.type;
+        phdr.group_element = token.group_element;
+        void *ptr;
+        if (find_by_header_group(phdr, &ptr, token.key, group_info, 0, 0, 0) == nullptr) {
+            return nullptr;
+        }
+        base = (ptrdiff_t)ptr;
+    } else if (!get_base(info, base)) {
+        return nullptr;
+    }
+    if (token.idx != 0) {
+        // element of a Vector3f
+        base += (token.idx - 1u) * sizeof(float);
+    }
+    return (AP_Param *)base;
+}
+
+/*
+  return the storage of entry n, filling in its token and type
+ */
+AP_Param *AP_Param::index_entry(uint16_t n, ParamToken *token, enum ap_var_type *ptype)
+{
+    const IndexEntry &entry = _index_entries[n];
+    AP_Param *ap = index_resolve(entry);
+    if (ap != nullptr) {
+        *token = entry.token;
+        if (ptype != nullptr) {
+            *ptype = (enum ap_var_type)entry.type;
+        }
+    }
+    return ap;
+}
+
+/*
+  step a token to the next scalar using the index. Returns false if
+  the index can't answer, in which case the caller walks the
+  tree. The index is never built here, as next_scalar() is used by
+  the build itself
+ */
+bool AP_Param::index_next_scalar(ParamToken *token, enum ap_var_type *ptype, AP_Param *&ret)
+{
+    if (!_index_sem.take_nonblocking()) {
+        return false;
+    }
+    bool done = false;
+    if (index_update(false)) {
+        const int32_t n = index_token_find(*token);
+        if (n >= 0 && n+1 >= _index_num_entries) {
+            // end of the list
+            ret = nullptr;
+            done = true;
+        } else if (n >= 0) {
+            ret = index_entry(n+1, token, ptype);
+            done = ret != nullptr;
+        }
+    }
+    _index_sem.give();
+    return done;
+}
+
+/*
+  find a scalar parameter by name using the index. Returns nullptr if
+  not found or if the index is not usable, in which case the caller
+  falls back to a linear search. The index is only built here when
+  disarmed; when armed it is left to the IO thread
+ */
+AP_Param *AP_Param::index_find(const char *name, bool case_sensitive, ParamToken *token, enum ap_var_type *ptype)
+{
+    if (!_index_sem.take_nonblocking()) {
+        return nullptr;
+    }
+    AP_Param *ret = nullptr;
+    if (index_update(!hal.util->get_soft_armed())) {
+        const uint32_t hash = index_hash(name);
+        const uint16_t hash16 = hash >> 16;
+        for (uint16_t i = hash & _index_slots_mask;
+             _index_slots[i].ref != 0;
+             i = (i + 1) & _index_slots_mask) {
+            const IndexSlot &slot = _index_slots[i];
+            if (slot.hash != hash16 || (slot.ref & INDEX_REF_OBJECT)) {
+                continue;
+            }
+            const IndexEntry &entry = _index_entries[slot.ref-1];
+            AP_Param *ap = index_resolve(entry);
+            if (ap == nullptr) {
+                continue;
+            }
+            const ParamToken entry_token = entry.token;
+            char buf[AP_MAX_NAME_SIZE+1];
+            ap->copy_name_token(entry_token, buf, AP_MAX_NAME_SIZE);
+            buf[AP_MAX_NAME_SIZE] = 0;
+            if (case_sensitive ? strcmp(name, buf) != 0 : strncasecmp(name, buf, AP_MAX_NAME_SIZE) != 0) {
+                continue;
+            }
+            *token = entry_token;
+            *ptype = (enum ap_var_type)entry.type;
+            ret = ap;
+            break;
+        }
+    }
+    _index_sem.give();
+    return ret;
+}
+
+/*
+  find a top level object by name using the index
+ */
+AP_Param *AP_Param::index_find_object(const char *name)
+{
+    if (!_index_sem.take_nonblocking()) {
+        return nullptr;
+    }
+    AP_Param *ret = nullptr;
+    if (index_update(!hal.util->get_soft_armed())) {
+        const uint32_t hash = index_hash(name);
+        const uint16_t hash16 = hash >> 16;
+        for (uint16_t i = hash & _index_slots_mask;
+             _index_slots[i].ref != 0;
+             i = (i + 1) & _index_slots_mask) {
+            const IndexSlot &slot = _index_slots[i];
+            if (slot.hash != hash16 || !(slot.ref & INDEX_REF_OBJECT)) {
+                continue;
+            }
+            const auto &info = var_info(slot.ref & ~INDEX_REF_OBJECT);
+            ptrdiff_t base;
+            if (strcasecmp(name, info.name) == 0 && get_base(info, base)) {
+                ret = (AP_Param *)base;
+                break;
+            }
+        }
+    }
+    _index_sem.give();
+    return ret;
+}
+#endif  // AP_PARAM_INDEX_ENABLED
+
 /*
   set a default value by name
  */
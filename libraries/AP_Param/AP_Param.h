@@ -876,6 +876,50 @@ private:
     static void check_default(AP_Param *ap, float *default_value);
 
     static bool eeprom_full;
+
+#if AP_PARAM_INDEX_ENABLED
+    /*
+      hashed index of parameter names. The entries are the scalar
+      parameters in first()/next_scalar() order, which also gives
+      find_by_index() directly; each name slot refers either to an
+      entry or to a row of the top level var_info table, and the token
+      slots map a ParamToken back to its entry for next_scalar(). The
+      index is rebuilt whenever the parameter count is invalidated,
+      and lookups always verify the name, so a stale index can only
+      cause a fallback to the linear search
+     */
+    struct PACKED IndexEntry {
+        ParamToken token;
+        uint8_t type;
+    };
+    struct IndexSlot {
+        uint16_t hash;  // upper 16 bits of the name hash
+        uint16_t ref;   // 0 when empty, else entry+1 or INDEX_REF_OBJECT|vindex
+    };
+    static const uint16_t INDEX_REF_OBJECT = 0x8000;
+    static IndexEntry *_index_entries;
+    static IndexSlot *_index_slots;
+    static uint16_t *_index_token_slots;  // 0 when empty, else entry+1
+    static uint16_t _index_num_entries;
+    static uint16_t _index_entries_len;
+    static uint16_t _index_slots_mask;
+    static uint16_t _index_marker;
+    static bool _index_valid;
+    static HAL_Semaphore _index_sem;
+
+    static uint32_t index_hash(const char *name);
+    static void index_insert(uint32_t hash, uint16_t ref);
+    static uint32_t index_token_value(ParamToken token);
+    static void index_token_insert(uint16_t n);
+    static int32_t index_token_find(ParamToken token);
+    static bool index_build(void);
+    static bool index_update(bool allow_build);
+    static AP_Param *index_resolve(const IndexEntry &entry);
+    static AP_Param *index_entry(uint16_t n, ParamToken *token, enum ap_var_type *ptype);
+    static bool index_next_scalar(ParamToken *token, enum ap_var_type *ptype, AP_Param *&ret);
+    static AP_Param *index_find(const char *name, bool case_sensitive, ParamToken *token, enum ap_var_type *ptype);
+    static AP_Param *index_find_object(const char *name);
+#endif
 };
 
 namespace AP {
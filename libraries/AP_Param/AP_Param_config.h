@@ -11,3 +11,8 @@
 #ifndef FORCE_APJ_DEFAULT_PARAMETERS
 #define FORCE_APJ_DEFAULT_PARAMETERS 0
 #endif
+
+// hashed name index for find(), find_by_name() and find_object()
+#ifndef AP_PARAM_INDEX_ENABLED
+#define AP_PARAM_INDEX_ENABLED (CONFIG_HAL_BOARD == HAL_BOARD_SITL || CONFIG_HAL_BOARD == HAL_BOARD_LINUX)
+#endif
@@ -0,0 +1,145 @@
+/*
+   This program is free software: you can redistribute it and/or modify
+   it under the terms of the GNU General Public License as published by
+   the Free Software Foundation, either version 3 of the License, or
+   (at your option) any later version.
+
+   This program is distributed in the hope that it will be useful,
+   but WITHOUT ANY WARRANTY; without even the implied warranty of
+   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+   GNU General Public License for more details.
+
+   You should have received a copy of the GNU General Public License
+   along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+/*
+  parameter enumeration and lookup, with and without the parameter
+  index. The tree walk is forced by arming, as the index is then
+  neither built nor used once invalidated
+ */
+#include <AP_gbenchmark.h>
+
+#include <AP_Math/AP_Math.h>
+#include <AP_Param/AP_Param.h>
+
+const AP_HAL::HAL& hal = AP_HAL::get_HAL();
+
+#define NUM_GROUPS 32
+
+class BenchGroup {
+public:
+    static const struct AP_Param::GroupInfo var_info[];
+    AP_Int8 enable;
+    AP_Int16 rate;
+    AP_Int32 options;
+    AP_Float p[8];
+    AP_Vector3f ofs;
+    AP_Vector3f scale;
+};
+
+const AP_Param::GroupInfo BenchGroup::var_info[] = {
+    AP_GROUPINFO("ENABLE", 1, BenchGroup, enable, 1),
+    AP_GROUPINFO("RATE", 2, BenchGroup, rate, 50),
+    AP_GROUPINFO("OPTIONS", 3, BenchGroup, options, 0),
+    AP_GROUPINFO("P0", 4, BenchGroup, p[0], 0),
+    AP_GROUPINFO("P1", 5, BenchGroup, p[1], 0),
+    AP_GROUPINFO("P2", 6, BenchGroup, p[2], 0),
+    AP_GROUPINFO("P3", 7, BenchGroup, p[3], 0),
+    AP_GROUPINFO("P4", 8, BenchGroup, p[4], 0),
+    AP_GROUPINFO("P5", 9, BenchGroup, p[5], 0),
+    AP_GROUPINFO("P6", 10, BenchGroup, p[6], 0),
+    AP_GROUPINFO("P7", 11, BenchGroup, p[7], 0),
+    AP_GROUPINFO("OFS", 12, BenchGroup, ofs, 0),
+    AP_GROUPINFO("SCALE", 13, BenchGroup, scale, 1),
+    AP_GROUPEND
+};
+
+static AP_Int16 format_version;
+static BenchGroup groups[NUM_GROUPS];
+
+#define BENCH_GROUP(n, name) { name, (const void *)&groups[n], {group_info : BenchGroup::var_info}, 0, n+1, AP_PARAM_GROUP }
+
+static const AP_Param::Info var_info[] = {
+    { "FORMAT_VERSION", &format_version, {def_value : 0}, 0, 0, AP_PARAM_INT16 },
+    BENCH_GROUP(0, "GA_"), BENCH_GROUP(1, "GB_"), BENCH_GROUP(2, "GC_"), BENCH_GROUP(3, "GD_"),
+    BENCH_GROUP(4, "GE_"), BENCH_GROUP(5, "GF_"), BENCH_GROUP(6, "GG_"), BENCH_GROUP(7, "GH_"),
+    BENCH_GROUP(8, "GI_"), BENCH_GROUP(9, "GJ_"), BENCH_GROUP(10, "GK_"), BENCH_GROUP(11, "GL_"),
+    BENCH_GROUP(12, "GM_"), BENCH_GROUP(13, "GN_"), BENCH_GROUP(14, "GO_"), BENCH_GROUP(15, "GP_"),
+    BENCH_GROUP(16, "GQ_"), BENCH_GROUP(17, "GR_"), BENCH_GROUP(18, "GS_"), BENCH_GROUP(19, "GT_"),
+    BENCH_GROUP(20, "GU_"), BENCH_GROUP(21, "GV_"), BENCH_GROUP(22, "GW_"), BENCH_GROUP(23, "GX_"),
+    BENCH_GROUP(24, "GY_"), BENCH_GROUP(25, "GZ_"), BENCH_GROUP(26, "HA_"), BENCH_GROUP(27, "HB_"),
+    BENCH_GROUP(28, "HC_"), BENCH_GROUP(29, "HD_"), BENCH_GROUP(30, "HE_"), BENCH_GROUP(31, "HF_"),
+    AP_VAREND
+};
+
+static AP_Param param_loader{var_info};
+
+// state.range(0) selects the index (1) or the tree walk (0)
+static void setup_index(benchmark::State& state)
+{
+    hal.util->set_soft_armed(state.range(0) == 0);
+    AP_Param::invalidate_count();
+    // a lookup while disarmed builds the index
+    AP_Param::ParamToken token;
+    enum ap_var_type type;
+    AP_Param::find_by_index(0, &type, &token);
+}
+
+static void BM_ParamIterate(benchmark::State& state)
+{
+    setup_index(state);
+    while (state.KeepRunning()) {
+        AP_Param::ParamToken token {};
+        enum ap_var_type type;
+        uint16_t count = 0;
+        for (AP_Param *ap = AP_Param::first(&token, &type);
+             ap != nullptr;
+             ap = AP_Param::next_scalar(&token, &type)) {
+            count++;
+        }
+        gbenchmark_escape(&count);
+    }
+}
+
+static void BM_ParamFindByIndex(benchmark::State& state)
+{
+    setup_index(state);
+    const uint16_t count = AP_Param::count_parameters();
+    uint16_t i = 0;
+    while (state.KeepRunning()) {
+        AP_Param::ParamToken token;
+        enum ap_var_type type;
+        AP_Param *ap = AP_Param::find_by_index(i, &type, &token);
+        gbenchmark_escape(ap);
+        // stride through the list like PARAM_REQUEST_READ retries
+        i = (i + 97) % count;
+    }
+}
+
+static void BM_ParamFindByName(benchmark::State& state)
+{
+    setup_index(state);
+    while (state.KeepRunning()) {
+        AP_Param::ParamToken token;
+        enum ap_var_type type;
+        AP_Param *ap = AP_Param::find_by_name("HF_SCALE_Z", &type, &token);
+        gbenchmark_escape(ap);
+    }
+}
+
+static void BM_ParamFind(benchmark::State& state)
+{
+    setup_index(state);
+    while (state.KeepRunning()) {
+        enum ap_var_type type;
+        AP_Param *ap = AP_Param::find("GP_P7", &type);
+        gbenchmark_escape(ap);
+    }
+}
+
+BENCHMARK(BM_ParamIterate)->Arg(0)->Arg(1);
+BENCHMARK(BM_ParamFindByIndex)->Arg(0)->Arg(1);
+BENCHMARK(BM_ParamFindByName)->Arg(0)->Arg(1);
+BENCHMARK(BM_ParamFind)->Arg(0)->Arg(1);
+
+BENCHMARK_MAIN();
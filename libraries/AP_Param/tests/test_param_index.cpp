@@ -0,0 +1,213 @@
+#define AP_PARAM_VEHICLE_NAME testvehicle
+
+#include <AP_gtest.h>
+#include <AP_Math/AP_Math.h>
+#include <AP_Param/AP_Param.h>
+#include <AP_Vehicle/AP_Vehicle.h>
+
+const AP_HAL::HAL& hal = AP_HAL::get_HAL();
+
+class Parameters {
+public:
+    enum {
+        k_param_a,
+        k_param_b,
+        k_param_v,
+        k_param_grp,
+    };
+    AP_Int8 a;
+    AP_Float b;
+    AP_Vector3f v;
+};
+
+class TestGroup {
+public:
+    static const struct AP_Param::GroupInfo var_info[];
+    AP_Int16 rate;
+    AP_Float gain;
+    AP_Vector3f offs;
+};
+
+const AP_Param::GroupInfo TestGroup::var_info[] = {
+    AP_GROUPINFO("RATE", 1, TestGroup, rate, 50),
+    AP_GROUPINFO("GAIN", 2, TestGroup, gain, 0.5),
+    AP_GROUPINFO("OFFS", 3, TestGroup, offs, 0),
+    AP_GROUPEND
+};
+
+class TestVehicle : public AP_Vehicle {
+public:
+    friend class Test;
+
+    TestVehicle() { unused_log_bitmask.set(-1); }
+    // HAL::Callbacks implementation.
+    void load_parameters(void) override {};
+    void get_scheduler_tasks(const AP_Scheduler::Task *&tasks,
+                             uint8_t &task_count,
+                             uint32_t &log_bit) override {
+        tasks = nullptr;
+        task_count = 0;
+        log_bit = 0;
+    };
+
+    virtual bool set_mode(const uint8_t new_mode, const ModeReason reason) override { return true; }
+    virtual uint8_t get_mode() const override { return 0; }
+
+    AP_Int32 unused_log_bitmask; // logging is magic for Test; this is unused
+    struct LogStructure log_structure[256] = {
+    };
+
+protected:
+
+    const AP_Int32 &get_log_bitmask() override { return unused_log_bitmask; }
+    const struct LogStructure *get_log_structures() const override {
+        return log_structure;
+    }
+    uint8_t get_num_log_structures() const override {
+        return uint8_t(ARRAY_SIZE(log_structure));
+    }
+
+    void init_ardupilot() override {};
+
+public:
+
+    static const AP_Param::Info var_info[];
+
+    Parameters g;
+    TestGroup grp;
+    // setup the var_info table
+    AP_Param param_loader{var_info};
+
+};
+static TestVehicle testvehicle;
+
+const AP_Param::Info TestVehicle::var_info[] {
+    GSCALAR(a,         "A", 0),
+    GSCALAR(b,         "B", 0),
+    GSCALAR(v,         "V", 0),
+    GOBJECT(grp,       "GRP_", TestGroup),
+    AP_VAREND
+};
+
+static AP_Param *vector_element(AP_Vector3f &v, uint8_t i)
+{
+    return (AP_Param *)((ptrdiff_t)&v + i*sizeof(float));
+}
+
+// every parameter seen by iteration must be found by name, with the
+// same token, type and storage
+TEST(ParamIndex, FindByNameMatchesIteration)
+{
+    for (uint8_t pass=0; pass<2; pass++) {
+        AP_Param::ParamToken token {};
+        enum ap_var_type type;
+        uint16_t count = 0;
+        for (AP_Param *ap = AP_Param::first(&token, &type);
+             ap != nullptr;
+             ap = AP_Param::next_scalar(&token, &type)) {
+            char name[AP_MAX_NAME_SIZE+1] {};
+            ap->copy_name_token(token, name, AP_MAX_NAME_SIZE);
+            enum ap_var_type ptype = AP_PARAM_NONE;
+            AP_Param::ParamToken ftoken {};
+            EXPECT_EQ(AP_Param::find_by_name(name, &ptype, &ftoken), ap) << name;
+            EXPECT_EQ(ptype, type) << name;
+            EXPECT_EQ(uint32_t(ftoken.key), uint32_t(token.key)) << name;
+            EXPECT_EQ(uint32_t(ftoken.group_element), uint32_t(token.group_element)) << name;
+            EXPECT_EQ(uint32_t(ftoken.idx), uint32_t(token.idx)) << name;
+            count++;
+        }
+        EXPECT_EQ(count, AP_Param::count_parameters());
+        // the second pass runs against a rebuilt index
+        AP_Param::invalidate_count();
+    }
+}
+
+// index based access must give the same sequence as walking the tree
+TEST(ParamIndex, FindByIndexMatchesTreeWalk)
+{
+    struct {
+        AP_Param *ap;
+        AP_Param::ParamToken token;
+        enum ap_var_type type;
+    } walk[32];
+    uint16_t count = 0;
+
+    // the index is not built while armed, so this walks the tree
+    hal.util->set_soft_armed(true);
+    AP_Param::invalidate_count();
+    AP_Param::ParamToken token {};
+    enum ap_var_type type;
+    for (AP_Param *ap = AP_Param::first(&token, &type);
+         ap != nullptr && count < ARRAY_SIZE(walk);
+         ap = AP_Param::next_scalar(&token, &type)) {
+        walk[count].ap = ap;
+        walk[count].token = token;
+        walk[count].type = type;
+        count++;
+    }
+    hal.util->set_soft_armed(false);
+    ASSERT_EQ(count, AP_Param::count_parameters());
+
+    for (uint16_t i=0; i<count; i++) {
+        AP_Param::ParamToken itoken {};
+        enum ap_var_type itype = AP_PARAM_NONE;
+        EXPECT_EQ(AP_Param::find_by_index(i, &itype, &itoken), walk[i].ap);
+        EXPECT_EQ(itype, walk[i].type);
+        EXPECT_EQ(uint32_t(itoken.key), uint32_t(walk[i].token.key));
+        EXPECT_EQ(uint32_t(itoken.group_element), uint32_t(walk[i].token.group_element));
+        EXPECT_EQ(uint32_t(itoken.idx), uint32_t(walk[i].token.idx));
+
+        // stepping on from the token gives the next parameter
+        AP_Param *next = AP_Param::next_scalar(&itoken, &itype);
+        EXPECT_EQ(next, i+1 < count ? walk[i+1].ap : nullptr);
+    }
+    EXPECT_EQ(AP_Param::find_by_index(count, &type, &token), nullptr);
+}
+
+TEST(ParamIndex, Find)
+{
+    enum ap_var_type ptype;
+    uint16_t flags = 0xFFFF;
+    EXPECT_EQ(AP_Param::find("A", &ptype), &testvehicle.g.a);
+    EXPECT_EQ(ptype, AP_PARAM_INT8);
+    EXPECT_EQ(AP_Param::find("B", &ptype), &testvehicle.g.b);
+    EXPECT_EQ(ptype, AP_PARAM_FLOAT);
+    EXPECT_EQ(AP_Param::find("GRP_RATE", &ptype, &flags), &testvehicle.grp.rate);
+    EXPECT_EQ(ptype, AP_PARAM_INT16);
+    EXPECT_EQ(flags, 0);
+    EXPECT_EQ(AP_Param::find("GRP_GAIN", &ptype), &testvehicle.grp.gain);
+    EXPECT_EQ(ptype, AP_PARAM_FLOAT);
+    EXPECT_EQ(AP_Param::find("GRP_OFFS_Z", &ptype), vector_element(testvehicle.grp.offs, 2));
+    EXPECT_EQ(ptype, AP_PARAM_FLOAT);
+
+    // whole vectors and top level vector elements keep the behaviour
+    // of the linear search
+    EXPECT_EQ(AP_Param::find("V", &ptype), &testvehicle.g.v);
+    EXPECT_EQ(ptype, AP_PARAM_VECTOR3F);
+    EXPECT_EQ(AP_Param::find("V_X", &ptype), nullptr);
+
+    EXPECT_EQ(AP_Param::find("GRP_NONE", &ptype), nullptr);
+    EXPECT_EQ(AP_Param::find("", &ptype), nullptr);
+}
+
+TEST(ParamIndex, FindByName)
+{
+    enum ap_var_type ptype;
+    AP_Param::ParamToken token;
+    EXPECT_EQ(AP_Param::find_by_name("grp_gain", &ptype, &token), &testvehicle.grp.gain);
+    EXPECT_EQ(AP_Param::find_by_name("V_Y", &ptype, &token), vector_element(testvehicle.g.v, 1));
+    EXPECT_EQ(ptype, AP_PARAM_FLOAT);
+    EXPECT_EQ(AP_Param::find_by_name("GRP_OFFS_X", &ptype, &token), vector_element(testvehicle.grp.offs, 0));
+    EXPECT_EQ(uint32_t(token.idx), 1U);
+    EXPECT_EQ(AP_Param::find_by_name("NOPE", &ptype, &token), nullptr);
+}
+
+TEST(ParamIndex, FindObject)
+{
+    EXPECT_EQ(AP_Param::find_object("GRP_"), (AP_Param *)&testvehicle.grp);
+    EXPECT_EQ(AP_Param::find_object("grp_"), (AP_Param *)&testvehicle.grp);
+    EXPECT_EQ(AP_Param::find_object("A"), &testvehicle.g.a);
+    EXPECT_EQ(AP_Param::find_object("GRP"), nullptr);
+}
+
+AP_GTEST_MAIN()
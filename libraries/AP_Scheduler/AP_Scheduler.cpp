@@ -33,6 +33,7 @@
 #include <AP_InternalError/AP_InternalError.h>
 #include <AP_Common/ExpandingString.h>
 #include <AP_HAL/SIMState.h>
+#include <AP_HAL/utility/Trace.h>
 #include <AP_Vehicle/AP_Vehicle_Type.h>
 
 #if CONFIG_HAL_BOARD == HAL_BOARD_SITL
@@ -70,7 +71,7 @@ const AP_Param::GroupInfo AP_Scheduler::var_info[] = {
     // @Param: OPTIONS
     // @DisplayName: Scheduling options
     // @Description: This controls optional aspects of the scheduler.
-    // @Bitmask: 0:Enable per-task perf info
+    // @Bitmask: 0:Enable per-task perf info, 1:Enable per-task latency histograms, 2:Enable timeline trace recording (SITL and Linux only), 3:Enable adaptive task budgeting
     // @User: Advanced
     AP_GROUPINFO("OPTIONS",  2, AP_Scheduler, _options, 0),
 
@@ -141,6 +142,15 @@ void AP_Scheduler::init(const AP_Scheduler::Task *tasks, uint8_t num_tasks, uint
     if (_options & uint8_t(Options::RECORD_TASK_INFO)) {
         perf_info.allocate_task_info(_num_tasks);
     }
+    if (_options & uint8_t(Options::RECORD_TASK_LATENCY)) {
+        perf_info.allocate_task_latency(_num_tasks);
+    }
+#if AP_HAL_TRACE_ENABLED
+    AP_HAL::Trace::set_enabled(_options & uint8_t(Options::RECORD_TRACE));
+#endif
+    if (_options & uint8_t(Options::ADAPTIVE_BUDGET)) {
+        allocate_task_cost();
+    }
 
     _log_performance_bit = log_performance_bit;
 
@@ -183,6 +193,103 @@ static void fill_nanf_stack(void)
 }
 #endif
 
+// allocate the learned task cost table used for adaptive budgeting
+void AP_Scheduler::allocate_task_cost()
+{
+    _task_cost = NEW_NOTHROW TaskCost[_num_tasks];
+    if (_task_cost == nullptr) {
+        DEV_PRINTF("Unable to allocate scheduler TaskCost\n");
+    }
+}
+
+void AP_Scheduler::free_task_cost()
+{
+    delete[] _task_cost;
+    _task_cost = nullptr;
+}
+
+/*
+  update the learned cost of a task after it has run. The filter is
+  slow enough that a single long run does not cause the task to be
+  deferred, but fast enough to follow changes in load
+ */
+void AP_Scheduler::update_task_cost(uint8_t task_index, uint32_t time_taken)
+{
+    TaskCost &cost = _task_cost[task_index];
+    if (is_zero(cost.mean_us)) {
+        // a zero mean marks an unmeasured task
+        cost.mean_us = MAX(time_taken, 1U);
+        cost.dev_us = 0;
+        return;
+    }
+    const float err = time_taken - cost.mean_us;
+    cost.mean_us += 0.125f * err;
+    cost.dev_us += 0.125f * (fabsf(err) - cost.dev_us);
+}
+
+/*
+  predicted time a task will take. Until a task has been measured we
+  trust its table entry, after that we use the learned mean plus three
+  times the mean absolute deviation to cover the bulk of its run time
+  distribution
+ */
+uint32_t AP_Scheduler::predicted_cost_us(uint8_t task_index, const Task &task) const
+{
+    if (_task_cost == nullptr || is_zero(_task_cost[task_index].mean_us)) {
+        return task.max_time_micros;
+    }
+    const TaskCost &cost = _task_cost[task_index];
+    return uint32_t(cost.mean_us + 3 * cost.dev_us + 0.5f);
+}
+
+uint32_t AP_Scheduler::get_interval_ticks(const Task &task) const
+{
+    // we allow 0 to mean loop rate
+    const uint32_t ticks = (is_zero(task.rate_hz) ? 1 : _loop_rate_hz / task.rate_hz);
+    return MAX(ticks, 1U);
+}
+
+const AP_Scheduler::Task *AP_Scheduler::next_task(uint8_t &vehicle_tasks_offset, uint8_t &common_tasks_offset) const
+{
+    // In case of a priority tie the vehicle-specific entry wins
+    if (vehicle_tasks_offset < _num_vehicle_tasks &&
+        (common_tasks_offset >= _num_common_tasks ||
+         _vehicle_tasks[vehicle_tasks_offset].priority <= _common_tasks[common_tasks_offset].priority)) {
+        return &_vehicle_tasks[vehicle_tasks_offset++];
+    }
+    if (common_tasks_offset < _num_common_tasks) {
+        return &_common_tasks[common_tasks_offset++];
+    }
+    return nullptr;
+}
+
+/*
+  work out how much of this loop must be kept for the fast tasks and
+  for tasks that have slipped so far they must run now. Other tasks
+  are only started if their predicted cost fits around this
+ */
+uint32_t AP_Scheduler::reserved_time_us() const
+{
+    uint32_t reserved_us = 0;
+    uint8_t vehicle_tasks_offset = 0;
+    uint8_t common_tasks_offset = 0;
+    for (uint8_t i=0; i<_num_tasks; i++) {
+        const Task *task = next_task(vehicle_tasks_offset, common_tasks_offset);
+        if (task == nullptr) {
+            break;
+        }
+        if (task->priority <= MAX_FAST_TASK_PRIORITIES) {
+            reserved_us += predicted_cost_us(i, *task);
+            continue;
+        }
+        const uint16_t dt = _tick_counter - _last_run[i];
+        if (dt >= get_interval_ticks(*task)*max_task_slowdown) {
+            reserved_us += predicted_cost_us(i, *task);
+        }
+    }
+    return reserved_us;
+}
+
 /*
   run one tick
   this will run as many scheduler tasks as we can in the specified time
@@ -192,6 +299,13 @@ void AP_Scheduler::run(uint32_t time_available)
     uint32_t run_started_usec = AP_HAL::micros();
     uint32_t now = run_started_usec;
 
+    // with adaptive budgeting, time predicted for tasks that must run
+    // later in this loop and have not yet run
+    uint32_t reserved_us = 0;
+    if (_task_cost != nullptr) {
+        reserved_us = reserved_time_us();
+    }
+
     uint8_t vehicle_tasks_offset = 0;
     uint8_t common_tasks_offset = 0;
 
@@ -227,13 +341,13 @@ void AP_Scheduler::run(uint32_t time_available)
             common_tasks_offset++;
         }
 
+        // number of whole loops this task has been held back beyond
+        // its intended slot
+        uint32_t slot_delay_ticks = 0;
+
         if (task.priority > MAX_FAST_TASK_PRIORITIES) {
             const uint16_t dt = _tick_counter - _last_run[i];
-            // we allow 0 to mean loop rate
-            uint32_t interval_ticks = (is_zero(task.rate_hz) ? 1 : _loop_rate_hz / task.rate_hz);
-            if (interval_ticks < 1) {
-                interval_ticks = 1;
-            }
+            const uint32_t interval_ticks = get_interval_ticks(task);
             if (dt < interval_ticks) {
                 // this task is not yet scheduled to run again
                 continue;
@@ -245,28 +359,51 @@ void AP_Scheduler::run(uint32_t time_available)
                 perf_info.task_slipped(i);
             }
 
-            if (dt >= interval_ticks*max_task_slowdown) {
+            const bool starved = dt >= interval_ticks*max_task_slowdown;
+            if (starved) {
                 // we are going beyond the maximum slowdown factor for a
                 // task. This will trigger increasing the time budget
                 task_not_achieved++;
             }
 
-            if (_task_time_allowed > time_available) {
+            if (_task_cost != nullptr) {
+                // adaptive budgeting: pack tasks by their learned cost,
+                // deferring this one if it would eat into the time
+                // kept for fast and starved tasks later in the table
+                const uint32_t predicted_us = predicted_cost_us(i, task);
+                if (starved) {
+                    reserved_us -= MIN(predicted_us, reserved_us);
+                }
+                const uint32_t needed_us = starved ? predicted_us : predicted_us + reserved_us;
+                if (needed_us > time_available) {
+                    continue;
+                }
+            } else if (_task_time_allowed > time_available) {
                 // not enough time to run this task.  Continue loop -
                 // maybe another task will fit into time remaining
                 continue;
             }
+            slot_delay_ticks = dt - interval_ticks;
         } else {
             _task_time_allowed = get_loop_period_us();
+            if (_task_cost != nullptr) {
+                reserved_us -= MIN(predicted_cost_us(i, task), reserved_us);
+            }
         }
 
+        // start time jitter relative to the start of the loop in
+        // which the task was due
+        const uint32_t jitter_us = slot_delay_ticks * get_loop_period_us() + (now - uint32_t(_loop_sample_time_us));
+
         // run it
         _task_time_started = now;
         hal.util->persistent_data.scheduler_task = i;
 #if CONFIG_HAL_BOARD == HAL_BOARD_SITL
         fill_nanf_stack();
 #endif
+        HAL_TRACE_BEGIN(task.name);
         task.function();
+        HAL_TRACE_END(task.name);
         hal.util->persistent_data.scheduler_task = -1;
 
         // record the tick counter when we ran. This drives
@@ -287,7 +424,11 @@ void AP_Scheduler::run(uint32_t time_available)
                   (unsigned)_task_time_allowed);
         }
 
-        perf_info.update_task_info(i, time_taken, overrun);
+        perf_info.update_task_info(i, time_taken, overrun, jitter_us);
+
+        if (_task_cost != nullptr) {
+            update_task_cost(i, time_taken);
+        }
 
         if (time_taken >= time_available) {
             /*
@@ -349,7 +490,9 @@ void AP_Scheduler::loop()
     // wait for an INS sample
     hal.util->persistent_data.scheduler_task = -3;
     _rsem.give();
+    HAL_TRACE_BEGIN("wait_for_sample");
     AP::ins().wait_for_sample();
+    HAL_TRACE_END("wait_for_sample");
     _rsem.take_blocking();
     hal.util->persistent_data.scheduler_task = -1;
 
@@ -438,6 +581,7 @@ void AP_Scheduler::update_logging()
     if (_log_performance_bit != (uint32_t)-1 &&
         AP::logger().should_log(_log_performance_bit)) {
         Log_Write_Performance();
+        Log_Write_TaskLatency();
     }
     perf_info.set_loop_rate(get_loop_rate_hz());
     perf_info.reset();
@@ -447,6 +591,19 @@ void AP_Scheduler::update_logging()
     } else if ((_options & uint8_t(Options::RECORD_TASK_INFO)) && !perf_info.has_task_info()) {
         perf_info.allocate_task_info(_num_tasks);
     }
+    if (!(_options & uint8_t(Options::RECORD_TASK_LATENCY)) && perf_info.has_task_latency()) {
+        perf_info.free_task_latency();
+    } else if ((_options & uint8_t(Options::RECORD_TASK_LATENCY)) && !perf_info.has_task_latency()) {
+        perf_info.allocate_task_latency(_num_tasks);
+    }
+#if AP_HAL_TRACE_ENABLED
+    AP_HAL::Trace::set_enabled(_options & uint8_t(Options::RECORD_TRACE));
+#endif
+    if (!(_options & uint8_t(Options::ADAPTIVE_BUDGET)) && _task_cost != nullptr) {
+        free_task_cost();
+    } else if ((_options & uint8_t(Options::ADAPTIVE_BUDGET)) && _task_cost == nullptr) {
+        allocate_task_cost();
+    }
 }
 
 // Write a performance monitoring packet
@@ -478,13 +635,58 @@ void AP_Scheduler::Log_Write_Performance()
     };
     AP::logger().WriteCriticalBlock(&pkt, sizeof(pkt));
 }
+
+// Write per-task latency percentiles, plus one entry for the whole loop
+void AP_Scheduler::Log_Write_TaskLatency()
+{
+    if (!perf_info.has_task_latency()) {
+        return;
+    }
+    const uint64_t now_us = AP_HAL::micros64();
+
+    struct log_TaskLatency pkt = {
+        LOG_PACKET_HEADER_INIT(LOG_TASK_LATENCY_MSG),
+        time_us : now_us,
+        id      : UINT8_MAX,
+    };
+    const AP::PerfInfo::LatencyHistogram &loop_latency = perf_info.get_loop_latency();
+    pkt.p50 = loop_latency.percentile(500);
+    pkt.p99 = loop_latency.percentile(990);
+    pkt.p999 = loop_latency.percentile(999);
+    pkt.max_jitter = MIN(perf_info.get_max_loop_jitter(), uint32_t(UINT16_MAX));
+    strncpy_noterm(pkt.name, "loop", sizeof(pkt.name));
+    AP::logger().WriteBlock(&pkt, sizeof(pkt));
+
+    uint8_t vehicle_tasks_offset = 0;
+    uint8_t common_tasks_offset = 0;
+    for (uint8_t i = 0; i < _num_tasks; i++) {
+        const Task *task = next_task(vehicle_tasks_offset, common_tasks_offset);
+        if (task == nullptr) {
+            break;
+        }
+
+        const AP::PerfInfo::LatencyHistogram *latency = perf_info.get_task_latency(i);
+        if (latency == nullptr || latency->count() == 0) {
+            continue;
+        }
+        const AP::PerfInfo::TaskInfo *ti = perf_info.get_task_info(i);
+        pkt.id = i;
+        pkt.p50 = latency->percentile(500);
+        pkt.p99 = latency->percentile(990);
+        pkt.p999 = latency->percentile(999);
+        pkt.max_jitter = ti != nullptr ? ti->max_jitter_us : 0;
+        memset(pkt.name, 0, sizeof(pkt.name));
+        strncpy_noterm(pkt.name, task->name, sizeof(pkt.name));
+        AP::logger().WriteBlock(&pkt, sizeof(pkt));
+    }
+}
 #endif  // HAL_LOGGING_ENABLED
 
 // display task statistics as text buffer for @SYS/tasks.txt
 void AP_Scheduler::task_info(ExpandingString &str)
 {
     // a header to allow for machine parsers to determine format
-    str.printf("TasksV2\n");
+    str.printf("TasksV3\n");
 
     // dynamically enable statistics collection
     if (!(_options & uint8_t(Options::RECORD_TASK_INFO))) {
@@ -496,6 +698,17 @@ void AP_Scheduler::task_info(ExpandingString &str)
         return;
     }
 
+    // whole-loop statistics
+    str.printf("LOOP JMX=%5u", unsigned(perf_info.get_max_loop_jitter()));
+    if (perf_info.has_task_latency()) {
+        const AP::PerfInfo::LatencyHistogram &loop_latency = perf_info.get_loop_latency();
+        str.printf(" P50=%5u P99=%5u P999=%5u",
+                   unsigned(loop_latency.percentile(500)),
+                   unsigned(loop_latency.percentile(990)),
+                   unsigned(loop_latency.percentile(999)));
+    }
+    str.printf("\n");
+
     // baseline the total time taken by all tasks
     float total_time = 1.0f;
     for (uint8_t i = 0; i < _num_tasks + 1; i++) {
@@ -542,7 +755,7 @@ void AP_Scheduler::task_info(ExpandingString &str)
             task_name = _common_tasks[common_tasks_offset++].name;
         }
 
-        ti->print(task_name, total_time, str);
+        ti->print(task_name, total_time, perf_info.get_task_latency(i), str);
     }
 }
 
@@ -93,7 +93,10 @@ public:
     };
 
     enum class Options : uint8_t {
-        RECORD_TASK_INFO = 1 << 0
+        RECORD_TASK_INFO = 1 << 0,
+        RECORD_TASK_LATENCY = 1 << 1,
+        RECORD_TRACE = 1 << 2,
+        ADAPTIVE_BUDGET = 1 << 3,
     };
 
     enum FastTaskPriorities {
@@ -116,6 +119,9 @@ public:
     // write out PERF message to logger
     void Log_Write_Performance();
 
+    // write out per-task latency percentiles to logger
+    void Log_Write_TaskLatency();
+
     // call when one tick has passed
     void tick(void);
 
@@ -273,6 +279,34 @@ private:
 
     // semaphore that is held while not waiting for ins samples
     HAL_Semaphore _rsem;
+
+    /*
+      learned run time of each task, used for adaptive budgeting.
+      mean and mean absolute deviation are low pass filtered
+     */
+    struct TaskCost {
+        float mean_us;
+        float dev_us;
+    };
+    TaskCost *_task_cost;
+
+    void allocate_task_cost();
+    void free_task_cost();
+    void update_task_cost(uint8_t task_index, uint32_t time_taken);
+
+    // predicted time a task will take to run
+    uint32_t predicted_cost_us(uint8_t task_index, const Task &task) const;
+
+    // return the number of ticks between runs of a task
+    uint32_t get_interval_ticks(const Task &task) const;
+
+    // return the next task in priority order, merging the vehicle and
+    // common task lists. Returns nullptr when both are exhausted
+    const Task *next_task(uint8_t &vehicle_tasks_offset, uint8_t &common_tasks_offset) const;
+
+    // total predicted time of the fast tasks and of the tasks which
+    // have reached max_task_slowdown, which must run this loop
+    uint32_t reserved_time_us() const;
 };
 
 namespace AP {
@@ -31,6 +31,7 @@ void AP::PerfInfo::reset()
     long_running = 0;
     sigma_time = 0;
     sigmasquared_time = 0;
+    max_loop_jitter_us = 0;
     if (_task_info != nullptr) {
         memset(_task_info, 0, (_num_tasks) * sizeof(TaskInfo));
     }
@@ -61,22 +62,46 @@ void AP::PerfInfo::free_task_info()
     _num_tasks = 0;
 }
 
-// called after each run of a task to update its statistics based on measurements taken by the scheduler
-void AP::PerfInfo::update_task_info(uint8_t task_index, uint16_t task_time_us, bool overrun)
+// allocate the per-task latency histograms. These are kept separately
+// from the TaskInfo array as they accumulate across reset() calls
+void AP::PerfInfo::allocate_task_latency(uint8_t num_tasks)
 {
-    if (_task_info == nullptr) {
+    _task_latency = NEW_NOTHROW LatencyHistogram[num_tasks];
+    if (_task_latency == nullptr) {
+        DEV_PRINTF("Unable to allocate scheduler latency histograms\n");
+        _num_latency_tasks = 0;
         return;
     }
+    _num_latency_tasks = num_tasks;
+    loop_latency.reset();
+}
 
-    if (task_index >= _num_tasks) {
-        INTERNAL_ERROR(AP_InternalError::error_t::flow_of_control);
-        return;
+void AP::PerfInfo::free_task_latency()
+{
+    delete[] _task_latency;
+    _task_latency = nullptr;
+    _num_latency_tasks = 0;
+}
+
+// called after each run of a task to update its statistics based on measurements taken by the scheduler
+void AP::PerfInfo::update_task_info(uint8_t task_index, uint16_t task_time_us, bool overrun, uint32_t jitter_us)
+{
+    // task info and latency histograms are enabled independently
+    if (_task_info != nullptr) {
+        if (task_index >= _num_tasks) {
+            INTERNAL_ERROR(AP_InternalError::error_t::flow_of_control);
+            return;
+        }
+        TaskInfo& ti = _task_info[task_index];
+        ti.update(task_time_us, overrun, jitter_us);
+    }
+
+    if (_task_latency != nullptr && task_index < _num_latency_tasks) {
+        _task_latency[task_index].add(task_time_us);
     }
-    TaskInfo& ti = _task_info[task_index];
-    ti.update(task_time_us, overrun);
 }
 
-void AP::PerfInfo::TaskInfo::update(uint16_t task_time_us, bool overrun)
+void AP::PerfInfo::TaskInfo::update(uint16_t task_time_us, bool overrun, uint32_t jitter_us)
 {
     max_time_us = MAX(max_time_us, task_time_us);
     if (min_time_us == 0) {
@@ -89,24 +114,104 @@ void AP::PerfInfo::TaskInfo::update(uint16_t task_time_us, bool overrun)
     if (overrun) {
         overrun_count++;
     }
+    max_jitter_us = MIN(MAX(uint32_t(max_jitter_us), jitter_us), uint32_t(UINT16_MAX));
+    jitter_time_us += jitter_us;
 }
 
-void AP::PerfInfo::TaskInfo::print(const char* task_name, uint32_t total_time, ExpandingString& str) const
+void AP::PerfInfo::TaskInfo::print(const char* task_name, uint32_t total_time, const LatencyHistogram *latency, ExpandingString& str) const
 {
     uint16_t avg = 0;
+    uint16_t jitter_avg = 0;
     float pct = 0.0f;
     if (tick_count > 0) {
         pct = elapsed_time_us * 100.0f / total_time;
         avg = MIN(uint16_t(elapsed_time_us / tick_count), 9999);
+        jitter_avg = MIN(jitter_time_us / tick_count, 9999U);
     }
 #if AP_SCHEDULER_EXTENDED_TASKINFO_ENABLED
-    const char* fmt = "%-32.32s MIN=%4u MAX=%4u AVG=%4u OVR=%3u SLP=%3u, TOT=%4.1f%%\n";
+    const char* fmt = "%-32.32s MIN=%4u MAX=%4u AVG=%4u OVR=%3u SLP=%3u, TOT=%4.1f%% JAV=%4u JMX=%5u";
 #else
-    const char* fmt = "%-16.16s MIN=%4u MAX=%4u AVG=%4u OVR=%3u SLP=%3u, TOT=%4.1f%%\n";
+    const char* fmt = "%-16.16s MIN=%4u MAX=%4u AVG=%4u OVR=%3u SLP=%3u, TOT=%4.1f%% JAV=%4u JMX=%5u";
 #endif
     str.printf(fmt, task_name,
                 unsigned(MIN(min_time_us, 9999)), unsigned(MIN(max_time_us, 9999)), unsigned(avg),
-                unsigned(MIN(overrun_count, 999)), unsigned(MIN(slip_count, 999)), pct);
+                unsigned(MIN(overrun_count, 999)), unsigned(MIN(slip_count, 999)), pct,
+                unsigned(jitter_avg), unsigned(max_jitter_us));
+    if (latency != nullptr) {
+        str.printf(" P50=%5u P99=%5u P999=%5u",
+                   unsigned(latency->percentile(500)),
+                   unsigned(latency->percentile(990)),
+                   unsigned(latency->percentile(999)));
+    }
+    str.printf("\n");
+}
+
+/*
+  map a time to a histogram bucket. Times of 0 and 1us map directly,
+  above that the two bits below the most significant bit select one
+  of two buckets per power of two
+ */
+uint8_t AP::PerfInfo::LatencyHistogram::bucket_index(uint32_t time_us)
+{
+    if (time_us < 2) {
+        return time_us;
+    }
+    if (time_us > UINT16_MAX) {
+        return NUM_BUCKETS - 1;
+    }
+    const uint8_t msb = 31 - __builtin_clz(time_us);
+    const uint8_t sub = (time_us >> (msb - 1)) & 1U;
+    return msb * 2 + sub;
+}
+
+// return the largest time which maps to the given bucket
+uint32_t AP::PerfInfo::LatencyHistogram::bucket_upper_us(uint8_t idx)
+{
+    if (idx < 2) {
+        return idx;
+    }
+    const uint8_t msb = idx / 2;
+    const uint32_t half = 1U << (msb - 1);
+    return (1U << msb) + (idx & 1U) * half + half - 1;
+}
+
+void AP::PerfInfo::LatencyHistogram::add(uint32_t time_us)
+{
+    const uint8_t idx = bucket_index(time_us);
+    if (bucket[idx] == UINT16_MAX) {
+        // decay the whole histogram rather than losing its shape
+        for (uint8_t i = 0; i < NUM_BUCKETS; i++) {
+            bucket[i] /= 2;
+        }
+    }
+    bucket[idx]++;
+}
+
+uint32_t AP::PerfInfo::LatencyHistogram::count() const
+{
+    uint32_t total = 0;
+    for (uint8_t i = 0; i < NUM_BUCKETS; i++) {
+        total += bucket[i];
+    }
+    return total;
+}
+
+uint32_t AP::PerfInfo::LatencyHistogram::percentile(uint16_t per_mille) const
+{
+    const uint32_t total = count();
+    if (total == 0) {
+        return 0;
+    }
+    // number of samples at or below the requested percentile, rounded up
+    const uint32_t target = MAX(uint32_t((uint64_t(total) * per_mille + 999) / 1000), 1U);
+    uint32_t sum = 0;
+    for (uint8_t i = 0; i < NUM_BUCKETS; i++) {
+        sum += bucket[i];
+        if (sum >= target) {
+            return bucket_upper_us(i);
+        }
+    }
+    return bucket_upper_us(NUM_BUCKETS - 1);
 }
 
 // check_loop_time - check latest loop time vs min, max and overtime threshold
@@ -132,6 +237,17 @@ void AP::PerfInfo::check_loop_time(uint32_t time_in_micros)
     sigma_time += time_in_micros;
     sigmasquared_time += time_in_micros * time_in_micros;
 
+    // track the whole-loop time distribution and how far each loop
+    // strays from the nominal period
+    if (_task_latency != nullptr) {
+        loop_latency.add(time_in_micros);
+    }
+    if (loop_rate_hz > 0) {
+        const uint32_t period_us = 1000000UL / loop_rate_hz;
+        const uint32_t jitter_us = time_in_micros > period_us ? time_in_micros - period_us : period_us - time_in_micros;
+        max_loop_jitter_us = MAX(max_loop_jitter_us, jitter_us);
+    }
+
     /* we keep a filtered loop time for use as G_Dt which is the
        predicted time for the next loop. We remove really excessive
        times from this calculation so as not to throw it off too far
@@ -5,6 +5,7 @@
 #if AP_SCHEDULER_ENABLED
 
 #include <stdint.h>
+#include <string.h>
 #include <AP_Common/ExpandingString.h>
 
 namespace AP {
@@ -13,6 +14,35 @@ class PerfInfo {
 public:
     PerfInfo() {}
 
+    /*
+      fixed-memory log-linear latency histogram. Values below 2us get
+      their own bucket, above that there are two buckets per power of
+      two, covering up to 65535us. Counts are halved when any bucket
+      saturates, so the histogram never needs resetting and keeps the
+      shape of the distribution over long runs
+     */
+    class LatencyHistogram {
+    public:
+        static constexpr uint8_t NUM_BUCKETS = 32;
+
+        void add(uint32_t time_us);
+        void reset() { memset(bucket, 0, sizeof(bucket)); }
+
+        // total number of samples currently held
+        uint32_t count() const;
+
+        // return the upper bound in microseconds of the bucket
+        // containing the given percentile, expressed in tenths of a
+        // percent (e.g. 990 for p99, 999 for p99.9)
+        uint32_t percentile(uint16_t per_mille) const;
+
+    private:
+        static uint8_t bucket_index(uint32_t time_us);
+        static uint32_t bucket_upper_us(uint8_t idx);
+
+        uint16_t bucket[NUM_BUCKETS];
+    };
+
     // per-task timing information
     struct TaskInfo {
         uint16_t min_time_us;
@@ -21,9 +51,13 @@ public:
         uint32_t tick_count;
         uint16_t slip_count;
         uint16_t overrun_count;
+        // delay between the start of the loop the task was due in and
+        // the time it actually started
+        uint16_t max_jitter_us;
+        uint32_t jitter_time_us;
 
-        void update(uint16_t task_time_us, bool overrun);
-        void print(const char* task_name, uint32_t total_time, ExpandingString& str) const;
+        void update(uint16_t task_time_us, bool overrun, uint32_t jitter_us);
+        void print(const char* task_name, uint32_t total_time, const LatencyHistogram *latency, ExpandingString& str) const;
     };
 
     /* Do not allow copies */
@@ -40,6 +74,8 @@ public:
     uint32_t get_stddev_time() const;
     float    get_filtered_time() const;
     float get_filtered_loop_rate_hz() const;
+    uint32_t get_max_loop_jitter() const { return max_loop_jitter_us; }
+    const LatencyHistogram &get_loop_latency() const { return loop_latency; }
     void set_loop_rate(uint16_t rate_hz);
 
     void update_logging() const;
@@ -53,8 +89,15 @@ public:
     const TaskInfo* get_task_info(uint8_t task_index) const {
         return (_task_info && task_index < _num_tasks) ? &_task_info[task_index] : nullptr;
     }
+    // allocate the per-task latency histograms
+    void allocate_task_latency(uint8_t num_tasks);
+    void free_task_latency();
+    bool has_task_latency() const { return _task_latency != nullptr; }
+    const LatencyHistogram* get_task_latency(uint8_t task_index) const {
+        return (_task_latency && task_index < _num_latency_tasks) ? &_task_latency[task_index] : nullptr;
+    }
     // called after each run of a task to update its statistics based on measurements taken by the scheduler
-    void update_task_info(uint8_t task_index, uint16_t task_time_us, bool overrun);
+    void update_task_info(uint8_t task_index, uint16_t task_time_us, bool overrun, uint32_t jitter_us);
     // record that a task slipped
     void task_slipped(uint8_t task_index) {
         if (_task_info && task_index < _num_tasks) {
@@ -74,9 +117,15 @@ private:
     uint32_t last_check_us;
     float filtered_loop_time;
     bool ignore_loop;
+    // deviation of loop time from the nominal loop period
+    uint32_t max_loop_jitter_us;
+    // distribution of loop times, not cleared by reset()
+    LatencyHistogram loop_latency;
     // performance monitoring
     uint8_t _num_tasks;
     TaskInfo* _task_info;
+    uint8_t _num_latency_tasks;
+    LatencyHistogram* _task_latency;
 };
 
 };
@@ -85,6 +85,16 @@ const AP_Param::GroupInfo AP_Terrain::var_info[] = {
     // @User: Advanced
     AP_GROUPINFO("CACHE_SZ",  5, AP_Terrain, config_cache_size, TERRAIN_GRID_BLOCK_CACHE_SIZE),
 
+#if AP_TERRAIN_L2_CACHE_ENABLED
+    // @Param: L2_CACHE
+    // @DisplayName: Terrain second level cache size
+    // @Description: The number of 32x28 blocks to keep in memory after they drop out of the main cache, saving a read from the SD card when they are next needed. Each block uses about 1800 bytes of memory. The TERC log message shows how often blocks are found in each cache
+    // @Range: 0 2048
+    // @User: Advanced
+    // @RebootRequired: True
+    AP_GROUPINFO("L2_CACHE",  6, AP_Terrain, config_cache_l2_size, TERRAIN_GRID_BLOCK_CACHE_L2_SIZE),
+#endif
+
     AP_GROUPEND
 };
 
@@ -394,6 +404,13 @@ void AP_Terrain::update(void)
         have_surrounding_tiles = false;
     }
 
+#if AP_TERRAIN_PREFETCH_ENABLED
+    // and the tiles ahead of us
+    if (pos_valid) {
+        update_prefetch(loc);
+    }
+#endif
+
     // update capabilities and status
     if (allocate()) {
         if (!pos_valid) {
@@ -482,6 +499,34 @@ void AP_Terrain::log_terrain_data()
         reference_offset : have_reference_offset?reference_offset:0,
     };
     AP::logger().WriteBlock(&pkt, sizeof(pkt));
+
+    // @LoggerMessage: TERC
+    // @Description: Terrain grid cache statistics
+    // @Field: TimeUS: Time since system startup
+    // @Field: Hit: lookups found in the main cache
+    // @Field: L2Hit: lookups found in the second level cache
+    // @Field: Miss: lookups that needed a disk read
+    // @Field: Pf: blocks loaded by the prefetcher
+    // @Field: PfHit: prefetched blocks that were later used
+    // @Field: Rd: completed disk reads
+    // @Field: RdAvg: average time from request to completion of a disk read
+    // @Field: RdMax: maximum time from request to completion of a disk read
+    const CacheStats &stats = cache_stats;
+    AP::logger().WriteStreaming(
+        "TERC",
+        "TimeUS,Hit,L2Hit,Miss,Pf,PfHit,Rd,RdAvg,RdMax",
+        "s------ss",
+        "F------CC",
+        "QIIIIIIfI",
+        AP_HAL::micros64(),
+        stats.hits,
+        stats.l2_hits,
+        stats.misses,
+        stats.prefetches,
+        stats.prefetch_hits,
+        stats.disk_reads,
+        stats.disk_reads > 0 ? float(stats.read_time_total_ms) / stats.disk_reads : 0.0f,
+        stats.read_time_max_ms);
 }
 #endif
 
@@ -504,6 +549,17 @@ bool AP_Terrain::allocate(void)
         return false;
     }
     cache_size = config_cache_size;
+
+#if AP_TERRAIN_L2_CACHE_ENABLED
+    // the second level cache is optional, so failing to allocate it
+    // is not an error
+    if (config_cache_l2_size > 0) {
+        cache_l2 = (struct grid_cache *)calloc(config_cache_l2_size, sizeof(cache_l2[0]));
+        if (cache_l2 != nullptr) {
+            cache_l2_size = config_cache_l2_size;
+        }
+    }
+#endif
     return true;
 }
 
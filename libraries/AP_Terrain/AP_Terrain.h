@@ -50,6 +50,23 @@
 #define TERRAIN_GRID_BLOCK_CACHE_SIZE 12
 #endif
 
+// default number of grid_blocks in the second level cache
+#ifndef TERRAIN_GRID_BLOCK_CACHE_L2_SIZE
+#define TERRAIN_GRID_BLOCK_CACHE_L2_SIZE 256
+#endif
+
+// the prefetcher fetches the blocks needed for this many seconds of
+// travel, at most TERRAIN_PREFETCH_MAX_BLOCKS blocks per pass
+#define TERRAIN_PREFETCH_TIME_S 30
+#define TERRAIN_PREFETCH_INTERVAL_MS 1000
+#define TERRAIN_PREFETCH_MAX_BLOCKS 4
+#define TERRAIN_PREFETCH_MIN_SPEED 2
+
+// number of degree files kept memory mapped
+#ifndef TERRAIN_MMAP_FILES
+#define TERRAIN_MMAP_FILES 4
+#endif
+
 // format of grid on disk
 #define TERRAIN_GRID_FORMAT_VERSION 1
 
@@ -187,6 +204,22 @@ public:
      */
     void get_statistics(uint16_t &pending, uint16_t &loaded) const;
 
+    /*
+      grid cache statistics, used to size the caches. Hits and misses
+      only count lookups for data, not prefetches
+     */
+    struct CacheStats {
+        uint32_t hits;              // found in the LRU cache
+        uint32_t l2_hits;           // found in the second level cache
+        uint32_t misses;            // needed a disk read
+        uint32_t prefetches;        // blocks loaded by the prefetcher
+        uint32_t prefetch_hits;     // prefetched blocks later used
+        uint32_t disk_reads;        // completed disk reads
+        uint32_t read_time_total_ms;
+        uint32_t read_time_max_ms;
+    };
+    const CacheStats &get_cache_stats() const { return cache_stats; }
+
     /*
       get grid spacing in meters
      */
@@ -267,6 +300,12 @@ private:
 
         // the last time access was requested to this block, used for LRU
         uint32_t last_access_ms;
+
+        // loaded by the prefetcher and not yet used
+        bool prefetched;
+
+        // time the disk read was requested
+        uint32_t request_ms;
     };
 
     /*
@@ -302,9 +341,19 @@ private:
     void calculate_grid_info(const Location &loc, struct grid_info &info) const;
 
     /*
-      find a grid structure given a grid_info
+      find a grid structure given a grid_info. Prefetch lookups are
+      read from disk after lookups for data
     */
-    struct grid_cache &find_grid_cache(const struct grid_info &info);
+    struct grid_cache &find_grid_cache(const struct grid_info &info, bool prefetch=false);
+
+#if AP_TERRAIN_L2_CACHE_ENABLED
+    /*
+      second level cache functions
+     */
+    bool cache_l2_swap(const struct grid_info &info, struct grid_cache &gcache);
+    void cache_l2_store(const struct grid_cache &gcache);
+    void cache_l2_write_done(void);
+#endif
 
     /*
       calculate bit number in grid_block bitmap. This corresponds to a
@@ -345,14 +394,34 @@ private:
     void check_disk_write(void);
     void io_timer(void);
     void open_file(void);
+    static const char *terrain_directory(void);
+    static bool tile_path(char *path, size_t size, const char *dir, const struct grid_block &block);
     void seek_offset(void);
     uint32_t east_blocks(struct grid_block &block) const;
+    uint32_t block_file_offset(struct grid_block &block) const;
+    bool block_valid(struct grid_block &block, int32_t lat, int32_t lon);
     void write_block(void);
     void read_block(void);
 
+#if AP_TERRAIN_MMAP_ENABLED
+    /*
+      memory mapped degree file functions
+     */
+    struct terrain_map;
+    bool mmap_read(struct grid_cache &gcache);
+    struct terrain_map *find_map(const struct grid_block &block, bool &missing);
+    void unmap(struct terrain_map &map);
+#endif
+
     // check for missing data in squares surrounding loc:
     bool update_surrounding_tiles(const Location &loc);
 
+#if AP_TERRAIN_PREFETCH_ENABLED
+    // fetch blocks ahead of the vehicle
+    void update_prefetch(const Location &loc);
+    void prefetch_path(Location loc, float bearing, float distance, struct grid_info &last, uint8_t &budget);
+#endif
+
     /*
       check for missing mission terrain data
      */
@@ -376,6 +445,9 @@ private:
     AP_Int16 options; // option bits
     AP_Float offset_max;
     AP_Int16 config_cache_size;
+#if AP_TERRAIN_L2_CACHE_ENABLED
+    AP_Int16 config_cache_l2_size;
+#endif
 
     enum class Options {
         DisableDownload = (1U<<0),
@@ -385,6 +457,21 @@ private:
     uint8_t cache_size = 0;
     struct grid_cache *cache = nullptr;
 
+#if AP_TERRAIN_L2_CACHE_ENABLED
+    // blocks evicted from the LRU cache. Empty entries are
+    // GRID_CACHE_INVALID
+    uint16_t cache_l2_size;
+    uint16_t cache_l2_dirty;
+    struct grid_cache *cache_l2 = nullptr;
+#endif
+
+    CacheStats cache_stats;
+
+#if AP_TERRAIN_PREFETCH_ENABLED
+    // last time we looked ahead of the vehicle
+    uint32_t last_prefetch_ms;
+#endif
+
     // a grid_cache block waiting for disk IO
     enum DiskIoState {
         DiskIoIdle      = 0,
@@ -396,6 +483,22 @@ private:
     volatile enum DiskIoState disk_io_state;
     union grid_io_block disk_block;
 
+#if AP_TERRAIN_MMAP_ENABLED
+    /*
+      a degree file mapped for reading on the main thread. Blocks are
+      still written by the IO thread, and the shared mapping sees
+      those writes
+     */
+    struct terrain_map {
+        const uint8_t *data;
+        size_t length;
+        int fd;
+        int8_t lat_degrees;
+        int16_t lon_degrees;
+        uint32_t last_access_ms;
+    } maps[TERRAIN_MMAP_FILES];
+#endif
+
 #if HAL_GCS_ENABLED
     // last time we asked for more grids
     uint32_t last_request_time_ms[MAVLINK_COMM_NUM_BUFFERS];
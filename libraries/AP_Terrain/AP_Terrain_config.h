@@ -6,3 +6,21 @@
 #ifndef AP_TERRAIN_AVAILABLE
 #define AP_TERRAIN_AVAILABLE AP_FILESYSTEM_FILE_READING_ENABLED
 #endif
+
+// second level cache of grid blocks evicted from the LRU cache, for
+// boards with RAM to spare
+#ifndef AP_TERRAIN_L2_CACHE_ENABLED
+#define AP_TERRAIN_L2_CACHE_ENABLED (CONFIG_HAL_BOARD == HAL_BOARD_SITL || CONFIG_HAL_BOARD == HAL_BOARD_LINUX)
+#endif
+
+// fetch grid blocks ahead of the vehicle along its velocity vector
+// and the current mission leg
+#ifndef AP_TERRAIN_PREFETCH_ENABLED
+#define AP_TERRAIN_PREFETCH_ENABLED 1
+#endif
+
+// read grid blocks straight from memory mapped degree files on a
+// cache miss, rather than waiting for the IO thread
+#ifndef AP_TERRAIN_MMAP_ENABLED
+#define AP_TERRAIN_MMAP_ENABLED ((CONFIG_HAL_BOARD == HAL_BOARD_SITL || CONFIG_HAL_BOARD == HAL_BOARD_LINUX) && AP_FILESYSTEM_POSIX_ENABLED)
+#endif
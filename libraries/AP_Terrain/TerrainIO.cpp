@@ -29,17 +29,29 @@
 extern const AP_HAL::HAL& hal;
 
 /*
-  check for blocks that need to be read from disk
+  check for blocks that need to be read from disk. Blocks that have
+  been asked for data are read before prefetched blocks
  */
 void AP_Terrain::check_disk_read(void)
 {
+    int16_t prefetch_idx = -1;
     for (uint16_t i=0; i<cache_size; i++) {
         if (cache[i].state == GRID_CACHE_DISKWAIT) {
+            if (cache[i].prefetched) {
+                if (prefetch_idx == -1) {
+                    prefetch_idx = i;
+                }
+                continue;
+            }
             disk_block.block = cache[i].grid;
             disk_io_state = DiskIoWaitRead;
             return;
         }
-    }    
+    }
+    if (prefetch_idx != -1) {
+        disk_block.block = cache[prefetch_idx].grid;
+        disk_io_state = DiskIoWaitRead;
+    }
 }
 
 /*
@@ -53,7 +65,17 @@ void AP_Terrain::check_disk_write(void)
             disk_io_state = DiskIoWaitWrite;
             return;
         }
-    }    
+    }
+#if AP_TERRAIN_L2_CACHE_ENABLED
+    // then blocks evicted before they were written
+    for (uint16_t i=0; i<cache_l2_size && cache_l2_dirty > 0; i++) {
+        if (cache_l2[i].state == GRID_CACHE_DIRTY) {
+            disk_block.block = cache_l2[i].grid;
+            disk_io_state = DiskIoWaitWrite;
+            return;
+        }
+    }
+#endif
 }
 
 /*
@@ -89,7 +111,13 @@ void AP_Terrain::schedule_disk_io(void)
                 cache[cache_idx].grid = disk_block.block;
             }
             cache[cache_idx].state = GRID_CACHE_VALID;
-            cache[cache_idx].last_access_ms = AP_HAL::millis();
+            const uint32_t now_ms = AP_HAL::millis();
+            cache[cache_idx].last_access_ms = now_ms;
+
+            const uint32_t read_time_ms = now_ms - cache[cache_idx].request_ms;
+            cache_stats.disk_reads++;
+            cache_stats.read_time_total_ms += read_time_ms;
+            cache_stats.read_time_max_ms = MAX(cache_stats.read_time_max_ms, read_time_ms);
         }
         disk_io_state = DiskIoIdle;
         break;
@@ -104,6 +132,12 @@ void AP_Terrain::schedule_disk_io(void)
                 cache[cache_idx].state = GRID_CACHE_VALID;
             }
         }
+#if AP_TERRAIN_L2_CACHE_ENABLED
+        if (cache_idx == -1) {
+            // evicted while it was being written
+            cache_l2_write_done();
+        }
+#endif
         disk_io_state = DiskIoIdle;
         break;
     }
@@ -133,6 +167,44 @@ All file operations are done by the IO thread.
 /*
   open the current degree file
  */
+/*
+  directory holding the terrain files
+ */
+const char *AP_Terrain::terrain_directory(void)
+{
+    const char* terrain_dir = hal.util->get_custom_terrain_directory();
+    if (terrain_dir == nullptr) {
+        terrain_dir = HAL_BOARD_TERRAIN_DIRECTORY;
+    }
+    return terrain_dir;
+}
+
+/*
+  format the path of the file holding the degree square of a block,
+  dir/NxxExxx.DAT. Returns false if it doesn't fit in size bytes
+ */
+bool AP_Terrain::tile_path(char *path, size_t size, const char *dir, const struct grid_block &block)
+{
+    // our fancy templatified MIN macro get gcc 9.3.0 all confused; it
+    // thinks there are more digits than there can be so says there's
+    // a buffer overflow in the snprintf.  Constrain it long-form:
+    uint32_t lat_tmp = abs((int32_t)block.lat_degrees);
+    if (lat_tmp > 99U) {
+        lat_tmp = 99U;
+    }
+    uint32_t lon_tmp = abs((int32_t)block.lon_degrees);
+    if (lon_tmp > 999U) {
+        lon_tmp = 999;
+    }
+    const int n = hal.util->snprintf(path, size, "%s/%c%02u%c%03u.DAT",
+                                     dir,
+                                     block.lat_degrees<0?'S':'N',
+                                     (unsigned)lat_tmp,
+                                     block.lon_degrees<0?'W':'E',
+                                     (unsigned)lon_tmp);
+    return n > 0 && size_t(n) < size;
+}
+
 void AP_Terrain::open_file(void)
 {
     struct grid_block &block = disk_block.block;
@@ -143,11 +215,7 @@ void AP_Terrain::open_file(void)
         return;
     }
     if (file_path == nullptr) {
-        const char* terrain_dir = hal.util->get_custom_terrain_directory();
-        if (terrain_dir == nullptr) {
-            terrain_dir = HAL_BOARD_TERRAIN_DIRECTORY;
-        }
-        if (asprintf(&file_path, "%s/NxxExxx.DAT", terrain_dir) <= 0) {
+        if (asprintf(&file_path, "%s/NxxExxx.DAT", terrain_directory()) <= 0) {
             io_failure = true;
             file_path = nullptr;
             return;
@@ -162,22 +230,7 @@ void AP_Terrain::open_file(void)
         io_failure = true;
         return;        
     }
-    // our fancy templatified MIN macro get gcc 9.3.0 all confused; it
-    // thinks there are more digits than there can be so says there's
-    // a buffer overflow in the snprintf.  Constrain it long-form:
-    uint32_t lat_tmp = abs((int32_t)block.lat_degrees);
-    if (lat_tmp > 99U) {
-        lat_tmp = 99U;
-    }
-    uint32_t lon_tmp = abs((int32_t)block.lon_degrees);
-    if (lon_tmp > 999U) {
-        lon_tmp = 999;
-    }
-    hal.util->snprintf(p, 13, "/%c%02u%c%03u.DAT",
-             block.lat_degrees<0?'S':'N',
-             (unsigned)lat_tmp,
-             block.lon_degrees<0?'W':'E',
-             (unsigned)lon_tmp);
+    tile_path(p, 13, "", block);
 
     // create directory if need be
     if (!directory_created) {
@@ -232,14 +285,34 @@ uint32_t AP_Terrain::east_blocks(struct grid_block &block) const
 }
 
 /*
-  seek to the right offset for disk_block
+  get the offset of a block in its degree file
  */
-void AP_Terrain::seek_offset(void)
+uint32_t AP_Terrain::block_file_offset(struct grid_block &block) const
 {
-    struct grid_block &block = disk_block.block;
     // work out how many longitude blocks there are at this latitude
     uint32_t blocknum = east_blocks(block) * block.grid_idx_x + block.grid_idx_y;
-    uint32_t file_offset = blocknum * sizeof(union grid_io_block);
+    return blocknum * sizeof(union grid_io_block);
+}
+
+/*
+  check a block read from disk is the one we asked for and is intact
+ */
+bool AP_Terrain::block_valid(struct grid_block &block, int32_t lat, int32_t lon)
+{
+    return TERRAIN_LATLON_EQUAL(block.lat,lat) &&
+        TERRAIN_LATLON_EQUAL(block.lon,lon) &&
+        block.bitmap != 0 &&
+        block.spacing == grid_spacing &&
+        block.version == TERRAIN_GRID_FORMAT_VERSION &&
+        block.crc == get_block_crc(block);
+}
+
+/*
+  seek to the right offset for disk_block
+ */
+void AP_Terrain::seek_offset(void)
+{
+    uint32_t file_offset = block_file_offset(disk_block.block);
     if (AP::FS().lseek(fd, file_offset, SEEK_SET) != (off_t)file_offset) {
 #if TERRAIN_DEBUG
         hal.console->printf("Seek %lu failed - %s\n",
@@ -298,12 +371,7 @@ void AP_Terrain::read_block(void)
 
     ssize_t ret = AP::FS().read(fd, &disk_block, sizeof(disk_block));
     if (ret != sizeof(disk_block) || 
-        !TERRAIN_LATLON_EQUAL(disk_block.block.lat,lat) ||
-        !TERRAIN_LATLON_EQUAL(disk_block.block.lon,lon) ||
-        disk_block.block.bitmap == 0 ||
-        disk_block.block.spacing != grid_spacing ||
-        disk_block.block.version != TERRAIN_GRID_FORMAT_VERSION ||
-        disk_block.block.crc != get_block_crc(disk_block.block)) {
+        !block_valid(disk_block.block, lat, lon)) {
 #if TERRAIN_DEBUG
         printf("read empty block at %ld %ld ret=%d (%ld %ld %u 0x%08lx) 0x%04x:0x%04x\n",
                (long)lat,
@@ -26,6 +26,7 @@
 #include <AP_Mission/AP_Mission.h>
 #include <AP_Rally/AP_Rally.h>
 #include <AP_GPS/AP_GPS.h>
+#include <AP_AHRS/AP_AHRS.h>
 
 extern const AP_HAL::HAL& hal;
 
@@ -114,6 +115,86 @@ void AP_Terrain::update_mission_data(void)
 #endif  // AP_MISSION_ENABLED
 }
 
+#if AP_TERRAIN_PREFETCH_ENABLED
+/*
+  fetch the grid blocks the vehicle will need over the next
+  TERRAIN_PREFETCH_TIME_S seconds. When flying a mission this follows
+  the current and next legs, otherwise the velocity vector. The
+  budget stops the prefetcher from taking over the LRU cache
+ */
+void AP_Terrain::update_prefetch(const Location &loc)
+{
+    const uint32_t now_ms = AP_HAL::millis();
+    if (now_ms - last_prefetch_ms < TERRAIN_PREFETCH_INTERVAL_MS ||
+        grid_spacing <= 0) {
+        return;
+    }
+    last_prefetch_ms = now_ms;
+
+    Vector3f vel;
+    if (!AP::ahrs().get_velocity_NED(vel)) {
+        return;
+    }
+    const float speed = vel.xy().length();
+    if (speed < TERRAIN_PREFETCH_MIN_SPEED) {
+        return;
+    }
+
+    uint8_t budget = MIN(TERRAIN_PREFETCH_MAX_BLOCKS, cache_size/4);
+    float distance = speed * TERRAIN_PREFETCH_TIME_S;
+
+    struct grid_info last;
+    calculate_grid_info(loc, last);
+
+#if AP_MISSION_ENABLED
+    AP_Mission *mission = AP::mission();
+    if (mission != nullptr && mission->state() == AP_Mission::MISSION_RUNNING) {
+        const AP_Mission::Mission_Command &nav_cmd = mission->get_current_nav_cmd();
+        const Location &dest = nav_cmd.content.location;
+        if (dest.lat != 0 || dest.lng != 0) {
+            // the current leg, then the start of the next
+            const float leg_length = loc.get_distance(dest);
+            prefetch_path(loc, degrees(loc.get_bearing(dest)), MIN(leg_length, distance), last, budget);
+            distance -= leg_length;
+            AP_Mission::Mission_Command next_cmd;
+            if (distance > 0 &&
+                mission->get_next_nav_cmd(nav_cmd.index+1, next_cmd) &&
+                (next_cmd.content.location.lat != 0 || next_cmd.content.location.lng != 0)) {
+                const Location &next_dest = next_cmd.content.location;
+                prefetch_path(dest, degrees(dest.get_bearing(next_dest)), MIN(dest.get_distance(next_dest), distance), last, budget);
+            }
+            return;
+        }
+    }
+#endif
+
+    prefetch_path(loc, degrees(atan2f(vel.y, vel.x)), distance, last, budget);
+}
+
+/*
+  fetch the blocks along a path, skipping the block in last
+ */
+void AP_Terrain::prefetch_path(Location loc, float bearing, float distance, struct grid_info &last, uint8_t &budget)
+{
+    // half a block, so no block on the path is stepped over
+    const float step = TERRAIN_GRID_BLOCK_SPACING_X * grid_spacing * 0.5f;
+    float travelled = 0;
+    while (travelled < distance && budget > 0) {
+        const float move = MIN(step, distance - travelled);
+        loc.offset_bearing(bearing, move);
+        travelled += move;
+        struct grid_info info;
+        calculate_grid_info(loc, info);
+        if (info.grid_lat == last.grid_lat && info.grid_lon == last.grid_lon) {
+            continue;
+        }
+        last = info;
+        find_grid_cache(info, true);
+        budget--;
+    }
+}
+#endif // AP_TERRAIN_PREFETCH_ENABLED
+
 #if HAL_RALLY_ENABLED
 /*
   check that we have fetched all rally terrain data
@@ -0,0 +1,159 @@
+/*
+   This program is free software: you can redistribute it and/or modify
+   it under the terms of the GNU General Public License as published by
+   the Free Software Foundation, either version 3 of the License, or
+   (at your option) any later version.
+
+   This program is distributed in the hope that it will be useful,
+   but WITHOUT ANY WARRANTY; without even the implied warranty of
+   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+   GNU General Public License for more details.
+
+   You should have received a copy of the GNU General Public License
+   along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+/*
+  read terrain grid blocks from memory mapped degree files
+
+  On boards with a posix filesystem a cache miss is filled by copying
+  the block out of a read-only shared mapping of its degree file,
+  instead of queueing a read for the IO thread. The on-disk format is
+  unchanged and writes still go through the IO thread
+ */
+
+#include "AP_Terrain.h"
+
+#if AP_TERRAIN_AVAILABLE && AP_TERRAIN_MMAP_ENABLED
+
+#include <AP_Filesystem/AP_Filesystem.h>
+#include <AP_HAL/AP_HAL.h>
+#include <AP_Math/AP_Math.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+
+extern const AP_HAL::HAL& hal;
+
+/*
+  find the mapping for the degree file holding a block, mapping it if
+  needed. Sets missing if the file doesn't exist or is empty, meaning
+  the block isn't on disk
+ */
+AP_Terrain::terrain_map *AP_Terrain::find_map(const struct grid_block &block, bool &missing)
+{
+    missing = false;
+
+    const uint32_t now_ms = AP_HAL::millis();
+    uint8_t oldest_i = 0;
+    for (uint8_t i=0; i<ARRAY_SIZE(maps); i++) {
+        struct terrain_map &map = maps[i];
+        if (map.data != nullptr &&
+            map.lat_degrees == block.lat_degrees &&
+            map.lon_degrees == block.lon_degrees) {
+            map.last_access_ms = now_ms;
+            return &map;
+        }
+        if (map.data == nullptr ||
+            (maps[oldest_i].data != nullptr && map.last_access_ms < maps[oldest_i].last_access_ms)) {
+            oldest_i = i;
+        }
+    }
+
+    char path[128];
+    if (!tile_path(path, sizeof(path), terrain_directory(), block)) {
+        return nullptr;
+    }
+
+    // the local filesystem backend hands out OS file descriptors,
+    // which is what lets us map the file
+    const int map_fd = AP::FS().open(path, O_RDONLY);
+    if (map_fd == -1) {
+        missing = (errno == ENOENT);
+        return nullptr;
+    }
+    struct stat st;
+    if (::fstat(map_fd, &st) != 0) {
+        AP::FS().close(map_fd);
+        return nullptr;
+    }
+    if (st.st_size < (off_t)sizeof(union grid_io_block)) {
+        AP::FS().close(map_fd);
+        missing = true;
+        return nullptr;
+    }
+    void *data = ::mmap(nullptr, st.st_size, PROT_READ, MAP_SHARED, map_fd, 0);
+    if (data == MAP_FAILED) {
+        AP::FS().close(map_fd);
+        return nullptr;
+    }
+
+    struct terrain_map &map = maps[oldest_i];
+    unmap(map);
+    map.data = (const uint8_t *)data;
+    map.length = st.st_size;
+    map.fd = map_fd;
+    map.lat_degrees = block.lat_degrees;
+    map.lon_degrees = block.lon_degrees;
+    map.last_access_ms = now_ms;
+    return &map;
+}
+
+void AP_Terrain::unmap(struct terrain_map &map)
+{
+    if (map.data == nullptr) {
+        return;
+    }
+    ::munmap(const_cast<uint8_t *>(map.data), map.length);
+    AP::FS().close(map.fd);
+    map.data = nullptr;
+    map.length = 0;
+}
+
+/*
+  fill a grid_cache waiting for a disk read from the mapped degree
+  file. Returns false if the read needs to go through the IO thread
+ */
+bool AP_Terrain::mmap_read(struct grid_cache &gcache)
+{
+    struct grid_block &block = gcache.grid;
+    bool missing;
+    struct terrain_map *map = find_map(block, missing);
+    if (map == nullptr) {
+        if (!missing) {
+            return false;
+        }
+        // no file yet, so the block is empty
+        gcache.state = GRID_CACHE_VALID;
+        cache_stats.disk_reads++;
+        return true;
+    }
+
+    const uint32_t file_offset = block_file_offset(block);
+    if (file_offset + sizeof(union grid_io_block) > map->length) {
+        // the IO thread may have written past the end of the
+        // mapping. Remap if the file has grown
+        struct stat st;
+        if (::fstat(map->fd, &st) != 0) {
+            return false;
+        }
+        if (size_t(st.st_size) > map->length) {
+            unmap(*map);
+            map = find_map(block, missing);
+            if (map == nullptr) {
+                return false;
+            }
+        }
+    }
+
+    if (file_offset + sizeof(union grid_io_block) <= map->length) {
+        struct grid_block disk;
+        memcpy(&disk, &map->data[file_offset], sizeof(disk));
+        if (block_valid(disk, block.lat, block.lon)) {
+            block = disk;
+        }
+    }
+    gcache.state = GRID_CACHE_VALID;
+    cache_stats.disk_reads++;
+    return true;
+}
+
+#endif // AP_TERRAIN_AVAILABLE && AP_TERRAIN_MMAP_ENABLED
@@ -104,7 +104,7 @@ void AP_Terrain::calculate_grid_info(const Location &loc, struct grid_info &info
 /*
   find a grid structure given a grid_info
  */
-AP_Terrain::grid_cache &AP_Terrain::find_grid_cache(const struct grid_info &info)
+AP_Terrain::grid_cache &AP_Terrain::find_grid_cache(const struct grid_info &info, bool prefetch)
 {
     uint16_t oldest_i = 0;
 
@@ -115,6 +115,13 @@ AP_Terrain::grid_cache &AP_Terrain::find_grid_cache(const struct grid_info &info
             TERRAIN_LATLON_EQUAL(cache[i].grid.lon,info.grid_lon) &&
             cache[i].grid.spacing == grid_spacing) {
             cache[i].last_access_ms = now_ms;
+            if (!prefetch) {
+                cache_stats.hits++;
+                if (cache[i].prefetched) {
+                    cache[i].prefetched = false;
+                    cache_stats.prefetch_hits++;
+                }
+            }
             return cache[i];
         }
         if (cache[i].last_access_ms < cache[oldest_i].last_access_ms) {
@@ -122,9 +129,26 @@ AP_Terrain::grid_cache &AP_Terrain::find_grid_cache(const struct grid_info &info
         }
     }
 
-    // Not found. Use the oldest grid and make it this grid,
-    // initially unpopulated
+    // Not found. Use the oldest grid and make it this grid
     struct grid_cache &grid = cache[oldest_i];
+
+    if (prefetch) {
+        cache_stats.prefetches++;
+    }
+
+#if AP_TERRAIN_L2_CACHE_ENABLED
+    if (cache_l2_swap(info, grid)) {
+        grid.last_access_ms = now_ms;
+        grid.prefetched = prefetch;
+        if (!prefetch) {
+            cache_stats.l2_hits++;
+        }
+        return grid;
+    }
+    cache_l2_store(grid);
+#endif
+
+    // initially unpopulated
     memset(&grid, 0, sizeof(grid));
 
     grid.grid.lat = info.grid_lat;
@@ -136,6 +160,17 @@ AP_Terrain::grid_cache &AP_Terrain::find_grid_cache(const struct grid_info &info
     grid.grid.lon_degrees = info.lon_degrees;
     grid.grid.version = TERRAIN_GRID_FORMAT_VERSION;
     grid.last_access_ms = now_ms;
+    grid.request_ms = now_ms;
+    grid.prefetched = prefetch;
+    if (!prefetch) {
+        cache_stats.misses++;
+    }
+
+#if AP_TERRAIN_MMAP_ENABLED
+    if (mmap_read(grid)) {
+        return grid;
+    }
+#endif
 
     // mark as waiting for disk read
     grid.state = GRID_CACHE_DISKWAIT;
@@ -143,6 +178,93 @@ AP_Terrain::grid_cache &AP_Terrain::find_grid_cache(const struct grid_info &info
     return grid;
 }
 
+#if AP_TERRAIN_L2_CACHE_ENABLED
+/*
+  look for a grid in the second level cache. If it is there swap it
+  with gcache, which is being evicted from the LRU cache
+ */
+bool AP_Terrain::cache_l2_swap(const struct grid_info &info, struct grid_cache &gcache)
+{
+    for (uint16_t i=0; i<cache_l2_size; i++) {
+        struct grid_cache &l2 = cache_l2[i];
+        if (l2.state == GRID_CACHE_INVALID ||
+            !TERRAIN_LATLON_EQUAL(l2.grid.lat,info.grid_lat) ||
+            !TERRAIN_LATLON_EQUAL(l2.grid.lon,info.grid_lon) ||
+            l2.grid.spacing != grid_spacing) {
+            continue;
+        }
+        if (l2.state == GRID_CACHE_DIRTY) {
+            cache_l2_dirty--;
+        }
+        const struct grid_cache found = l2;
+        if (gcache.state >= GRID_CACHE_VALID && gcache.grid.bitmap != 0) {
+            l2 = gcache;
+            if (l2.state == GRID_CACHE_DIRTY) {
+                cache_l2_dirty++;
+            }
+        } else {
+            l2.state = GRID_CACHE_INVALID;
+        }
+        gcache = found;
+        return true;
+    }
+    return false;
+}
+
+/*
+  keep a grid being evicted from the LRU cache, replacing the oldest
+  clean grid in the second level cache
+ */
+void AP_Terrain::cache_l2_store(const struct grid_cache &gcache)
+{
+    if (cache_l2_size == 0 ||
+        gcache.state < GRID_CACHE_VALID ||
+        gcache.grid.bitmap == 0) {
+        // nothing worth keeping
+        return;
+    }
+    int32_t oldest_i = -1;
+    for (uint16_t i=0; i<cache_l2_size; i++) {
+        const struct grid_cache &l2 = cache_l2[i];
+        if (l2.state == GRID_CACHE_INVALID) {
+            oldest_i = i;
+            break;
+        }
+        if (l2.state == GRID_CACHE_VALID &&
+            (oldest_i == -1 || l2.last_access_ms < cache_l2[oldest_i].last_access_ms)) {
+            oldest_i = i;
+        }
+    }
+    if (oldest_i == -1) {
+        // everything is waiting to be written
+        return;
+    }
+    cache_l2[oldest_i] = gcache;
+    if (gcache.state == GRID_CACHE_DIRTY) {
+        cache_l2_dirty++;
+    }
+}
+
+/*
+  mark the second level cache copy of disk_block as written
+ */
+void AP_Terrain::cache_l2_write_done(void)
+{
+    for (uint16_t i=0; i<cache_l2_size; i++) {
+        struct grid_cache &l2 = cache_l2[i];
+        if (l2.state == GRID_CACHE_DIRTY &&
+            TERRAIN_LATLON_EQUAL(disk_block.block.lat,l2.grid.lat) &&
+            TERRAIN_LATLON_EQUAL(disk_block.block.lon,l2.grid.lon)) {
+            if (l2.grid.bitmap == disk_block.block.bitmap) {
+                l2.state = GRID_CACHE_VALID;
+                cache_l2_dirty--;
+            }
+            return;
+        }
+    }
+}
+#endif // AP_TERRAIN_L2_CACHE_ENABLED
+
 /*
   find cache index of disk_block
  */
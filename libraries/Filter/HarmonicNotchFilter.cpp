@@ -219,8 +219,14 @@ void HarmonicNotchFilter<T>::allocate_filters(uint8_t num_notches, uint32_t harm
 
     if (_num_filters > 0) {
         _filters = NEW_NOTHROW NotchFilter<T>[_num_filters];
-        if (_filters == nullptr) {
+        bool ok = _filters != nullptr;
+#if AP_FILTER_NOTCH_BANK_ENABLED
+        ok = ok && _bank.allocate(_num_filters);
+#endif
+        if (!ok) {
             GCS_SEND_TEXT(MAV_SEVERITY_ERROR, "Failed to allocate %u bytes for notch filter", (unsigned int)(_num_filters * sizeof(NotchFilter<T>)));
+            delete[] _filters;
+            _filters = nullptr;
             _num_filters = 0;
         }
     }
@@ -244,6 +250,12 @@ void HarmonicNotchFilter<T>::expand_filter_count(uint16_t total_notches)
       note that we rely on the semaphore in
       AP_InertialSensor_Backend.cpp to make this thread safe
      */
+#if AP_FILTER_NOTCH_BANK_ENABLED
+    if (!_bank.allocate(total_notches)) {
+        _alloc_has_failed = true;
+        return;
+    }
+#endif
     auto filters = NEW_NOTHROW NotchFilter<T>[total_notches];
     if (filters == nullptr) {
         _alloc_has_failed = true;
@@ -332,6 +344,10 @@ void HarmonicNotchFilter<T>::set_center_frequency(uint16_t idx, float notch_cent
     */
     notch_center *= spread_mul;
 
+#if AP_FILTER_NOTCH_BANK_ENABLED
+    // the filter state is held in the bank, so take the reset from there
+    notch.need_reset = _bank.reset_pending(idx);
+#endif
     notch.init_with_A_and_Q(_sample_freq_hz, notch_center, A, _Q);
 }
 
@@ -387,10 +403,17 @@ void HarmonicNotchFilter<T>::update(uint8_t num_centers, const float center_freq
             set_center_frequency(_num_enabled_filters++, notch_center, 1.0 + _notch_spread, harmonic_mul);
         }
     }
+
+#if AP_FILTER_NOTCH_BANK_ENABLED
+    // pick up all of the new coefficients in one pass
+    _bank.load_coefficients(_filters, _num_enabled_filters);
+#endif
 }
 
 /*
-  apply a sample to each of the underlying filters in turn and return the output
+  apply a sample to each of the underlying filters in turn and return the output.
+  Where the bank is enabled the filters are run from it, as it holds
+  their coefficients and state
  */
 template <class T>
 T HarmonicNotchFilter<T>::apply(const T &sample)
@@ -406,23 +429,28 @@ T HarmonicNotchFilter<T>::apply(const T &sample)
     }
 #endif
 
-    T output = sample;
-    for (uint16_t i = 0; i < _num_enabled_filters; i++) {
 #if NOTCH_DEBUG_LOGGING
+    for (uint16_t i = 0; i < _num_enabled_filters; i++) {
         if (!_filters[i].initialised) {
             ::dprintf(dfd, "------- ");
         } else {
             ::dprintf(dfd, "%.4f ", _filters[i]._center_freq_hz);
         }
-#endif
-        output = _filters[i].apply(output);
     }
-#if NOTCH_DEBUG_LOGGING
     if (_num_enabled_filters > 0) {
         ::dprintf(dfd, "\n");
     }
 #endif
+
+#if AP_FILTER_NOTCH_BANK_ENABLED
+    return _bank.apply(sample);
+#else
+    T output = sample;
+    for (uint16_t i = 0; i < _num_enabled_filters; i++) {
+        output = _filters[i].apply(output);
+    }
     return output;
+#endif
 }
 
 /*
@@ -435,9 +463,13 @@ void HarmonicNotchFilter<T>::reset()
         return;
     }
 
+#if AP_FILTER_NOTCH_BANK_ENABLED
+    _bank.reset();
+#else
     for (uint16_t i = 0; i < _num_filters; i++) {
         _filters[i].reset();
     }
+#endif
 }
 
 #if HAL_LOGGING_ENABLED
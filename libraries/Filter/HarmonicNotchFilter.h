@@ -18,6 +18,7 @@
 #include <cmath>
 #include <AP_Param/AP_Param.h>
 #include "NotchFilter.h"
+#include "NotchFilterBank.h"
 
 #define HNF_MAX_HARMONICS 16
 
@@ -62,6 +63,10 @@ public:
 private:
     // underlying bank of notch filters
     NotchFilter<T>*  _filters;
+#if AP_FILTER_NOTCH_BANK_ENABLED
+    // coefficients and state of the enabled filters, used by apply()
+    NotchFilterBank<T> _bank;
+#endif
     // sample frequency for each filter
     float _sample_freq_hz;
     // base double notch bandwidth for each filter
@@ -0,0 +1,188 @@
+/*
+   This program is free software: you can redistribute it and/or modify
+   it under the terms of the GNU General Public License as published by
+   the Free Software Foundation, either version 3 of the License, or
+   (at your option) any later version.
+
+   This program is distributed in the hope that it will be useful,
+   but WITHOUT ANY WARRANTY; without even the implied warranty of
+   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+   GNU General Public License for more details.
+
+   You should have received a copy of the GNU General Public License
+   along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef HAL_DEBUG_BUILD
+#define AP_INLINE_VECTOR_OPS
+#pragma GCC optimize("O2")
+#endif
+
+#include "NotchFilterBank.h"
+
+#if AP_FILTER_NOTCH_BANK_ENABLED
+
+#include <string.h>
+
+// conversion between the filtered type and the lane it is held in
+template <class T>
+static inline T to_lane(const T &v)
+{
+    return v;
+}
+
+template <class T>
+static inline T from_lane(const T &v)
+{
+    return v;
+}
+
+#if AP_FILTER_SIMD_ENABLED
+typedef NotchFilterBankLane<Vector3f>::type vec3_lane_t;
+
+static inline vec3_lane_t to_lane(const Vector3f &v)
+{
+    return vec3_lane_t{v.x, v.y, v.z, 0};
+}
+
+static inline Vector3f from_lane(const vec3_lane_t &v)
+{
+    return Vector3f{v[0], v[1], v[2]};
+}
+#endif
+
+template <class T>
+NotchFilterBank<T>::~NotchFilterBank()
+{
+    delete[] _b0;
+    delete[] _state;
+    delete[] _flags;
+}
+
+/*
+  grow the bank. The coefficients share one allocation, split into
+  an array per coefficient. New notches start zeroed, as NEW_NOTHROW
+  clears the memory it returns
+ */
+template <class T>
+bool NotchFilterBank<T>::allocate(uint16_t num_notches)
+{
+    if (num_notches <= _num_notches) {
+        return true;
+    }
+    float *coeffs = NEW_NOTHROW float[5 * num_notches];
+    State *state = NEW_NOTHROW State[num_notches];
+    uint8_t *flags = NEW_NOTHROW uint8_t[num_notches];
+    if (coeffs == nullptr || state == nullptr || flags == nullptr) {
+        delete[] coeffs;
+        delete[] state;
+        delete[] flags;
+        return false;
+    }
+    float *b0 = &coeffs[0];
+    float *b1 = &coeffs[num_notches];
+    float *b2 = &coeffs[2*num_notches];
+    float *a1 = &coeffs[3*num_notches];
+    float *a2 = &coeffs[4*num_notches];
+    if (_num_notches > 0) {
+        memcpy(b0, _b0, sizeof(float) * _num_notches);
+        memcpy(b1, _b1, sizeof(float) * _num_notches);
+        memcpy(b2, _b2, sizeof(float) * _num_notches);
+        memcpy(a1, _a1, sizeof(float) * _num_notches);
+        memcpy(a2, _a2, sizeof(float) * _num_notches);
+        memcpy(state, _state, sizeof(state[0]) * _num_notches);
+        memcpy(flags, _flags, sizeof(flags[0]) * _num_notches);
+    }
+
+    /*
+      note that we rely on the semaphore in
+      AP_InertialSensor_Backend.cpp to make this thread safe
+     */
+    float *old_coeffs = _b0;
+    State *old_state = _state;
+    uint8_t *old_flags = _flags;
+    _b0 = b0;
+    _b1 = b1;
+    _b2 = b2;
+    _a1 = a1;
+    _a2 = a2;
+    _state = state;
+    _flags = flags;
+    _num_notches = num_notches;
+    delete[] old_coeffs;
+    delete[] old_state;
+    delete[] old_flags;
+    return true;
+}
+
+/*
+  copy the coefficients calculated by each notch into the bank
+ */
+template <class T>
+void NotchFilterBank<T>::load_coefficients(const NotchFilter<T> filters[], uint16_t count)
+{
+    count = MIN(count, _num_notches);
+    for (uint16_t i = 0; i < count; i++) {
+        const NotchFilter<T> &notch = filters[i];
+        _b0[i] = notch.b0;
+        _b1[i] = notch.b1;
+        _b2[i] = notch.b2;
+        _a1[i] = notch.a1;
+        _a2[i] = notch.a2;
+        if (notch.initialised) {
+            _flags[i] |= FLAG_ENABLED;
+        } else {
+            _flags[i] &= ~FLAG_ENABLED;
+        }
+    }
+    _count = count;
+}
+
+/*
+  apply a sample to the cascade. Each notch behaves as
+  NotchFilter<T>::apply(), including passing the sample through and
+  loading the delayed samples when disabled or reset
+ */
+template <class T>
+T NotchFilterBank<T>::apply(const T &sample)
+{
+    lane_t output = to_lane(sample);
+    for (uint16_t i = 0; i < _count; i++) {
+        State &s = _state[i];
+        if (_flags[i] != FLAG_ENABLED) {
+            s.signal1 = output;
+            s.signal2 = output;
+            s.ntchsig1 = output;
+            s.ntchsig2 = output;
+            _flags[i] &= ~FLAG_RESET;
+            continue;
+        }
+        // the input term is added last, as only it depends on the
+        // previous notch in the cascade
+        const lane_t out = s.ntchsig1*_b1[i] + s.ntchsig2*_b2[i] - s.signal1*_a1[i] - s.signal2*_a2[i] + output*_b0[i];
+
+        s.ntchsig2 = s.ntchsig1;
+        s.ntchsig1 = output;
+
+        s.signal2 = s.signal1;
+        s.signal1 = out;
+        output = out;
+    }
+    return from_lane(output);
+}
+
+template <class T>
+void NotchFilterBank<T>::reset()
+{
+    for (uint16_t i = 0; i < _num_notches; i++) {
+        _flags[i] |= FLAG_RESET;
+    }
+}
+
+/*
+  instantiate template classes
+ */
+template class NotchFilterBank<Vector3f>;
+template class NotchFilterBank<float>;
+
+#endif  // AP_FILTER_NOTCH_BANK_ENABLED
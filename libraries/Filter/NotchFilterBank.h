@@ -0,0 +1,116 @@
+/*
+   This program is free software: you can redistribute it and/or modify
+   it under the terms of the GNU General Public License as published by
+   the Free Software Foundation, either version 3 of the License, or
+   (at your option) any later version.
+
+   This program is distributed in the hope that it will be useful,
+   but WITHOUT ANY WARRANTY; without even the implied warranty of
+   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+   GNU General Public License for more details.
+
+   You should have received a copy of the GNU General Public License
+   along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+#pragma once
+
+/*
+  a cascade of notch filters held as a structure of arrays
+
+  The coefficients of every notch are kept in contiguous arrays and
+  loaded in a single pass after the notch centers change, and the
+  cascade is run in one loop without touching the NotchFilter
+  objects. The output of each notch feeds the next, so the
+  parallelism is across the lanes of T: on SITL and Linux the three
+  axes of a Vector3f are filtered together in one SSE2 or NEON
+  register.
+
+  The bank keeps its own copy of the state, so it is only used where
+  SIMD makes it pay for the extra memory. Elsewhere the harmonic notch
+  runs its NotchFilter objects directly.
+ */
+
+#include <AP_HAL/AP_HAL_Boards.h>
+#include <AP_Math/AP_Math.h>
+#include "NotchFilter.h"
+
+#ifndef AP_FILTER_SIMD_ENABLED
+#if (CONFIG_HAL_BOARD == HAL_BOARD_SITL || CONFIG_HAL_BOARD == HAL_BOARD_LINUX) && (defined(__SSE2__) || defined(__ARM_NEON))
+#define AP_FILTER_SIMD_ENABLED 1
+#else
+#define AP_FILTER_SIMD_ENABLED 0
+#endif
+#endif
+
+#ifndef AP_FILTER_NOTCH_BANK_ENABLED
+#define AP_FILTER_NOTCH_BANK_ENABLED AP_FILTER_SIMD_ENABLED
+#endif
+
+#if AP_FILTER_NOTCH_BANK_ENABLED
+
+// the type each notch's state is held in
+template <class T>
+struct NotchFilterBankLane {
+    typedef T type;
+};
+
+#if AP_FILTER_SIMD_ENABLED
+/*
+  x, y, z and an unused lane. The alignment is lowered so the state
+  array doesn't rely on the heap returning 16 byte aligned blocks
+ */
+template <>
+struct NotchFilterBankLane<Vector3f> {
+    typedef float type __attribute__((vector_size(16), aligned(4)));
+};
+#endif
+
+template <class T>
+class NotchFilterBank {
+public:
+    ~NotchFilterBank();
+
+    // make room for num_notches notches, keeping the state of the
+    // existing ones. Returns false on allocation failure
+    bool allocate(uint16_t num_notches);
+
+    // load the coefficients of the first count filters, which become
+    // the cascade run by apply(). Filters that are not initialised
+    // pass samples through unchanged
+    void load_coefficients(const NotchFilter<T> filters[], uint16_t count);
+
+    // apply a sample to each notch in turn
+    T apply(const T &sample);
+
+    // restart all notches from the next sample applied
+    void reset();
+
+    // true if the notch has been reset and not yet had a sample applied
+    bool reset_pending(uint16_t idx) const {
+        return idx < _num_notches && (_flags[idx] & FLAG_RESET) != 0;
+    }
+
+private:
+    typedef typename NotchFilterBankLane<T>::type lane_t;
+
+    enum : uint8_t {
+        FLAG_ENABLED = 1U<<0,
+        FLAG_RESET   = 1U<<1,
+    };
+
+    struct State {
+        lane_t ntchsig1, ntchsig2, signal1, signal2;
+    };
+
+    // coefficients, each an array of _num_notches
+    float *_b0, *_b1, *_b2, *_a1, *_a2;
+    State *_state;
+    uint8_t *_flags;
+
+    // number of allocated notches
+    uint16_t _num_notches;
+    // number of notches in the cascade
+    uint16_t _count;
+};
+
+#endif  // AP_FILTER_NOTCH_BANK_ENABLED
@@ -0,0 +1,131 @@
+/*
+   This program is free software: you can redistribute it and/or modify
+   it under the terms of the GNU General Public License as published by
+   the Free Software Foundation, either version 3 of the License, or
+   (at your option) any later version.
+
+   This program is distributed in the hope that it will be useful,
+   but WITHOUT ANY WARRANTY; without even the implied warranty of
+   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+   GNU General Public License for more details.
+
+   You should have received a copy of the GNU General Public License
+   along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+/*
+  gyro harmonic notch, a chain of NotchFilter objects against the
+  HarmonicNotchFilter bank. The argument is the number of notch
+  sources; each has three harmonics of a triple notch, so 4 sources
+  is 36 notches, as with ESC telemetry on a quad
+ */
+#include <AP_gbenchmark.h>
+
+#include <Filter/HarmonicNotchFilter.h>
+
+const AP_HAL::HAL& hal = AP_HAL::get_HAL();
+
+static const float rate_hz = 2000;
+static const float base_freq = 80;
+static const float bandwidth = 40;
+static const float attenuation_dB = 40;
+static const uint8_t composite_notches = 3;
+static const uint32_t harmonics = 0x7;
+
+static Vector3f bench_sample(uint32_t n)
+{
+    return Vector3f{sinf(n * 0.1f), cosf(n * 0.07f), sinf(n * 0.03f)};
+}
+
+static void setup_harmonic_notch(HarmonicNotchFilterVector3f &filter, HarmonicNotchFilterParams &params, uint8_t num_sources)
+{
+    params.set_center_freq_hz(base_freq);
+    params.set_bandwidth_hz(bandwidth);
+    params.set_attenuation(attenuation_dB);
+    params.set_harmonics(harmonics);
+    params.set_freq_min_ratio(1.0);
+    params.set_options(uint16_t(HarmonicNotchFilterParams::Options::TripleNotch));
+    filter.allocate_filters(num_sources, harmonics, composite_notches);
+    filter.init(rate_hz, params);
+}
+
+static float source_freq(uint8_t i)
+{
+    return base_freq + 10 * i;
+}
+
+/*
+  the same notches as the harmonic notch with the same sources, run
+  one NotchFilter at a time
+ */
+static void BM_NotchChain(benchmark::State& state)
+{
+    const uint8_t num_sources = state.range(0);
+    const uint8_t num_harmonics = __builtin_popcount(harmonics);
+    const uint16_t num_notches = num_sources * num_harmonics * composite_notches;
+    NotchFilterVector3f *chain = new NotchFilterVector3f[num_notches];
+    const float spread = bandwidth / (32 * base_freq);
+    const float spread_mul[composite_notches] { 1.0, 1.0 - spread, 1.0 + spread };
+    float A, Q;
+    NotchFilterVector3f::calculate_A_and_Q(base_freq, bandwidth / composite_notches, attenuation_dB, A, Q);
+    uint16_t idx = 0;
+    for (uint8_t h=0; h<num_harmonics; h++) {
+        for (uint8_t i=0; i<num_sources; i++) {
+            for (uint8_t c=0; c<composite_notches; c++) {
+                chain[idx++].init_with_A_and_Q(rate_hz, source_freq(i) * (h+1) * spread_mul[c], A, Q);
+            }
+        }
+    }
+    uint32_t n = 0;
+    while (state.KeepRunning()) {
+        Vector3f v = bench_sample(n++);
+        for (uint16_t i=0; i<num_notches; i++) {
+            v = chain[i].apply(v);
+        }
+        gbenchmark_escape(&v);
+    }
+    delete[] chain;
+}
+
+static void BM_HarmonicNotch(benchmark::State& state)
+{
+    const uint8_t num_sources = state.range(0);
+    HarmonicNotchFilterParams params {};
+    HarmonicNotchFilterVector3f filter {};
+    setup_harmonic_notch(filter, params, num_sources);
+    float freqs[8];
+    for (uint8_t i=0; i<num_sources; i++) {
+        freqs[i] = source_freq(i);
+    }
+    filter.update(num_sources, freqs);
+
+    uint32_t n = 0;
+    while (state.KeepRunning()) {
+        Vector3f v = filter.apply(bench_sample(n++));
+        gbenchmark_escape(&v);
+    }
+}
+
+// coefficient updates, as done at the loop rate with ESC telemetry
+static void BM_HarmonicNotchUpdate(benchmark::State& state)
+{
+    const uint8_t num_sources = state.range(0);
+    HarmonicNotchFilterParams params {};
+    HarmonicNotchFilterVector3f filter {};
+    setup_harmonic_notch(filter, params, num_sources);
+    float freqs[8];
+    uint32_t n = 0;
+    while (state.KeepRunning()) {
+        for (uint8_t i=0; i<num_sources; i++) {
+            freqs[i] = source_freq(i) + (n & 1);
+        }
+        n++;
+        filter.update(num_sources, freqs);
+        gbenchmark_escape(&filter);
+    }
+}
+
+BENCHMARK(BM_NotchChain)->Arg(1)->Arg(4)->Arg(8);
+BENCHMARK(BM_HarmonicNotch)->Arg(1)->Arg(4)->Arg(8);
+BENCHMARK(BM_HarmonicNotchUpdate)->Arg(1)->Arg(4)->Arg(8);
+
+BENCHMARK_MAIN();
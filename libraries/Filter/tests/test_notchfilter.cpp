@@ -363,4 +363,76 @@ TEST(NotchFilterTest, HarmonicNotchTest5)
     fclose(f);
 }
 
+/*
+  check a Vector3f harmonic notch against a chain of individual
+  notches updated the same way, including slewing of the centers, a
+  reset and notches being disabled and enabled again. The bank sums
+  the terms of each notch in a different order, so allow for rounding
+ */
+TEST(NotchFilterTest, HarmonicNotchMatchesChain)
+{
+    const float rate_hz = 1000;
+    const float base_freq = 50;
+    const float bandwidth = 25;
+    const float attenuation_dB = 40;
+    const uint32_t samples = 6000;
+
+    HarmonicNotchFilter<Vector3f> filter {};
+    HarmonicNotchFilterParams notch_params {};
+    notch_params.set_attenuation(attenuation_dB);
+    notch_params.set_bandwidth_hz(bandwidth);
+    notch_params.set_center_freq_hz(base_freq);
+    notch_params.set_freq_min_ratio(1.0);
+    notch_params.set_options(0);
+    // 1st and 2nd harmonics
+    filter.allocate_filters(1, 3, 1);
+    filter.init(rate_hz, notch_params);
+
+    NotchFilter<Vector3f> chain[2] {};
+    float A, Q;
+    NotchFilter<Vector3f>::calculate_A_and_Q(base_freq, bandwidth, attenuation_dB, A, Q);
+
+    // start both from the base frequency, whatever the tracking mode
+    filter.update(base_freq);
+    for (uint8_t h=0; h<ARRAY_SIZE(chain); h++) {
+        chain[h].init_with_A_and_Q(rate_hz, base_freq * (h+1), A, Q);
+    }
+
+    for (uint32_t s=0; s<samples; s++) {
+        // sweep up, drop below the disable frequency then come back
+        float freq = 60 + 60 * s / float(samples);
+        if (s >= 4000 && s < 4500) {
+            freq = 5;
+        }
+        filter.update(freq);
+        for (uint8_t h=0; h<ARRAY_SIZE(chain); h++) {
+            if (freq * (h+1) < base_freq * 0.25) {
+                chain[h].disable();
+            } else {
+                chain[h].init_with_A_and_Q(rate_hz, freq * (h+1), A, Q);
+            }
+        }
+        if (s == 2000) {
+            filter.reset();
+            chain[0].reset();
+            chain[1].reset();
+        }
+
+        const double t = s / rate_hz;
+        const Vector3f sample {
+            float(sin(freq * t * 2 * M_PI)),
+            float(0.5 * cos(2 * freq * t * 2 * M_PI)),
+            float(0.3 * sin(37 * t * 2 * M_PI) + 0.1),
+        };
+        const Vector3f v = filter.apply(sample);
+        Vector3f expected = sample;
+        for (auto &notch : chain) {
+            expected = notch.apply(expected);
+        }
+        EXPECT_NEAR(v.x, expected.x, 1e-5);
+        EXPECT_NEAR(v.y, expected.y, 1e-5);
+        EXPECT_NEAR(v.z, expected.z, 1e-5);
+    }
+}
+
 AP_GTEST_MAIN()
@@ -206,6 +206,17 @@ void GCS::send_to_active_channels(uint32_t msgid, const char *pkt)
     }
 }
 
+// requested and achieved rates of streamed messages, in Hz, with the
+// estimated bandwidth of each link in bytes/s (0 if not limited)
+void GCS::stream_rate_info(ExpandingString &str) const
+{
+    // a header to allow for machine parsers to determine format
+    str.printf("StreamsV1\n");
+    for (uint8_t i=0; i<num_gcs(); i++) {
+        chan(i)->stream_rate_info(str);
+    }
+}
+
 void GCS::send_named_float(const char *name, float value) const
 {
 
@@ -484,6 +484,14 @@ public:
     virtual uint64_t capabilities() const;
     uint16_t get_stream_slowdown_ms() const { return stream_slowdown_ms; }
 
+    // get the interval a message is actually being sent at, which is
+    // longer than requested when the link is short of bandwidth.
+    // Returns false if the message is not being sent
+    bool get_ap_message_achieved_interval(ap_message id, uint16_t &interval_ms) const;
+
+    // add requested and achieved rates of each streamed message to str
+    void stream_rate_info(ExpandingString &str) const;
+
     MAV_RESULT set_message_interval(uint32_t msg_id, int32_t interval_us);
 
 protected:
@@ -842,15 +850,43 @@ private:
                                                          // queued send
     uint32_t                    _queued_parameter_send_time_ms;
 
-    // number of extra ms to add to slow things down for the radio
+    // number of extra ms the radio's transmit buffer is behind by,
+    // from RADIO_STATUS. Used to allow more time for transfers
     uint16_t         stream_slowdown_ms;
 
+    // stream-rated messages are given a priority.  When the link is
+    // short of bandwidth the lower priorities are slowed down first
+    enum class StreamPriority : uint8_t {
+        LOW,
+        NORMAL,
+        HIGH,
+    };
+    static constexpr uint8_t NUM_STREAM_PRIORITIES = 3;
+    static StreamPriority get_ap_message_priority(ap_message id);
+
+    // estimate of the bandwidth available on the link, measured over
+    // a window of about a second.  The estimate is lowered when
+    // RADIO_STATUS shows the radio's buffer filling or we run out of
+    // txspace, and raised again while neither happens
+    struct {
+        uint32_t link_bytes_per_s;      // 0 if the link has not been limited
+        uint32_t sent_bytes_per_s;      // bytes sent over the last window
+        uint32_t window_start_ms;
+        uint32_t window_start_tx_bytes;
+        uint32_t window_bucket_bytes;   // bytes sent from buckets this window
+        uint32_t radio_status_ms;       // time RADIO_STATUS was received on this link
+        uint16_t window_start_out_of_space;
+        // multiplier applied to the interval of each priority's buckets
+        float interval_scale[NUM_STREAM_PRIORITIES] { 1.0f, 1.0f, 1.0f };
+    } stream_budget;
+    void update_stream_budget();
+
     // outbound ("deferred message") queue.
 
     // "special" messages such as heartbeat, next_param etc are stored
     // separately to stream-rated messages like AHRS2 etc.  If these
     // were to be stored in buckets then they would be slowed down
-    // based on stream_slowdown, which we have not traditionally done.
+    // based on the link bandwidth, which we have not traditionally done.
     struct deferred_message_t {
         const ap_message id;
         uint16_t interval_ms;
@@ -874,6 +910,11 @@ private:
         Bitmask<MSG_LAST> ap_message_ids;
         uint16_t interval_ms;
         uint16_t last_sent_ms; // from AP_HAL::millis16()
+        StreamPriority priority;
+        uint16_t pass_bytes;            // bytes sent so far in this pass
+        uint16_t bytes_per_pass;        // filtered bytes sent per pass
+        uint16_t achieved_interval_ms;  // filtered time between passes
+        uint32_t last_pass_ms;          // time the last pass finished
     };
     deferred_message_bucket_t deferred_message_bucket[10];
     static const uint8_t no_bucket_to_send = -1;
@@ -884,6 +925,10 @@ private:
     ap_message next_deferred_bucket_message_to_send(uint16_t now16_ms);
     void find_next_bucket_to_send(uint16_t now16_ms);
     void remove_message_from_bucket(int8_t bucket, ap_message id);
+    // record bytes sent for the message just sent from sending_bucket_id
+    void bucket_message_sent(uint32_t sent_bytes);
+    // record that every message in sending_bucket_id has been sent
+    void bucket_pass_finished();
 
     // bitmask of IDs the code has spontaneously decided it wants to
     // send out.  Examples include HEARTBEAT (gcs_send_heartbeat)
@@ -908,6 +953,9 @@ private:
     // try_send_message, will cause a mavlink message with that id to
     // be emitted.  Returns MSG_LAST if no such mapping exists.
     ap_message mavlink_id_to_ap_message_id(const uint32_t mavlink_id) const;
+    // map an ap_message to the mavlink ID it is sent as.  Returns
+    // false if no such mapping exists.
+    static bool ap_message_id_to_mavlink_id(const ap_message id, uint32_t &mavlink_id);
     // set the interval at which an ap_message should be emitted (in ms)
     bool set_ap_message_interval(enum ap_message id, uint16_t interval_ms);
     // call set_ap_message_interval for each entry in a stream,
@@ -1234,6 +1282,9 @@ public:
     virtual const GCS_MAVLINK *chan(const uint8_t ofs) const = 0;
     // return the number of valid GCS objects
     uint8_t num_gcs() const { return _num_gcs; };
+
+    // add requested and achieved stream rates of every channel to str
+    void stream_rate_info(ExpandingString &str) const;
     void send_message(enum ap_message id);
     void send_mission_item_reached_message(uint16_t mission_index);
     void send_named_float(const char *name, float value) const;
@@ -908,10 +908,10 @@ void GCS_MAVLINK::handle_radio_status(const mavlink_message_t &msg)
     }
 
     last_radio_status.txbuf = packet.txbuf;
+    stream_budget.radio_status_ms = now;
 
-    // use the state of the transmit buffer in the radio to
-    // control the stream rate, giving us adaptive software
-    // flow control
+    // track how far behind the radio is. The stream rates
+    // themselves are adjusted in update_stream_budget()
     if (packet.txbuf < 20 && stream_slowdown_ms < 2000) {
         // we are very low on space - slow down a lot
         stream_slowdown_ms += 60;
@@ -1022,186 +1022,197 @@ void GCS_MAVLINK::handle_mission_item(const mavlink_message_t &msg)
     prot->handle_mission_item(msg, mission_item_int);
 }
 
-ap_message GCS_MAVLINK::mavlink_id_to_ap_message_id(const uint32_t mavlink_id) const
-{
-    // MSG_NEXT_MISSION_REQUEST doesn't correspond to a mavlink message directly.
-    // It is used to request the next waypoint after receiving one.
+// MSG_NEXT_MISSION_REQUEST doesn't correspond to a mavlink message directly.
+// It is used to request the next waypoint after receiving one.
 
-    // MSG_NEXT_PARAM doesn't correspond to a mavlink message directly.
-    // It is used to send the next parameter in a stream after sending one
+// MSG_NEXT_PARAM doesn't correspond to a mavlink message directly.
+// It is used to send the next parameter in a stream after sending one
 
-    // MSG_NAMED_FLOAT messages can't really be "streamed"...
+// MSG_NAMED_FLOAT messages can't really be "streamed"...
 
-    static const struct {
-        uint32_t mavlink_id;
-        ap_message msg_id;
-    } map[] {
-        { MAVLINK_MSG_ID_HEARTBEAT,             MSG_HEARTBEAT},
-        { MAVLINK_MSG_ID_HOME_POSITION,         MSG_HOME},
-        { MAVLINK_MSG_ID_GPS_GLOBAL_ORIGIN,     MSG_ORIGIN},
-        { MAVLINK_MSG_ID_SYS_STATUS,            MSG_SYS_STATUS},
-        { MAVLINK_MSG_ID_POWER_STATUS,          MSG_POWER_STATUS},
+static const struct {
+    uint32_t mavlink_id;
+    ap_message msg_id;
+} ap_message_mavlink_ids[] {
+    { MAVLINK_MSG_ID_HEARTBEAT,             MSG_HEARTBEAT},
+    { MAVLINK_MSG_ID_HOME_POSITION,         MSG_HOME},
+    { MAVLINK_MSG_ID_GPS_GLOBAL_ORIGIN,     MSG_ORIGIN},
+    { MAVLINK_MSG_ID_SYS_STATUS,            MSG_SYS_STATUS},
+    { MAVLINK_MSG_ID_POWER_STATUS,          MSG_POWER_STATUS},
 #if HAL_WITH_MCU_MONITORING
-        { MAVLINK_MSG_ID_MCU_STATUS,            MSG_MCU_STATUS},
+    { MAVLINK_MSG_ID_MCU_STATUS,            MSG_MCU_STATUS},
 #endif
-        { MAVLINK_MSG_ID_MEMINFO,               MSG_MEMINFO},
-        { MAVLINK_MSG_ID_NAV_CONTROLLER_OUTPUT, MSG_NAV_CONTROLLER_OUTPUT},
-        { MAVLINK_MSG_ID_MISSION_CURRENT,       MSG_CURRENT_WAYPOINT},
-        { MAVLINK_MSG_ID_SERVO_OUTPUT_RAW,      MSG_SERVO_OUTPUT_RAW},
-        { MAVLINK_MSG_ID_RC_CHANNELS,           MSG_RC_CHANNELS},
+    { MAVLINK_MSG_ID_MEMINFO,               MSG_MEMINFO},
+    { MAVLINK_MSG_ID_NAV_CONTROLLER_OUTPUT, MSG_NAV_CONTROLLER_OUTPUT},
+    { MAVLINK_MSG_ID_MISSION_CURRENT,       MSG_CURRENT_WAYPOINT},
+    { MAVLINK_MSG_ID_SERVO_OUTPUT_RAW,      MSG_SERVO_OUTPUT_RAW},
+    { MAVLINK_MSG_ID_RC_CHANNELS,           MSG_RC_CHANNELS},
 #if AP_MAVLINK_MSG_RC_CHANNELS_RAW_ENABLED
-        { MAVLINK_MSG_ID_RC_CHANNELS_RAW,       MSG_RC_CHANNELS_RAW},
+    { MAVLINK_MSG_ID_RC_CHANNELS_RAW,       MSG_RC_CHANNELS_RAW},
 #endif
-        { MAVLINK_MSG_ID_RAW_IMU,               MSG_RAW_IMU},
-        { MAVLINK_MSG_ID_SCALED_IMU,            MSG_SCALED_IMU},
-        { MAVLINK_MSG_ID_SCALED_IMU2,           MSG_SCALED_IMU2},
-        { MAVLINK_MSG_ID_SCALED_IMU3,           MSG_SCALED_IMU3},
+    { MAVLINK_MSG_ID_RAW_IMU,               MSG_RAW_IMU},
+    { MAVLINK_MSG_ID_SCALED_IMU,            MSG_SCALED_IMU},
+    { MAVLINK_MSG_ID_SCALED_IMU2,           MSG_SCALED_IMU2},
+    { MAVLINK_MSG_ID_SCALED_IMU3,           MSG_SCALED_IMU3},
 #if AP_MAVLINK_MSG_HIGHRES_IMU_ENABLED
-        { MAVLINK_MSG_ID_HIGHRES_IMU,           MSG_HIGHRES_IMU},
+    { MAVLINK_MSG_ID_HIGHRES_IMU,           MSG_HIGHRES_IMU},
 #endif
-        { MAVLINK_MSG_ID_SCALED_PRESSURE,       MSG_SCALED_PRESSURE},
-        { MAVLINK_MSG_ID_SCALED_PRESSURE2,      MSG_SCALED_PRESSURE2},
-        { MAVLINK_MSG_ID_SCALED_PRESSURE3,      MSG_SCALED_PRESSURE3},
+    { MAVLINK_MSG_ID_SCALED_PRESSURE,       MSG_SCALED_PRESSURE},
+    { MAVLINK_MSG_ID_SCALED_PRESSURE2,      MSG_SCALED_PRESSURE2},
+    { MAVLINK_MSG_ID_SCALED_PRESSURE3,      MSG_SCALED_PRESSURE3},
 #if AP_GPS_GPS_RAW_INT_SENDING_ENABLED
-        { MAVLINK_MSG_ID_GPS_RAW_INT,           MSG_GPS_RAW},
+    { MAVLINK_MSG_ID_GPS_RAW_INT,           MSG_GPS_RAW},
 #endif
 #if AP_GPS_GPS_RTK_SENDING_ENABLED
-        { MAVLINK_MSG_ID_GPS_RTK,               MSG_GPS_RTK},
+    { MAVLINK_MSG_ID_GPS_RTK,               MSG_GPS_RTK},
 #endif
 #if AP_GPS_GPS2_RAW_SENDING_ENABLED
-        { MAVLINK_MSG_ID_GPS2_RAW,              MSG_GPS2_RAW},
+    { MAVLINK_MSG_ID_GPS2_RAW,              MSG_GPS2_RAW},
 #endif
 #if AP_GPS_GPS2_RTK_SENDING_ENABLED
-        { MAVLINK_MSG_ID_GPS2_RTK,              MSG_GPS2_RTK},
+    { MAVLINK_MSG_ID_GPS2_RTK,              MSG_GPS2_RTK},
 #endif
-        { MAVLINK_MSG_ID_SYSTEM_TIME,           MSG_SYSTEM_TIME},
+    { MAVLINK_MSG_ID_SYSTEM_TIME,           MSG_SYSTEM_TIME},
 #if APM_BUILD_TYPE(APM_BUILD_Rover)
-        { MAVLINK_MSG_ID_RC_CHANNELS_SCALED,    MSG_SERVO_OUT},
+    { MAVLINK_MSG_ID_RC_CHANNELS_SCALED,    MSG_SERVO_OUT},
 #endif  // APM_BUILD_TYPE(APM_BUILD_Rover)
-        { MAVLINK_MSG_ID_PARAM_VALUE,           MSG_NEXT_PARAM},
+    { MAVLINK_MSG_ID_PARAM_VALUE,           MSG_NEXT_PARAM},
 #if AP_FENCE_ENABLED
-        { MAVLINK_MSG_ID_FENCE_STATUS,          MSG_FENCE_STATUS},
+    { MAVLINK_MSG_ID_FENCE_STATUS,          MSG_FENCE_STATUS},
 #endif
 #if AP_SIM_ENABLED
-        { MAVLINK_MSG_ID_SIMSTATE,              MSG_SIMSTATE},
-        { MAVLINK_MSG_ID_SIM_STATE,             MSG_SIM_STATE},
+    { MAVLINK_MSG_ID_SIMSTATE,              MSG_SIMSTATE},
+    { MAVLINK_MSG_ID_SIM_STATE,             MSG_SIM_STATE},
 #endif
 #if AP_AHRS_ENABLED
-        { MAVLINK_MSG_ID_AHRS2,                 MSG_AHRS2},
-        { MAVLINK_MSG_ID_AHRS,                  MSG_AHRS},
-        { MAVLINK_MSG_ID_ATTITUDE,              MSG_ATTITUDE},
-        { MAVLINK_MSG_ID_ATTITUDE_QUATERNION,   MSG_ATTITUDE_QUATERNION},
-        { MAVLINK_MSG_ID_GLOBAL_POSITION_INT,   MSG_LOCATION},
-        { MAVLINK_MSG_ID_LOCAL_POSITION_NED,    MSG_LOCAL_POSITION},
-        { MAVLINK_MSG_ID_VFR_HUD,               MSG_VFR_HUD},
-#endif
-        { MAVLINK_MSG_ID_HWSTATUS,              MSG_HWSTATUS},
-        { MAVLINK_MSG_ID_WIND,                  MSG_WIND},
+    { MAVLINK_MSG_ID_AHRS2,                 MSG_AHRS2},
+    { MAVLINK_MSG_ID_AHRS,                  MSG_AHRS},
+    { MAVLINK_MSG_ID_ATTITUDE,              MSG_ATTITUDE},
+    { MAVLINK_MSG_ID_ATTITUDE_QUATERNION,   MSG_ATTITUDE_QUATERNION},
+    { MAVLINK_MSG_ID_GLOBAL_POSITION_INT,   MSG_LOCATION},
+    { MAVLINK_MSG_ID_LOCAL_POSITION_NED,    MSG_LOCAL_POSITION},
+    { MAVLINK_MSG_ID_VFR_HUD,               MSG_VFR_HUD},
+#endif
+    { MAVLINK_MSG_ID_HWSTATUS,              MSG_HWSTATUS},
+    { MAVLINK_MSG_ID_WIND,                  MSG_WIND},
 #if AP_MAVLINK_MSG_RANGEFINDER_SENDING_ENABLED
-        { MAVLINK_MSG_ID_RANGEFINDER,           MSG_RANGEFINDER},
+    { MAVLINK_MSG_ID_RANGEFINDER,           MSG_RANGEFINDER},
 #endif  // AP_MAVLINK_MSG_RANGEFINDER_SENDING_ENABLED
-        { MAVLINK_MSG_ID_DISTANCE_SENSOR,       MSG_DISTANCE_SENSOR},
+    { MAVLINK_MSG_ID_DISTANCE_SENSOR,       MSG_DISTANCE_SENSOR},
 #if AP_TERRAIN_AVAILABLE
-        { MAVLINK_MSG_ID_TERRAIN_REQUEST,       MSG_TERRAIN_REQUEST},
-        { MAVLINK_MSG_ID_TERRAIN_REPORT,        MSG_TERRAIN_REPORT},
+    { MAVLINK_MSG_ID_TERRAIN_REQUEST,       MSG_TERRAIN_REQUEST},
+    { MAVLINK_MSG_ID_TERRAIN_REPORT,        MSG_TERRAIN_REPORT},
 #endif
 #if AP_CAMERA_ENABLED
-        { MAVLINK_MSG_ID_CAMERA_FEEDBACK,       MSG_CAMERA_FEEDBACK},
-        { MAVLINK_MSG_ID_CAMERA_INFORMATION,    MSG_CAMERA_INFORMATION},
-        { MAVLINK_MSG_ID_CAMERA_SETTINGS,       MSG_CAMERA_SETTINGS},
+    { MAVLINK_MSG_ID_CAMERA_FEEDBACK,       MSG_CAMERA_FEEDBACK},
+    { MAVLINK_MSG_ID_CAMERA_INFORMATION,    MSG_CAMERA_INFORMATION},
+    { MAVLINK_MSG_ID_CAMERA_SETTINGS,       MSG_CAMERA_SETTINGS},
 #if AP_CAMERA_SEND_FOV_STATUS_ENABLED
-        { MAVLINK_MSG_ID_CAMERA_FOV_STATUS,     MSG_CAMERA_FOV_STATUS},
+    { MAVLINK_MSG_ID_CAMERA_FOV_STATUS,     MSG_CAMERA_FOV_STATUS},
 #endif
-        { MAVLINK_MSG_ID_CAMERA_CAPTURE_STATUS, MSG_CAMERA_CAPTURE_STATUS},
+    { MAVLINK_MSG_ID_CAMERA_CAPTURE_STATUS, MSG_CAMERA_CAPTURE_STATUS},
 #if AP_CAMERA_SEND_THERMAL_RANGE_ENABLED
-        { MAVLINK_MSG_ID_CAMERA_THERMAL_RANGE,  MSG_CAMERA_THERMAL_RANGE},
+    { MAVLINK_MSG_ID_CAMERA_THERMAL_RANGE,  MSG_CAMERA_THERMAL_RANGE},
 #endif // AP_CAMERA_SEND_THERMAL_RANGE_ENABLED
 #if AP_MAVLINK_MSG_VIDEO_STREAM_INFORMATION_ENABLED
-        { MAVLINK_MSG_ID_VIDEO_STREAM_INFORMATION, MSG_VIDEO_STREAM_INFORMATION},
+    { MAVLINK_MSG_ID_VIDEO_STREAM_INFORMATION, MSG_VIDEO_STREAM_INFORMATION},
 #endif // AP_MAVLINK_MSG_VIDEO_STREAM_INFORMATION_ENABLED
 #endif // AP_CAMERA_ENABLED
 #if HAL_MOUNT_ENABLED
-        { MAVLINK_MSG_ID_GIMBAL_DEVICE_ATTITUDE_STATUS, MSG_GIMBAL_DEVICE_ATTITUDE_STATUS},
-        { MAVLINK_MSG_ID_AUTOPILOT_STATE_FOR_GIMBAL_DEVICE, MSG_AUTOPILOT_STATE_FOR_GIMBAL_DEVICE},
-        { MAVLINK_MSG_ID_GIMBAL_MANAGER_INFORMATION, MSG_GIMBAL_MANAGER_INFORMATION},
-        { MAVLINK_MSG_ID_GIMBAL_MANAGER_STATUS, MSG_GIMBAL_MANAGER_STATUS},
+    { MAVLINK_MSG_ID_GIMBAL_DEVICE_ATTITUDE_STATUS, MSG_GIMBAL_DEVICE_ATTITUDE_STATUS},
+    { MAVLINK_MSG_ID_AUTOPILOT_STATE_FOR_GIMBAL_DEVICE, MSG_AUTOPILOT_STATE_FOR_GIMBAL_DEVICE},
+    { MAVLINK_MSG_ID_GIMBAL_MANAGER_INFORMATION, MSG_GIMBAL_MANAGER_INFORMATION},
+    { MAVLINK_MSG_ID_GIMBAL_MANAGER_STATUS, MSG_GIMBAL_MANAGER_STATUS},
 #endif
 #if AP_OPTICALFLOW_ENABLED
-        { MAVLINK_MSG_ID_OPTICAL_FLOW,          MSG_OPTICAL_FLOW},
+    { MAVLINK_MSG_ID_OPTICAL_FLOW,          MSG_OPTICAL_FLOW},
 #endif
 #if COMPASS_CAL_ENABLED
-        { MAVLINK_MSG_ID_MAG_CAL_PROGRESS,      MSG_MAG_CAL_PROGRESS},
-        { MAVLINK_MSG_ID_MAG_CAL_REPORT,        MSG_MAG_CAL_REPORT},
+    { MAVLINK_MSG_ID_MAG_CAL_PROGRESS,      MSG_MAG_CAL_PROGRESS},
+    { MAVLINK_MSG_ID_MAG_CAL_REPORT,        MSG_MAG_CAL_REPORT},
 #endif
-        { MAVLINK_MSG_ID_EKF_STATUS_REPORT,     MSG_EKF_STATUS_REPORT},
-        { MAVLINK_MSG_ID_PID_TUNING,            MSG_PID_TUNING},
-        { MAVLINK_MSG_ID_VIBRATION,             MSG_VIBRATION},
+    { MAVLINK_MSG_ID_EKF_STATUS_REPORT,     MSG_EKF_STATUS_REPORT},
+    { MAVLINK_MSG_ID_PID_TUNING,            MSG_PID_TUNING},
+    { MAVLINK_MSG_ID_VIBRATION,             MSG_VIBRATION},
 #if AP_RPM_ENABLED
-        { MAVLINK_MSG_ID_RPM,                   MSG_RPM},
+    { MAVLINK_MSG_ID_RPM,                   MSG_RPM},
 #endif
-        { MAVLINK_MSG_ID_MISSION_ITEM_REACHED,  MSG_MISSION_ITEM_REACHED},
-        { MAVLINK_MSG_ID_ATTITUDE_TARGET,       MSG_ATTITUDE_TARGET},
-        { MAVLINK_MSG_ID_POSITION_TARGET_GLOBAL_INT,  MSG_POSITION_TARGET_GLOBAL_INT},
-        { MAVLINK_MSG_ID_POSITION_TARGET_LOCAL_NED,  MSG_POSITION_TARGET_LOCAL_NED},
+    { MAVLINK_MSG_ID_MISSION_ITEM_REACHED,  MSG_MISSION_ITEM_REACHED},
+    { MAVLINK_MSG_ID_ATTITUDE_TARGET,       MSG_ATTITUDE_TARGET},
+    { MAVLINK_MSG_ID_POSITION_TARGET_GLOBAL_INT,  MSG_POSITION_TARGET_GLOBAL_INT},
+    { MAVLINK_MSG_ID_POSITION_TARGET_LOCAL_NED,  MSG_POSITION_TARGET_LOCAL_NED},
 #if HAL_ADSB_ENABLED
-        { MAVLINK_MSG_ID_ADSB_VEHICLE,          MSG_ADSB_VEHICLE},
+    { MAVLINK_MSG_ID_ADSB_VEHICLE,          MSG_ADSB_VEHICLE},
 #endif
 #if AP_BATTERY_ENABLED
-        { MAVLINK_MSG_ID_BATTERY_STATUS,        MSG_BATTERY_STATUS},
+    { MAVLINK_MSG_ID_BATTERY_STATUS,        MSG_BATTERY_STATUS},
 #endif
 #if APM_BUILD_TYPE(APM_BUILD_ArduPlane)
-        { MAVLINK_MSG_ID_AOA_SSA,               MSG_AOA_SSA},
+    { MAVLINK_MSG_ID_AOA_SSA,               MSG_AOA_SSA},
 #endif  // APM_BUILD_ArduPlane
 #if HAL_LANDING_DEEPSTALL_ENABLED && APM_BUILD_TYPE(APM_BUILD_ArduPlane)
-        { MAVLINK_MSG_ID_DEEPSTALL,             MSG_LANDING},
+    { MAVLINK_MSG_ID_DEEPSTALL,             MSG_LANDING},
 #endif
-        { MAVLINK_MSG_ID_EXTENDED_SYS_STATE,    MSG_EXTENDED_SYS_STATE},
-        { MAVLINK_MSG_ID_AUTOPILOT_VERSION,     MSG_AUTOPILOT_VERSION},
+    { MAVLINK_MSG_ID_EXTENDED_SYS_STATE,    MSG_EXTENDED_SYS_STATE},
+    { MAVLINK_MSG_ID_AUTOPILOT_VERSION,     MSG_AUTOPILOT_VERSION},
 #if HAL_EFI_ENABLED
-        { MAVLINK_MSG_ID_EFI_STATUS,            MSG_EFI_STATUS},
+    { MAVLINK_MSG_ID_EFI_STATUS,            MSG_EFI_STATUS},
 #endif
 #if HAL_GENERATOR_ENABLED
-        { MAVLINK_MSG_ID_GENERATOR_STATUS,      MSG_GENERATOR_STATUS},
+    { MAVLINK_MSG_ID_GENERATOR_STATUS,      MSG_GENERATOR_STATUS},
 #endif
 #if AP_WINCH_ENABLED
-        { MAVLINK_MSG_ID_WINCH_STATUS,          MSG_WINCH_STATUS},
+    { MAVLINK_MSG_ID_WINCH_STATUS,          MSG_WINCH_STATUS},
 #endif
 #if HAL_WITH_ESC_TELEM
-        { MAVLINK_MSG_ID_ESC_TELEMETRY_1_TO_4,  MSG_ESC_TELEMETRY},
+    { MAVLINK_MSG_ID_ESC_TELEMETRY_1_TO_4,  MSG_ESC_TELEMETRY},
 #endif
 #if AP_RANGEFINDER_ENABLED && APM_BUILD_TYPE(APM_BUILD_Rover)
-        { MAVLINK_MSG_ID_WATER_DEPTH,           MSG_WATER_DEPTH},
+    { MAVLINK_MSG_ID_WATER_DEPTH,           MSG_WATER_DEPTH},
 #endif
 #if HAL_HIGH_LATENCY2_ENABLED
-        { MAVLINK_MSG_ID_HIGH_LATENCY2,         MSG_HIGH_LATENCY2},
+    { MAVLINK_MSG_ID_HIGH_LATENCY2,         MSG_HIGH_LATENCY2},
 #endif
 #if AP_AIS_ENABLED
-        { MAVLINK_MSG_ID_AIS_VESSEL,            MSG_AIS_VESSEL},
+    { MAVLINK_MSG_ID_AIS_VESSEL,            MSG_AIS_VESSEL},
 #endif
 #if AP_MAVLINK_MSG_UAVIONIX_ADSB_OUT_STATUS_ENABLED
-        { MAVLINK_MSG_ID_UAVIONIX_ADSB_OUT_STATUS, MSG_UAVIONIX_ADSB_OUT_STATUS},
+    { MAVLINK_MSG_ID_UAVIONIX_ADSB_OUT_STATUS, MSG_UAVIONIX_ADSB_OUT_STATUS},
 #endif
 #if AP_MAVLINK_MSG_RELAY_STATUS_ENABLED
-        { MAVLINK_MSG_ID_RELAY_STATUS, MSG_RELAY_STATUS},
+    { MAVLINK_MSG_ID_RELAY_STATUS, MSG_RELAY_STATUS},
 #endif
 #if AP_AIRSPEED_ENABLED
-        { MAVLINK_MSG_ID_AIRSPEED, MSG_AIRSPEED},
+    { MAVLINK_MSG_ID_AIRSPEED, MSG_AIRSPEED},
 #endif
-        { MAVLINK_MSG_ID_AVAILABLE_MODES, MSG_AVAILABLE_MODES},
-        { MAVLINK_MSG_ID_AVAILABLE_MODES_MONITOR, MSG_AVAILABLE_MODES_MONITOR},
+    { MAVLINK_MSG_ID_AVAILABLE_MODES, MSG_AVAILABLE_MODES},
+    { MAVLINK_MSG_ID_AVAILABLE_MODES_MONITOR, MSG_AVAILABLE_MODES_MONITOR},
 #if AP_MAVLINK_MSG_FLIGHT_INFORMATION_ENABLED
-        { MAVLINK_MSG_ID_FLIGHT_INFORMATION, MSG_FLIGHT_INFORMATION},
+    { MAVLINK_MSG_ID_FLIGHT_INFORMATION, MSG_FLIGHT_INFORMATION},
 #endif
-    };
+};
 
-    for (uint8_t i=0; i<ARRAY_SIZE(map); i++) {
-        if (map[i].mavlink_id == mavlink_id) {
-            return map[i].msg_id;
+ap_message GCS_MAVLINK::mavlink_id_to_ap_message_id(const uint32_t mavlink_id) const
+{
+    for (uint8_t i=0; i<ARRAY_SIZE(ap_message_mavlink_ids); i++) {
+        if (ap_message_mavlink_ids[i].mavlink_id == mavlink_id) {
+            return ap_message_mavlink_ids[i].msg_id;
         }
     }
     return MSG_LAST;
 }
 
+bool GCS_MAVLINK::ap_message_id_to_mavlink_id(const ap_message id, uint32_t &mavlink_id)
+{
+    for (uint8_t i=0; i<ARRAY_SIZE(ap_message_mavlink_ids); i++) {
+        if (ap_message_mavlink_ids[i].msg_id == id) {
+            mavlink_id = ap_message_mavlink_ids[i].mavlink_id;
+            return true;
+        }
+    }
+    return false;
+}
+
 bool GCS_MAVLINK::set_mavlink_message_id_interval(const uint32_t mavlink_id,
                                                   const uint16_t interval_ms)
 {
@@ -1237,9 +1248,8 @@ bool GCS_MAVLINK::should_send_message_in_delay_callback(const ap_message id) con
 
 uint16_t GCS_MAVLINK::get_reschedule_interval_ms(const deferred_message_bucket_t &deferred) const
 {
-    uint32_t interval_ms = deferred.interval_ms;
-
-    interval_ms += stream_slowdown_ms;
+    // slow the bucket down to fit its priority's share of the link:
+    uint32_t interval_ms = uint32_t(deferred.interval_ms * stream_budget.interval_scale[uint8_t(deferred.priority)]);
 
     // slow most messages down if we're transfering parameters or
     // waypoints:
@@ -1265,6 +1275,189 @@ uint16_t GCS_MAVLINK::get_reschedule_interval_ms(const deferred_message_bucket_t
     return interval_ms;
 }
 
+// priority of a stream-rated message when the link is short of
+// bandwidth.  Messages a pilot relies on to fly are HIGH, bulk sensor
+// and debug data is LOW
+GCS_MAVLINK::StreamPriority GCS_MAVLINK::get_ap_message_priority(ap_message id)
+{
+    switch (id) {
+    case MSG_HEARTBEAT:
+    case MSG_SYS_STATUS:
+#if AP_AHRS_ENABLED
+    case MSG_ATTITUDE:
+    case MSG_ATTITUDE_QUATERNION:
+    case MSG_LOCATION:
+    case MSG_VFR_HUD:
+#endif
+    case MSG_GPS_RAW:
+    case MSG_CURRENT_WAYPOINT:
+    case MSG_HOME:
+    case MSG_BATTERY_STATUS:
+    case MSG_EKF_STATUS_REPORT:
+    case MSG_EXTENDED_SYS_STATE:
+        return StreamPriority::HIGH;
+#if AP_AHRS_ENABLED
+    case MSG_AHRS:
+    case MSG_AHRS2:
+#endif
+    case MSG_POWER_STATUS:
+    case MSG_MEMINFO:
+    case MSG_MCU_STATUS:
+    case MSG_SERVO_OUTPUT_RAW:
+    case MSG_RC_CHANNELS_RAW:
+    case MSG_RAW_IMU:
+    case MSG_SCALED_IMU:
+    case MSG_SCALED_IMU2:
+    case MSG_SCALED_IMU3:
+#if AP_MAVLINK_MSG_HIGHRES_IMU_ENABLED
+    case MSG_HIGHRES_IMU:
+#endif
+    case MSG_SCALED_PRESSURE:
+    case MSG_SCALED_PRESSURE2:
+    case MSG_SCALED_PRESSURE3:
+    case MSG_SIMSTATE:
+    case MSG_SIM_STATE:
+    case MSG_HWSTATUS:
+    case MSG_PID_TUNING:
+    case MSG_VIBRATION:
+    case MSG_RPM:
+    case MSG_ESC_TELEMETRY:
+        return StreamPriority::LOW;
+    default:
+        return StreamPriority::NORMAL;
+    }
+}
+
+/*
+  update the estimate of the bandwidth the link can carry and share
+  it out between the priorities of stream-rated messages.  Each
+  priority gets its requested rate if what is left of the link can
+  carry it, and is slowed down to fit otherwise, so bulk streams are
+  slowed before important ones
+ */
+void GCS_MAVLINK::update_stream_budget()
+{
+    const uint32_t now_ms = AP_HAL::millis();
+    const uint32_t dt_ms = now_ms - stream_budget.window_start_ms;
+    if (dt_ms < 1000) {
+        return;
+    }
+
+    const uint32_t tx_bytes = comm_get_tx_bytes(chan);
+    const uint32_t sent_bytes_per_s = uint64_t(tx_bytes - stream_budget.window_start_tx_bytes) * 1000U / dt_ms;
+    const uint32_t bucket_bytes_per_s = uint64_t(stream_budget.window_bucket_bytes) * 1000U / dt_ms;
+    const bool out_of_space = out_of_space_to_send_count != stream_budget.window_start_out_of_space;
+    const bool have_radio = stream_budget.radio_status_ms != 0 && now_ms - stream_budget.radio_status_ms < 5000;
+    const bool new_radio_status = have_radio && now_ms - stream_budget.radio_status_ms < dt_ms;
+    const bool first_window = stream_budget.window_start_ms == 0;
+
+    stream_budget.window_start_ms = now_ms;
+    stream_budget.window_start_tx_bytes = tx_bytes;
+    stream_budget.window_bucket_bytes = 0;
+    stream_budget.window_start_out_of_space = out_of_space_to_send_count;
+    stream_budget.sent_bytes_per_s = sent_bytes_per_s;
+
+    if (first_window || dt_ms > 5000) {
+        // we haven't been sending, so learn nothing about the link
+        return;
+    }
+
+    // the link couldn't carry what we sent if we ran out of txspace
+    // or the radio's buffer is filling up
+    float limit_scale = 0;
+    bool can_grow = false;
+    if (out_of_space) {
+        limit_scale = 0.9f;
+    } else if (!have_radio) {
+        can_grow = true;
+    } else if (new_radio_status) {
+        const uint8_t txbuf = last_radio_status.txbuf;
+        if (txbuf < 20) {
+            limit_scale = 0.7f;
+        } else if (txbuf < 50) {
+            limit_scale = 0.9f;
+        } else if (txbuf > 90) {
+            can_grow = true;
+        }
+    }
+
+    uint32_t &link_bytes_per_s = stream_budget.link_bytes_per_s;
+    if (is_positive(limit_scale)) {
+        const uint32_t limit = MAX(uint32_t(sent_bytes_per_s * limit_scale), 200U);
+        link_bytes_per_s = link_bytes_per_s == 0 ? limit : MIN(link_bytes_per_s, limit);
+    } else if (can_grow && link_bytes_per_s != 0) {
+        // probe for more bandwidth, and stop limiting once the link
+        // is carrying well under the limit
+        link_bytes_per_s += link_bytes_per_s / 10 + 100;
+        if (link_bytes_per_s > 2 * sent_bytes_per_s) {
+            link_bytes_per_s = 0;
+        }
+    }
+
+    if (link_bytes_per_s == 0) {
+        for (uint8_t i=0; i<NUM_STREAM_PRIORITIES; i++) {
+            stream_budget.interval_scale[i] = 1.0f;
+        }
+        return;
+    }
+
+    // bytes per second each priority asks for
+    float demand[NUM_STREAM_PRIORITIES] {};
+    for (uint8_t i=0; i<ARRAY_SIZE(deferred_message_bucket); i++) {
+        const deferred_message_bucket_t &bucket = deferred_message_bucket[i];
+        if (bucket.interval_ms == 0) {
+            continue;
+        }
+        demand[uint8_t(bucket.priority)] += bucket.bytes_per_pass * 1000.0f / bucket.interval_ms;
+    }
+
+    // leave room for what is sent outside the buckets, such as
+    // parameters, mission items and heartbeats
+    const uint32_t other_bytes_per_s = sent_bytes_per_s > bucket_bytes_per_s ? sent_bytes_per_s - bucket_bytes_per_s : 0;
+    float budget = MAX(float(link_bytes_per_s) - other_bytes_per_s, link_bytes_per_s * 0.25f);
+
+    for (int8_t i=NUM_STREAM_PRIORITIES-1; i>=0; i--) {
+        float rate = 1.0f;
+        if (demand[i] > budget) {
+            // no priority is slowed by more than a factor of 20
+            rate = MAX(budget / demand[i], 0.05f);
+        }
+        stream_budget.interval_scale[i] = 1.0f / rate;
+        budget = MAX(budget - demand[i] * rate, 0.0f);
+    }
+}
+
+void GCS_MAVLINK::bucket_message_sent(uint32_t sent_bytes)
+{
+    deferred_message_bucket_t &bucket = deferred_message_bucket[sending_bucket_id];
+    bucket.pass_bytes = MIN(bucket.pass_bytes + sent_bytes, uint32_t(UINT16_MAX));
+    stream_budget.window_bucket_bytes += sent_bytes;
+}
+
+void GCS_MAVLINK::bucket_pass_finished()
+{
+    deferred_message_bucket_t &bucket = deferred_message_bucket[sending_bucket_id];
+    const uint32_t now_ms = AP_HAL::millis();
+
+    // filter the pass size and interval, giving the latest a quarter weight
+    if (bucket.bytes_per_pass == 0) {
+        bucket.bytes_per_pass = bucket.pass_bytes;
+    } else {
+        bucket.bytes_per_pass = (3U * bucket.bytes_per_pass + bucket.pass_bytes) / 4;
+    }
+    bucket.pass_bytes = 0;
+
+    if (bucket.last_pass_ms != 0) {
+        const uint16_t pass_interval_ms = MIN(now_ms - bucket.last_pass_ms, 60000U);
+        if (bucket.achieved_interval_ms == 0) {
+            bucket.achieved_interval_ms = pass_interval_ms;
+        } else {
+            bucket.achieved_interval_ms = (3U * bucket.achieved_interval_ms + pass_interval_ms) / 4;
+        }
+    }
+    bucket.last_pass_ms = now_ms;
+}
+
 // typical runtime on fmuv3: 5 microseconds for 3 buckets
 void GCS_MAVLINK::find_next_bucket_to_send(uint16_t now16_ms)
 {
@@ -1572,6 +1765,8 @@ void GCS_MAVLINK::update_send()
     // check for any in-progress tasks; check_tasks does its own rate-limiting
     GCS_MAVLINK_InProgress::check_tasks();
 
+    update_stream_budget();
+
     const uint32_t start = AP_HAL::millis();
     const uint16_t start16 = start & 0xFFFF;
     while (AP_HAL::millis() - start < 5) { // spend a max of 5ms sending messages.  This should never trigger - out_of_time() should become true
@@ -1636,11 +1831,14 @@ void GCS_MAVLINK::update_send()
 
         ap_message next = next_deferred_bucket_message_to_send(start16);
         if (next != no_message_to_send) {
+            const uint32_t tx_bytes = comm_get_tx_bytes(chan);
             if (!do_try_send_message(next)) {
                 break;
             }
+            bucket_message_sent(comm_get_tx_bytes(chan) - tx_bytes);
             bucket_message_ids_to_send.clear(next);
             if (bucket_message_ids_to_send.count() == 0) {
+                bucket_pass_finished();
                 // we sent everything in the bucket.  Reschedule it.
                 // we try to keep output on a regular clock to avoid
                 // user support questions:
@@ -1687,6 +1885,10 @@ void GCS_MAVLINK::remove_message_from_bucket(int8_t bucket, ap_message id)
         // bucket empty.  Free it:
         deferred_message_bucket[bucket].interval_ms = 0;
         deferred_message_bucket[bucket].last_sent_ms = 0;
+        deferred_message_bucket[bucket].pass_bytes = 0;
+        deferred_message_bucket[bucket].bytes_per_pass = 0;
+        deferred_message_bucket[bucket].achieved_interval_ms = 0;
+        deferred_message_bucket[bucket].last_pass_ms = 0;
     }
 
     if (bucket == sending_bucket_id) {
@@ -1732,9 +1934,12 @@ bool GCS_MAVLINK::set_ap_message_interval(enum ap_message id, uint16_t interval_
         return true;
     }
 
-    // see which bucket has the closest interval:
+    // see which bucket of the same priority has the closest interval:
+    const StreamPriority priority = get_ap_message_priority(id);
     int8_t closest_bucket = -1;
     uint16_t closest_bucket_interval_delta = UINT16_MAX;
+    int8_t closest_other_bucket = -1;
+    uint16_t closest_other_bucket_interval_delta = UINT16_MAX;
     int8_t in_bucket = -1;
     int8_t empty_bucket_id = -1;
     for (uint8_t i=0; i<ARRAY_SIZE(deferred_message_bucket); i++) {
@@ -1755,6 +1960,13 @@ bool GCS_MAVLINK::set_ap_message_interval(enum ap_message id, uint16_t interval_
             in_bucket = i;
         }
         const uint16_t interval_delta = abs(bucket.interval_ms - interval_ms);
+        if (bucket.priority != priority) {
+            if (interval_delta < closest_other_bucket_interval_delta) {
+                closest_other_bucket = i;
+                closest_other_bucket_interval_delta = interval_delta;
+            }
+            continue;
+        }
         if (interval_delta < closest_bucket_interval_delta) {
             closest_bucket = i;
             closest_bucket_interval_delta = interval_delta;
@@ -1785,6 +1997,13 @@ bool GCS_MAVLINK::set_ap_message_interval(enum ap_message id, uint16_t interval_
         }
     }
 
+    if (closest_bucket == -1 && empty_bucket_id == -1) {
+        // no bucket of this priority and none free; share one with
+        // messages of another priority
+        closest_bucket = closest_other_bucket;
+        closest_bucket_interval_delta = closest_other_bucket_interval_delta;
+    }
+
     if (closest_bucket == -1 && empty_bucket_id == -1) {
         // gah?!
 #if CONFIG_HAL_BOARD == HAL_BOARD_SITL
@@ -1799,6 +2018,7 @@ bool GCS_MAVLINK::set_ap_message_interval(enum ap_message id, uint16_t interval_
         // allocate a bucket for this interval
         deferred_message_bucket[empty_bucket_id].interval_ms = interval_ms;
         deferred_message_bucket[empty_bucket_id].last_sent_ms = AP_HAL::millis16();
+        deferred_message_bucket[empty_bucket_id].priority = priority;
         closest_bucket = empty_bucket_id;
     }
 
@@ -3293,6 +3513,63 @@ bool GCS_MAVLINK::get_ap_message_interval(ap_message id, uint16_t &interval_ms)
     return false;
 }
 
+bool GCS_MAVLINK::get_ap_message_achieved_interval(ap_message id, uint16_t &interval_ms) const
+{
+    // specially-handled messages are never slowed down:
+    const int8_t deferred_offset = get_deferred_message_index(id);
+    if (deferred_offset != -1) {
+        interval_ms = deferred_message[deferred_offset].interval_ms;
+        return interval_ms != 0;
+    }
+
+    for (uint8_t i=0; i<ARRAY_SIZE(deferred_message_bucket); i++) {
+        const deferred_message_bucket_t &bucket = deferred_message_bucket[i];
+        if (!bucket.ap_message_ids.get(id)) {
+            continue;
+        }
+        if (bucket.last_pass_ms == 0) {
+            // not sent yet
+            return false;
+        }
+        // don't report a stream which has stopped as keeping up:
+        const uint16_t since_pass_ms = MIN(AP_HAL::millis() - bucket.last_pass_ms, 60000U);
+        interval_ms = MAX(bucket.achieved_interval_ms, since_pass_ms);
+        return true;
+    }
+
+    return false;
+}
+
+void GCS_MAVLINK::stream_rate_info(ExpandingString &str) const
+{
+    str.printf("MAV%u LINK=%u SENT=%u\n",
+               unsigned(chan),
+               unsigned(stream_budget.link_bytes_per_s),
+               unsigned(stream_budget.sent_bytes_per_s));
+    for (uint8_t i=0; i<ARRAY_SIZE(deferred_message_bucket); i++) {
+        const deferred_message_bucket_t &bucket = deferred_message_bucket[i];
+        if (bucket.interval_ms == 0) {
+            continue;
+        }
+        for (uint16_t id=0; id<MSG_LAST; id++) {
+            if (!bucket.ap_message_ids.get(id)) {
+                continue;
+            }
+            uint32_t mavlink_id;
+            if (!ap_message_id_to_mavlink_id(ap_message(id), mavlink_id)) {
+                continue;
+            }
+            uint16_t achieved_ms = 0;
+            IGNORE_RETURN(get_ap_message_achieved_interval(ap_message(id), achieved_ms));
+            str.printf("%-6u PRI=%u REQ=%6.2f ACH=%6.2f\n",
+                       unsigned(mavlink_id),
+                       unsigned(bucket.priority),
+                       1000.0f / bucket.interval_ms,
+                       achieved_ms == 0 ? 0.0f : 1000.0f / achieved_ms);
+        }
+    }
+}
+
 MAV_RESULT GCS_MAVLINK::handle_command_get_message_interval(const mavlink_command_int_t &packet)
 {
     if (txspace() < PAYLOAD_SIZE(chan, MESSAGE_INTERVAL) + PAYLOAD_SIZE(chan, COMMAND_ACK)) {
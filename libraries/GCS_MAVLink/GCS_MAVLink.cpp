@@ -75,6 +75,8 @@ bool gcs_alternative_active[MAVLINK_COMM_NUM_BUFFERS];
 // per-channel lock
 static HAL_Semaphore chan_locks[MAVLINK_COMM_NUM_BUFFERS];
 static bool chan_discard[MAVLINK_COMM_NUM_BUFFERS];
+// bytes written to each channel
+static uint32_t chan_tx_bytes[MAVLINK_COMM_NUM_BUFFERS];
 
 mavlink_system_t mavlink_system = {7,1};
 
@@ -127,6 +129,14 @@ uint16_t comm_get_txspace(mavlink_channel_t chan)
     return link->txspace();
 }
 
+uint32_t comm_get_tx_bytes(mavlink_channel_t chan)
+{
+    if (!valid_channel(chan)) {
+        return 0;
+    }
+    return chan_tx_bytes[chan];
+}
+
 /*
   send a buffer out a MAVLink channel
  */
@@ -147,6 +157,7 @@ void comm_send_buffer(mavlink_channel_t chan, const uint8_t *buf, uint8_t len)
         return;
     }
     const size_t written = mavlink_comm_port[chan]->write(buf, len);
+    chan_tx_bytes[chan] += written;
 #if CONFIG_HAL_BOARD == HAL_BOARD_SITL
     if (written < len && !mavlink_comm_port[chan]->is_write_locked()) {
         AP_HAL::panic("Short write on UART: %lu < %u", (unsigned long)written, len);
@@ -33,7 +33,12 @@ extern const AP_HAL::HAL& hal;
 #define ROUTING_DEBUG 0
 
 // constructor
-MAVLink_routing::MAVLink_routing(void) : num_routes(0) {}
+MAVLink_routing::MAVLink_routing(void) :
+    num_routes(0),
+    route_channel_mask(0)
+{
+    memset(route_bucket, ROUTE_NONE, sizeof(route_bucket));
+}
 
 /*
   forward a MAVLink message to the right port. This also
@@ -114,7 +119,7 @@ bool MAVLink_routing::check_and_forward(GCS_MAVLINK &in_link, const mavlink_mess
 
     // learn new routes including private channels
     // so that find_mav_type works for all channels
-    learn_route(in_link, msg);
+    learn_route(in_link.get_chan(), msg, AP_HAL::millis());
 
     if (msg.msgid == MAVLINK_MSG_ID_RADIO ||
         msg.msgid == MAVLINK_MSG_ID_RADIO_STATUS) {
@@ -171,45 +176,33 @@ bool MAVLink_routing::check_and_forward(GCS_MAVLINK &in_link, const mavlink_mess
         return true;
     }
 
-    // forward on any channels matching the targets
-    bool forwarded = false;
-    bool sent_to_chan[MAVLINK_COMM_NUM_BUFFERS];
-    memset(sent_to_chan, 0, sizeof(sent_to_chan));
-    for (uint8_t i=0; i<num_routes; i++) {
+    // work out which channels match the targets, then forward once
+    // on each of them
+    uint8_t out_mask = forward_mask(target_system, target_component, in_link.get_chan());
 
-        // Skip if channel is private and the target system or component IDs do not match
-        GCS_MAVLINK *out_link = gcs().chan(routes[i].channel);
-        if (out_link == nullptr) {
-            // this is bad
+    bool forwarded = false;
+    for (uint8_t i=0; out_mask != 0; i++, out_mask >>= 1) {
+        if ((out_mask & 1U) == 0) {
             continue;
         }
-        if (out_link->is_private() &&
-            (target_system != routes[i].sysid ||
-             target_component != routes[i].compid)) {
+        const mavlink_channel_t channel = (mavlink_channel_t)(MAVLINK_COMM_0 + i);
+        GCS_MAVLINK *out_link = gcs().chan(channel);
+        if (out_link == nullptr) {
+            // this is bad
             continue;
         }
-
-        if (broadcast_system || (target_system == routes[i].sysid &&
-                                 (broadcast_component || 
-                                  target_component == routes[i].compid ||
-                                  !match_system))) {
-
-            if (&in_link != out_link && !sent_to_chan[routes[i].channel]) {
-                if (out_link->check_payload_size(msg.len)) {
+        if (out_link->check_payload_size(msg.len)) {
 #if ROUTING_DEBUG
-                    ::printf("fwd msg %u from chan %u on chan %u sysid=%d compid=%d\n",
-                             msg.msgid,
-                             (unsigned)in_link.get_chan(),
-                             (unsigned)routes[i].channel,
-                             (int)target_system,
-                             (int)target_component);
+            ::printf("fwd msg %u from chan %u on chan %u sysid=%d compid=%d\n",
+                     msg.msgid,
+                     (unsigned)in_link.get_chan(),
+                     (unsigned)channel,
+                     (int)target_system,
+                     (int)target_component);
 #endif
-                    _mavlink_resend_uart(routes[i].channel, &msg);
-                }
-                sent_to_chan[routes[i].channel] = true;
-                forwarded = true;
-            }
+            _mavlink_resend_uart(channel, &msg);
         }
+        forwarded = true;
     }
 
     if ((!forwarded && match_system) ||
@@ -220,6 +213,41 @@ bool MAVLink_routing::check_and_forward(GCS_MAVLINK &in_link, const mavlink_mess
     return process_locally;
 }
 
+/*
+  the mask of channels a message with the given targets should be
+  forwarded on, not including the channel it arrived on
+*/
+uint8_t MAVLink_routing::forward_mask(int16_t target_system, int16_t target_component, mavlink_channel_t in_channel) const
+{
+    const bool broadcast_system = (target_system == 0 || target_system == -1);
+    const bool broadcast_component = (target_component == 0 || target_component == -1);
+    const bool match_system = broadcast_system || (target_system == mavlink_system.sysid);
+
+    uint8_t out_mask = 0;
+    if (broadcast_system) {
+        // a broadcast never matches a route over a private channel
+        out_mask = route_channel_mask & ~GCS_MAVLINK::private_channel_mask();
+    } else {
+        for (uint8_t i=route_bucket[bucket(target_system)]; i!=ROUTE_NONE; i=routes[i].next) {
+            const route &r = routes[i];
+            if (r.sysid != target_system) {
+                continue;
+            }
+            // Skip if channel is private and the target component ID does not match
+            if ((GCS_MAVLINK::private_channel_mask() & channel_bit(r.channel)) &&
+                target_component != r.compid) {
+                continue;
+            }
+            if (broadcast_component ||
+                target_component == r.compid ||
+                !match_system) {
+                out_mask |= channel_bit(r.channel);
+            }
+        }
+    }
+    return out_mask & ~channel_bit(in_channel);
+}
+
 /*
   send a MAVLink message to all components with this vehicle's system id
 
@@ -236,29 +264,28 @@ void MAVLink_routing::send_to_components(uint32_t msgid, const char *pkt, uint8_
 
 void MAVLink_routing::send_to_components(const char *pkt, const mavlink_msg_entry_t *entry, const uint8_t pkt_len)
 {
-    bool sent_to_chan[MAVLINK_COMM_NUM_BUFFERS] {};
-
-    // check learned routes
-    for (uint8_t i=0; i<num_routes; i++) {
-        if (routes[i].sysid != mavlink_system.sysid) {
-            // our system ID hasn't been seen on this link
-            continue;
+    // find the links our system ID has been seen on
+    uint8_t out_mask = 0;
+    for (uint8_t i=route_bucket[bucket(mavlink_system.sysid)]; i!=ROUTE_NONE; i=routes[i].next) {
+        if (routes[i].sysid == mavlink_system.sysid) {
+            out_mask |= channel_bit(routes[i].channel);
         }
-        if (sent_to_chan[routes[i].channel]) {
-            // we've already send it on this link
+    }
+
+    for (uint8_t i=0; out_mask != 0; i++, out_mask >>= 1) {
+        if ((out_mask & 1U) == 0) {
             continue;
         }
-        if (comm_get_txspace(routes[i].channel) <
-            ((uint16_t)entry->max_msg_len) + GCS_MAVLINK::packet_overhead_chan(routes[i].channel)) {
+        const mavlink_channel_t channel = (mavlink_channel_t)(MAVLINK_COMM_0 + i);
+        if (comm_get_txspace(channel) <
+            ((uint16_t)entry->max_msg_len) + GCS_MAVLINK::packet_overhead_chan(channel)) {
             // it doesn't fit on this channel
             continue;
         }
 #if ROUTING_DEBUG
-        ::printf("send msg %u on chan %u sysid=%u compid=%u\n",
+        ::printf("send msg %u on chan %u\n",
                  entry->msgid,
-                 (unsigned)routes[i].channel,
-                 (unsigned)routes[i].sysid,
-                 (unsigned)routes[i].compid);
+                 (unsigned)channel);
 #endif
 #if CONFIG_HAL_BOARD == HAL_BOARD_SITL
         if (entry->max_msg_len > pkt_len) {
@@ -266,13 +293,12 @@ void MAVLink_routing::send_to_components(const char *pkt, const mavlink_msg_entr
                           entry->max_msg_len, pkt_len);
         }
 #endif
-        _mav_finalize_message_chan_send(routes[i].channel,
+        _mav_finalize_message_chan_send(channel,
                                         entry->msgid,
                                         pkt,
                                         entry->min_msg_len,
                                         MIN(entry->max_msg_len, pkt_len),
                                         entry->crc_extra);
-        sent_to_chan[routes[i].channel] = true;
     }
 }
 
@@ -315,9 +341,8 @@ bool MAVLink_routing::find_by_mavtype_and_compid(uint8_t mavtype, uint8_t compid
 /*
   see if the message is for a new route and learn it
 */
-void MAVLink_routing::learn_route(GCS_MAVLINK &in_link, const mavlink_message_t &msg)
+void MAVLink_routing::learn_route(mavlink_channel_t in_channel, const mavlink_message_t &msg, uint32_t now_ms)
 {
-    uint8_t i;
     if (msg.sysid == 0) {
         // don't learn routes to the broadcast system
         return;
@@ -334,31 +359,80 @@ void MAVLink_routing::learn_route(GCS_MAVLINK &in_link, const mavlink_message_t
         // should also process them locally.
         return;
     }
-    const mavlink_channel_t in_channel = in_link.get_chan();
-    for (i=0; i<num_routes; i++) {
-        if (routes[i].sysid == msg.sysid &&
-            routes[i].compid == msg.compid &&
-            routes[i].channel == in_channel) {
-            if (routes[i].mavtype == 0 && msg.msgid == MAVLINK_MSG_ID_HEARTBEAT) {
-                routes[i].mavtype = mavlink_msg_heartbeat_get_type(&msg);
+    for (uint8_t i=route_bucket[bucket(msg.sysid)]; i!=ROUTE_NONE; i=routes[i].next) {
+        route &r = routes[i];
+        if (r.sysid == msg.sysid &&
+            r.compid == msg.compid &&
+            r.channel == in_channel) {
+            if (r.mavtype == 0 && msg.msgid == MAVLINK_MSG_ID_HEARTBEAT) {
+                r.mavtype = mavlink_msg_heartbeat_get_type(&msg);
             }
-            break;
+            r.last_seen_ms = now_ms;
+            return;
         }
     }
-    if (i == num_routes && i<MAVLINK_MAX_ROUTES) {
-        routes[i].sysid = msg.sysid;
-        routes[i].compid = msg.compid;
-        routes[i].channel = in_channel;
-        if (msg.msgid == MAVLINK_MSG_ID_HEARTBEAT) {
-            routes[i].mavtype = mavlink_msg_heartbeat_get_type(&msg);
+
+    if (num_routes == MAVLINK_MAX_ROUTES) {
+        // the table is full. Remove the route we haven't heard from
+        // for longest if it has timed out
+        uint8_t oldest = 0;
+        for (uint8_t j=1; j<num_routes; j++) {
+            if (now_ms - routes[j].last_seen_ms > now_ms - routes[oldest].last_seen_ms) {
+                oldest = j;
+            }
+        }
+        if (now_ms - routes[oldest].last_seen_ms < MAVLINK_ROUTE_TIMEOUT_MS) {
+            return;
         }
-        num_routes++;
 #if ROUTING_DEBUG
-        ::printf("learned route %u %u via %u\n",
-                 (unsigned)msg.sysid,
-                 (unsigned)msg.compid,
-                 (unsigned)in_channel);
+        ::printf("expired route %u %u via %u\n",
+                 (unsigned)routes[oldest].sysid,
+                 (unsigned)routes[oldest].compid,
+                 (unsigned)routes[oldest].channel);
+#endif
+        remove_route(oldest);
+    }
+
+    // new routes go on the end, keeping the table in the order the
+    // routes were learnt
+    const uint8_t i = num_routes++;
+    route &r = routes[i];
+    r.sysid = msg.sysid;
+    r.compid = msg.compid;
+    r.channel = in_channel;
+    r.mavtype = 0;
+    if (msg.msgid == MAVLINK_MSG_ID_HEARTBEAT) {
+        r.mavtype = mavlink_msg_heartbeat_get_type(&msg);
+    }
+    r.last_seen_ms = now_ms;
+    r.next = route_bucket[bucket(r.sysid)];
+    route_bucket[bucket(r.sysid)] = i;
+    route_channel_mask |= channel_bit(in_channel);
+#if ROUTING_DEBUG
+    ::printf("learned route %u %u via %u\n",
+             (unsigned)msg.sysid,
+             (unsigned)msg.compid,
+             (unsigned)in_channel);
 #endif
+}
+
+/*
+  remove a route, moving the routes after it down to fill its place
+*/
+void MAVLink_routing::remove_route(uint8_t idx)
+{
+    num_routes--;
+    memmove(&routes[idx], &routes[idx+1], (num_routes - idx) * sizeof(routes[0]));
+
+    // the indexes of the routes have changed, so link the buckets
+    // again and work out which channels are still routed to. This
+    // only happens when the table is full
+    memset(route_bucket, ROUTE_NONE, sizeof(route_bucket));
+    route_channel_mask = 0;
+    for (uint8_t i=0; i<num_routes; i++) {
+        routes[i].next = route_bucket[bucket(routes[i].sysid)];
+        route_bucket[bucket(routes[i].sysid)] = i;
+        route_channel_mask |= channel_bit(routes[i].channel);
     }
 }
 
@@ -382,9 +456,9 @@ void MAVLink_routing::handle_heartbeat(GCS_MAVLINK &link, const mavlink_message_
     mask &= ~no_route_mask;
     
     // mask out channels that are known sources for this sysid/compid
-    for (uint8_t i=0; i<num_routes; i++) {
+    for (uint8_t i=route_bucket[bucket(msg.sysid)]; i!=ROUTE_NONE; i=routes[i].next) {
         if (routes[i].sysid == msg.sysid && routes[i].compid == msg.compid) {
-            mask &= ~(1U<<((unsigned)(routes[i].channel-MAVLINK_COMM_0)));
+            mask &= ~channel_bit(routes[i].channel);
         }
     }
 
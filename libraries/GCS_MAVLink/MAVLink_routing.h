@@ -5,9 +5,23 @@
 #include <AP_Common/AP_Common.h>
 #include "GCS_MAVLink.h"
 
+#ifndef MAVLINK_MAX_ROUTES
+#if CONFIG_HAL_BOARD == HAL_BOARD_LINUX
+// companion computers routing between many links can see a lot of
+// systems and components
+#define MAVLINK_MAX_ROUTES 100
+#else
 // 20 routes should be enough for now. This may need to increase as
 // we make more extensive use of MAVLink forwarding
 #define MAVLINK_MAX_ROUTES 20
+#endif
+#endif
+
+// once the routing table is full, a route which hasn't been heard
+// from for this long can be replaced by a new route
+#ifndef MAVLINK_ROUTE_TIMEOUT_MS
+#define MAVLINK_ROUTE_TIMEOUT_MS 30000
+#endif
 
 /*
   object to handle MAVLink packet routing
@@ -15,6 +29,7 @@
 class MAVLink_routing
 {
     friend class GCS_MAVLINK;
+    friend class MAVLink_routing_test;
     
 public:
     MAVLink_routing(void);
@@ -50,21 +65,47 @@ public:
     bool find_by_mavtype_and_compid(uint8_t mavtype, uint8_t compid, uint8_t &sysid, mavlink_channel_t &channel) const;
 
 private:
-    // a simple linear routing table. We don't expect to have a lot of
-    // routes, so a scalable structure isn't worthwhile yet.
+    static constexpr uint8_t ROUTE_NONE = 0xFF;
+    static_assert(MAVLINK_MAX_ROUTES < ROUTE_NONE, "too many routes");
+
+    // a power of two, with at least one bucket per route
+    static constexpr uint16_t NUM_ROUTE_BUCKETS = MAVLINK_MAX_ROUTES <= 32 ? 32 : (MAVLINK_MAX_ROUTES <= 128 ? 128 : 256);
+
+    // the routing table. Routes are kept in the order they were
+    // learnt and hashed into buckets by sysid, with the routes in
+    // each bucket linked through their next index
     uint8_t num_routes;
     struct route {
         uint8_t sysid;
         uint8_t compid;
         mavlink_channel_t channel;
         uint8_t mavtype;
+        uint8_t next;           // next route in the same bucket
+        uint32_t last_seen_ms;  // when a message last arrived over this route
     } routes[MAVLINK_MAX_ROUTES];
-    
+    uint8_t route_bucket[NUM_ROUTE_BUCKETS];   // first route in each bucket
+
+    // channels with at least one route
+    uint8_t route_channel_mask;
+
     // a channel mask to block routing as required
     uint8_t no_route_mask;
-    
+
+    uint8_t bucket(uint8_t sysid) const {
+        return sysid & (NUM_ROUTE_BUCKETS - 1);
+    }
+    static uint8_t channel_bit(mavlink_channel_t chan) {
+        return 1U << (chan - MAVLINK_COMM_0);
+    }
+
     // learn new routes
-    void learn_route(GCS_MAVLINK &link, const mavlink_message_t &msg);
+    void learn_route(mavlink_channel_t in_channel, const mavlink_message_t &msg, uint32_t now_ms);
+
+    // remove a route to make room for a new one
+    void remove_route(uint8_t idx);
+
+    // channels to forward a message with these targets on
+    uint8_t forward_mask(int16_t target_system, int16_t target_component, mavlink_channel_t in_channel) const;
 
     // extract target sysid and compid from a message
     void get_targets(const mavlink_message_t &msg, int16_t &sysid, int16_t &compid);
@@ -0,0 +1,249 @@
+/*
+  check the hashed routing table learns, ages and forwards the same
+  as a plain list of routes scanned in the order they were learnt
+ */
+#include <AP_gtest.h>
+
+#include <GCS_MAVLink/GCS.h>
+
+const AP_HAL::HAL& hal = AP_HAL::get_HAL();
+
+#if HAL_GCS_ENABLED
+
+static uint32_t seed = 1;
+
+static uint32_t random_int(uint32_t n)
+{
+    seed = seed * 1103515245U + 12345U;
+    return (seed >> 8) % n;
+}
+
+/*
+  a routing table which is searched linearly, as the table was before
+  routes were hashed by sysid
+ */
+class ReferenceRoutes {
+public:
+    struct route {
+        uint8_t sysid;
+        uint8_t compid;
+        mavlink_channel_t channel;
+        uint8_t mavtype;
+        uint32_t last_seen_ms;
+    } routes[MAVLINK_MAX_ROUTES];
+    uint8_t num_routes;
+    uint32_t num_removed;
+
+    void learn(mavlink_channel_t channel, const mavlink_message_t &msg, uint32_t now_ms)
+    {
+        if (msg.sysid == 0 ||
+            (msg.sysid == mavlink_system.sysid && msg.compid == mavlink_system.compid) ||
+            (msg.sysid == mavlink_system.sysid && msg.compid == MAV_COMP_ID_ALL)) {
+            return;
+        }
+        for (uint8_t i=0; i<num_routes; i++) {
+            route &r = routes[i];
+            if (r.sysid == msg.sysid && r.compid == msg.compid && r.channel == channel) {
+                if (r.mavtype == 0 && msg.msgid == MAVLINK_MSG_ID_HEARTBEAT) {
+                    r.mavtype = mavlink_msg_heartbeat_get_type(&msg);
+                }
+                r.last_seen_ms = now_ms;
+                return;
+            }
+        }
+        if (num_routes == MAVLINK_MAX_ROUTES) {
+            uint8_t oldest = 0;
+            for (uint8_t i=1; i<num_routes; i++) {
+                if (now_ms - routes[i].last_seen_ms > now_ms - routes[oldest].last_seen_ms) {
+                    oldest = i;
+                }
+            }
+            if (now_ms - routes[oldest].last_seen_ms < MAVLINK_ROUTE_TIMEOUT_MS) {
+                return;
+            }
+            for (uint8_t i=oldest; i<num_routes-1; i++) {
+                routes[i] = routes[i+1];
+            }
+            num_routes--;
+            num_removed++;
+        }
+        route &r = routes[num_routes++];
+        r.sysid = msg.sysid;
+        r.compid = msg.compid;
+        r.channel = channel;
+        r.mavtype = msg.msgid == MAVLINK_MSG_ID_HEARTBEAT ? mavlink_msg_heartbeat_get_type(&msg) : 0;
+        r.last_seen_ms = now_ms;
+    }
+
+    uint8_t forward_mask(int16_t target_system, int16_t target_component, mavlink_channel_t in_channel) const
+    {
+        const bool broadcast_system = (target_system == 0 || target_system == -1);
+        const bool broadcast_component = (target_component == 0 || target_component == -1);
+        const bool match_system = broadcast_system || (target_system == mavlink_system.sysid);
+        uint8_t mask = 0;
+        for (uint8_t i=0; i<num_routes; i++) {
+            const route &r = routes[i];
+            if (GCS_MAVLINK::is_private(r.channel) &&
+                (target_system != r.sysid || target_component != r.compid)) {
+                continue;
+            }
+            if (broadcast_system || (target_system == r.sysid &&
+                                     (broadcast_component ||
+                                      target_component == r.compid ||
+                                      !match_system))) {
+                mask |= 1U << r.channel;
+            }
+        }
+        return mask & ~(1U << in_channel);
+    }
+};
+
+class MAVLink_routing_test {
+public:
+    static void learn_route(MAVLink_routing &routing, mavlink_channel_t channel, const mavlink_message_t &msg, uint32_t now_ms)
+    {
+        routing.learn_route(channel, msg, now_ms);
+    }
+
+    static uint8_t forward_mask(const MAVLink_routing &routing, int16_t target_system, int16_t target_component, mavlink_channel_t in_channel)
+    {
+        return routing.forward_mask(target_system, target_component, in_channel);
+    }
+
+    // the routes must be in the same order as the reference table
+    static void check_routes(const MAVLink_routing &routing, const ReferenceRoutes &reference)
+    {
+        ASSERT_EQ(routing.num_routes, reference.num_routes);
+        for (uint8_t i=0; i<routing.num_routes; i++) {
+            EXPECT_EQ(routing.routes[i].sysid, reference.routes[i].sysid);
+            EXPECT_EQ(routing.routes[i].compid, reference.routes[i].compid);
+            EXPECT_EQ(routing.routes[i].channel, reference.routes[i].channel);
+            EXPECT_EQ(routing.routes[i].mavtype, reference.routes[i].mavtype);
+        }
+    }
+};
+
+// sysids which share hash buckets, and our own sysid
+static const uint8_t sysids[] { 1, 2, 3, 34, 66, 98, 130, 200, 232, 255 };
+static const uint8_t compids[] { MAV_COMP_ID_ALL, 1, 154, 190 };
+static const uint8_t NUM_CHANNELS = 5;
+
+static void random_message(mavlink_message_t &msg)
+{
+    const uint8_t sysid = sysids[random_int(ARRAY_SIZE(sysids))];
+    const uint8_t compid = compids[random_int(ARRAY_SIZE(compids))];
+    if (random_int(4) == 0) {
+        mavlink_msg_heartbeat_pack(sysid, compid, &msg,
+                                   1 + random_int(3), MAV_AUTOPILOT_GENERIC, 0, 0, MAV_STATE_ACTIVE);
+    } else {
+        memset(&msg, 0, sizeof(msg));
+        msg.msgid = MAVLINK_MSG_ID_SYS_STATUS;
+        msg.sysid = sysid;
+        msg.compid = compid;
+    }
+}
+
+static int16_t random_target(const uint8_t *ids, uint8_t num_ids)
+{
+    switch (random_int(8)) {
+    case 0:
+        return -1;
+    case 1:
+        return 0;
+    case 2:
+        // not in the table
+        return 50;
+    default:
+        return ids[random_int(num_ids)];
+    }
+}
+
+TEST(MAVLink_routing, matches_linear_table)
+{
+    mavlink_system.sysid = 1;
+    mavlink_system.compid = 1;
+
+    MAVLink_routing routing;
+    ReferenceRoutes reference {};
+    uint32_t now_ms = 1000;
+
+    for (uint32_t n=0; n<60000; n++) {
+        if (n == 30000) {
+            // the second half is with a private channel
+            GCS_MAVLINK::set_channel_private(MAVLINK_COMM_3);
+        }
+        mavlink_message_t msg;
+        random_message(msg);
+        const mavlink_channel_t channel = mavlink_channel_t(MAVLINK_COMM_0 + random_int(NUM_CHANNELS));
+        MAVLink_routing_test::learn_route(routing, channel, msg, now_ms);
+        reference.learn(channel, msg, now_ms);
+        now_ms += random_int(200);
+
+        if (n % 100 == 0) {
+            MAVLink_routing_test::check_routes(routing, reference);
+        }
+
+        const int16_t target_system = random_target(sysids, ARRAY_SIZE(sysids));
+        const int16_t target_component = random_target(compids, ARRAY_SIZE(compids));
+        const mavlink_channel_t in_channel = mavlink_channel_t(MAVLINK_COMM_0 + random_int(NUM_CHANNELS));
+        EXPECT_EQ(MAVLink_routing_test::forward_mask(routing, target_system, target_component, in_channel),
+                  reference.forward_mask(target_system, target_component, in_channel));
+
+        const uint8_t mavtype = 1 + random_int(3);
+        uint8_t sysid = 0, compid = 0;
+        mavlink_channel_t found_channel = MAVLINK_COMM_0;
+        const bool found = routing.find_by_mavtype(mavtype, sysid, compid, found_channel);
+        bool expected_found = false;
+        for (uint8_t i=0; i<reference.num_routes; i++) {
+            const ReferenceRoutes::route &r = reference.routes[i];
+            if (r.mavtype == mavtype) {
+                expected_found = true;
+                EXPECT_EQ(sysid, r.sysid);
+                EXPECT_EQ(compid, r.compid);
+                EXPECT_EQ(found_channel, r.channel);
+                break;
+            }
+        }
+        EXPECT_EQ(found, expected_found);
+    }
+    MAVLink_routing_test::check_routes(routing, reference);
+
+    // routes must have been replaced often enough to test it
+    EXPECT_GT(reference.num_removed, 100U);
+}
+
+TEST(MAVLink_routing, full_table_keeps_recent_routes)
+{
+    mavlink_system.sysid = 1;
+    mavlink_system.compid = 1;
+
+    MAVLink_routing routing;
+    uint32_t now_ms = 1000;
+    mavlink_message_t msg {};
+    msg.msgid = MAVLINK_MSG_ID_SYS_STATUS;
+    msg.compid = 1;
+    for (uint8_t i=0; i<MAVLINK_MAX_ROUTES; i++) {
+        msg.sysid = 10 + i;
+        MAVLink_routing_test::learn_route(routing, MAVLINK_COMM_0, msg, now_ms);
+    }
+
+    // no room for a new route while the others are recent
+    msg.sysid = 10 + MAVLINK_MAX_ROUTES;
+    now_ms += MAVLINK_ROUTE_TIMEOUT_MS - 1;
+    MAVLink_routing_test::learn_route(routing, MAVLINK_COMM_1, msg, now_ms);
+    EXPECT_EQ(MAVLink_routing_test::forward_mask(routing, msg.sysid, 1, MAVLINK_COMM_2), 0);
+
+    // once they time out, the one heard from least recently is replaced
+    now_ms += 2;
+    msg.sysid = 11;
+    MAVLink_routing_test::learn_route(routing, MAVLINK_COMM_0, msg, now_ms);
+    msg.sysid = 10 + MAVLINK_MAX_ROUTES;
+    MAVLink_routing_test::learn_route(routing, MAVLINK_COMM_1, msg, now_ms);
+    EXPECT_EQ(MAVLink_routing_test::forward_mask(routing, msg.sysid, 1, MAVLINK_COMM_2), uint8_t(1U << MAVLINK_COMM_1));
+    EXPECT_EQ(MAVLink_routing_test::forward_mask(routing, 10, 1, MAVLINK_COMM_2), 0);
+    EXPECT_EQ(MAVLink_routing_test::forward_mask(routing, 11, 1, MAVLINK_COMM_2), uint8_t(1U << MAVLINK_COMM_0));
+}
+
+#endif  // HAL_GCS_ENABLED
+
+AP_GTEST_MAIN()
@@ -64,6 +64,10 @@ public:
     void set_speedup(float speedup);
     float get_speedup() const { return target_speedup; }
 
+    // a speedup of zero advances simulated time without reference to
+    // the wall clock
+    bool lock_step() const { return target_speedup <= 0; }
+
     /*
       set instance number
      */
@@ -0,0 +1,306 @@
+/*
+   This program is free software: you can redistribute it and/or modify
+   it under the terms of the GNU General Public License as published by
+   the Free Software Foundation, either version 3 of the License, or
+   (at your option) any later version.
+
+   This program is distributed in the hope that it will be useful,
+   but WITHOUT ANY WARRANTY; without even the implied warranty of
+   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+   GNU General Public License for more details.
+
+   You should have received a copy of the GNU General Public License
+   along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+/*
+  simulate a swarm of vehicles
+
+  The members fly in rings around a formation centre which moves
+  around a circle starting at home. Each member is its own MAVLink
+  system, sending HEARTBEAT, GLOBAL_POSITION_INT and ADSB_VEHICLE to
+  the simulated vehicle, so large swarms can be used to test MAVLink
+  routing, ADS-B avoidance and follow modes from a single SITL
+  process. Messages for all members are sent in batches to keep the
+  cost per member low.
+*/
+
+#include "SIM_config.h"
+
+#if AP_SIM_SWARM_ENABLED
+
+#include "SIM_Swarm.h"
+
+#include "SITL.h"
+
+#include <stdio.h>
+
+using namespace SITL;
+
+// SITL swarm parameters
+const AP_Param::GroupInfo SwarmSim::var_info[] = {
+    // @Param: ENABLE
+    // @DisplayName: Swarm Enable
+    // @Description: Enable swarm simulation
+    // @Values: 0:Disable,1:Enabled
+    AP_GROUPINFO("ENABLE",    1, SwarmSim,  enable, 0),
+    // @Param: COUNT
+    // @DisplayName: Swarm size
+    // @Description: Number of vehicles in the swarm
+    // @Range: 1 250
+    AP_GROUPINFO("COUNT",     2, SwarmSim,  count, 10),
+    // @Param: SYSID
+    // @DisplayName: First System ID
+    // @Description: System ID of the first member of the swarm. Members use consecutive system IDs
+    // @Range: 1 254
+    AP_GROUPINFO("SYSID",     3, SwarmSim,  sys_id, 100),
+    // @Param: SPEED
+    // @DisplayName: Swarm Speed
+    // @Description: Speed of the swarm's formation centre
+    // @Units: m/s
+    AP_GROUPINFO("SPEED",     4, SwarmSim,  speed, 5),
+    // @Param: PSIZE
+    // @DisplayName: Path Size
+    // @Description: Diameter of the circle the swarm's formation centre is traveling on
+    // @Units: m
+    AP_GROUPINFO("PSIZE",     5, SwarmSim,  path_size, 500),
+    // @Param: SPACE
+    // @DisplayName: Member spacing
+    // @Description: Distance between the rings of the formation
+    // @Units: m
+    AP_GROUPINFO("SPACE",     6, SwarmSim,  spacing, 20),
+    // @Param: ALT
+    // @DisplayName: Swarm altitude
+    // @Description: Altitude of the swarm above home
+    // @Units: m
+    AP_GROUPINFO("ALT",       7, SwarmSim,  alt, 50),
+    // @Param: PORT
+    // @DisplayName: Swarm port
+    // @Description: TCP port of the simulated vehicle's serial port the swarm connects to
+    // @Range: 1 65535
+    AP_GROUPINFO("PORT",      8, SwarmSim,  port, 5763),
+    AP_GROUPEND
+};
+
+SwarmSim::SwarmSim()
+{
+    AP_Param::setup_object_defaults(this, var_info);
+}
+
+/*
+  place the members in rings around the formation centre, six in the
+  first ring, twelve in the second and so on
+ */
+void SwarmSim::setup_members(void)
+{
+    setup_count = count.get();
+    setup_sys_id = sys_id.get();
+    // keep every member's system ID within 1 to 254
+    first_sys_id = constrain_int16(setup_sys_id, 1, 254);
+    num_members = constrain_int16(setup_count, 0, MIN(int16_t(num_members_MAX), int16_t(255 - first_sys_id)));
+    uint8_t ring = 1;
+    uint16_t ring_pos = 0;
+    for (uint8_t i=0; i<num_members; i++) {
+        Member &m = members[i];
+        const float angle = M_2PI * ring_pos / (6 * ring);
+        m.slot = Vector3f(cosf(angle), sinf(angle), 0) * (ring * spacing.get());
+        m.slot.z = -alt.get();
+        m.position = Vector3f(centre.x, centre.y, 0) + m.slot;
+        m.velocity.zero();
+        if (++ring_pos == 6 * ring) {
+            ring++;
+            ring_pos = 0;
+        }
+    }
+}
+
+/*
+  move the formation centre, and each member towards its slot
+ */
+void SwarmSim::update_members(float dt)
+{
+    // same path as the simulated ship
+    const float circumference = M_PI * path_size.get();
+    const float dist = dt * speed.get();
+    centre_heading_deg = wrap_360(centre_heading_deg + (dist / circumference) * 360.0);
+    Vector2f centre_vel(speed.get(), 0);
+    centre_vel.rotate(radians(centre_heading_deg));
+    centre += centre_vel * dt;
+
+    const Vector3f centre_pos(centre.x, centre.y, 0);
+    const Vector3f centre_vel3(centre_vel.x, centre_vel.y, 0);
+    const float max_speed = speed.get() * 2 + 5;
+    const float max_dv = 3.0 * dt;  // m/s/s
+    for (uint8_t i=0; i<num_members; i++) {
+        Member &m = members[i];
+        Vector3f vel_target = centre_vel3 + (centre_pos + m.slot - m.position) * 0.5f;
+        vel_target.limit_length_xy(max_speed);
+        Vector3f dv = vel_target - m.velocity;
+        if (dv.length() > max_dv) {
+            dv *= max_dv / dv.length();
+        }
+        m.velocity += dv;
+        m.position += m.velocity * dt;
+    }
+}
+
+/*
+  update the SwarmSim state
+*/
+void SwarmSim::update(void)
+{
+    if (!enable) {
+        return;
+    }
+
+    auto *sitl = AP::sitl();
+    uint32_t now_us = AP_HAL::micros();
+
+    if (!initialised) {
+        home = sitl->state.home;
+        if (home.lat == 0 && home.lng == 0) {
+            return;
+        }
+        initialised = true;
+        last_update_us = now_us;
+        last_report_ms = AP_HAL::millis();
+        setup_members();
+        ::printf("SwarmSim %u vehicles\n", unsigned(num_members));
+    }
+    if (count.get() != setup_count || sys_id.get() != setup_sys_id) {
+        setup_members();
+    }
+
+    float dt = (now_us - last_update_us)*1.0e-6;
+    last_update_us = now_us;
+
+    update_members(dt);
+
+    uint32_t now_ms = AP_HAL::millis();
+    if (now_ms - last_report_ms >= reporting_period_ms) {
+        last_report_ms = now_ms;
+        send_report();
+    }
+}
+
+/*
+  prepare to encode a message from a member, using its own sequence
+ */
+void SwarmSim::start_message(const Member &m)
+{
+    mav_status.current_tx_seq = m.tx_seq;
+}
+
+/*
+  add an encoded message from a member to the batch
+ */
+void SwarmSim::queue_message(Member &m, const mavlink_message_t &msg)
+{
+    m.tx_seq = mav_status.current_tx_seq;
+    if (send_len + MAVLINK_MAX_PACKET_LEN > sizeof(send_buf)) {
+        flush();
+    }
+    send_len += mavlink_msg_to_send_buffer(&send_buf[send_len], &msg);
+}
+
+void SwarmSim::flush(void)
+{
+    if (send_len > 0) {
+        mav_socket.send(send_buf, send_len);
+        send_len = 0;
+    }
+}
+
+/*
+  send reports for all members to the vehicle control code over MAVLink
+*/
+void SwarmSim::send_report(void)
+{
+    if (!mavlink_connected && mav_socket.connect(target_address, port.get())) {
+        ::printf("SwarmSim connected to %s:%u\n", target_address, (unsigned)port.get());
+        mavlink_connected = true;
+    }
+    if (!mavlink_connected) {
+        return;
+    }
+
+    const uint32_t now = AP_HAL::millis();
+    const uint8_t component_id = MAV_COMP_ID_AUTOPILOT1;
+
+    const bool send_heartbeat = now - last_heartbeat_ms >= 1000;
+    if (send_heartbeat) {
+        last_heartbeat_ms = now;
+    }
+    const bool send_adsb = now - last_adsb_ms >= 1000;
+    if (send_adsb) {
+        last_adsb_ms = now;
+    }
+
+    for (uint8_t i=0; i<num_members; i++) {
+        Member &m = members[i];
+        const uint8_t member_sysid = first_sys_id + i;
+        mavlink_message_t msg;
+
+        if (send_heartbeat) {
+            const mavlink_heartbeat_t heartbeat{
+            custom_mode: 0,
+            type : MAV_TYPE_QUADROTOR,
+            autopilot : MAV_AUTOPILOT_INVALID,
+            base_mode: MAV_MODE_FLAG_SAFETY_ARMED,
+            system_status: MAV_STATE_ACTIVE,
+            mavlink_version: 0,
+            };
+            start_message(m);
+            mavlink_msg_heartbeat_encode_status(member_sysid, component_id, &mav_status, &msg, &heartbeat);
+            queue_message(m, msg);
+        }
+
+        Location loc = home;
+        loc.offset(m.position.x, m.position.y);
+        loc.alt -= m.position.z * 100;
+        const float heading_deg = wrap_360(degrees(atan2f(m.velocity.y, m.velocity.x)));
+
+        const mavlink_global_position_int_t global_position_int{
+        time_boot_ms: now,
+        lat: loc.lat,
+        lon: loc.lng,
+        alt: loc.alt * 10,
+        relative_alt: int32_t(-m.position.z * 1000),
+        vx: int16_t(m.velocity.x*100),
+        vy: int16_t(m.velocity.y*100),
+        vz: int16_t(m.velocity.z*100),
+        hdg: uint16_t(heading_deg*100)
+        };
+        start_message(m);
+        mavlink_msg_global_position_int_encode_status(member_sysid, component_id, &mav_status, &msg, &global_position_int);
+        queue_message(m, msg);
+
+        if (send_adsb) {
+            mavlink_adsb_vehicle_t adsb_vehicle {};
+            adsb_vehicle.ICAO_address = 0x5000 + member_sysid;
+            adsb_vehicle.lat = loc.lat;
+            adsb_vehicle.lon = loc.lng;
+            adsb_vehicle.altitude_type = ADSB_ALTITUDE_TYPE_GEOMETRIC;
+            adsb_vehicle.altitude = loc.alt * 10;
+            adsb_vehicle.heading = uint16_t(heading_deg*100);
+            adsb_vehicle.hor_velocity = m.velocity.xy().length() * 100;
+            adsb_vehicle.ver_velocity = -m.velocity.z * 100;
+            snprintf(adsb_vehicle.callsign, sizeof(adsb_vehicle.callsign), "SWRM%u", unsigned(member_sysid));
+            adsb_vehicle.emitter_type = ADSB_EMITTER_TYPE_UAV;
+            adsb_vehicle.tslc = 1;
+            adsb_vehicle.flags =
+                ADSB_FLAGS_VALID_COORDS |
+                ADSB_FLAGS_VALID_ALTITUDE |
+                ADSB_FLAGS_VALID_HEADING |
+                ADSB_FLAGS_VALID_VELOCITY |
+                ADSB_FLAGS_VALID_CALLSIGN |
+                ADSB_FLAGS_SIMULATED |
+                ADSB_FLAGS_VERTICAL_VELOCITY_VALID;
+            start_message(m);
+            mavlink_msg_adsb_vehicle_encode_status(member_sysid, MAV_COMP_ID_ADSB, &mav_status, &msg, &adsb_vehicle);
+            queue_message(m, msg);
+        }
+    }
+    flush();
+}
+
+#endif  // AP_SIM_SWARM_ENABLED
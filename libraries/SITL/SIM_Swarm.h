@@ -0,0 +1,104 @@
+/*
+   This program is free software: you can redistribute it and/or modify
+   it under the terms of the GNU General Public License as published by
+   the Free Software Foundation, either version 3 of the License, or
+   (at your option) any later version.
+
+   This program is distributed in the hope that it will be useful,
+   but WITHOUT ANY WARRANTY; without even the implied warranty of
+   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+   GNU General Public License for more details.
+
+   You should have received a copy of the GNU General Public License
+   along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+/*
+  simulate a swarm of vehicles flying in formation around the
+  simulated vehicle, each appearing over MAVLink as its own system
+*/
+
+#pragma once
+
+#include "SIM_config.h"
+
+#if AP_SIM_SWARM_ENABLED
+
+#include <AP_HAL/utility/Socket_native.h>
+#include <AP_Math/AP_Math.h>
+#include <AP_Common/Location.h>
+#include <GCS_MAVLink/GCS_MAVLink.h>
+
+namespace SITL {
+
+class SwarmSim {
+public:
+    SwarmSim();
+    void update(void);
+
+    static const struct AP_Param::GroupInfo var_info[];
+
+    static const uint8_t num_members_MAX = 250;
+
+private:
+
+    AP_Int8 enable;
+    AP_Int16 count;
+    AP_Int16 sys_id;
+    AP_Float speed;
+    AP_Float path_size;
+    AP_Float spacing;
+    AP_Float alt;
+    AP_Int16 port;
+
+    /*
+      a member of the swarm, flying towards its slot in the formation
+      with limited speed and acceleration
+     */
+    struct Member {
+        Vector3f position;      // NED from home
+        Vector3f velocity;      // NED
+        Vector3f slot;          // offset from the formation centre
+        uint8_t tx_seq;         // MAVLink sequence of this system
+    };
+    Member members[num_members_MAX];
+    uint8_t num_members;
+    int16_t setup_count;        // COUNT and SYSID the members were set up for
+    int16_t setup_sys_id;
+    uint8_t first_sys_id;       // system ID of the first member
+
+    Location home;
+    const char *target_address = "127.0.0.1";
+
+    bool initialised;
+    uint32_t last_update_us;
+
+    // formation centre, moving around a circle of path_size
+    Vector2f centre;
+    float centre_heading_deg;
+
+    void setup_members(void);
+    void update_members(float dt);
+
+    // reporting period in ms
+    const float reporting_period_ms = 200;
+    uint32_t last_report_ms;
+    uint32_t last_heartbeat_ms;
+    uint32_t last_adsb_ms;
+
+    SocketAPM_native mav_socket { false };
+    bool mavlink_connected;
+    mavlink_status_t mav_status;
+
+    // messages of all members are sent in batches
+    uint8_t send_buf[4096];
+    uint16_t send_len;
+    void start_message(const Member &m);
+    void queue_message(Member &m, const mavlink_message_t &msg);
+    void flush(void);
+
+    void send_report(void);
+};
+
+}  // namespace SITL
+
+#endif  // AP_SIM_SWARM_ENABLED
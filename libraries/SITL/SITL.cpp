@@ -225,8 +225,8 @@ const AP_Param::GroupInfo SIM::var_info[] = {
     AP_GROUPINFO("ADSB_TX",       51, SIM,  adsb_tx, 0),
     // @Param: SPEEDUP
     // @DisplayName: Sim Speedup
-    // @Description: Runs the simulation at multiples of normal speed. Do not use if realtime physics, like RealFlight, is being used
-    // @Range: 1 10
+    // @Description: Runs the simulation at multiples of normal speed. Zero runs the simulation in lock-step as fast as the CPU allows. Do not use if realtime physics, like RealFlight, is being used
+    // @Range: 0 10
     // @User: Advanced
     AP_GROUPINFO("SPEEDUP",       52, SIM,  speedup, 1),
     // @Param: IMU_POS
@@ -1321,6 +1321,12 @@ const AP_Param::GroupInfo SIM::ModelParm::var_info[] = {
     AP_SUBGROUPPTR(ais_ptr, "AIS_", 7, SIM::ModelParm, AIS),
 #endif  // AP_SIM_AIS_ENABLED
 
+#if AP_SIM_SWARM_ENABLED
+    // @Group: SWRM_
+    // @Path: ./SIM_Swarm.cpp
+    AP_SUBGROUPINFO(swarm_sim, "SWRM_", 8, SIM::ModelParm, SwarmSim),
+#endif
+
     AP_GROUPEND
 };
 
@@ -27,6 +27,7 @@
 #include "SIM_FETtecOneWireESC.h"
 #include "SIM_IntelligentEnergy24.h"
 #include "SIM_Ship.h"
+#include "SIM_Swarm.h"
 #include "SIM_SlungPayload.h"
 #include "SIM_Tether.h"
 #include "SIM_GPS.h"
@@ -372,6 +373,9 @@ public:
 #if AP_SIM_AIS_ENABLED
         class AIS *ais_ptr;
 #endif  // AP_SIM_AIS_ENABLED
+#if AP_SIM_SWARM_ENABLED
+        SwarmSim swarm_sim;
+#endif
     };
     ModelParm models;
     